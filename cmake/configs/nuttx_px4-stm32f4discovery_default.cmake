@@ -18,6 +18,8 @@ set(config_module_list
 	systemcmds/mixer
 	systemcmds/param
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
 	systemcmds/reboot
 	systemcmds/top
 	systemcmds/config
@@ -51,6 +51,8 @@ set(config_module_list
 	systemcmds/mixer
 	systemcmds/param
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
 	systemcmds/pwm
 	systemcmds/esc_calib
 	systemcmds/reboot
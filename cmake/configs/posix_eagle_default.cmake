@@ -17,6 +17,7 @@ set(config_module_list
 	systemcmds/mixer
 	systemcmds/ver
 	systemcmds/topic_listener
+	systemcmds/top
 
 	modules/mavlink
 
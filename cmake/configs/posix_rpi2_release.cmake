@@ -23,6 +23,9 @@ set(config_module_list
 	systemcmds/reboot
 	systemcmds/topic_listener
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
+	systemcmds/top
 	modules/uORB
 	modules/param
 	modules/systemlib
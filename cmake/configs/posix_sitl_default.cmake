@@ -25,7 +25,11 @@ set(config_module_list
 	systemcmds/reboot
 	systemcmds/topic_listener
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
+	systemcmds/top
 	modules/uORB
+	modules/muorb/shm
 	modules/param
 	modules/systemlib
 	modules/systemlib/mixer
@@ -25,6 +25,9 @@ set(config_module_list
 	systemcmds/reboot
 	systemcmds/topic_listener
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
+	systemcmds/top
 	modules/uORB
 	modules/param
 	modules/systemlib
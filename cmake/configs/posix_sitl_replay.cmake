@@ -11,6 +11,8 @@ set(config_module_list
 	systemcmds/param
 	systemcmds/ver
 	systemcmds/perf
+	systemcmds/latency
+	systemcmds/trace
 	modules/uORB
 	modules/param
 	modules/systemlib
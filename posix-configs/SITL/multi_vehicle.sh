@@ -0,0 +1,91 @@
+#!/bin/bash
+#
+# Launch several simulated vehicles and report their CPU and memory usage.
+#
+# usage: multi_vehicle.sh build_path [num_vehicles] [duration_s]
+#
+# Every vehicle gets its own working directory (rootfs, parameters and logs)
+# and its own MAVLink port (14556 + 10 * instance).
+# The startup file is generated from init/rcS_multi_iris.
+#
+# Scope: this script runs one mainapp process per vehicle, it does NOT host
+# several vehicles in one process. The uORB topic namespaces
+# ('uorb namespace <n>'), including work queue items and hrt callouts, are
+# isolated per vehicle, but most modules are still singletons and cannot be
+# started a second time in the same process. Single-process hosting requires
+# those modules to become multi-instance first; until then the numbers below
+# are the per-process baseline it has to improve on.
+
+build_path=$1
+num_vehicles=${2:-10}
+duration=${3:-30}
+script_dir=$(cd "$(dirname "$0")" && pwd)
+template=$script_dir/init/rcS_multi_iris
+
+if [ "$build_path" == "" ]
+then
+	echo usage: multi_vehicle.sh build_path [num_vehicles] [duration_s]
+	exit 1
+fi
+
+app_dir=$(cd "$build_path/src/firmware/posix" && pwd)
+
+if [ ! -x "$app_dir/mainapp" ]
+then
+	echo "mainapp not found in $app_dir, build posix_sitl_default first"
+	exit 1
+fi
+
+echo "starting $num_vehicles vehicles, one mainapp process per vehicle"
+
+pids=()
+
+cleanup() {
+	for pid in "${pids[@]}"
+	do
+		kill $pid 2>/dev/null
+	done
+}
+
+trap cleanup EXIT INT TERM
+
+for ((i = 0; i < num_vehicles; i++))
+do
+	vehicle_dir=$app_dir/vehicle_$i
+	mkdir -p $vehicle_dir/rootfs/fs/microsd
+	mkdir -p $vehicle_dir/rootfs/eeprom
+	touch $vehicle_dir/rootfs/eeprom/parameters
+
+	sed -e "s/@SYS_ID@/$((i + 1))/" \
+	    -e "s/@MAV_PORT@/$((14556 + 10 * i))/" \
+	    -e "s#\.\./\.\./\.\./\.\./ROMFS#$script_dir/../../ROMFS#" \
+	    $template > $vehicle_dir/rcS
+
+	(cd $vehicle_dir && exec $app_dir/mainapp -d rcS > mainapp.log 2>&1) &
+	pids+=($!)
+	echo "vehicle $i: pid ${pids[$i]} mavlink udp $((14556 + 10 * i))"
+done
+
+sleep $duration
+
+printf "\n%-8s %-8s %-8s %-10s %-8s\n" "vehicle" "pid" "%cpu" "rss_kb" "threads"
+total_cpu=0
+total_rss=0
+
+for ((i = 0; i < num_vehicles; i++))
+do
+	pid=${pids[$i]}
+
+	if ! kill -0 $pid 2>/dev/null
+	then
+		printf "%-8s %-8s exited, see vehicle_%d/mainapp.log\n" $i $pid $i
+		continue
+	fi
+
+	read cpu rss threads <<< $(ps -o %cpu=,rss=,nlwp= -p $pid)
+	printf "%-8s %-8s %-8s %-10s %-8s\n" $i $pid $cpu $rss $threads
+	total_cpu=$(echo "$total_cpu + $cpu" | bc)
+	total_rss=$((total_rss + rss))
+done
+
+printf "%-8s %-8s %-8s %-10s\n" "total" "" $total_cpu $total_rss
@@ -63,8 +63,6 @@ Integrator::~Integrator()
 bool
 Integrator::put(uint64_t timestamp, math::Vector<3> &val, math::Vector<3> &integral, uint64_t &integral_dt)
 {
-	bool auto_reset = false;
-
 	if (_last_integration == 0) {
 		/* this is the first item in the integrator */
 		_last_integration = timestamp;
@@ -73,6 +71,50 @@ Integrator::put(uint64_t timestamp, math::Vector<3> &val, math::Vector<3> &integ
 		return false;
 	}
 
+	integrate(timestamp, val);
+
+	return check_auto_reset(timestamp, integral, integral_dt);
+}
+
+bool
+Integrator::put_batch(uint64_t timestamp, const math::Vector<3> *vals, unsigned count, uint64_t interval,
+		      math::Vector<3> &integral, uint64_t &integral_dt)
+{
+	if (count == 0) {
+		return false;
+	}
+
+	const uint64_t span = (count - 1) * interval;
+	uint64_t t = (timestamp > span) ? timestamp - span : 0;
+	uint64_t step = interval;
+	unsigned first = 0;
+
+	if (_last_integration == 0) {
+		/* the first item only initializes the integrator */
+		_last_integration = t;
+		_last_auto = t;
+		_last_val = vals[0];
+		first = 1;
+		t += step;
+
+	} else if (t <= _last_integration) {
+		/* the back-dated batch overlaps the previous one, e.g. after a late
+		 * wakeup, so spread the items between the last integration and the timestamp */
+		step = (timestamp > _last_integration) ? (timestamp - _last_integration) / count : 0;
+		t = _last_integration + step;
+	}
+
+	for (unsigned k = first; k < count; k++) {
+		integrate(t, vals[k]);
+		t += step;
+	}
+
+	return check_auto_reset(timestamp, integral, integral_dt);
+}
+
+void
+Integrator::integrate(uint64_t timestamp, const math::Vector<3> &val)
+{
 	// Integrate
 	double dt = (double)(timestamp - _last_integration) / 1000000.0;
 	math::Vector<3> i = (val + _last_val) * dt * 0.5f;
@@ -93,24 +135,29 @@ Integrator::put(uint64_t timestamp, math::Vector<3> &val, math::Vector<3> &integ
 	_last_integration = timestamp;
 	_last_val = val;
 	_last_delta = i;
+}
 
-	if ((timestamp - _last_auto) > _auto_reset_interval) {
-		if (_auto_callback) {
-			/* call the callback */
-			_auto_callback(timestamp, _integral_auto);
-		}
-
-		integral = _integral_auto;
-		integral_dt = (timestamp - _last_auto);
+bool
+Integrator::check_auto_reset(uint64_t timestamp, math::Vector<3> &integral, uint64_t &integral_dt)
+{
+	if ((timestamp - _last_auto) <= _auto_reset_interval) {
+		return false;
+	}
 
-		auto_reset = true;
-		_last_auto = timestamp;
-		_integral_auto(0) = 0.0f;
-		_integral_auto(1) = 0.0f;
-		_integral_auto(2) = 0.0f;
+	if (_auto_callback) {
+		/* call the callback */
+		_auto_callback(timestamp, _integral_auto);
 	}
 
-	return auto_reset;
+	integral = _integral_auto;
+	integral_dt = (timestamp - _last_auto);
+
+	_last_auto = timestamp;
+	_integral_auto(0) = 0.0f;
+	_integral_auto(1) = 0.0f;
+	_integral_auto(2) = 0.0f;
+
+	return true;
 }
 
 math::Vector<3>
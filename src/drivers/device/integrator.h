@@ -60,6 +60,25 @@ public:
 	 */
 	bool			put(uint64_t timestamp, math::Vector<3> &val, math::Vector<3> &integral, uint64_t &integral_dt);
 
+	/**
+	 * Put a batch of equidistant items into the integral, e.g. a sensor FIFO.
+	 *
+	 * Every item is integrated (and coning compensated) individually, the
+	 * auto-reset is only evaluated once for the whole batch. The items are
+	 * back-dated from the timestamp; if that reaches into the previous batch
+	 * they are spread evenly after the last integrated item instead.
+	 *
+	 * @param timestamp	Timestamp of the last (newest) item
+	 * @param vals		Items to put, oldest first
+	 * @param count		Number of items
+	 * @param interval	Time between two items in microseconds
+	 * @param integral	Current integral in case the integrator did reset, else the value will not be modified
+	 * @return		true if putting the items triggered an integral reset
+	 *			and the integral should be published
+	 */
+	bool			put_batch(uint64_t timestamp, const math::Vector<3> *vals, unsigned count, uint64_t interval,
+					  math::Vector<3> &integral, uint64_t &integral_dt);
+
 	/**
 	 * Get the current integral value
 	 *
@@ -91,6 +110,16 @@ private:
 	void (*_auto_callback)(uint64_t, math::Vector<3>);	/**< the function callback for auto-reset */
 	bool _coning_comp_on;				/**< coning compensation */
 
+	/**
+	 * Integrate a single item without evaluating the auto-reset.
+	 */
+	void integrate(uint64_t timestamp, const math::Vector<3> &val);
+
+	/**
+	 * Reset the integral if the auto-reset interval elapsed.
+	 */
+	bool check_auto_reset(uint64_t timestamp, math::Vector<3> &integral, uint64_t &integral_dt);
+
 	/* we don't want this class to be copied */
 	Integrator(const Integrator &);
 	Integrator operator=(const Integrator &);
@@ -76,6 +76,9 @@ typedef struct hrt_call {
 	hrt_abstime		period;
 	hrt_callout		callout;
 	void			*arg;
+#ifdef __PX4_POSIX
+	int			ns;	/**< task namespace the callout runs in */
+#endif
 } *hrt_call_t;
 
 /**
@@ -531,30 +531,9 @@ int ASHTECH::receive(unsigned timeout)
 		/* timeout additional to poll */
 		uint64_t time_started = hrt_absolute_time();
 
-		int j = 0;
-		ssize_t bytes_count = 0;
-
 		while (true) {
 
-			/* pass received bytes to the packet decoder */
-			while (j < bytes_count) {
-				int l = 0;
-
-				if ((l = parse_char(buf[j])) > 0) {
-					/* return to configure during configuration or to the gps driver during normal work
-					 * if a packet has arrived */
-					if (handle_message(l) > 0) {
-						return 1;
-					}
-				}
-
-				j++;
-			}
-
-			/* everything is read */
-			j = bytes_count = 0;
-
-			/* then poll or read for new data */
+			/* poll or read for new data */
 			int ret = poll_or_read(_fd, buf, sizeof(buf), timeout * 2);
 
 			if (ret < 0) {
@@ -566,8 +545,12 @@ int ASHTECH::receive(unsigned timeout)
 				 * stay here, and use timeout below. */
 
 			} else if (ret > 0) {
-				/* if we have new data from GPS, go handle it */
-				bytes_count = ret;
+				/* if we have new data from GPS, pass it to the packet decoder. Return
+				 * to configure during configuration or to the gps driver during normal
+				 * work if a packet has arrived */
+				if (parse(buf, ret) > 0) {
+					return 1;
+				}
 			}
 
 			/* in case we get crap from GPS or time out */
@@ -578,63 +561,91 @@ int ASHTECH::receive(unsigned timeout)
 	}
 
 }
+
 #define HEXDIGIT_CHAR(d) ((char)((d) + (((d) < 0xA) ? '0' : 'A'-0xA)))
 
-int ASHTECH::parse_char(uint8_t b)
+int ASHTECH::parse(const uint8_t *buf, unsigned len)
 {
 	int iRet = 0;
+	const uint8_t *p = buf;
+	const uint8_t *end = buf + len;
+
+	while (p < end) {
+		switch (_decode_state) {
+		/* First, look for sync1 */
+		case NME_DECODE_UNINIT: {
+				const uint8_t *sync = (const uint8_t *)memchr(p, '$', end - p);
+
+				if (sync == nullptr) {
+					p = end;
+					break;
+				}
 
-	switch (_decode_state) {
-	/* First, look for sync1 */
-	case NME_DECODE_UNINIT:
-		if (b == '$') {
-			_decode_state = NME_DECODE_GOT_SYNC1;
-			_rx_buffer_bytes = 0;
-			_rx_buffer[_rx_buffer_bytes++] = b;
-		}
+				_decode_state = NME_DECODE_GOT_SYNC1;
+				_rx_buffer_bytes = 0;
+				_rx_buffer[_rx_buffer_bytes++] = '$';
+				p = sync + 1;
+			}
+			break;
 
-		break;
+		case NME_DECODE_GOT_SYNC1: {
+				/* copy the sentence body up to the checksum delimiter */
+				const uint8_t *asterisk = (const uint8_t *)memchr(p, '*', end - p);
+				const uint8_t *span_end = (asterisk != nullptr) ? asterisk + 1 : end;
 
-	case NME_DECODE_GOT_SYNC1:
-		if (b == '$') {
-			_decode_state = NME_DECODE_GOT_SYNC1;
-			_rx_buffer_bytes = 0;
+				/* a new sentence start drops the current one */
+				const uint8_t *sync;
 
-		} else if (b == '*') {
-			_decode_state = NME_DECODE_GOT_ASTERIKS;
-		}
+				while ((sync = (const uint8_t *)memchr(p, '$', span_end - p)) != nullptr) {
+					_rx_buffer_bytes = 0;
+					_rx_buffer[_rx_buffer_bytes++] = '$';
+					p = sync + 1;
+				}
 
-		if (_rx_buffer_bytes >= (sizeof(_rx_buffer) - 5)) {
-			_decode_state = NME_DECODE_UNINIT;
-			_rx_buffer_bytes = 0;
+				unsigned n = span_end - p;
 
-		} else {
-			_rx_buffer[_rx_buffer_bytes++] = b;
-		}
+				if (_rx_buffer_bytes + n > (sizeof(_rx_buffer) - 5)) {
+					_decode_state = NME_DECODE_UNINIT;
+					_rx_buffer_bytes = 0;
+					p = span_end;
+					break;
+				}
 
-		break;
+				memcpy(&_rx_buffer[_rx_buffer_bytes], p, n);
+				_rx_buffer_bytes += n;
+				p = span_end;
 
-	case NME_DECODE_GOT_ASTERIKS:
-		_rx_buffer[_rx_buffer_bytes++] = b;
-		_decode_state = NME_DECODE_GOT_FIRST_CS_BYTE;
-		break;
+				if (asterisk != nullptr) {
+					_decode_state = NME_DECODE_GOT_ASTERIKS;
+				}
+			}
+			break;
 
-	case NME_DECODE_GOT_FIRST_CS_BYTE:
-		_rx_buffer[_rx_buffer_bytes++] = b;
-		uint8_t checksum = 0;
-		uint8_t *buffer = _rx_buffer + 1;
-		uint8_t *bufend = _rx_buffer + _rx_buffer_bytes - 3;
+		case NME_DECODE_GOT_ASTERIKS:
+			_rx_buffer[_rx_buffer_bytes++] = *p++;
+			_decode_state = NME_DECODE_GOT_FIRST_CS_BYTE;
+			break;
 
-		for (; buffer < bufend; buffer++) { checksum ^= *buffer; }
+		case NME_DECODE_GOT_FIRST_CS_BYTE: {
+				_rx_buffer[_rx_buffer_bytes++] = *p++;
+				uint8_t checksum = 0;
+				uint8_t *buffer = _rx_buffer + 1;
+				uint8_t *bufend = _rx_buffer + _rx_buffer_bytes - 3;
 
-		if ((HEXDIGIT_CHAR(checksum >> 4) == *(_rx_buffer + _rx_buffer_bytes - 2)) &&
-		    (HEXDIGIT_CHAR(checksum & 0x0F) == *(_rx_buffer + _rx_buffer_bytes - 1))) {
-			iRet = _rx_buffer_bytes;
-		}
+				for (; buffer < bufend; buffer++) { checksum ^= *buffer; }
+
+				if ((HEXDIGIT_CHAR(checksum >> 4) == *(_rx_buffer + _rx_buffer_bytes - 2)) &&
+				    (HEXDIGIT_CHAR(checksum & 0x0F) == *(_rx_buffer + _rx_buffer_bytes - 1))) {
+					if (handle_message(_rx_buffer_bytes) > 0) {
+						iRet = 1;
+					}
+				}
 
-		_decode_state = NME_DECODE_UNINIT;
-		_rx_buffer_bytes = 0;
-		break;
+				_decode_state = NME_DECODE_UNINIT;
+				_rx_buffer_bytes = 0;
+			}
+			break;
+		}
 	}
 
 	return iRet;
@@ -83,7 +83,13 @@ public:
 	int             configure(unsigned &baudrate);
 	void            decode_init(void);
 	int             handle_message(int len);
-	int             parse_char(uint8_t b);
+	/**
+	 * Parse a buffer of received bytes and handle every complete sentence,
+	 * sentences may be split across calls
+	 *
+	 * @return 1 if at least one sentence was handled, 0 otherwise
+	 */
+	int             parse(const uint8_t *buf, unsigned len);
 	/** Read int ASHTECH parameter */
 	int32_t         read_int();
 	/** Read float ASHTECH parameter */
@@ -113,32 +113,18 @@ int
 MTK::receive(unsigned timeout)
 {
 	uint8_t buf[32];
-	gps_mtk_packet_t packet;
 
 	/* timeout additional to poll */
 	uint64_t time_started = hrt_absolute_time();
 
-	int j = 0;
-
 	while (true) {
 
 		int ret = poll_or_read(_fd, buf, sizeof(buf), timeout);
 
 		if (ret > 0) {
-			/* first read whatever is left */
-			if (j < ret) {
-				/* pass received bytes to the packet decoder */
-				while (j < ret) {
-					if (parse_char(buf[j], packet) > 0) {
-						handle_message(packet);
-						return 1;
-					}
-
-					j++;
-				}
-
-				/* everything is read */
-				j = 0;
+			/* pass received bytes to the packet decoder */
+			if (parse(buf, ret) > 0) {
+				return 1;
 			}
 
 		} else {
@@ -160,53 +146,65 @@ MTK::decode_init(void)
 	_rx_count = 0;
 	_decode_state = MTK_DECODE_UNINIT;
 }
+
 int
-MTK::parse_char(uint8_t b, gps_mtk_packet_t &packet)
+MTK::parse(const uint8_t *buf, unsigned len)
 {
 	int ret = 0;
+	unsigned i = 0;
 
-	if (_decode_state == MTK_DECODE_UNINIT) {
+	while (i < len) {
+		if (_decode_state == MTK_DECODE_UNINIT) {
+			/* skip to the next start symbol */
+			while (i < len && buf[i] != MTK_SYNC1_V16 && buf[i] != MTK_SYNC1_V19) {
+				i++;
+			}
 
-		if (b == MTK_SYNC1_V16) {
-			_decode_state = MTK_DECODE_GOT_CK_A;
-			_mtk_revision = 16;
+			if (i < len) {
+				_mtk_revision = (buf[i++] == MTK_SYNC1_V16) ? 16 : 19;
+				_decode_state = MTK_DECODE_GOT_CK_A;
+			}
 
-		} else if (b == MTK_SYNC1_V19) {
-			_decode_state = MTK_DECODE_GOT_CK_A;
-			_mtk_revision = 19;
-		}
+		} else if (_decode_state == MTK_DECODE_GOT_CK_A) {
+			if (buf[i] == MTK_SYNC2) {
+				_decode_state = MTK_DECODE_GOT_CK_B;
+				i++;
 
-	} else if (_decode_state == MTK_DECODE_GOT_CK_A) {
-		if (b == MTK_SYNC2) {
-			_decode_state = MTK_DECODE_GOT_CK_B;
+			} else {
+				// Second start symbol was wrong, reset state machine, this byte may be a start symbol
+				decode_init();
+			}
 
-		} else {
-			// Second start symbol was wrong, reset state machine
-			decode_init();
-		}
+		} else if (_decode_state == MTK_DECODE_GOT_CK_B) {
+			/* copy as much of the packet as we have */
+			unsigned n = sizeof(_packet) - _rx_count;
 
-	} else if (_decode_state == MTK_DECODE_GOT_CK_B) {
-		// Add to checksum
-		if (_rx_count < 33) {
-			add_byte_to_checksum(b);
-		}
+			if (n > len - i) {
+				n = len - i;
+			}
 
-		// Fill packet buffer
-		((uint8_t *)(&packet))[_rx_count] = b;
-		_rx_count++;
+			memcpy(((uint8_t *)&_packet) + _rx_count, &buf[i], n);
 
-		/* Packet size minus checksum, XXX ? */
-		if (_rx_count >= sizeof(packet)) {
-			/* Compare checksum */
-			if (_rx_ck_a == packet.ck_a && _rx_ck_b == packet.ck_b) {
-				ret = 1;
+			/* checksum is calculated over everything except the checksum bytes */
+			const unsigned ck_len = sizeof(_packet) - 2;
 
-			} else {
-				ret = -1;
+			if (_rx_count < ck_len) {
+				add_to_checksum(&buf[i], (_rx_count + n > ck_len) ? ck_len - _rx_count : n);
 			}
 
-			// Reset state machine to decode next packet
-			decode_init();
+			_rx_count += n;
+			i += n;
+
+			if (_rx_count >= sizeof(_packet)) {
+				/* Compare checksum */
+				if (_rx_ck_a == _packet.ck_a && _rx_ck_b == _packet.ck_b) {
+					handle_message(_packet);
+					ret = 1;
+				}
+
+				// Reset state machine to decode next packet
+				decode_init();
+			}
 		}
 	}
 
@@ -301,8 +299,10 @@ MTK::handle_message(gps_mtk_packet_t &packet)
 }
 
 void
-MTK::add_byte_to_checksum(uint8_t b)
+MTK::add_to_checksum(const uint8_t *b, unsigned len)
 {
-	_rx_ck_a = _rx_ck_a + b;
-	_rx_ck_b = _rx_ck_b + _rx_ck_a;
+	for (unsigned i = 0; i < len; i++) {
+		_rx_ck_a = _rx_ck_a + b[i];
+		_rx_ck_b = _rx_ck_b + _rx_ck_a;
+	}
 }
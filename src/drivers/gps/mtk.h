@@ -93,11 +93,14 @@ public:
 	int				receive(unsigned timeout);
 	int				configure(unsigned &baudrate);
 
-private:
 	/**
-	 * Parse the binary MTK packet
+	 * Parse a buffer of received bytes, packets may be split across calls
+	 *
+	 * @return 1 if at least one packet was handled, 0 otherwise
 	 */
-	int				parse_char(uint8_t b, gps_mtk_packet_t &packet);
+	int				parse(const uint8_t *buf, unsigned len);
+
+private:
 
 	/**
 	 * Handle the package once it has arrived
@@ -112,7 +115,7 @@ private:
 	/**
 	 * While parsing add every byte (except the sync bytes) to the checksum
 	 */
-	void				add_byte_to_checksum(uint8_t);
+	void				add_to_checksum(const uint8_t *b, unsigned len);
 
 	int					_fd;
 	struct vehicle_gps_position_s *_gps_position;
@@ -121,6 +124,7 @@ private:
 	unsigned			_rx_count;
 	uint8_t 			_rx_ck_a;
 	uint8_t				_rx_ck_b;
+	gps_mtk_packet_t		_packet;
 };
 
 #endif /* MTK_H_ */
@@ -76,7 +76,7 @@
 
 
 /**** Trace macros, disable for production builds */
-#define UBX_TRACE_PARSER(s, ...)	{/*PX4_INFO(s, ## __VA_ARGS__);*/}	/* decoding progress in parse_char() */
+#define UBX_TRACE_PARSER(s, ...)	{/*PX4_INFO(s, ## __VA_ARGS__);*/}	/* decoding progress in parse() */
 #define UBX_TRACE_RXMSG(s, ...)		{/*PX4_INFO(s, ## __VA_ARGS__);*/}	/* Rx msgs in payload_rx_done() */
 #define UBX_TRACE_SVINFO(s, ...)	{/*PX4_INFO(s, ## __VA_ARGS__);*/}	/* NAV-SVINFO processing (debug use only, will cause rx buffer overflows) */
 
@@ -97,6 +97,8 @@ UBX::UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct sate
 	_ubx_version(0),
 	_use_nav_pvt(false)
 {
+	_rx_stream = false;
+
 	decode_init();
 }
 
@@ -331,10 +333,7 @@ UBX::receive(const unsigned timeout)
 			UBX_DEBUG("read %d bytes", ret);
 
 			/* pass received bytes to the packet decoder */
-			for (int i = 0; i < ret; i++) {
-				handled |= parse_char(buf[i]);
-				UBX_DEBUG("parsed %d: 0x%x", i, buf[i]);
-			}
+			handled |= parse(buf, ret);
 		}
 
 		/* abort after timeout if no useful packets received */
@@ -346,276 +345,286 @@ UBX::receive(const unsigned timeout)
 }
 
 int	// 0 = decoding, 1 = message handled, 2 = sat info message handled
-UBX::parse_char(const uint8_t b)
+UBX::parse(const uint8_t *buf, unsigned len)
 {
-	int ret = 0;
-
-	switch (_decode_state) {
-
-	/* Expecting Sync1 */
-	case UBX_DECODE_SYNC1:
-		if (b == UBX_SYNC1) {	// Sync1 found --> expecting Sync2
-			UBX_TRACE_PARSER("A");
-			_decode_state = UBX_DECODE_SYNC2;
-		}
-
-		break;
-
-	/* Expecting Sync2 */
-	case UBX_DECODE_SYNC2:
-		if (b == UBX_SYNC2) {	// Sync2 found --> expecting Class
-			UBX_TRACE_PARSER("B");
-			_decode_state = UBX_DECODE_CLASS;
+	int handled = 0;
+	unsigned i = 0;
 
-		} else {		// Sync1 not followed by Sync2: reset parser
-			decode_init();
-		}
+	while (i < len) {
+		switch (_decode_state) {
 
-		break;
+		/* Expecting Sync1 */
+		case UBX_DECODE_SYNC1: {
+				/* skip everything up to the next sync byte */
+				const uint8_t *sync = (const uint8_t *)memchr(&buf[i], UBX_SYNC1, len - i);
 
-	/* Expecting Class */
-	case UBX_DECODE_CLASS:
-		UBX_TRACE_PARSER("C");
-		add_byte_to_checksum(b);  // checksum is calculated for everything except Sync and Checksum bytes
-		_rx_msg = b;
-		_decode_state = UBX_DECODE_ID;
-		break;
-
-	/* Expecting ID */
-	case UBX_DECODE_ID:
-		UBX_TRACE_PARSER("D");
-		add_byte_to_checksum(b);
-		_rx_msg |= b << 8;
-		_decode_state = UBX_DECODE_LENGTH1;
-		break;
+				if (sync == nullptr) {
+					i = len;
+					break;
+				}
 
-	/* Expecting first length byte */
-	case UBX_DECODE_LENGTH1:
-		UBX_TRACE_PARSER("E");
-		add_byte_to_checksum(b);
-		_rx_payload_length = b;
-		_decode_state = UBX_DECODE_LENGTH2;
-		break;
+				i = sync - buf;
 
-	/* Expecting second length byte */
-	case UBX_DECODE_LENGTH2:
-		UBX_TRACE_PARSER("F");
-		add_byte_to_checksum(b);
-		_rx_payload_length |= b << 8;	// calculate payload size
+				/* decode in place if the whole frame is in the buffer */
+				unsigned frame_len = 0;
+				int ret = parse_frame(sync, len - i, frame_len);
 
-		if (payload_rx_init() != 0) {	// start payload reception
-			// payload will not be handled, discard message
-			decode_init();
+				if (ret >= 0) {
+					handled |= ret;
+					i += frame_len;
 
-		} else {
-			_decode_state = (_rx_payload_length > 0) ? UBX_DECODE_PAYLOAD : UBX_DECODE_CHKSUM1;
-		}
+				} else {	// Sync1 found --> expecting Sync2
+					UBX_TRACE_PARSER("A");
+					_decode_state = UBX_DECODE_SYNC2;
+					i++;
+				}
+			}
+			break;
 
-		break;
+		/* Expecting Sync2 */
+		case UBX_DECODE_SYNC2:
+			if (buf[i] == UBX_SYNC2) {	// Sync2 found --> expecting Class
+				UBX_TRACE_PARSER("B");
+				_decode_state = UBX_DECODE_CLASS;
+				i++;
 
-	/* Expecting payload */
-	case UBX_DECODE_PAYLOAD:
-		UBX_TRACE_PARSER(".");
-		add_byte_to_checksum(b);
+			} else {		// Sync1 not followed by Sync2: reset parser, this byte may be Sync1
+				decode_init();
+			}
 
-		switch (_rx_msg) {
-		case UBX_MSG_NAV_SVINFO:
-			ret = payload_rx_add_nav_svinfo(b);	// add a NAV-SVINFO payload byte
 			break;
 
-		case UBX_MSG_MON_VER:
-			ret = payload_rx_add_mon_ver(b);	// add a MON-VER payload byte
+		/* Expecting Class */
+		case UBX_DECODE_CLASS:
+			UBX_TRACE_PARSER("C");
+			add_byte_to_checksum(buf[i]);  // checksum is calculated for everything except Sync and Checksum bytes
+			_rx_msg = buf[i++];
+			_decode_state = UBX_DECODE_ID;
 			break;
 
-		default:
-			ret = payload_rx_add(b);		// add a payload byte
+		/* Expecting ID */
+		case UBX_DECODE_ID:
+			UBX_TRACE_PARSER("D");
+			add_byte_to_checksum(buf[i]);
+			_rx_msg |= buf[i++] << 8;
+			_decode_state = UBX_DECODE_LENGTH1;
 			break;
-		}
 
-		if (ret < 0) {
-			// payload not handled, discard message
-			decode_init();
+		/* Expecting first length byte */
+		case UBX_DECODE_LENGTH1:
+			UBX_TRACE_PARSER("E");
+			add_byte_to_checksum(buf[i]);
+			_rx_payload_length = buf[i++];
+			_decode_state = UBX_DECODE_LENGTH2;
+			break;
 
-		} else if (ret > 0) {
-			// payload complete, expecting checksum
-			_decode_state = UBX_DECODE_CHKSUM1;
+		/* Expecting second length byte */
+		case UBX_DECODE_LENGTH2:
+			UBX_TRACE_PARSER("F");
+			add_byte_to_checksum(buf[i]);
+			_rx_payload_length |= buf[i++] << 8;	// calculate payload size
 
-		} else {
-			// expecting more payload, stay in state UBX_DECODE_PAYLOAD
-		}
+			if (payload_rx_init() != 0) {	// start payload reception
+				// payload will not be handled, discard message
+				decode_init();
 
-		ret = 0;
-		break;
+			} else {
+				_decode_state = (_rx_payload_length > 0) ? UBX_DECODE_PAYLOAD : UBX_DECODE_CHKSUM1;
+			}
 
-	/* Expecting first checksum byte */
-	case UBX_DECODE_CHKSUM1:
-		if (_rx_ck_a != b) {
-			UBX_WARN("ubx checksum err");
-			decode_init();
+			break;
 
-		} else {
-			_decode_state = UBX_DECODE_CHKSUM2;
-		}
+		/* Expecting payload */
+		case UBX_DECODE_PAYLOAD: {
+				UBX_TRACE_PARSER(".");
+				unsigned n = MIN(len - i, (unsigned)(_rx_payload_length - _rx_payload_index));
+				int ret = 0;
 
-		break;
+				if (_rx_stream) {
+					// variable length payload, decode byte by byte
+					unsigned k = 0;
 
-	/* Expecting second checksum byte */
-	case UBX_DECODE_CHKSUM2:
-		if (_rx_ck_b != b) {
-			UBX_WARN("ubx checksum err");
+					while (k < n && ret == 0) {
+						ret = (_rx_msg == UBX_MSG_NAV_SVINFO) ? payload_rx_add_nav_svinfo(buf[i + k]) : payload_rx_add_mon_ver(buf[i + k]);
+						k++;
+					}
 
-		} else {
-			ret = payload_rx_done();	// finish payload processing
-		}
+					n = k;
 
-		decode_init();
-		break;
+				} else {
+					ret = payload_rx_add(&buf[i], n);
+				}
 
-	default:
-		break;
-	}
+				add_to_checksum(&buf[i], n);
+				i += n;
 
-	return ret;
-}
+				if (ret < 0) {
+					// payload not handled, discard message
+					decode_init();
 
-/**
- * Start payload rx
- */
-int	// -1 = abort, 0 = continue
-UBX::payload_rx_init()
-{
-	int ret = 0;
+				} else if (ret > 0) {
+					// payload complete, expecting checksum
+					_decode_state = UBX_DECODE_CHKSUM1;
 
-	_rx_state = UBX_RXMSG_HANDLE;	// handle by default
+				} else {
+					// expecting more payload, stay in state UBX_DECODE_PAYLOAD
+				}
+			}
+			break;
 
-	switch (_rx_msg) {
-	case UBX_MSG_NAV_PVT:
-		if ((_rx_payload_length != UBX_PAYLOAD_RX_NAV_PVT_SIZE_UBX7)		/* u-blox 7 msg format */
-		    && (_rx_payload_length != UBX_PAYLOAD_RX_NAV_PVT_SIZE_UBX8)) {	/* u-blox 8+ msg format */
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+		/* Expecting first checksum byte */
+		case UBX_DECODE_CHKSUM1:
+			if (_rx_ck_a != buf[i++]) {
+				UBX_WARN("ubx checksum err");
+				decode_init();
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+			} else {
+				_decode_state = UBX_DECODE_CHKSUM2;
+			}
 
-		} else if (!_use_nav_pvt) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if not using NAV-PVT
-		}
+			break;
 
-		break;
+		/* Expecting second checksum byte */
+		case UBX_DECODE_CHKSUM2:
+			if (_rx_ck_b != buf[i++]) {
+				UBX_WARN("ubx checksum err");
 
-	case UBX_MSG_NAV_POSLLH:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_nav_posllh_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+			} else {
+				handled |= payload_rx_done(_buf);	// finish payload processing
+			}
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+			decode_init();
+			break;
 
-		} else if (_use_nav_pvt) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if using NAV-PVT instead
+		default:
+			decode_init();
+			break;
 		}
+	}
 
-		break;
-
-	case UBX_MSG_NAV_SOL:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_nav_sol_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
-
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
-
-		} else if (_use_nav_pvt) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if using NAV-PVT instead
-		}
+	return handled;
+}
 
-		break;
+int	// -1 = frame incomplete, 0 = no message handled, 1 = message handled, 2 = sat info message handled
+UBX::parse_frame(const uint8_t *frame, unsigned len, unsigned &frame_len)
+{
+	/* sync (2), class & ID (2), length (2), payload, checksum (2) */
+	if (len < 8 || frame[1] != UBX_SYNC2) {
+		return -1;
+	}
 
-	case UBX_MSG_NAV_DOP:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_nav_dop_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	const uint16_t payload_length = frame[4] | (frame[5] << 8);
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+	if (len < 8u + payload_length) {
+		return -1;
+	}
 
-		}
+	ubx_checksum_t checksum = {0, 0};
+	calc_checksum(&frame[2], 4 + payload_length, &checksum);
 
-		break;
+	if (checksum.ck_a != frame[6 + payload_length] || checksum.ck_b != frame[7 + payload_length]) {
+		UBX_WARN("ubx checksum err");
+		frame_len = 1;	// resync after the sync byte
+		return 0;
+	}
 
-	case UBX_MSG_NAV_TIMEUTC:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_nav_timeutc_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	frame_len = 8 + payload_length;
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+	_rx_msg = frame[2] | (frame[3] << 8);
+	_rx_payload_length = payload_length;
 
-		} else if (_use_nav_pvt) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if using NAV-PVT instead
-		}
+	int ret = 0;
 
-		break;
+	if (payload_rx_init() == 0) {
+		const uint8_t *payload = &frame[6];
 
-	case UBX_MSG_NAV_SVINFO:
-		if (_satellite_info == nullptr) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if sat info not requested
+		if (_rx_stream) {
+			for (unsigned k = 0; k < payload_length && ret == 0; k++) {
+				ret = (_rx_msg == UBX_MSG_NAV_SVINFO) ? payload_rx_add_nav_svinfo(payload[k]) : payload_rx_add_mon_ver(payload[k]);
+			}
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+			ret = (ret < 0) ? 0 : payload_rx_done(_buf);
 
 		} else {
-			memset(_satellite_info, 0, sizeof(*_satellite_info));        // initialize sat info
+			// fixed length payload, decode it straight from the read buffer
+			ret = payload_rx_done(*(const ubx_buf_t *)payload);
 		}
+	}
 
-		break;
-
-	case UBX_MSG_NAV_VELNED:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_nav_velned_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	decode_init();
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
+	return ret;
+}
 
-		} else if (_use_nav_pvt) {
-			_rx_state = UBX_RXMSG_DISABLE;        // disable if using NAV-PVT instead
+/**
+ * Rx message table
+ *
+ * Accepted payload lengths and the conditions under which a message is handled.
+ */
+static const ubx_rx_msg_info_t ubx_rx_msgs[] = {
+	{UBX_MSG_NAV_PVT,	{UBX_PAYLOAD_RX_NAV_PVT_SIZE_UBX7, UBX_PAYLOAD_RX_NAV_PVT_SIZE_UBX8},		UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_PVT},
+	{UBX_MSG_NAV_POSLLH,	{sizeof(ubx_payload_rx_nav_posllh_t), sizeof(ubx_payload_rx_nav_posllh_t)},	UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_NO_PVT},
+	{UBX_MSG_NAV_SOL,	{sizeof(ubx_payload_rx_nav_sol_t), sizeof(ubx_payload_rx_nav_sol_t)},		UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_NO_PVT},
+	{UBX_MSG_NAV_DOP,	{sizeof(ubx_payload_rx_nav_dop_t), sizeof(ubx_payload_rx_nav_dop_t)},		UBX_RX_FLAG_CONFIGURED},
+	{UBX_MSG_NAV_TIMEUTC,	{sizeof(ubx_payload_rx_nav_timeutc_t), sizeof(ubx_payload_rx_nav_timeutc_t)},	UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_NO_PVT},
+	{UBX_MSG_NAV_SVINFO,	{0, 0},											UBX_RX_FLAG_SATINFO | UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_STREAM},
+	{UBX_MSG_NAV_VELNED,	{sizeof(ubx_payload_rx_nav_velned_t), sizeof(ubx_payload_rx_nav_velned_t)},	UBX_RX_FLAG_CONFIGURED | UBX_RX_FLAG_NO_PVT},
+	{UBX_MSG_MON_VER,	{0, 0},											UBX_RX_FLAG_STREAM},
+	{UBX_MSG_MON_HW,	{sizeof(ubx_payload_rx_mon_hw_ubx6_t), sizeof(ubx_payload_rx_mon_hw_ubx7_t)},	UBX_RX_FLAG_CONFIGURED},
+	{UBX_MSG_ACK_ACK,	{sizeof(ubx_payload_rx_ack_ack_t), sizeof(ubx_payload_rx_ack_ack_t)},		UBX_RX_FLAG_UNCONFIGURED},
+	{UBX_MSG_ACK_NAK,	{sizeof(ubx_payload_rx_ack_nak_t), sizeof(ubx_payload_rx_ack_nak_t)},		UBX_RX_FLAG_UNCONFIGURED},
+};
+
+const ubx_rx_msg_info_t *
+UBX::find_rx_msg(const uint16_t msg)
+{
+	for (unsigned i = 0; i < sizeof(ubx_rx_msgs) / sizeof(ubx_rx_msgs[0]); i++) {
+		if (ubx_rx_msgs[i].msg == msg) {
+			return &ubx_rx_msgs[i];
 		}
+	}
 
-		break;
+	return nullptr;
+}
 
-	case UBX_MSG_MON_VER:
-		break;		// unconditionally handle this message
+/**
+ * Start payload rx
+ */
+int	// -1 = abort, 0 = continue
+UBX::payload_rx_init()
+{
+	int ret = 0;
 
-	case UBX_MSG_MON_HW:
-		if ((_rx_payload_length != sizeof(ubx_payload_rx_mon_hw_ubx6_t))	/* u-blox 6 msg format */
-		    && (_rx_payload_length != sizeof(ubx_payload_rx_mon_hw_ubx7_t))) {	/* u-blox 7+ msg format */
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	_rx_state = UBX_RXMSG_HANDLE;	// handle by default
 
-		} else if (!_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
-		}
+	const ubx_rx_msg_info_t *info = find_rx_msg(_rx_msg);
 
-		break;
+	// variable length payloads are always decoded while receiving, even if the message is ignored
+	_rx_stream = (info != nullptr) && (info->flags & UBX_RX_FLAG_STREAM);
 
-	case UBX_MSG_ACK_ACK:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_ack_ack_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	if (info == nullptr) {
+		_rx_state = UBX_RXMSG_DISABLE;	// disable all other messages
 
-		} else if (_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if _configured
-		}
+	} else if ((info->length[0] != 0)
+		   && (_rx_payload_length != info->length[0])
+		   && (_rx_payload_length != info->length[1])) {
+		_rx_state = UBX_RXMSG_ERROR_LENGTH;
 
-		break;
+	} else if ((info->flags & UBX_RX_FLAG_SATINFO) && (_satellite_info == nullptr)) {
+		_rx_state = UBX_RXMSG_DISABLE;        // disable if sat info not requested
 
-	case UBX_MSG_ACK_NAK:
-		if (_rx_payload_length != sizeof(ubx_payload_rx_ack_nak_t)) {
-			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+	} else if ((info->flags & UBX_RX_FLAG_CONFIGURED) && !_configured) {
+		_rx_state = UBX_RXMSG_IGNORE;        // ignore if not _configured
 
-		} else if (_configured) {
-			_rx_state = UBX_RXMSG_IGNORE;        // ignore if _configured
-		}
+	} else if ((info->flags & UBX_RX_FLAG_UNCONFIGURED) && _configured) {
+		_rx_state = UBX_RXMSG_IGNORE;        // ignore if _configured
 
-		break;
+	} else if (((info->flags & UBX_RX_FLAG_PVT) && !_use_nav_pvt)
+		   || ((info->flags & UBX_RX_FLAG_NO_PVT) && _use_nav_pvt)) {
+		_rx_state = UBX_RXMSG_DISABLE;        // disable if not using NAV-PVT or if using NAV-PVT instead
 
-	default:
-		_rx_state = UBX_RXMSG_DISABLE;	// disable all other messages
-		break;
+	} else if (_rx_msg == UBX_MSG_NAV_SVINFO) {
+		memset(_satellite_info, 0, sizeof(*_satellite_info));        // initialize sat info
 	}
 
 	switch (_rx_state) {
@@ -656,16 +665,17 @@ UBX::payload_rx_init()
 }
 
 /**
- * Add payload rx byte
+ * Add a span of payload rx bytes
  */
 int	// -1 = error, 0 = ok, 1 = payload completed
-UBX::payload_rx_add(const uint8_t b)
+UBX::payload_rx_add(const uint8_t *b, unsigned len)
 {
 	int ret = 0;
 
-	_buf.raw[_rx_payload_index] = b;
+	memcpy(&_buf.raw[_rx_payload_index], b, len);
+	_rx_payload_index += len;
 
-	if (++_rx_payload_index >= _rx_payload_length) {
+	if (_rx_payload_index >= _rx_payload_length) {
 		ret = 1;	// payload received completely
 	}
 
@@ -771,7 +781,7 @@ UBX::payload_rx_add_mon_ver(const uint8_t b)
  * Finish payload rx
  */
 int	// 0 = no message handled, 1 = message handled, 2 = sat info message handled
-UBX::payload_rx_done(void)
+UBX::payload_rx_done(const ubx_buf_t &rx)
 {
 	int ret = 0;
 
@@ -787,8 +797,8 @@ UBX::payload_rx_done(void)
 		UBX_TRACE_RXMSG("Rx NAV-PVT");
 
 		//Check if position fix flag is good
-		if ((_buf.payload_rx_nav_pvt.flags & UBX_RX_NAV_PVT_FLAGS_GNSSFIXOK) == 1) {
-			_gps_position->fix_type		 = _buf.payload_rx_nav_pvt.fixType;
+		if ((rx.payload_rx_nav_pvt.flags & UBX_RX_NAV_PVT_FLAGS_GNSSFIXOK) == 1) {
+			_gps_position->fix_type		 = rx.payload_rx_nav_pvt.fixType;
 			_gps_position->vel_ned_valid = true;
 
 		} else {
@@ -796,37 +806,37 @@ UBX::payload_rx_done(void)
 			_gps_position->vel_ned_valid = false;
 		}
 
-		_gps_position->satellites_used	= _buf.payload_rx_nav_pvt.numSV;
+		_gps_position->satellites_used	= rx.payload_rx_nav_pvt.numSV;
 
-		_gps_position->lat		= _buf.payload_rx_nav_pvt.lat;
-		_gps_position->lon		= _buf.payload_rx_nav_pvt.lon;
-		_gps_position->alt		= _buf.payload_rx_nav_pvt.hMSL;
+		_gps_position->lat		= rx.payload_rx_nav_pvt.lat;
+		_gps_position->lon		= rx.payload_rx_nav_pvt.lon;
+		_gps_position->alt		= rx.payload_rx_nav_pvt.hMSL;
 
-		_gps_position->eph		= (float)_buf.payload_rx_nav_pvt.hAcc * 1e-3f;
-		_gps_position->epv		= (float)_buf.payload_rx_nav_pvt.vAcc * 1e-3f;
-		_gps_position->s_variance_m_s	= (float)_buf.payload_rx_nav_pvt.sAcc * 1e-3f;
+		_gps_position->eph		= (float)rx.payload_rx_nav_pvt.hAcc * 1e-3f;
+		_gps_position->epv		= (float)rx.payload_rx_nav_pvt.vAcc * 1e-3f;
+		_gps_position->s_variance_m_s	= (float)rx.payload_rx_nav_pvt.sAcc * 1e-3f;
 
-		_gps_position->vel_m_s		= (float)_buf.payload_rx_nav_pvt.gSpeed * 1e-3f;
+		_gps_position->vel_m_s		= (float)rx.payload_rx_nav_pvt.gSpeed * 1e-3f;
 
-		_gps_position->vel_n_m_s	= (float)_buf.payload_rx_nav_pvt.velN * 1e-3f;
-		_gps_position->vel_e_m_s	= (float)_buf.payload_rx_nav_pvt.velE * 1e-3f;
-		_gps_position->vel_d_m_s	= (float)_buf.payload_rx_nav_pvt.velD * 1e-3f;
+		_gps_position->vel_n_m_s	= (float)rx.payload_rx_nav_pvt.velN * 1e-3f;
+		_gps_position->vel_e_m_s	= (float)rx.payload_rx_nav_pvt.velE * 1e-3f;
+		_gps_position->vel_d_m_s	= (float)rx.payload_rx_nav_pvt.velD * 1e-3f;
 
-		_gps_position->cog_rad		= (float)_buf.payload_rx_nav_pvt.headMot * M_DEG_TO_RAD_F * 1e-5f;
-		_gps_position->c_variance_rad	= (float)_buf.payload_rx_nav_pvt.headAcc * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->cog_rad		= (float)rx.payload_rx_nav_pvt.headMot * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->c_variance_rad	= (float)rx.payload_rx_nav_pvt.headAcc * M_DEG_TO_RAD_F * 1e-5f;
 
 		//Check if time and date fix flags are good
-		if ((_buf.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_VALIDDATE)
-		    && (_buf.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_VALIDTIME)
-		    && (_buf.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_FULLYRESOLVED)) {
+		if ((rx.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_VALIDDATE)
+		    && (rx.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_VALIDTIME)
+		    && (rx.payload_rx_nav_pvt.valid & UBX_RX_NAV_PVT_VALID_FULLYRESOLVED)) {
 			/* convert to unix timestamp */
 			struct tm timeinfo;
-			timeinfo.tm_year	= _buf.payload_rx_nav_pvt.year - 1900;
-			timeinfo.tm_mon		= _buf.payload_rx_nav_pvt.month - 1;
-			timeinfo.tm_mday	= _buf.payload_rx_nav_pvt.day;
-			timeinfo.tm_hour	= _buf.payload_rx_nav_pvt.hour;
-			timeinfo.tm_min		= _buf.payload_rx_nav_pvt.min;
-			timeinfo.tm_sec		= _buf.payload_rx_nav_pvt.sec;
+			timeinfo.tm_year	= rx.payload_rx_nav_pvt.year - 1900;
+			timeinfo.tm_mon		= rx.payload_rx_nav_pvt.month - 1;
+			timeinfo.tm_mday	= rx.payload_rx_nav_pvt.day;
+			timeinfo.tm_hour	= rx.payload_rx_nav_pvt.hour;
+			timeinfo.tm_min		= rx.payload_rx_nav_pvt.min;
+			timeinfo.tm_sec		= rx.payload_rx_nav_pvt.sec;
 
 			// TODO: this functionality is not available on the Snapdragon yet
 #ifndef __PX4_QURT
@@ -839,14 +849,14 @@ UBX::payload_rx_done(void)
 
 				timespec ts;
 				ts.tv_sec = epoch;
-				ts.tv_nsec = _buf.payload_rx_nav_pvt.nano;
+				ts.tv_nsec = rx.payload_rx_nav_pvt.nano;
 
 				if (clock_settime(CLOCK_REALTIME, &ts)) {
 					warn("failed setting clock");
 				}
 
 				_gps_position->time_utc_usec = static_cast<uint64_t>(epoch) * 1000000ULL;
-				_gps_position->time_utc_usec += _buf.payload_rx_nav_timeutc.nano / 1000;
+				_gps_position->time_utc_usec += rx.payload_rx_nav_timeutc.nano / 1000;
 
 			} else {
 				_gps_position->time_utc_usec = 0;
@@ -874,12 +884,12 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_POSLLH:
 		UBX_TRACE_RXMSG("Rx NAV-POSLLH");
 
-		_gps_position->lat	= _buf.payload_rx_nav_posllh.lat;
-		_gps_position->lon	= _buf.payload_rx_nav_posllh.lon;
-		_gps_position->alt	= _buf.payload_rx_nav_posllh.hMSL;
-		_gps_position->eph	= (float)_buf.payload_rx_nav_posllh.hAcc * 1e-3f; // from mm to m
-		_gps_position->epv	= (float)_buf.payload_rx_nav_posllh.vAcc * 1e-3f; // from mm to m
-		_gps_position->alt_ellipsoid = _buf.payload_rx_nav_posllh.height;
+		_gps_position->lat	= rx.payload_rx_nav_posllh.lat;
+		_gps_position->lon	= rx.payload_rx_nav_posllh.lon;
+		_gps_position->alt	= rx.payload_rx_nav_posllh.hMSL;
+		_gps_position->eph	= (float)rx.payload_rx_nav_posllh.hAcc * 1e-3f; // from mm to m
+		_gps_position->epv	= (float)rx.payload_rx_nav_posllh.vAcc * 1e-3f; // from mm to m
+		_gps_position->alt_ellipsoid = rx.payload_rx_nav_posllh.height;
 
 		_gps_position->timestamp_position = hrt_absolute_time();
 
@@ -892,9 +902,9 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_SOL:
 		UBX_TRACE_RXMSG("Rx NAV-SOL");
 
-		_gps_position->fix_type		= _buf.payload_rx_nav_sol.gpsFix;
-		_gps_position->s_variance_m_s	= (float)_buf.payload_rx_nav_sol.sAcc * 1e-2f;	// from cm to m
-		_gps_position->satellites_used	= _buf.payload_rx_nav_sol.numSV;
+		_gps_position->fix_type		= rx.payload_rx_nav_sol.gpsFix;
+		_gps_position->s_variance_m_s	= (float)rx.payload_rx_nav_sol.sAcc * 1e-2f;	// from cm to m
+		_gps_position->satellites_used	= rx.payload_rx_nav_sol.numSV;
 
 		_gps_position->timestamp_variance = hrt_absolute_time();
 
@@ -904,8 +914,8 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_DOP:
 		UBX_TRACE_RXMSG("Rx NAV-DOP");
 
-		_gps_position->hdop		= _buf.payload_rx_nav_dop.hDOP * 0.01f;	// from cm to m
-		_gps_position->vdop		= _buf.payload_rx_nav_dop.vDOP * 0.01f;	// from cm to m
+		_gps_position->hdop		= rx.payload_rx_nav_dop.hDOP * 0.01f;	// from cm to m
+		_gps_position->vdop		= rx.payload_rx_nav_dop.vDOP * 0.01f;	// from cm to m
 
 		_gps_position->timestamp_variance = hrt_absolute_time();
 
@@ -915,15 +925,15 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_TIMEUTC:
 		UBX_TRACE_RXMSG("Rx NAV-TIMEUTC");
 
-		if (_buf.payload_rx_nav_timeutc.valid & UBX_RX_NAV_TIMEUTC_VALID_VALIDUTC) {
+		if (rx.payload_rx_nav_timeutc.valid & UBX_RX_NAV_TIMEUTC_VALID_VALIDUTC) {
 			// convert to unix timestamp
 			struct tm timeinfo;
-			timeinfo.tm_year	= _buf.payload_rx_nav_timeutc.year - 1900;
-			timeinfo.tm_mon		= _buf.payload_rx_nav_timeutc.month - 1;
-			timeinfo.tm_mday	= _buf.payload_rx_nav_timeutc.day;
-			timeinfo.tm_hour	= _buf.payload_rx_nav_timeutc.hour;
-			timeinfo.tm_min		= _buf.payload_rx_nav_timeutc.min;
-			timeinfo.tm_sec		= _buf.payload_rx_nav_timeutc.sec;
+			timeinfo.tm_year	= rx.payload_rx_nav_timeutc.year - 1900;
+			timeinfo.tm_mon		= rx.payload_rx_nav_timeutc.month - 1;
+			timeinfo.tm_mday	= rx.payload_rx_nav_timeutc.day;
+			timeinfo.tm_hour	= rx.payload_rx_nav_timeutc.hour;
+			timeinfo.tm_min		= rx.payload_rx_nav_timeutc.min;
+			timeinfo.tm_sec		= rx.payload_rx_nav_timeutc.sec;
 			// TODO: this functionality is not available on the Snapdragon yet
 #ifndef __PX4_QURT
 			time_t epoch = mktime(&timeinfo);
@@ -937,14 +947,14 @@ UBX::payload_rx_done(void)
 
 				timespec ts;
 				ts.tv_sec = epoch;
-				ts.tv_nsec = _buf.payload_rx_nav_timeutc.nano;
+				ts.tv_nsec = rx.payload_rx_nav_timeutc.nano;
 
 				if (clock_settime(CLOCK_REALTIME, &ts)) {
 					warn("failed setting clock");
 				}
 
 				_gps_position->time_utc_usec = static_cast<uint64_t>(epoch) * 1000000ULL;
-				_gps_position->time_utc_usec += _buf.payload_rx_nav_timeutc.nano / 1000;
+				_gps_position->time_utc_usec += rx.payload_rx_nav_timeutc.nano / 1000;
 
 			} else {
 				_gps_position->time_utc_usec = 0;
@@ -972,12 +982,12 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_VELNED:
 		UBX_TRACE_RXMSG("Rx NAV-VELNED");
 
-		_gps_position->vel_m_s		= (float)_buf.payload_rx_nav_velned.speed * 1e-2f;
-		_gps_position->vel_n_m_s	= (float)_buf.payload_rx_nav_velned.velN * 1e-2f; /* NED NORTH velocity */
-		_gps_position->vel_e_m_s	= (float)_buf.payload_rx_nav_velned.velE * 1e-2f; /* NED EAST velocity */
-		_gps_position->vel_d_m_s	= (float)_buf.payload_rx_nav_velned.velD * 1e-2f; /* NED DOWN velocity */
-		_gps_position->cog_rad		= (float)_buf.payload_rx_nav_velned.heading * M_DEG_TO_RAD_F * 1e-5f;
-		_gps_position->c_variance_rad	= (float)_buf.payload_rx_nav_velned.cAcc * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->vel_m_s		= (float)rx.payload_rx_nav_velned.speed * 1e-2f;
+		_gps_position->vel_n_m_s	= (float)rx.payload_rx_nav_velned.velN * 1e-2f; /* NED NORTH velocity */
+		_gps_position->vel_e_m_s	= (float)rx.payload_rx_nav_velned.velE * 1e-2f; /* NED EAST velocity */
+		_gps_position->vel_d_m_s	= (float)rx.payload_rx_nav_velned.velD * 1e-2f; /* NED DOWN velocity */
+		_gps_position->cog_rad		= (float)rx.payload_rx_nav_velned.heading * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->c_variance_rad	= (float)rx.payload_rx_nav_velned.cAcc * M_DEG_TO_RAD_F * 1e-5f;
 		_gps_position->vel_ned_valid	= true;
 
 		_gps_position->timestamp_velocity = hrt_absolute_time();
@@ -1000,15 +1010,15 @@ UBX::payload_rx_done(void)
 		switch (_rx_payload_length) {
 
 		case sizeof(ubx_payload_rx_mon_hw_ubx6_t):	/* u-blox 6 msg format */
-			_gps_position->noise_per_ms		= _buf.payload_rx_mon_hw_ubx6.noisePerMS;
-			_gps_position->jamming_indicator	= _buf.payload_rx_mon_hw_ubx6.jamInd;
+			_gps_position->noise_per_ms		= rx.payload_rx_mon_hw_ubx6.noisePerMS;
+			_gps_position->jamming_indicator	= rx.payload_rx_mon_hw_ubx6.jamInd;
 
 			ret = 1;
 			break;
 
 		case sizeof(ubx_payload_rx_mon_hw_ubx7_t):	/* u-blox 7+ msg format */
-			_gps_position->noise_per_ms		= _buf.payload_rx_mon_hw_ubx7.noisePerMS;
-			_gps_position->jamming_indicator	= _buf.payload_rx_mon_hw_ubx7.jamInd;
+			_gps_position->noise_per_ms		= rx.payload_rx_mon_hw_ubx7.noisePerMS;
+			_gps_position->jamming_indicator	= rx.payload_rx_mon_hw_ubx7.jamInd;
 
 			ret = 1;
 			break;
@@ -1023,7 +1033,7 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_ACK_ACK:
 		UBX_TRACE_RXMSG("Rx ACK-ACK");
 
-		if ((_ack_state == UBX_ACK_WAITING) && (_buf.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
+		if ((_ack_state == UBX_ACK_WAITING) && (rx.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
 			_ack_state = UBX_ACK_GOT_ACK;
 		}
 
@@ -1033,7 +1043,7 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_ACK_NAK:
 		UBX_TRACE_RXMSG("Rx ACK-NAK");
 
-		if ((_ack_state == UBX_ACK_WAITING) && (_buf.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
+		if ((_ack_state == UBX_ACK_WAITING) && (rx.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
 			_ack_state = UBX_ACK_GOT_NAK;
 		}
 
@@ -1064,6 +1074,15 @@ UBX::add_byte_to_checksum(const uint8_t b)
 	_rx_ck_b = _rx_ck_b + _rx_ck_a;
 }
 
+void
+UBX::add_to_checksum(const uint8_t *b, unsigned len)
+{
+	for (unsigned i = 0; i < len; i++) {
+		_rx_ck_a = _rx_ck_a + b[i];
+		_rx_ck_b = _rx_ck_b + _rx_ck_a;
+	}
+}
+
 void
 UBX::calc_checksum(const uint8_t *buffer, const uint16_t length, ubx_checksum_t *checksum)
 {
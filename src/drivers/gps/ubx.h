@@ -478,6 +478,21 @@ typedef enum {
 	UBX_RXMSG_ERROR_LENGTH
 } ubx_rxmsg_state_t;
 
+/* Rx message handling flags, see the rx message table in ubx.cpp */
+#define UBX_RX_FLAG_CONFIGURED		0x01	/**< ignore unless the receiver is configured */
+#define UBX_RX_FLAG_UNCONFIGURED	0x02	/**< ignore once the receiver is configured */
+#define UBX_RX_FLAG_PVT			0x04	/**< disable unless NAV-PVT is used */
+#define UBX_RX_FLAG_NO_PVT		0x08	/**< disable if NAV-PVT is used */
+#define UBX_RX_FLAG_SATINFO		0x10	/**< disable if satellite info is not requested */
+#define UBX_RX_FLAG_STREAM		0x20	/**< variable length, payload is decoded while it is received */
+
+/* Rx message table entry */
+typedef struct {
+	uint16_t	msg;		/**< message class & ID */
+	uint16_t	length[2];	/**< accepted payload lengths, 0 = any */
+	uint8_t		flags;		/**< UBX_RX_FLAG_* */
+} ubx_rx_msg_info_t;
+
 /* ACK state */
 typedef enum {
 	UBX_ACK_IDLE = 0,
@@ -495,12 +510,32 @@ public:
 	int			receive(const unsigned timeout);
 	int			configure(unsigned &baudrate);
 
+	/**
+	 * Parse a buffer of received bytes
+	 *
+	 * Frames may be split across calls. Frames that are completely contained
+	 * in the buffer are checksummed and decoded in place without copying.
+	 *
+	 * @return 0 = nothing handled, 1 = message handled, 2 = sat info message handled (or-ed over all frames)
+	 */
+	int			parse(const uint8_t *buf, unsigned len);
+
 private:
 
 	/**
-	 * Parse the binary UBX packet
+	 * Parse a frame that is completely contained in the buffer
+	 *
+	 * @param frame		buffer starting at the sync bytes
+	 * @param len		number of bytes available
+	 * @param frame_len	length of the frame if it was consumed
+	 * @return		-1 = frame incomplete, else same as parse()
+	 */
+	int			parse_frame(const uint8_t *frame, unsigned len, unsigned &frame_len);
+
+	/**
+	 * Look up a message in the rx message table
 	 */
-	int			parse_char(const uint8_t b);
+	static const ubx_rx_msg_info_t *find_rx_msg(const uint16_t msg);
 
 	/**
 	 * Start payload rx
@@ -508,16 +543,18 @@ private:
 	int			payload_rx_init(void);
 
 	/**
-	 * Add payload rx byte
+	 * Add a span of payload rx bytes
 	 */
-	int			payload_rx_add(const uint8_t b);
+	int			payload_rx_add(const uint8_t *b, unsigned len);
 	int			payload_rx_add_nav_svinfo(const uint8_t b);
 	int			payload_rx_add_mon_ver(const uint8_t b);
 
 	/**
 	 * Finish payload rx
+	 *
+	 * @param rx		received payload, either _buf or the frame in the read buffer
 	 */
-	int			payload_rx_done(void);
+	int			payload_rx_done(const ubx_buf_t &rx);
 
 	/**
 	 * Reset the parse state machine for a fresh start
@@ -528,6 +565,7 @@ private:
 	 * While parsing add every byte (except the sync bytes) to the checksum
 	 */
 	void			add_byte_to_checksum(const uint8_t);
+	void			add_to_checksum(const uint8_t *b, unsigned len);
 
 	/**
 	 * Send a message
@@ -566,6 +604,7 @@ private:
 	ubx_rxmsg_state_t	_rx_state;
 	uint16_t		_rx_payload_length;
 	uint16_t		_rx_payload_index;
+	bool			_rx_stream;
 	uint8_t			_rx_ck_a;
 	uint8_t			_rx_ck_b;
 	hrt_abstime		_disable_cmd_last;
@@ -58,6 +58,7 @@
 #include <getopt.h>
 
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
 #include <systemlib/err.h>
 #include <systemlib/conversions.h>
 
@@ -72,7 +73,7 @@
 #include <drivers/device/integrator.h>
 #include <drivers/drv_accel.h>
 #include <drivers/drv_gyro.h>
-#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/BiquadFilterBank.hpp>
 #include <lib/conversion/rotation.h>
 
 #define DIR_READ			0x80
@@ -147,6 +148,12 @@
 #define BIT_RAW_RDY_EN			0x01
 #define BIT_I2C_IF_DIS			0x10
 #define BIT_INT_STATUS_DATA		0x01
+#define BIT_INT_STATUS_FIFO_OFLOW	0x10
+#define BIT_USER_CTRL_FIFO_EN		0x40
+#define BIT_USER_CTRL_FIFO_RESET	0x04
+#define BITS_FIFO_EN_TEMP		0x80
+#define BITS_FIFO_EN_GYRO		0x70
+#define BITS_FIFO_EN_ACCEL		0x08
 
 #define MPU_WHOAMI_6000			0x68
 #define ICM_WHOAMI_20608		0xaf
@@ -196,6 +203,14 @@
 
 #define MPU6000_ONE_G					9.80665f
 
+/* one FIFO sample holds accel, temperature and gyro, big endian as in the sensor registers */
+#define MPU6000_FIFO_SAMPLE_SIZE			14
+/* the FIFO holds 1024 bytes, one burst drains all complete samples in it */
+#define MPU6000_FIFO_SIZE				1024
+#define MPU6000_FIFO_MAX_SAMPLES			(MPU6000_FIFO_SIZE / MPU6000_FIFO_SAMPLE_SIZE)
+/* default rate at which the FIFO is drained and reports are published */
+#define MPU6000_FIFO_DEFAULT_POLL_RATE			250
+
 #ifdef PX4_SPI_BUS_EXT
 #define EXTERNAL_BUS PX4_SPI_BUS_EXT
 #else
@@ -249,6 +264,15 @@ public:
 	// deliberately cause a sensor error
 	void 			test_error();
 
+	/**
+	 * Enable FIFO burst readout, must be called before init().
+	 *
+	 * All samples buffered in the sensor FIFO are read in one transfer
+	 * per wakeup, filtered and integrated individually and published as
+	 * one report.
+	 */
+	void			enable_fifo() { _fifo_mode = true; }
+
 protected:
 	virtual int		probe();
 
@@ -289,17 +313,13 @@ private:
 	perf_counter_t		_good_transfers;
 	perf_counter_t		_reset_retries;
 	perf_counter_t		_duplicates;
-	perf_counter_t		_controller_latency_perf;
+	perf_counter_t		_fifo_overflows;
 
 	uint8_t			_register_wait;
 	uint64_t		_reset_wait;
 
-	math::LowPassFilter2p	_accel_filter_x;
-	math::LowPassFilter2p	_accel_filter_y;
-	math::LowPassFilter2p	_accel_filter_z;
-	math::LowPassFilter2p	_gyro_filter_x;
-	math::LowPassFilter2p	_gyro_filter_y;
-	math::LowPassFilter2p	_gyro_filter_z;
+	math::BiquadFilterBank<3>	_accel_filter;
+	math::BiquadFilterBank<3>	_gyro_filter;
 
 	Integrator		_accel_int;
 	Integrator		_gyro_int;
@@ -325,6 +345,12 @@ private:
 	uint16_t		_last_accel[3];
 	bool			_got_duplicate;
 
+	// FIFO burst readout
+	bool			_fifo_mode;
+	uint8_t			*_fifo_buffer;
+	math::Vector<3>		*_fifo_accel;	///< scaled samples of one burst, kept off the interrupt stack
+	math::Vector<3>		*_fifo_gyro;
+
 	/**
 	 * Start automatic measurement.
 	 */
@@ -367,6 +393,26 @@ private:
 	 */
 	void			measure();
 
+	/**
+	 * Drain the sensor FIFO and publish one report for all samples.
+	 */
+	void			measure_fifo();
+
+	/**
+	 * Enable the sensor FIFO and discard its content.
+	 */
+	void			reset_fifo();
+
+	/**
+	 * Sample rate the software filters run at.
+	 *
+	 * In FIFO mode every sensor sample is filtered, otherwise one sample per poll.
+	 */
+	float			filter_sample_rate(unsigned call_interval)
+	{
+		return _fifo_mode ? (float)_sample_rate : 1.0e6f / call_interval;
+	}
+
 	/**
 	 * Read a register from the MPU6000
 	 *
@@ -479,6 +525,19 @@ private:
 		uint8_t		gyro_y[2];
 		uint8_t		gyro_z[2];
 	};
+
+	/**
+	 * One sample as stored in the FIFO, same layout as the data registers.
+	 */
+	struct MPUFIFOSample {
+		uint8_t		accel_x[2];
+		uint8_t		accel_y[2];
+		uint8_t		accel_z[2];
+		uint8_t		temp[2];
+		uint8_t		gyro_x[2];
+		uint8_t		gyro_y[2];
+		uint8_t		gyro_z[2];
+	};
 #pragma pack(pop)
 };
 
@@ -561,15 +620,11 @@ MPU6000::MPU6000(int bus, const char *path_accel, const char *path_gyro, spi_dev
 	_good_transfers(perf_alloc(PC_COUNT, "mpu6000_good_transfers")),
 	_reset_retries(perf_alloc(PC_COUNT, "mpu6000_reset_retries")),
 	_duplicates(perf_alloc(PC_COUNT, "mpu6000_duplicates")),
-	_controller_latency_perf(perf_alloc_once(PC_ELAPSED, "ctrl_latency")),
+	_fifo_overflows(perf_alloc(PC_COUNT, "mpu6000_fifo_overflows")),
 	_register_wait(0),
 	_reset_wait(0),
-	_accel_filter_x(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_y(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_z(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_x(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_y(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_z(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
+	_accel_filter(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
+	_gyro_filter(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
 	_accel_int(1000000 / MPU6000_ACCEL_MAX_OUTPUT_RATE),
 	_gyro_int(1000000 / MPU6000_GYRO_MAX_OUTPUT_RATE, true),
 	_rotation(rotation),
@@ -577,7 +632,11 @@ MPU6000::MPU6000(int bus, const char *path_accel, const char *path_gyro, spi_dev
 	_in_factory_test(false),
 	_last_temperature(0),
 	_last_accel{},
-	_got_duplicate(false)
+	_got_duplicate(false),
+	_fifo_mode(false),
+	_fifo_buffer(nullptr),
+	_fifo_accel(nullptr),
+	_fifo_gyro(nullptr)
 {
 	// disable debug() calls
 	_debug_enabled = false;
@@ -624,6 +683,18 @@ MPU6000::~MPU6000()
 		delete _gyro_reports;
 	}
 
+	if (_fifo_buffer != nullptr) {
+		delete[] _fifo_buffer;
+	}
+
+	if (_fifo_accel != nullptr) {
+		delete[] _fifo_accel;
+	}
+
+	if (_fifo_gyro != nullptr) {
+		delete[] _fifo_gyro;
+	}
+
 	if (_accel_class_instance != -1) {
 		unregister_class_devname(ACCEL_BASE_DEVICE_PATH, _accel_class_instance);
 	}
@@ -637,6 +708,7 @@ MPU6000::~MPU6000()
 	perf_free(_good_transfers);
 	perf_free(_reset_retries);
 	perf_free(_duplicates);
+	perf_free(_fifo_overflows);
 }
 
 int
@@ -666,6 +738,21 @@ MPU6000::init()
 		goto out;
 	}
 
+	if (_fifo_mode) {
+		/* command byte followed by the burst of samples */
+		_fifo_buffer = new uint8_t[1 + MPU6000_FIFO_MAX_SAMPLES * MPU6000_FIFO_SAMPLE_SIZE];
+		_fifo_accel = new math::Vector<3>[MPU6000_FIFO_MAX_SAMPLES];
+		_fifo_gyro = new math::Vector<3>[MPU6000_FIFO_MAX_SAMPLES];
+
+		if (_fifo_buffer == nullptr || _fifo_accel == nullptr || _fifo_gyro == nullptr) {
+			goto out;
+		}
+
+		/* the filters see every sensor sample */
+		_accel_filter.set_cutoff_frequency(_sample_rate, _accel_filter.get_cutoff_freq());
+		_gyro_filter.set_cutoff_frequency(_sample_rate, _gyro_filter.get_cutoff_freq());
+	}
+
 	if (reset() != OK) {
 		goto out;
 	}
@@ -801,6 +888,10 @@ int MPU6000::reset()
 		write_checked_reg(MPUREG_ICM_UNDOC1, MPUREG_ICM_UNDOC1_VALUE);
 	}
 
+	if (_fifo_mode) {
+		reset_fifo();
+	}
+
 	// Oscillator set
 	// write_reg(MPUREG_PWR_MGMT_1,MPU_CLK_SEL_PLLGYROZ);
 	usleep(1000);
@@ -1299,7 +1390,8 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 				return ioctl(filp, SENSORIOCSPOLLRATE, 1000);
 
 			case SENSOR_POLLRATE_DEFAULT:
-				return ioctl(filp, SENSORIOCSPOLLRATE, MPU6000_ACCEL_DEFAULT_RATE);
+				return ioctl(filp, SENSORIOCSPOLLRATE,
+					     _fifo_mode ? MPU6000_FIFO_DEFAULT_POLL_RATE : MPU6000_ACCEL_DEFAULT_RATE);
 
 			/* adjust to a legal polling interval in Hz */
 			default: {
@@ -1315,19 +1407,15 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 					}
 
 					// adjust filters
-					float cutoff_freq_hz = _accel_filter_x.get_cutoff_freq();
-					float sample_rate = 1.0e6f / ticks;
+					float cutoff_freq_hz = _accel_filter.get_cutoff_freq();
+					float sample_rate = filter_sample_rate(ticks);
 					_set_dlpf_filter(cutoff_freq_hz);
-					_accel_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
+					_accel_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
 
 
-					float cutoff_freq_hz_gyro = _gyro_filter_x.get_cutoff_freq();
+					float cutoff_freq_hz_gyro = _gyro_filter.get_cutoff_freq();
 					_set_dlpf_filter(cutoff_freq_hz_gyro);
-					_gyro_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
+					_gyro_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
 
 					/* update interval for next measurement */
 					/* XXX this is a bit shady, but no other way to adjust... */
@@ -1387,15 +1475,13 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case ACCELIOCGLOWPASS:
-		return _accel_filter_x.get_cutoff_freq();
+		return _accel_filter.get_cutoff_freq();
 
 	case ACCELIOCSLOWPASS:
 		// set hardware filtering
 		_set_dlpf_filter(arg);
 		// set software filtering
-		_accel_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_accel_filter.set_cutoff_frequency(filter_sample_rate(_call_interval), arg);
 		return OK;
 
 	case ACCELIOCSSCALE: {
@@ -1472,14 +1558,12 @@ MPU6000::gyro_ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case GYROIOCGLOWPASS:
-		return _gyro_filter_x.get_cutoff_freq();
+		return _gyro_filter.get_cutoff_freq();
 
 	case GYROIOCSLOWPASS:
 		// set hardware filtering
 		_set_dlpf_filter(arg);
-		_gyro_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_gyro_filter.set_cutoff_frequency(filter_sample_rate(_call_interval), arg);
 		return OK;
 
 	case GYROIOCSSCALE:
@@ -1741,6 +1825,11 @@ MPU6000::measure()
 		return;
 	}
 
+	if (_fifo_mode) {
+		measure_fifo();
+		return;
+	}
+
 	struct MPUReport mpu_report;
 
 	struct Report {
@@ -1756,6 +1845,9 @@ MPU6000::measure()
 	/* start measuring */
 	perf_begin(_sample_perf);
 
+	/* the timer callout is the time the sample is taken, the bus transfer adds to the driver latency */
+	const hrt_abstime timestamp_sample = hrt_absolute_time();
+
 	/*
 	 * Fetch the full set of measurements from the MPU6000 in one pass.
 	 */
@@ -1857,7 +1949,7 @@ MPU6000::measure()
 	/*
 	 * Adjust and scale results to m/s^2.
 	 */
-	grb.timestamp = arb.timestamp = hrt_absolute_time();
+	grb.timestamp = arb.timestamp = timestamp_sample;
 
 	// report the error count as the sum of the number of bad
 	// transfers and bad register reads. This allows the higher
@@ -1898,9 +1990,11 @@ MPU6000::measure()
 	float y_in_new = ((yraw_f * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
 	float z_in_new = ((zraw_f * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
 
-	arb.x = _accel_filter_x.apply(x_in_new);
-	arb.y = _accel_filter_y.apply(y_in_new);
-	arb.z = _accel_filter_z.apply(z_in_new);
+	float accel_filtered[3] = { x_in_new, y_in_new, z_in_new };
+	_accel_filter.apply(accel_filtered);
+	arb.x = accel_filtered[0];
+	arb.y = accel_filtered[1];
+	arb.z = accel_filtered[2];
 
 	math::Vector<3> aval(x_in_new, y_in_new, z_in_new);
 	math::Vector<3> aval_integrated;
@@ -1938,9 +2032,11 @@ MPU6000::measure()
 	float y_gyro_in_new = ((yraw_f * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
 	float z_gyro_in_new = ((zraw_f * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
 
-	grb.x = _gyro_filter_x.apply(x_gyro_in_new);
-	grb.y = _gyro_filter_y.apply(y_gyro_in_new);
-	grb.z = _gyro_filter_z.apply(z_gyro_in_new);
+	float gyro_filtered[3] = { x_gyro_in_new, y_gyro_in_new, z_gyro_in_new };
+	_gyro_filter.apply(gyro_filtered);
+	grb.x = gyro_filtered[0];
+	grb.y = gyro_filtered[1];
+	grb.z = gyro_filtered[2];
 
 	math::Vector<3> gval(x_gyro_in_new, y_gyro_in_new, z_gyro_in_new);
 	math::Vector<3> gval_integrated;
@@ -1969,8 +2065,6 @@ MPU6000::measure()
 	}
 
 	if (accel_notify && !(_pub_blocked)) {
-		/* log the time of this report */
-		perf_begin(_controller_latency_perf);
 		/* publish it */
 		orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
 	}
@@ -1978,6 +2072,228 @@ MPU6000::measure()
 	if (gyro_notify && !(_pub_blocked)) {
 		/* publish it */
 		orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+		latency_record(LATENCY_STAGE_DRIVER, grb.timestamp);
+	}
+
+	/* stop measuring */
+	perf_end(_sample_perf);
+}
+
+void
+MPU6000::reset_fifo()
+{
+	write_reg(MPUREG_FIFO_EN, 0);
+	modify_reg(MPUREG_USER_CTRL, BIT_USER_CTRL_FIFO_EN, BIT_USER_CTRL_FIFO_RESET);
+	up_udelay(10);
+	write_checked_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_EN);
+	write_reg(MPUREG_FIFO_EN, BITS_FIFO_EN_TEMP | BITS_FIFO_EN_GYRO | BITS_FIFO_EN_ACCEL);
+}
+
+void
+MPU6000::measure_fifo()
+{
+	/* start measuring */
+	perf_begin(_sample_perf);
+
+	/* the timer callout is the time the sample is taken, the bus transfer adds to the driver latency */
+	const hrt_abstime timestamp_sample = hrt_absolute_time();
+
+	// sensor transfer at high clock speed
+	set_frequency(MPU6000_HIGH_BUS_SPEED);
+
+	uint8_t status = read_reg(MPUREG_INT_STATUS, MPU6000_HIGH_BUS_SPEED);
+	uint16_t fifo_bytes = (read_reg(MPUREG_FIFO_COUNTH, MPU6000_HIGH_BUS_SPEED) << 8) |
+			      read_reg(MPUREG_FIFO_COUNTL, MPU6000_HIGH_BUS_SPEED);
+
+	if (status & BIT_INT_STATUS_FIFO_OFLOW) {
+		// samples were lost and the FIFO is no longer aligned to sample boundaries
+		perf_count(_fifo_overflows);
+		reset_fifo();
+		perf_end(_sample_perf);
+		return;
+	}
+
+	unsigned samples = fifo_bytes / MPU6000_FIFO_SAMPLE_SIZE;
+
+	if (samples == 0) {
+		// no new data - wait for next timer
+		perf_end(_sample_perf);
+		perf_count(_duplicates);
+		return;
+	}
+
+	if (samples > MPU6000_FIFO_MAX_SAMPLES) {
+		// the count register can not exceed the FIFO size, this is a bad transfer
+		perf_count(_bad_transfers);
+		reset_fifo();
+		perf_end(_sample_perf);
+		return;
+	}
+
+	_fifo_buffer[0] = DIR_READ | MPUREG_FIFO_R_W;
+
+	if (OK != transfer(_fifo_buffer, _fifo_buffer, 1 + samples * MPU6000_FIFO_SAMPLE_SIZE)) {
+		perf_end(_sample_perf);
+		return;
+	}
+
+	check_registers();
+
+	MPUFIFOSample *fifo = (MPUFIFOSample *)&_fifo_buffer[1];
+
+	float accel_filtered[3];
+	float gyro_filtered[3];
+	int16_t accel_raw[3];
+	int16_t gyro_raw[3];
+	int16_t temp_raw = 0;
+
+	for (unsigned k = 0; k < samples; k++) {
+		/*
+		 * Convert from big to little endian
+		 */
+		int16_t accel_x = int16_t_from_bytes(fifo[k].accel_x);
+		int16_t accel_y = int16_t_from_bytes(fifo[k].accel_y);
+		int16_t accel_z = int16_t_from_bytes(fifo[k].accel_z);
+		int16_t gyro_x = int16_t_from_bytes(fifo[k].gyro_x);
+		int16_t gyro_y = int16_t_from_bytes(fifo[k].gyro_y);
+		int16_t gyro_z = int16_t_from_bytes(fifo[k].gyro_z);
+		temp_raw = int16_t_from_bytes(fifo[k].temp);
+
+		if (accel_x == 0 && accel_y == 0 && accel_z == 0 &&
+		    temp_raw == 0 && gyro_x == 0 && gyro_y == 0 && gyro_z == 0) {
+			// all zero data - probably a SPI bus error, drop the whole burst
+			perf_count(_bad_transfers);
+			perf_end(_sample_perf);
+			return;
+		}
+
+		/*
+		 * Swap axes and negate y
+		 */
+		accel_raw[0] = accel_y;
+		accel_raw[1] = ((accel_x == -32768) ? 32767 : -accel_x);
+		accel_raw[2] = accel_z;
+		gyro_raw[0] = gyro_y;
+		gyro_raw[1] = ((gyro_x == -32768) ? 32767 : -gyro_x);
+		gyro_raw[2] = gyro_z;
+
+		float xraw_f = accel_raw[0];
+		float yraw_f = accel_raw[1];
+		float zraw_f = accel_raw[2];
+
+		// apply user specified rotation
+		rotate_3f(_rotation, xraw_f, yraw_f, zraw_f);
+
+		accel_filtered[0] = ((xraw_f * _accel_range_scale) - _accel_scale.x_offset) * _accel_scale.x_scale;
+		accel_filtered[1] = ((yraw_f * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
+		accel_filtered[2] = ((zraw_f * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
+		_fifo_accel[k] = math::Vector<3>(accel_filtered);
+		_accel_filter.apply(accel_filtered);
+
+		xraw_f = gyro_raw[0];
+		yraw_f = gyro_raw[1];
+		zraw_f = gyro_raw[2];
+
+		rotate_3f(_rotation, xraw_f, yraw_f, zraw_f);
+
+		gyro_filtered[0] = ((xraw_f * _gyro_range_scale) - _gyro_scale.x_offset) * _gyro_scale.x_scale;
+		gyro_filtered[1] = ((yraw_f * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
+		gyro_filtered[2] = ((zraw_f * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
+		_fifo_gyro[k] = math::Vector<3>(gyro_filtered);
+		_gyro_filter.apply(gyro_filtered);
+	}
+
+	perf_count(_good_transfers);
+
+	if (_register_wait != 0) {
+		// we are waiting for some good transfers before using
+		// the sensor again, see measure()
+		_register_wait--;
+		perf_end(_sample_perf);
+		return;
+	}
+
+	/*
+	 * Report buffers, filled from the newest sample of the burst.
+	 */
+	accel_report		arb;
+	gyro_report		grb;
+
+	grb.timestamp = arb.timestamp = timestamp_sample;
+	grb.error_count = arb.error_count = perf_event_count(_bad_transfers) + perf_event_count(_bad_registers);
+
+	const uint64_t sample_interval = 1000000 / _sample_rate;
+
+	arb.x_raw = accel_raw[0];
+	arb.y_raw = accel_raw[1];
+	arb.z_raw = accel_raw[2];
+	arb.x = accel_filtered[0];
+	arb.y = accel_filtered[1];
+	arb.z = accel_filtered[2];
+
+	math::Vector<3> aval_integrated;
+
+	bool accel_notify = _accel_int.put_batch(arb.timestamp, _fifo_accel, samples, sample_interval,
+			    aval_integrated, arb.integral_dt);
+	arb.x_integral = aval_integrated(0);
+	arb.y_integral = aval_integrated(1);
+	arb.z_integral = aval_integrated(2);
+
+	arb.scaling = _accel_range_scale;
+	arb.range_m_s2 = _accel_range_m_s2;
+
+	if (is_icm_device()) { // if it is an ICM20608
+		_last_temperature = temp_raw / 326.8f + 25.0f;
+
+	} else { // If it is an MPU6000
+		_last_temperature = temp_raw / 361.0f + 35.0f;
+	}
+
+	arb.temperature_raw = temp_raw;
+	arb.temperature = _last_temperature;
+
+	grb.x_raw = gyro_raw[0];
+	grb.y_raw = gyro_raw[1];
+	grb.z_raw = gyro_raw[2];
+	grb.x = gyro_filtered[0];
+	grb.y = gyro_filtered[1];
+	grb.z = gyro_filtered[2];
+
+	math::Vector<3> gval_integrated;
+
+	bool gyro_notify = _gyro_int.put_batch(arb.timestamp, _fifo_gyro, samples, sample_interval,
+					       gval_integrated, grb.integral_dt);
+	grb.x_integral = gval_integrated(0);
+	grb.y_integral = gval_integrated(1);
+	grb.z_integral = gval_integrated(2);
+
+	grb.scaling = _gyro_range_scale;
+	grb.range_rad_s = _gyro_range_rad_s;
+
+	grb.temperature_raw = temp_raw;
+	grb.temperature = _last_temperature;
+
+	_accel_reports->force(&arb);
+	_gyro_reports->force(&grb);
+
+	/* notify anyone waiting for data */
+	if (accel_notify) {
+		poll_notify(POLLIN);
+	}
+
+	if (gyro_notify) {
+		_gyro->parent_poll_notify();
+	}
+
+	if (accel_notify && !(_pub_blocked)) {
+		/* publish it */
+		orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
+	}
+
+	if (gyro_notify && !(_pub_blocked)) {
+		/* publish it */
+		orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+		latency_record(LATENCY_STAGE_DRIVER, grb.timestamp);
 	}
 
 	/* stop measuring */
@@ -1995,6 +2311,8 @@ MPU6000::print_info()
 	perf_print_counter(_good_transfers);
 	perf_print_counter(_reset_retries);
 	perf_print_counter(_duplicates);
+	perf_print_counter(_fifo_overflows);
+	::printf("fifo mode: %s\n", _fifo_mode ? "on" : "off");
 	_accel_reports->print_info("accel queue");
 	_gyro_reports->print_info("gyro queue");
 	::printf("checked_next: %u\n", _checked_next);
@@ -2101,7 +2419,7 @@ namespace mpu6000
 MPU6000	*g_dev_int; // on internal bus
 MPU6000	*g_dev_ext; // on external bus
 
-void	start(bool, enum Rotation, int range, int device_type);
+void	start(bool, enum Rotation, int range, int device_type, bool fifo);
 void	stop(bool);
 void	test(bool);
 void	reset(bool);
@@ -2118,7 +2436,7 @@ void	usage();
  * or failed to detect the sensor.
  */
 void
-start(bool external_bus, enum Rotation rotation, int range, int device_type)
+start(bool external_bus, enum Rotation rotation, int range, int device_type, bool fifo)
 {
 	int fd;
 	MPU6000 **g_dev_ptr = external_bus ? &g_dev_ext : &g_dev_int;
@@ -2157,6 +2475,10 @@ start(bool external_bus, enum Rotation rotation, int range, int device_type)
 		goto fail;
 	}
 
+	if (fifo) {
+		(*g_dev_ptr)->enable_fifo();
+	}
+
 	if (OK != (*g_dev_ptr)->init()) {
 		goto fail;
 	}
@@ -2397,6 +2719,7 @@ usage()
 	warnx("    -M 6000|20608 (default 6000)");
 	warnx("    -R rotation");
 	warnx("    -a accel range (in g)");
+	warnx("    -f    (FIFO burst readout)");
 }
 
 } // namespace
@@ -2409,9 +2732,10 @@ mpu6000_main(int argc, char *argv[])
 	int ch;
 	enum Rotation rotation = ROTATION_NONE;
 	int accel_range = 8;
+	bool fifo = false;
 
 	/* jump over start/off/etc and look at options first */
-	while ((ch = getopt(argc, argv, "T:XR:a:")) != EOF) {
+	while ((ch = getopt(argc, argv, "T:XR:a:f")) != EOF) {
 		switch (ch) {
 		case 'X':
 			external_bus = true;
@@ -2429,6 +2753,10 @@ mpu6000_main(int argc, char *argv[])
 			accel_range = atoi(optarg);
 			break;
 
+		case 'f':
+			fifo = true;
+			break;
+
 		default:
 			mpu6000::usage();
 			exit(0);
@@ -2442,7 +2770,7 @@ mpu6000_main(int argc, char *argv[])
 
 	 */
 	if (!strcmp(verb, "start")) {
-		mpu6000::start(external_bus, rotation, accel_range, device_type);
+		mpu6000::start(external_bus, rotation, accel_range, device_type, fifo);
 	}
 
 	if (!strcmp(verb, "stop")) {
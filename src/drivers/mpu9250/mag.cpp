@@ -61,7 +61,7 @@
 #include <drivers/drv_accel.h>
 #include <drivers/drv_gyro.h>
 #include <drivers/drv_mag.h>
-#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/BiquadFilterBank.hpp>
 #include <lib/conversion/rotation.h>
 
 #include "mag.h"
@@ -59,6 +59,7 @@
 #include <getopt.h>
 
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
 #include <systemlib/err.h>
 #include <systemlib/conversions.h>
 
@@ -74,7 +75,7 @@
 #include <drivers/drv_accel.h>
 #include <drivers/drv_gyro.h>
 #include <drivers/drv_mag.h>
-#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/BiquadFilterBank.hpp>
 #include <lib/conversion/rotation.h>
 
 #include "mag.h"
@@ -242,15 +243,10 @@ MPU9250::MPU9250(int bus, const char *path_accel, const char *path_gyro, const c
 	_good_transfers(perf_alloc(PC_COUNT, "mpu9250_good_transfers")),
 	_reset_retries(perf_alloc(PC_COUNT, "mpu9250_reset_retries")),
 	_duplicates(perf_alloc(PC_COUNT, "mpu9250_duplicates")),
-	_controller_latency_perf(perf_alloc_once(PC_ELAPSED, "ctrl_latency")),
 	_register_wait(0),
 	_reset_wait(0),
-	_accel_filter_x(MPU9250_ACCEL_DEFAULT_RATE, MPU9250_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_y(MPU9250_ACCEL_DEFAULT_RATE, MPU9250_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_z(MPU9250_ACCEL_DEFAULT_RATE, MPU9250_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_x(MPU9250_GYRO_DEFAULT_RATE, MPU9250_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_y(MPU9250_GYRO_DEFAULT_RATE, MPU9250_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_z(MPU9250_GYRO_DEFAULT_RATE, MPU9250_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
+	_accel_filter(MPU9250_ACCEL_DEFAULT_RATE, MPU9250_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
+	_gyro_filter(MPU9250_GYRO_DEFAULT_RATE, MPU9250_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
 	_accel_int(1000000 / MPU9250_ACCEL_MAX_OUTPUT_RATE),
 	_gyro_int(1000000 / MPU9250_GYRO_MAX_OUTPUT_RATE, true),
 	_rotation(rotation),
@@ -827,19 +823,15 @@ MPU9250::ioctl(struct file *filp, int cmd, unsigned long arg)
 					}
 
 					// adjust filters
-					float cutoff_freq_hz = _accel_filter_x.get_cutoff_freq();
+					float cutoff_freq_hz = _accel_filter.get_cutoff_freq();
 					float sample_rate = 1.0e6f / ticks;
 					_set_dlpf_filter(cutoff_freq_hz);
-					_accel_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
+					_accel_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
 
 
-					float cutoff_freq_hz_gyro = _gyro_filter_x.get_cutoff_freq();
+					float cutoff_freq_hz_gyro = _gyro_filter.get_cutoff_freq();
 					_set_dlpf_filter(cutoff_freq_hz_gyro);
-					_gyro_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
+					_gyro_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
 
 					/* update interval for next measurement */
 					/* XXX this is a bit shady, but no other way to adjust... */
@@ -899,13 +891,11 @@ MPU9250::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case ACCELIOCGLOWPASS:
-		return _accel_filter_x.get_cutoff_freq();
+		return _accel_filter.get_cutoff_freq();
 
 	case ACCELIOCSLOWPASS:
 		// set software filtering
-		_accel_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_accel_filter.set_cutoff_frequency(1.0e6f / _call_interval, arg);
 		return OK;
 
 	case ACCELIOCSSCALE: {
@@ -995,13 +985,11 @@ MPU9250::gyro_ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case GYROIOCGLOWPASS:
-		return _gyro_filter_x.get_cutoff_freq();
+		return _gyro_filter.get_cutoff_freq();
 
 	case GYROIOCSLOWPASS:
 		// set software filtering
-		_gyro_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_gyro_filter.set_cutoff_frequency(1.0e6f / _call_interval, arg);
 		return OK;
 
 	case GYROIOCSSCALE:
@@ -1303,6 +1291,9 @@ MPU9250::measure()
 	/* start measuring */
 	perf_begin(_sample_perf);
 
+	/* the timer callout is the time the sample is taken, the bus transfer adds to the driver latency */
+	const hrt_abstime timestamp_sample = hrt_absolute_time();
+
 	/*
 	 * Fetch the full set of measurements from the MPU9250 in one pass.
 	 */
@@ -1371,7 +1362,7 @@ MPU9250::measure()
 	/*
 	 * Adjust and scale results to m/s^2.
 	 */
-	grb.timestamp = arb.timestamp = hrt_absolute_time();
+	grb.timestamp = arb.timestamp = timestamp_sample;
 
 	// report the error count as the sum of the number of bad
 	// transfers and bad register reads. This allows the higher
@@ -1411,9 +1402,11 @@ MPU9250::measure()
 	float y_in_new = ((yraw_f * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
 	float z_in_new = ((zraw_f * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
 
-	arb.x = _accel_filter_x.apply(x_in_new);
-	arb.y = _accel_filter_y.apply(y_in_new);
-	arb.z = _accel_filter_z.apply(z_in_new);
+	float accel_filtered[3] = { x_in_new, y_in_new, z_in_new };
+	_accel_filter.apply(accel_filtered);
+	arb.x = accel_filtered[0];
+	arb.y = accel_filtered[1];
+	arb.z = accel_filtered[2];
 
 	math::Vector<3> aval(x_in_new, y_in_new, z_in_new);
 	math::Vector<3> aval_integrated;
@@ -1446,9 +1439,11 @@ MPU9250::measure()
 	float y_gyro_in_new = ((yraw_f * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
 	float z_gyro_in_new = ((zraw_f * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
 
-	grb.x = _gyro_filter_x.apply(x_gyro_in_new);
-	grb.y = _gyro_filter_y.apply(y_gyro_in_new);
-	grb.z = _gyro_filter_z.apply(z_gyro_in_new);
+	float gyro_filtered[3] = { x_gyro_in_new, y_gyro_in_new, z_gyro_in_new };
+	_gyro_filter.apply(gyro_filtered);
+	grb.x = gyro_filtered[0];
+	grb.y = gyro_filtered[1];
+	grb.z = gyro_filtered[2];
 
 	math::Vector<3> gval(x_gyro_in_new, y_gyro_in_new, z_gyro_in_new);
 	math::Vector<3> gval_integrated;
@@ -1477,8 +1472,6 @@ MPU9250::measure()
 	}
 
 	if (accel_notify && !(_pub_blocked)) {
-		/* log the time of this report */
-		perf_begin(_controller_latency_perf);
 		/* publish it */
 		orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
 	}
@@ -1486,6 +1479,7 @@ MPU9250::measure()
 	if (gyro_notify && !(_pub_blocked)) {
 		/* publish it */
 		orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+		latency_record(LATENCY_STAGE_DRIVER, grb.timestamp);
 	}
 
 	/* stop measuring */
@@ -75,6 +75,9 @@
 
 #include <systemlib/systemlib.h>
 #include <systemlib/mixer/mixer.h>
+#include <systemlib/latency.h>
+#include <systemlib/pipeline.h>
+#include <systemlib/perf_counter.h>
 
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/actuator_controls_0.h>
@@ -137,10 +140,24 @@ private:
 
 	actuator_controls_s _controls[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
 	orb_id_t	_control_topics[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
+	perf_counter_t	_control_latency_perf[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
 
 	static void	task_main_trampoline(int argc, char *argv[]);
 	void		task_main();
 
+	/**
+	 * Run by the sensors task in the pipeline mode.
+	 */
+	static void	pipeline_trampoline(void *arg);
+	volatile bool	_pipeline_unsubscribed;
+
+	/**
+	 * Mix and publish the outputs if new controls arrived.
+	 */
+	void		cycle();
+	void		update_subscriptions();
+	void		unsubscribe();
+
 	static int	control_callback(uintptr_t handle,
 					 uint8_t control_group,
 					 uint8_t control_index,
@@ -196,6 +213,7 @@ PWMSim::PWMSim() :
 	_groups_required(0),
 	_groups_subscribed(0),
 	_task_should_exit(false),
+	_pipeline_unsubscribed(false),
 	_mixers(nullptr)
 {
 	_debug_enabled = true;
@@ -205,6 +223,18 @@ PWMSim::PWMSim() :
 	_control_topics[1] = ORB_ID(actuator_controls_1);
 	_control_topics[2] = ORB_ID(actuator_controls_2);
 	_control_topics[3] = ORB_ID(actuator_controls_3);
+
+	/* from the controls timestamp of a group to the output publication */
+	static const char *const control_latency_names[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS] = {
+		"pwm_out_sim control 0 latency",
+		"pwm_out_sim control 1 latency",
+		"pwm_out_sim control 2 latency",
+		"pwm_out_sim control 3 latency"
+	};
+
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		_control_latency_perf[i] = perf_alloc(PC_HISTOGRAM, control_latency_names[i]);
+	}
 }
 
 PWMSim::~PWMSim()
@@ -228,6 +258,10 @@ PWMSim::~PWMSim()
 		} while (_task != -1);
 	}
 
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		perf_free(_control_latency_perf[i]);
+	}
+
 	g_pwm_sim = nullptr;
 }
 
@@ -380,8 +414,6 @@ PWMSim::task_main()
 	/* force a reset of the update rate */
 	_current_update_rate = 0;
 
-	_armed_sub = orb_subscribe(ORB_ID(actuator_armed));
-
 	/* advertise the mixed control outputs */
 	actuator_outputs_s outputs;
 	memset(&outputs, 0, sizeof(outputs));
@@ -389,32 +421,34 @@ PWMSim::task_main()
 	/* advertise the mixed control outputs, insist on the first group output */
 	_outputs_pub = orb_advertise(ORB_ID(actuator_outputs), &outputs);
 
+	if (pipeline_enabled()) {
+		/* the sensors task mixes, this task only waits for the stop */
+		if (pipeline_register(PIPELINE_STAGE_OUTPUT, "pwm_out_sim", &PWMSim::pipeline_trampoline, this) == 0) {
+			while (!_task_should_exit) {
+				usleep(100000);
+			}
 
-	/* loop until killed */
-	while (!_task_should_exit) {
+			/* the subscriptions belong to the sensors task, let the next cycle close them */
+			for (unsigned i = 0; i < 10 && !_pipeline_unsubscribed; i++) {
+				usleep(10000);
+			}
+
+			pipeline_unregister(PIPELINE_STAGE_OUTPUT);
 
-		if (_groups_subscribed != _groups_required) {
-			subscribe();
-			_groups_subscribed = _groups_required;
+		} else {
+			PX4_WARN("pipeline stage taken");
 		}
 
-		/* handle update rate changes */
-		if (_current_update_rate != _update_rate) {
-			int update_rate_in_ms = int(1000 / _update_rate);
+		_task = -1;
+		return;
+	}
 
-			if (update_rate_in_ms < 2) {
-				update_rate_in_ms = 2;
-			}
+	_armed_sub = orb_subscribe(ORB_ID(actuator_armed));
 
-			for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
-				if (_control_subs[i] > 0) {
-					orb_set_interval(_control_subs[i], update_rate_in_ms);
-				}
-			}
+	/* loop until killed */
+	while (!_task_should_exit) {
 
-			// up_pwm_servo_set_rate(_update_rate);
-			_current_update_rate = _update_rate;
-		}
+		update_subscriptions();
 
 		/* sleep waiting for data, but no more than a second */
 		int ret = 0;
@@ -428,7 +462,8 @@ PWMSim::task_main()
 			}
 
 		} else {
-			ret = px4_poll(&_poll_fds[0], _poll_fds_num, 1000);
+			/* woken by the controls, the timeout keeps the arming state up to date without them */
+			ret = px4_poll(&_poll_fds[0], _poll_fds_num, 100);
 		}
 
 		/* this would be bad... */
@@ -437,116 +472,187 @@ PWMSim::task_main()
 			continue;
 		}
 
-		if (ret == 0) {
-			// timeout
-			continue;
+		cycle();
+	}
+
+	unsubscribe();
+
+	/* make sure servos are off */
+	// up_pwm_servo_deinit();
+
+	/* note - someone else is responsible for restoring the GPIO config */
+
+	/* tell the dtor that we are exiting */
+	_task = -1;
+}
+
+void
+PWMSim::pipeline_trampoline(void *arg)
+{
+	PWMSim *sim = (PWMSim *)arg;
+
+	if (sim->_task_should_exit) {
+		if (!sim->_pipeline_unsubscribed) {
+			sim->unsubscribe();
+			sim->_pipeline_unsubscribed = true;
 		}
 
-		/* get controls for required topics */
-		unsigned poll_id = 0;
+		return;
+	}
+
+	/* the subscriptions have to belong to the task running the pipeline */
+	if (sim->_armed_sub < 0) {
+		sim->_armed_sub = orb_subscribe(ORB_ID(actuator_armed));
+	}
+
+	sim->update_subscriptions();
+	sim->cycle();
+}
+
+void
+PWMSim::update_subscriptions()
+{
+	if (_groups_subscribed != _groups_required) {
+		subscribe();
+		_groups_subscribed = _groups_required;
+	}
+
+	/* handle update rate changes */
+	if (_current_update_rate != _update_rate) {
+		int update_rate_in_ms = int(1000 / _update_rate);
+
+		if (update_rate_in_ms < 2) {
+			update_rate_in_ms = 2;
+		}
 
 		for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
 			if (_control_subs[i] > 0) {
-				if (_poll_fds[poll_id].revents & POLLIN) {
-					orb_copy(_control_topics[i], _control_subs[i], &_controls[i]);
-				}
-
-				poll_id++;
+				orb_set_interval(_control_subs[i], update_rate_in_ms);
 			}
 		}
 
-		/* can we mix? */
-		if (_armed && _mixers != nullptr) {
-
-			size_t num_outputs;
+		// up_pwm_servo_set_rate(_update_rate);
+		_current_update_rate = _update_rate;
+	}
+}
 
-			switch (_mode) {
-			case MODE_2PWM:
-				num_outputs = 2;
-				break;
+void
+PWMSim::unsubscribe()
+{
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		if (_control_subs[i] > 0) {
+			px4_close(_control_subs[i]);
+			_control_subs[i] = -1;
+		}
+	}
 
-			case MODE_4PWM:
-				num_outputs = 4;
-				break;
+	px4_close(_armed_sub);
+	_armed_sub = -1;
+}
 
-			case MODE_6PWM:
-				num_outputs = 6;
-				break;
+void
+PWMSim::cycle()
+{
+	/* get controls for required topics */
+	uint32_t groups_updated = 0;
 
-			case MODE_8PWM:
-				num_outputs = 8;
-				break;
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		if (_control_subs[i] > 0) {
+			bool group_updated = false;
+			orb_check(_control_subs[i], &group_updated);
 
-			default:
-				num_outputs = 0;
-				break;
+			if (group_updated) {
+				orb_copy(_control_topics[i], _control_subs[i], &_controls[i]);
+				groups_updated |= (1 << i);
 			}
+		}
+	}
 
-			/* do mixing */
-			actuator_outputs_s outputs = {};
-			num_outputs = _mixers->mix(&outputs.output[0], num_outputs, NULL);
-			outputs.noutputs = num_outputs;
-			outputs.timestamp = hrt_absolute_time();
+	/* can we mix? */
+	if (groups_updated != 0 && _armed && _mixers != nullptr) {
 
-			/* disable unused ports by setting their output to NaN */
-			for (size_t i = 0; i < sizeof(outputs.output) / sizeof(outputs.output[0]); i++) {
-				if (i >= num_outputs) {
-					outputs.output[i] = NAN;
-				}
-			}
+		size_t num_outputs;
 
-			/* iterate actuators */
-			for (unsigned i = 0; i < num_outputs; i++) {
-				/* last resort: catch NaN, INF and out-of-band errors */
-				if (i < outputs.noutputs &&
-				    PX4_ISFINITE(outputs.output[i]) &&
-				    outputs.output[i] >= -1.0f &&
-				    outputs.output[i] <= 1.0f) {
-					/* scale for PWM output 1000 - 2000us */
-					outputs.output[i] = 1500 + (500 * outputs.output[i]);
+		switch (_mode) {
+		case MODE_2PWM:
+			num_outputs = 2;
+			break;
 
-				} else {
-					/*
-					 * Value is NaN, INF or out of band - set to the minimum value.
-					 * This will be clearly visible on the servo status and will limit the risk of accidentally
-					 * spinning motors. It would be deadly in flight.
-					 */
-					outputs.output[i] = 900;
-				}
-			}
+		case MODE_4PWM:
+			num_outputs = 4;
+			break;
 
+		case MODE_6PWM:
+			num_outputs = 6;
+			break;
 
-			/* and publish for anyone that cares to see */
-			orb_publish(ORB_ID(actuator_outputs), _outputs_pub, &outputs);
-		}
+		case MODE_8PWM:
+			num_outputs = 8;
+			break;
 
-		/* how about an arming update? */
-		bool updated;
-		actuator_armed_s aa;
-		orb_check(_armed_sub, &updated);
+		default:
+			num_outputs = 0;
+			break;
+		}
 
-		if (updated) {
-			orb_copy(ORB_ID(actuator_armed), _armed_sub, &aa);
-			/* do not obey the lockdown value, as lockdown is for PWMSim */
-			_armed = aa.armed;
+		/* do mixing */
+		actuator_outputs_s outputs = {};
+		num_outputs = _mixers->mix(&outputs.output[0], num_outputs, NULL);
+		outputs.noutputs = num_outputs;
+		outputs.timestamp = hrt_absolute_time();
+		outputs.timestamp_sample = _controls[0].timestamp_sample;
+
+		/* disable unused ports by setting their output to NaN */
+		for (size_t i = 0; i < sizeof(outputs.output) / sizeof(outputs.output[0]); i++) {
+			if (i >= num_outputs) {
+				outputs.output[i] = NAN;
+			}
 		}
-	}
 
-	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
-		if (_control_subs[i] > 0) {
-			px4_close(_control_subs[i]);
+		/* iterate actuators */
+		for (unsigned i = 0; i < num_outputs; i++) {
+			/* last resort: catch NaN, INF and out-of-band errors */
+			if (i < outputs.noutputs &&
+			    PX4_ISFINITE(outputs.output[i]) &&
+			    outputs.output[i] >= -1.0f &&
+			    outputs.output[i] <= 1.0f) {
+				/* scale for PWM output 1000 - 2000us */
+				outputs.output[i] = 1500 + (500 * outputs.output[i]);
+
+			} else {
+				/*
+				 * Value is NaN, INF or out of band - set to the minimum value.
+				 * This will be clearly visible on the servo status and will limit the risk of accidentally
+				 * spinning motors. It would be deadly in flight.
+				 */
+				outputs.output[i] = 900;
+			}
 		}
-	}
 
-	px4_close(_armed_sub);
 
-	/* make sure servos are off */
-	// up_pwm_servo_deinit();
+		/* and publish for anyone that cares to see */
+		orb_publish(ORB_ID(actuator_outputs), _outputs_pub, &outputs);
+		latency_record(LATENCY_STAGE_OUTPUT, outputs.timestamp_sample);
 
-	/* note - someone else is responsible for restoring the GPIO config */
+		hrt_abstime now = hrt_absolute_time();
 
-	/* tell the dtor that we are exiting */
-	_task = -1;
+		for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+			if (groups_updated & (1 << i)) {
+				perf_set(_control_latency_perf[i], now - _controls[i].timestamp);
+			}
+		}
+	}
+
+	/* how about an arming update? */
+	bool updated;
+	actuator_armed_s aa;
+	orb_check(_armed_sub, &updated);
+
+	if (updated) {
+		orb_copy(ORB_ID(actuator_armed), _armed_sub, &aa);
+		/* do not obey the lockdown value, as lockdown is for PWMSim */
+		_armed = aa.armed;
+	}
 }
 
 int
@@ -38,6 +38,7 @@
  */
 
 #include <px4_config.h>
+#include <px4_tasks.h>
 
 #include <sys/types.h>
 #include <stdint.h>
@@ -69,14 +70,15 @@
 #include <systemlib/pwm_limit/pwm_limit.h>
 #include <systemlib/board_serial.h>
 #include <systemlib/param/param.h>
+#include <systemlib/latency.h>
+#include <systemlib/perf_counter.h>
 #include <drivers/drv_mixer.h>
 #include <drivers/drv_rc_input.h>
 #include <drivers/drv_input_capture.h>
 
 #include <lib/rc/sbus.h>
 #include <lib/rc/dsm.h>
-#include <lib/rc/st24.h>
-#include <lib/rc/sumd.h>
+#include <lib/rc/rc_decoder.h>
 
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/actuator_controls_0.h>
@@ -95,7 +97,7 @@
 
 #include <systemlib/circuit_breaker.h>
 
-#define SCHEDULE_INTERVAL	2000	/**< The schedule interval in usec (500 Hz) */
+#define SCHEDULE_INTERVAL	2000	/**< Longest wait for actuator controls in usec, RC input and safety run at least this often */
 #define NAN_VALUE	(0.0f/0.0f)		/**< NaN value for throttle lock mode */
 #define BUTTON_SAFETY	stm32_gpioread(GPIO_BTN_SAFETY)
 #define CYCLE_COUNT 10			/* safety switch must be held for 1 second to activate */
@@ -141,6 +143,8 @@ public:
 
 	static int	set_i2c_bus_clock(unsigned bus, unsigned clock_hz);
 
+	void		print_rc_status();
+
 	static void	capture_trampoline(void *context, uint32_t chan_index,
 					   hrt_abstime edge_time, uint32_t edge_state,
 					   uint32_t overflow);
@@ -149,18 +153,14 @@ private:
 	enum RC_SCAN {
 		RC_SCAN_PPM = 0,
 		RC_SCAN_SBUS,
-		RC_SCAN_DSM,
-		RC_SCAN_SUMD,
-		RC_SCAN_ST24
+		RC_SCAN_DSM	///< DSM, ST24 and SUMD, detected in parallel
 	};
 	enum RC_SCAN _rc_scan_state = RC_SCAN_SBUS;
 
-	char const *RC_SCAN_STRING[5] = {
+	char const *RC_SCAN_STRING[3] = {
 		"PPM",
 		"SBUS",
-		"DSM",
-		"SUMD",
-		"ST24"
+		"DSM"
 	};
 
 	hrt_abstime _rc_scan_begin = 0;
@@ -177,7 +177,8 @@ private:
 	unsigned	_pwm_alt_rate;
 	uint32_t	_pwm_alt_rate_channels;
 	unsigned	_current_update_rate;
-	struct work_s	_work;
+	int		_task;
+	volatile bool	_task_should_exit;
 	int		_armed_sub;
 	int		_param_sub;
 	struct rc_input_values	_rc_in;
@@ -187,6 +188,7 @@ private:
 	int		_class_instance;
 	int		_rcs_fd;
 	uint8_t _rcs_buf[SBUS_FRAME_SIZE];
+	struct rc_decoder _rc_decoder;
 
 	volatile bool	_initialized;
 	bool		_throttle_armed;
@@ -203,6 +205,7 @@ private:
 	orb_id_t	_control_topics[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
 	pollfd	_poll_fds[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
 	unsigned	_poll_fds_num;
+	perf_counter_t	_control_latency_perf[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS];
 
 	static pwm_limit_t	_pwm_limit;
 	static actuator_armed_s	_armed;
@@ -218,10 +221,9 @@ private:
 
 	static bool	arm_nothrottle() { return (_armed.prearmed && !_armed.armed); }
 
-	static void	cycle_trampoline(void *arg);
+	static void	task_main_trampoline(int argc, char *argv[]);
+	void		task_main();
 	void		cycle();
-	void		work_start();
-	void		work_stop();
 
 	static int	control_callback(uintptr_t handle,
 					 uint8_t control_group,
@@ -265,6 +267,7 @@ private:
 			unsigned frame_drops, int rssi);
 	void dsm_bind_ioctl(int dsmMode);
 	void set_rc_scan_state(RC_SCAN _rc_scan_state);
+	bool rc_decoder_update(int newBytes);
 	void rc_io_invert();
 	void rc_io_invert(bool invert);
 	void safety_check_button(void);
@@ -341,7 +344,8 @@ PX4FMU::PX4FMU() :
 	_pwm_alt_rate(50),
 	_pwm_alt_rate_channels(0),
 	_current_update_rate(0),
-	_work{},
+	_task(-1),
+	_task_should_exit(false),
 	_armed_sub(-1),
 	_param_sub(-1),
 	_rc_in{},
@@ -378,11 +382,24 @@ PX4FMU::PX4FMU() :
 	_control_topics[2] = ORB_ID(actuator_controls_2);
 	_control_topics[3] = ORB_ID(actuator_controls_3);
 
+	/* from the controls timestamp of a group to the PWM update */
+	static const char *const control_latency_names[actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS] = {
+		"fmu control 0 latency",
+		"fmu control 1 latency",
+		"fmu control 2 latency",
+		"fmu control 3 latency"
+	};
+
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		_control_latency_perf[i] = perf_alloc(PC_HISTOGRAM, control_latency_names[i]);
+	}
+
 	memset(_controls, 0, sizeof(_controls));
 	memset(_poll_fds, 0, sizeof(_poll_fds));
 
 	// rc input, published to ORB
 	memset(&_rc_in, 0, sizeof(_rc_in));
+	rc_decoder_init(&_rc_decoder, 0);
 	_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_PPM;
 
 #ifdef GPIO_SBUS_INV
@@ -401,18 +418,27 @@ PX4FMU::PX4FMU() :
 
 PX4FMU::~PX4FMU()
 {
-	if (_initialized) {
+	if (_task != -1) {
 		/* tell the task we want it to go away */
-		work_stop();
+		_task_should_exit = true;
 
 		int i = 10;
 
 		do {
-			/* wait 50ms - it should wake every 100ms or so worst-case */
+			/* wait 50ms - it should wake every 2ms worst-case */
 			usleep(50000);
-			i--;
 
-		} while (_initialized && i > 0);
+			/* if we have given up, kill it */
+			if (--i == 0) {
+				px4_task_delete(_task);
+				break;
+			}
+
+		} while (_task != -1);
+	}
+
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		perf_free(_control_latency_perf[i]);
 	}
 
 	/* clean up the alternate device node */
@@ -426,7 +452,7 @@ PX4FMU::init()
 {
 	int ret;
 
-	ASSERT(!_initialized);
+	ASSERT(_task == -1);
 
 	/* do regular cdev init */
 	ret = CDev::init();
@@ -444,7 +470,19 @@ PX4FMU::init()
 		warnx("FAILED registering class device");
 	}
 
-	work_start();
+	/* above the controllers, so a new actuator_controls publication is written out right away */
+	_task = px4_task_spawn_cmd("fmu",
+				   SCHED_DEFAULT,
+				   SCHED_PRIORITY_MAX - 4,
+				   1600,
+				   (px4_main_t)&PX4FMU::task_main_trampoline,
+				   nullptr);
+
+	if (_task < 0) {
+		_task = -1;
+		DEVICE_DEBUG("task start failed: %d", errno);
+		return -errno;
+	}
 
 	return OK;
 }
@@ -757,6 +795,7 @@ PX4FMU::publish_pwm_outputs(uint16_t *values, size_t numvalues)
 	actuator_outputs_s outputs = {};
 	outputs.noutputs = numvalues;
 	outputs.timestamp = hrt_absolute_time();
+	outputs.timestamp_sample = _controls[0].timestamp_sample;
 
 	for (size_t i = 0; i < _max_actuators; ++i) {
 		outputs.output[i] = i < numvalues ? (float)values[i] : 0;
@@ -769,22 +808,44 @@ PX4FMU::publish_pwm_outputs(uint16_t *values, size_t numvalues)
 	} else {
 		orb_publish(ORB_ID(actuator_outputs), _outputs_pub, &outputs);
 	}
+
+	latency_record(LATENCY_STAGE_OUTPUT, outputs.timestamp_sample);
 }
 
 
 void
-PX4FMU::work_start()
+PX4FMU::task_main_trampoline(int argc, char *argv[])
 {
-	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&PX4FMU::cycle_trampoline, this, 0);
+	g_fmu->task_main();
 }
 
 void
-PX4FMU::cycle_trampoline(void *arg)
+PX4FMU::task_main()
 {
-	PX4FMU *dev = reinterpret_cast<PX4FMU *>(arg);
+	while (!_task_should_exit) {
+		cycle();
+	}
+
+	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+		if (_control_subs[i] > 0) {
+			::close(_control_subs[i]);
+			_control_subs[i] = -1;
+		}
+	}
+
+	::close(_armed_sub);
+	::close(_param_sub);
+
+	/* make sure servos are off */
+	up_pwm_servo_deinit();
 
-	dev->cycle();
+	DEVICE_LOG("stopping");
+
+	/* note - someone else is responsible for restoring the GPIO config */
+
+	/* tell the dtor that we are exiting */
+	_initialized = false;
+	_task = -1;
 }
 
 void
@@ -846,6 +907,52 @@ void PX4FMU::set_rc_scan_state(RC_SCAN newState)
 	_rc_scan_state = newState;
 }
 
+void PX4FMU::print_rc_status()
+{
+	warnx("RC scan: %s%s", RC_SCAN_STRING[_rc_scan_state], _rc_scan_locked ? " (locked)" : "");
+	rc_decoder_print_status(&_rc_decoder);
+}
+
+bool PX4FMU::rc_decoder_update(int newBytes)
+{
+	if (newBytes <= 0
+	    || !rc_decoder_parse(&_rc_decoder, _cycle_timestamp, &_rcs_buf[0], newBytes)) {
+		return false;
+	}
+
+	switch (_rc_decoder.source) {
+	case RC_DECODER_PROTO_SBUS:
+		_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_SBUS;
+		break;
+
+	case RC_DECODER_PROTO_DSM:
+		_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_DSM;
+		break;
+
+	case RC_DECODER_PROTO_ST24:
+		_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_ST24;
+		break;
+
+	case RC_DECODER_PROTO_SUMD:
+		_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_SUMD;
+		break;
+
+	default:
+		return false;
+	}
+
+	fill_rc_in(_rc_decoder.num_values, _rc_decoder.values, _cycle_timestamp,
+		   _rc_decoder.frame_drop, _rc_decoder.failsafe,
+		   _rc_decoder.stats[_rc_decoder.source].errors, _rc_decoder.rssi);
+
+	/* a provisional frame is published, but the scan continues until the protocol locks */
+	if (!_rc_decoder.provisional) {
+		_rc_scan_locked = true;
+	}
+
+	return true;
+}
+
 void PX4FMU::rc_io_invert(bool invert)
 {
 	INVERT_RC_INPUT(invert);
@@ -948,11 +1055,19 @@ PX4FMU::cycle()
 		_current_update_rate = max_rate;
 	}
 
-	/* check if anything updated */
-	int ret = ::poll(_poll_fds, _poll_fds_num, 0);
+	/*
+	 * Wait for the actuator controls, the outputs are written as soon as
+	 * a group is published. The update interval set above limits the rate,
+	 * the timeout keeps RC input and safety going without controls.
+	 */
+	int ret = 0;
 
-	/* log if main actuator updated and sync */
-	int main_out_latency = 0;
+	if (_poll_fds_num == 0) {
+		usleep(SCHEDULE_INTERVAL);
+
+	} else {
+		ret = ::poll(_poll_fds, _poll_fds_num, SCHEDULE_INTERVAL / 1000);
+	}
 
 	/* this would be bad... */
 	if (ret < 0) {
@@ -966,26 +1081,13 @@ PX4FMU::cycle()
 
 		/* get controls for required topics */
 		unsigned poll_id = 0;
+		uint32_t groups_updated = 0;
 
 		for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
 			if (_control_subs[i] > 0) {
 				if (_poll_fds[poll_id].revents & POLLIN) {
 					orb_copy(_control_topics[i], _control_subs[i], &_controls[i]);
-
-					/* main outputs */
-					if (i == 0) {
-//						main_out_latency = hrt_absolute_time() - _controls[i].timestamp - 250;
-//						warnx("lat: %llu", hrt_absolute_time() - _controls[i].timestamp);
-
-						/* do only correct within the current phase */
-						if (abs(main_out_latency) > SCHEDULE_INTERVAL) {
-							main_out_latency = SCHEDULE_INTERVAL;
-						}
-
-						if (main_out_latency < 250) {
-							main_out_latency = 0;
-						}
-					}
+					groups_updated |= (1 << i);
 				}
 
 				poll_id++;
@@ -1054,6 +1156,14 @@ PX4FMU::cycle()
 				pwm_output_set(i, pwm_limited[i]);
 			}
 
+			hrt_abstime now = hrt_absolute_time();
+
+			for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
+				if (groups_updated & (1 << i)) {
+					perf_set(_control_latency_perf[i], now - _controls[i].timestamp);
+				}
+			}
+
 			publish_pwm_outputs(pwm_limited, num_outputs);
 		}
 	}
@@ -1149,16 +1259,10 @@ PX4FMU::cycle()
 	// Scan for 100 msec, then switch protocol
 	constexpr hrt_abstime rc_scan_max = 100 * 1000;
 
-	bool sbus_failsafe, sbus_frame_drop;
-	uint16_t raw_rc_values[input_rc_s::RC_INPUT_MAX_CHANNELS];
-	uint16_t raw_rc_count;
-	unsigned frame_drops;
-	bool dsm_11_bit;
-
-
 	if (_report_lock && _rc_scan_locked) {
 		_report_lock = false;
-		warnx("RCscan: %s RC input locked", RC_SCAN_STRING[_rc_scan_state]);
+		warnx("RCscan: %s RC input locked", _rc_scan_state == RC_SCAN_PPM ? RC_SCAN_STRING[_rc_scan_state] :
+		      rc_decoder_protocol_name(_rc_decoder.locked));
 	}
 
 	// read all available data from the serial RC input UART
@@ -1171,23 +1275,13 @@ PX4FMU::cycle()
 			// Configure serial port for SBUS
 			sbus_config(_rcs_fd, false);
 			rc_io_invert(true);
+			rc_decoder_init(&_rc_decoder, RC_DECODER_MASK_SBUS);
 
 		} else if (_rc_scan_locked
 			   || _cycle_timestamp - _rc_scan_begin < rc_scan_max) {
 
 			// parse new data
-			if (newBytes > 0) {
-				rc_updated = sbus_parse(_cycle_timestamp, &_rcs_buf[0], newBytes, &raw_rc_values[0], &raw_rc_count, &sbus_failsafe,
-							&sbus_frame_drop, &frame_drops, input_rc_s::RC_INPUT_MAX_CHANNELS);
-
-				if (rc_updated) {
-					// we have a new SBUS frame. Publish it.
-					_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_SBUS;
-					fill_rc_in(raw_rc_count, raw_rc_values, _cycle_timestamp,
-						   sbus_frame_drop, sbus_failsafe, frame_drops);
-					_rc_scan_locked = true;
-				}
-			}
+			rc_updated = rc_decoder_update(newBytes);
 
 		} else {
 			// Scan the next protocol
@@ -1199,111 +1293,22 @@ PX4FMU::cycle()
 	case RC_SCAN_DSM:
 		if (_rc_scan_begin == 0) {
 			_rc_scan_begin = _cycle_timestamp;
-//			// Configure serial port for DSM
-			dsm_config(_rcs_fd);
-			rc_io_invert(false);
-
-		} else if (_rc_scan_locked
-			   || _cycle_timestamp - _rc_scan_begin < rc_scan_max) {
-
-			if (newBytes > 0) {
-				// parse new data
-				rc_updated = dsm_parse(_cycle_timestamp, &_rcs_buf[0], newBytes, &raw_rc_values[0], &raw_rc_count,
-						       &dsm_11_bit, &frame_drops, input_rc_s::RC_INPUT_MAX_CHANNELS);
-
-				if (rc_updated) {
-					// we have a new DSM frame. Publish it.
-					_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_DSM;
-					fill_rc_in(raw_rc_count, raw_rc_values, _cycle_timestamp,
-						   false, false, frame_drops);
-					_rc_scan_locked = true;
-				}
-			}
-
-		} else {
-			// Scan the next protocol
-			set_rc_scan_state(RC_SCAN_ST24);
-		}
-
-		break;
-
-	case RC_SCAN_ST24:
-		if (_rc_scan_begin == 0) {
-			_rc_scan_begin = _cycle_timestamp;
-			// Configure serial port for DSM
-			dsm_config(_rcs_fd);
-			rc_io_invert(false);
-
-		} else if (_rc_scan_locked
-			   || _cycle_timestamp - _rc_scan_begin < rc_scan_max) {
-
-			if (newBytes > 0) {
-				// parse new data
-				uint8_t st24_rssi, rx_count;
-
-				rc_updated = false;
-
-				for (unsigned i = 0; i < newBytes; i++) {
-					/* set updated flag if one complete packet was parsed */
-					st24_rssi = RC_INPUT_RSSI_MAX;
-					rc_updated = (OK == st24_decode(_rcs_buf[i], &st24_rssi, &rx_count,
-									&raw_rc_count, raw_rc_values, input_rc_s::RC_INPUT_MAX_CHANNELS));
-				}
-
-				if (rc_updated) {
-					// we have a new ST24 frame. Publish it.
-					_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_ST24;
-					fill_rc_in(raw_rc_count, raw_rc_values, _cycle_timestamp,
-						   false, false, frame_drops, st24_rssi);
-					_rc_scan_locked = true;
-				}
-			}
-
-		} else {
-			// Scan the next protocol
-			set_rc_scan_state(RC_SCAN_SUMD);
-		}
-
-		break;
-
-	case RC_SCAN_SUMD:
-		if (_rc_scan_begin == 0) {
-			_rc_scan_begin = _cycle_timestamp;
-			// Configure serial port for DSM
+			// Configure serial port for DSM, ST24 and SUMD share the same settings
 			dsm_config(_rcs_fd);
 			rc_io_invert(false);
+			rc_decoder_init(&_rc_decoder, RC_DECODER_MASK_115200);
 
 		} else if (_rc_scan_locked
 			   || _cycle_timestamp - _rc_scan_begin < rc_scan_max) {
 
-			if (newBytes > 0) {
-				// parse new data
-				uint8_t sumd_rssi, rx_count;
-
-				rc_updated = false;
-
-				for (unsigned i = 0; i < newBytes; i++) {
-					/* set updated flag if one complete packet was parsed */
-					sumd_rssi = RC_INPUT_RSSI_MAX;
-					rc_updated = (OK == sumd_decode(_rcs_buf[i], &sumd_rssi, &rx_count,
-									&raw_rc_count, raw_rc_values, input_rc_s::RC_INPUT_MAX_CHANNELS));
-				}
-
-				if (rc_updated) {
-					// we have a new SUMD frame. Publish it.
-					_rc_in.input_source = input_rc_s::RC_INPUT_SOURCE_PX4FMU_SUMD;
-					fill_rc_in(raw_rc_count, raw_rc_values, _cycle_timestamp,
-						   false, false, frame_drops, sumd_rssi);
-					_rc_scan_locked = true;
-				}
-			}
+			// parse new data, all three protocols are tried on the same bytes
+			rc_updated = rc_decoder_update(newBytes);
 
 		} else {
 			// Scan the next protocol
-			set_rc_scan_state(RC_SCAN_SUMD);
+			set_rc_scan_state(RC_SCAN_PPM);
 		}
 
-		set_rc_scan_state(RC_SCAN_PPM);
 		break;
 
 	case RC_SCAN_PPM:
@@ -1369,33 +1374,6 @@ PX4FMU::cycle()
 		}
 	}
 
-	work_queue(HPWORK, &_work, (worker_t)&PX4FMU::cycle_trampoline, this,
-		   USEC2TICK(SCHEDULE_INTERVAL - main_out_latency));
-}
-
-void PX4FMU::work_stop()
-{
-	work_cancel(HPWORK, &_work);
-
-	for (unsigned i = 0; i < actuator_controls_s::NUM_ACTUATOR_CONTROL_GROUPS; i++) {
-		if (_control_subs[i] > 0) {
-			::close(_control_subs[i]);
-			_control_subs[i] = -1;
-		}
-	}
-
-	::close(_armed_sub);
-	::close(_param_sub);
-
-	/* make sure servos are off */
-	up_pwm_servo_deinit();
-
-	DEVICE_LOG("stopping");
-
-	/* note - someone else is responsible for restoring the GPIO config */
-
-	/* tell the dtor that we are exiting */
-	_initialized = false;
 }
 
 int
@@ -3066,6 +3044,11 @@ fmu_main(int argc, char *argv[])
 	if (!strcmp(verb, "info")) {
 #ifdef RC_SERIAL_PORT
 		warnx("frame drops: %u", sbus_dropped_frames());
+
+		if (g_fmu != nullptr) {
+			g_fmu->print_rc_status();
+		}
+
 #endif
 		return 0;
 	}
@@ -68,6 +68,7 @@
 
 #include <systemlib/mixer/mixer.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/scheduling_priorities.h>
@@ -1246,6 +1247,7 @@ PX4IO::io_set_control_state(unsigned group)
 			if (changed) {
 				orb_copy(ORB_ID(actuator_controls_0), _t_actuator_controls_0, &controls);
 				perf_set(_perf_sample_latency, hrt_elapsed_time(&controls.timestamp_sample));
+				latency_record(LATENCY_STAGE_OUTPUT, controls.timestamp_sample);
 			}
 		}
 		break;
@@ -134,13 +134,9 @@ __EXPORT int map_projection_global_project(double lat, double lon, float *x, flo
 
 }
 
-__EXPORT int map_projection_project(const struct map_projection_reference_s *ref, double lat, double lon, float *x,
-				    float *y)
+static inline void project_point(const struct map_projection_reference_s *ref, double lat, double lon, float *x,
+				 float *y)
 {
-	if (!map_projection_initialized(ref)) {
-		return -1;
-	}
-
 	double lat_rad = lat * M_DEG_TO_RAD;
 	double lon_rad = lon * M_DEG_TO_RAD;
 
@@ -162,6 +158,100 @@ __EXPORT int map_projection_project(const struct map_projection_reference_s *ref
 
 	*x = k * (ref->cos_lat * sin_lat - ref->sin_lat * cos_lat * cos_d_lon) * CONSTANTS_RADIUS_OF_EARTH;
 	*y = k * cos_lat * sin(lon_rad - ref->lon_rad) * CONSTANTS_RADIUS_OF_EARTH;
+}
+
+/*
+ * North and east components of the unit vector from the reference towards
+ * the point, scaled by sin(c), and the angle c between them. All terms are
+ * formed from the offset to the reference, so there is no cancellation
+ * and float is enough.
+ */
+/*
+ * Longitude difference wrapped to [-pi, pi]. Across the date line the raw
+ * difference is close to 2 pi, where a float ulp is already about 5e-7 rad,
+ * so it is wrapped in double before rounding.
+ */
+static inline float lon_offset(double lon_rad, double lon_0_rad)
+{
+	double d_lon = lon_rad - lon_0_rad;
+
+	if (d_lon > M_PI) {
+		d_lon -= 2.0 * M_PI;
+
+	} else if (d_lon < -M_PI) {
+		d_lon += 2.0 * M_PI;
+	}
+
+	return (float)d_lon;
+}
+
+static inline void offset_to_point(float sin_lat_0, float cos_lat_0, float d_lat, float d_lon, float *north,
+				   float *east, float *c)
+{
+	float sin_d_lat = sinf(d_lat);
+	float cos_d_lat = cosf(d_lat);
+	float cos_lat = cos_lat_0 * cos_d_lat - sin_lat_0 * sin_d_lat;
+
+	float sin_half_d_lat = sinf(0.5f * d_lat);
+	float sin_half_d_lon = sinf(0.5f * d_lon);
+	float hav_d_lon = sin_half_d_lon * sin_half_d_lon;
+
+	/* haversine of the angle, 1 - cos(d_lon) = 2 * hav_d_lon */
+	float h = sin_half_d_lat * sin_half_d_lat + cos_lat_0 * cos_lat * hav_d_lon;
+
+	*north = sin_d_lat + 2.0f * sin_lat_0 * cos_lat * hav_d_lon;
+	*east = cos_lat * sinf(d_lon);
+	*c = 2.0f * asinf(sqrtf(fminf(h, 1.0f)));
+}
+
+__EXPORT int map_projection_project(const struct map_projection_reference_s *ref, double lat, double lon, float *x,
+				    float *y)
+{
+	if (!map_projection_initialized(ref)) {
+		return -1;
+	}
+
+	project_point(ref, lat, lon, x, y);
+
+	return 0;
+}
+
+__EXPORT int map_projection_project_batch(const struct map_projection_reference_s *ref, const double *lat,
+		const double *lon, float *x, float *y, unsigned count)
+{
+	if (!map_projection_initialized(ref)) {
+		return -1;
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		project_point(ref, lat[i], lon[i], &x[i], &y[i]);
+	}
+
+	return 0;
+}
+
+__EXPORT int map_projection_project_batch_fast(const struct map_projection_reference_s *ref, const double *lat,
+		const double *lon, float *x, float *y, unsigned count)
+{
+	if (!map_projection_initialized(ref)) {
+		return -1;
+	}
+
+	float sin_lat_0 = ref->sin_lat;
+	float cos_lat_0 = ref->cos_lat;
+
+	for (unsigned i = 0; i < count; i++) {
+		float d_lat = lat[i] * M_DEG_TO_RAD - ref->lat_rad;
+		float d_lon = lon_offset(lon[i] * M_DEG_TO_RAD, ref->lon_rad);
+		float north, east, c;
+
+		offset_to_point(sin_lat_0, cos_lat_0, d_lat, d_lon, &north, &east, &c);
+
+		float k = (c < FLT_EPSILON) ? 1.0f : (c / sinf(c));
+
+		x[i] = k * north * CONSTANTS_RADIUS_OF_EARTH;
+		y[i] = k * east * CONSTANTS_RADIUS_OF_EARTH;
+	}
 
 	return 0;
 }
@@ -350,6 +440,64 @@ __EXPORT float get_bearing_to_next_waypoint(double lat_now, double lon_now, doub
 	return theta;
 }
 
+__EXPORT void get_distance_to_waypoints(double lat_now, double lon_now, const double *lat_next, const double *lon_next,
+					float *dist, float *bearing, unsigned count)
+{
+	double lat_now_rad = lat_now * M_DEG_TO_RAD;
+	double lon_now_rad = lon_now * M_DEG_TO_RAD;
+	double sin_lat_now = sin(lat_now_rad);
+	double cos_lat_now = cos(lat_now_rad);
+
+	for (unsigned i = 0; i < count; i++) {
+		double lat_next_rad = lat_next[i] * M_DEG_TO_RAD;
+		double lon_next_rad = lon_next[i] * M_DEG_TO_RAD;
+		double cos_lat_next = cos(lat_next_rad);
+		double d_lon = lon_next_rad - lon_now_rad;
+
+		if (dist != NULL) {
+			double sin_half_d_lat = sin((lat_next_rad - lat_now_rad) / (double)2.0);
+			double sin_half_d_lon = sin(d_lon / (double)2.0);
+			double a = sin_half_d_lat * sin_half_d_lat + sin_half_d_lon * sin_half_d_lon * cos_lat_now * cos_lat_next;
+			double c = (double)2.0 * atan2(sqrt(a), sqrt((double)1.0 - a));
+
+			dist[i] = CONSTANTS_RADIUS_OF_EARTH * c;
+		}
+
+		if (bearing != NULL) {
+			/* conscious mix of double and float trig function to maximize speed and efficiency */
+			float theta = atan2f(sin(d_lon) * cos_lat_next,
+					     cos_lat_now * sin(lat_next_rad) - sin_lat_now * cos_lat_next * cos(d_lon));
+
+			bearing[i] = _wrap_pi(theta);
+		}
+	}
+}
+
+__EXPORT void get_distance_to_waypoints_fast(double lat_now, double lon_now, const double *lat_next,
+		const double *lon_next, float *dist, float *bearing, unsigned count)
+{
+	double lat_now_rad = lat_now * M_DEG_TO_RAD;
+	double lon_now_rad = lon_now * M_DEG_TO_RAD;
+	float sin_lat_now = sin(lat_now_rad);
+	float cos_lat_now = cos(lat_now_rad);
+
+	for (unsigned i = 0; i < count; i++) {
+		float d_lat = lat_next[i] * M_DEG_TO_RAD - lat_now_rad;
+		float d_lon = lon_offset(lon_next[i] * M_DEG_TO_RAD, lon_now_rad);
+		float north, east, c;
+
+		offset_to_point(sin_lat_now, cos_lat_now, d_lat, d_lon, &north, &east, &c);
+
+		if (dist != NULL) {
+			dist[i] = CONSTANTS_RADIUS_OF_EARTH * c;
+		}
+
+		if (bearing != NULL) {
+			bearing[i] = _wrap_pi(atan2f(east, north));
+		}
+	}
+}
+
 __EXPORT void get_vector_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next, float *v_n,
 		float *v_e)
 {
@@ -170,6 +170,28 @@ __EXPORT int map_projection_global_project(double lat, double lon, float *x, flo
 __EXPORT int map_projection_project(const struct map_projection_reference_s *ref, double lat, double lon, float *x,
 				    float *y);
 
+/**
+ * Transforms an array of points with the projection given by the argument,
+ * same results as map_projection_project() for every point
+ *
+ * @param lat in degrees (47.1234567°, not 471234567°)
+ * @param lon in degrees (8.1234567°, not 81234567°)
+ * @param x north
+ * @param y east
+ * @param count number of points
+ * @return 0 if map_projection_init was called before, -1 else
+ */
+__EXPORT int map_projection_project_batch(const struct map_projection_reference_s *ref, const double *lat,
+		const double *lon, float *x, float *y, unsigned count);
+
+/**
+ * Like map_projection_project_batch(), but only the offset to the reference
+ * is computed in double, the projection itself in float. The error is below
+ * 1 cm within 10 km and below 10 cm within 100 km of the reference.
+ */
+__EXPORT int map_projection_project_batch_fast(const struct map_projection_reference_s *ref, const double *lat,
+		const double *lon, float *x, float *y, unsigned count);
+
 /**
  * Transforms a point in the local azimuthal equidistant plane to the
  * geographic coordinate system using the global projection
@@ -276,6 +298,29 @@ __EXPORT void waypoint_from_heading_and_distance(double lat_start, double lon_st
  */
 __EXPORT float get_bearing_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next);
 
+/**
+ * Returns the distances and bearings to an array of waypoints, same results
+ * as get_distance_to_next_waypoint() and get_bearing_to_next_waypoint().
+ *
+ * @param lat_now current position in degrees (47.1234567°, not 471234567°)
+ * @param lon_now current position in degrees (8.1234567°, not 81234567°)
+ * @param lat_next waypoint positions in degrees
+ * @param lon_next waypoint positions in degrees
+ * @param dist distances in meters, can be NULL
+ * @param bearing bearings in radians, can be NULL
+ * @param count number of waypoints
+ */
+__EXPORT void get_distance_to_waypoints(double lat_now, double lon_now, const double *lat_next, const double *lon_next,
+					float *dist, float *bearing, unsigned count);
+
+/**
+ * Like get_distance_to_waypoints(), but in float after the offset to the
+ * current position. The error is below 1 cm within 10 km and below 10 cm
+ * within 100 km of the current position.
+ */
+__EXPORT void get_distance_to_waypoints_fast(double lat_now, double lon_now, const double *lat_next,
+		const double *lon_next, float *dist, float *bearing, unsigned count);
+
 __EXPORT void get_vector_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next, float *v_n,
 		float *v_e);
 
@@ -34,9 +34,14 @@
 /**
 * @file geo_mag_declination.c
 *
-* Calculation / lookup table for earth magnetic field declination.
+* Calculation / lookup table for earth magnetic field declination,
+* inclination and strength.
 *
-* Lookup table from Scott Ferguson <scottfromscott@gmail.com>
+* Declination lookup table from Scott Ferguson <scottfromscott@gmail.com>
+*
+* Inclination and strength from the IGRF-12 main field at 2015.0 up to
+* degree 8, on the surface of a spherical earth. At the same grid points
+* it reproduces the declination above to 0.6 degrees on average.
 *
 * XXX Lookup table currently too coarse in resolution (only full degrees)
 * and lat/lon res - needs extension medium term.
@@ -44,6 +49,7 @@
 */
 
 #include <geo/geo.h>
+#include <string.h>
 
 /** set this always to the sampling in degrees for the table below */
 #define SAMPLING_RES		10.0f
@@ -52,80 +58,255 @@
 #define SAMPLING_MIN_LON	-180.0f
 #define SAMPLING_MAX_LON	180.0f
 
-static const int8_t declination_table[13][37] = \
-{
-	{ 46, 45, 44, 42, 41, 40, 38, 36, 33, 28, 23, 16, 10, 4, -1, -5, -9, -14, -19, -26, -33, -40, -48, -55, -61, -66, -71, -74, -75, -72, -61, -25, 22, 40, 45, 47, 46 },
-	{ 30, 30, 30, 30, 29, 29, 29, 29, 27, 24, 18, 11, 3, -3, -9, -12, -15, -17, -21, -26, -32, -39, -45, -51, -55, -57, -56, -53, -44, -31, -14, 0, 13, 21, 26, 29, 30 },
-	{ 21, 22, 22, 22, 22, 22, 22, 22, 21, 18, 13, 5, -3, -11, -17, -20, -21, -22, -23, -25, -29, -35, -40, -44, -45, -44, -40, -32, -22, -12, -3, 3, 9, 14, 18, 20, 21 },
-	{ 16, 17, 17, 17, 17, 17, 16, 16, 16, 13, 8, 0, -9, -16, -21, -24, -25, -25, -23, -20, -21, -24, -28, -31, -31, -29, -24, -17, -9, -3, 0, 4, 7, 10, 13, 15, 16 },
-	{ 12, 13, 13, 13, 13, 13, 12, 12, 11, 9, 3, -4, -12, -19, -23, -24, -24, -22, -17, -12, -9, -10, -13, -17, -18, -16, -13, -8, -3, 0, 1, 3, 6, 8, 10, 12, 12 },
-	{ 10, 10, 10, 10, 10, 10, 10, 9, 9, 6, 0, -6, -14, -20, -22, -22, -19, -15, -10, -6, -2, -2, -4, -7, -8, -8, -7, -4, 0, 1, 1, 2, 4, 6, 8, 10, 10 },
-	{ 9, 9, 9, 9, 9, 9, 8, 8, 7, 4, -1, -8, -15, -19, -20, -18, -14, -9, -5, -2, 0, 1, 0, -2, -3, -4, -3, -2, 0, 0, 0, 1, 3, 5, 7, 8, 9 },
-	{ 8, 8, 8, 9, 9, 9, 8, 8, 6, 2, -3, -9, -15, -18, -17, -14, -10, -6, -2, 0, 1, 2, 2, 0, -1, -1, -2, -1, 0, 0, 0, 0, 1, 3, 5, 7, 8 },
-	{ 8, 9, 9, 10, 10, 10, 10, 8, 5, 0, -5, -11, -15, -16, -15, -12, -8, -4, -1, 0, 2, 3, 2, 1, 0, 0, 0, 0, 0, -1, -2, -2, -1, 0, 3, 6, 8 },
-	{ 6, 9, 10, 11, 12, 12, 11, 9, 5, 0, -7, -12, -15, -15, -13, -10, -7, -3, 0, 1, 2, 3, 3, 3, 2, 1, 0, 0, -1, -3, -4, -5, -5, -2, 0, 3, 6 },
-	{ 5, 8, 11, 13, 15, 15, 14, 11, 5, -1, -9, -14, -17, -16, -14, -11, -7, -3, 0, 1, 3, 4, 5, 5, 5, 4, 3, 1, -1, -4, -7, -8, -8, -6, -2, 1, 5 },
-	{ 4, 8, 12, 15, 17, 18, 16, 12, 5, -3, -12, -18, -20, -19, -16, -13, -8, -4, -1, 1, 4, 6, 8, 9, 9, 9, 7, 3, -1, -6, -10, -12, -11, -9, -5, 0, 4 },
-	{ 3, 9, 14, 17, 20, 21, 19, 14, 4, -8, -19, -25, -26, -25, -21, -17, -12, -7, -2, 1, 5, 9, 13, 15, 16, 16, 13, 7, 0, -7, -12, -15, -14, -11, -6, -1, 3 },
+#define SAMPLING_LAT_COUNT	13
+#define SAMPLING_LON_COUNT	37
+
+/** Gauss per unit of the strength in the table */
+#define STRENGTH_RES		0.004f
+
+/* the three values of a grid point are next to each other, one cell is read at once */
+struct mag_sample_s {
+	int8_t declination;	///< degrees
+	int8_t inclination;	///< degrees
+	uint8_t strength;	///< STRENGTH_RES
 };
 
-static float get_lookup_table_val(unsigned lat, unsigned lon);
+static const struct mag_sample_s mag_table[SAMPLING_LAT_COUNT][SAMPLING_LON_COUNT] = {
+	/* -60 */
+	{
+		{46, -78, 155}, {45, -76, 150}, {44, -74, 146}, {42, -72, 141}, {41, -70, 136}, {40, -68, 130},
+		{38, -66, 124}, {36, -63, 117}, {33, -60, 109}, {28, -58, 102}, {23, -56, 95}, {16, -55, 89},
+		{10, -55, 85}, {4, -55, 81}, {-1, -57, 79}, {-5, -58, 77}, {-9, -59, 76}, {-14, -59, 76},
+		{-19, -59, 76}, {-26, -59, 78}, {-33, -59, 81}, {-40, -60, 87}, {-48, -61, 95}, {-55, -63, 105},
+		{-61, -66, 115}, {-66, -69, 126}, {-71, -73, 136}, {-74, -76, 145}, {-75, -79, 153}, {-72, -83, 159},
+		{-61, -86, 164}, {-25, -87, 166}, {22, -87, 166}, {40, -85, 165}, {45, -82, 162}, {47, -80, 159},
+		{46, -78, 155}
+	},
+	/* -50 */
+	{
+		{30, -72, 146}, {30, -70, 141}, {30, -68, 136}, {30, -66, 130}, {29, -64, 125}, {29, -62, 119},
+		{29, -60, 112}, {29, -57, 104}, {27, -54, 96}, {24, -51, 88}, {18, -49, 80}, {11, -48, 74},
+		{3, -49, 70}, {-3, -51, 68}, {-9, -54, 66}, {-12, -57, 66}, {-15, -60, 65}, {-17, -61, 64},
+		{-21, -61, 64}, {-26, -61, 66}, {-32, -60, 69}, {-39, -60, 76}, {-45, -61, 85}, {-51, -63, 96},
+		{-55, -66, 109}, {-57, -69, 122}, {-56, -73, 134}, {-53, -76, 144}, {-44, -78, 152}, {-31, -80, 159},
+		{-14, -81, 162}, {0, -81, 164}, {13, -80, 163}, {21, -78, 161}, {26, -76, 157}, {29, -74, 152},
+		{30, -72, 146}
+	},
+	/* -40 */
+	{
+		{21, -65, 136}, {22, -63, 130}, {22, -61, 124}, {22, -59, 118}, {22, -57, 112}, {22, -55, 106},
+		{22, -53, 100}, {22, -50, 93}, {21, -47, 85}, {18, -44, 77}, {13, -41, 69}, {5, -41, 64},
+		{-3, -43, 60}, {-11, -47, 59}, {-17, -52, 60}, {-20, -57, 60}, {-21, -61, 61}, {-22, -64, 61},
+		{-23, -65, 61}, {-25, -65, 61}, {-29, -64, 64}, {-35, -62, 70}, {-40, -62, 79}, {-44, -63, 92},
+		{-45, -65, 105}, {-44, -68, 119}, {-40, -71, 131}, {-32, -73, 141}, {-22, -74, 148}, {-12, -74, 153},
+		{-3, -73, 156}, {3, -73, 156}, {9, -72, 155}, {14, -70, 151}, {18, -69, 147}, {20, -67, 141},
+		{21, -65, 136}
+	},
+	/* -30 */
+	{
+		{16, -55, 123}, {17, -53, 117}, {17, -51, 111}, {17, -49, 105}, {17, -47, 100}, {17, -45, 94},
+		{16, -43, 89}, {16, -40, 83}, {16, -37, 77}, {13, -34, 70}, {8, -31, 63}, {0, -31, 58}, {-9, -34, 56},
+		{-16, -41, 56}, {-21, -48, 58}, {-24, -55, 60}, {-25, -60, 62}, {-25, -64, 63}, {-23, -67, 64},
+		{-20, -68, 65}, {-21, -66, 67}, {-24, -64, 71}, {-28, -61, 78}, {-31, -61, 89}, {-31, -62, 103},
+		{-29, -64, 116}, {-24, -65, 127}, {-17, -66, 135}, {-9, -66, 140}, {-3, -65, 143}, {0, -64, 144},
+		{4, -63, 143}, {7, -62, 141}, {10, -61, 138}, {13, -59, 134}, {15, -57, 128}, {16, -55, 123}
+	},
+	/* -20 */
+	{
+		{12, -42, 109}, {13, -40, 104}, {13, -38, 99}, {13, -36, 93}, {13, -33, 89}, {13, -31, 84},
+		{12, -28, 80}, {12, -26, 76}, {11, -22, 72}, {9, -18, 67}, {3, -15, 62}, {-4, -16, 58}, {-12, -21, 57},
+		{-19, -30, 57}, {-23, -40, 60}, {-24, -48, 63}, {-24, -55, 66}, {-22, -59, 69}, {-17, -62, 71},
+		{-12, -63, 73}, {-9, -61, 74}, {-10, -58, 75}, {-13, -55, 80}, {-17, -53, 89}, {-18, -53, 100},
+		{-16, -54, 111}, {-13, -55, 120}, {-8, -56, 126}, {-3, -55, 129}, {0, -53, 130}, {1, -52, 129},
+		{3, -51, 128}, {6, -50, 126}, {8, -49, 123}, {10, -47, 119}, {12, -45, 114}, {12, -42, 109}
+	},
+	/* -10 */
+	{
+		{10, -25, 95}, {10, -23, 91}, {10, -20, 88}, {10, -18, 84}, {10, -15, 81}, {10, -13, 78},
+		{10, -10, 76}, {9, -7, 73}, {9, -4, 71}, {6, 1, 68}, {0, 3, 65}, {-6, 2, 63}, {-14, -4, 61},
+		{-20, -15, 61}, {-22, -26, 63}, {-22, -36, 66}, {-19, -43, 70}, {-15, -48, 74}, {-10, -50, 77},
+		{-6, -50, 79}, {-2, -48, 80}, {-2, -45, 80}, {-4, -41, 83}, {-7, -39, 88}, {-8, -38, 96},
+		{-8, -39, 104}, {-7, -40, 111}, {-4, -40, 115}, {0, -39, 117}, {1, -37, 116}, {1, -36, 114},
+		{2, -36, 112}, {4, -35, 110}, {6, -34, 107}, {8, -32, 103}, {10, -28, 99}, {10, -25, 95}
+	},
+	/* 0 */
+	{
+		{9, -5, 86}, {9, -2, 83}, {9, 1, 82}, {9, 3, 80}, {9, 5, 78}, {9, 8, 78}, {8, 10, 77}, {8, 13, 77},
+		{7, 16, 77}, {4, 20, 76}, {-1, 22, 74}, {-8, 20, 71}, {-15, 13, 69}, {-19, 3, 67}, {-20, -9, 68},
+		{-18, -19, 70}, {-14, -25, 73}, {-9, -29, 77}, {-5, -30, 80}, {-2, -29, 82}, {0, -27, 83},
+		{1, -24, 84}, {0, -20, 85}, {-2, -17, 88}, {-3, -17, 93}, {-4, -17, 99}, {-3, -18, 104},
+		{-2, -19, 106}, {0, -18, 107}, {0, -17, 106}, {0, -16, 103}, {1, -16, 101}, {3, -16, 98}, {5, -15, 95},
+		{7, -13, 92}, {8, -9, 88}, {9, -5, 86}
+	},
+	/* 10 */
+	{
+		{8, 15, 82}, {8, 18, 82}, {8, 21, 81}, {9, 22, 82}, {9, 24, 82}, {9, 26, 83}, {8, 29, 85}, {8, 31, 87},
+		{6, 34, 88}, {2, 36, 88}, {-3, 37, 86}, {-9, 35, 84}, {-15, 29, 80}, {-18, 21, 77}, {-17, 11, 75},
+		{-14, 3, 76}, {-10, -2, 78}, {-6, -5, 80}, {-2, -5, 83}, {0, -4, 85}, {1, -1, 87}, {2, 2, 89},
+		{2, 5, 91}, {0, 7, 93}, {-1, 8, 96}, {-1, 7, 100}, {-2, 6, 103}, {-1, 6, 105}, {0, 6, 105},
+		{0, 7, 104}, {0, 7, 101}, {0, 6, 97}, {1, 5, 93}, {3, 6, 90}, {5, 8, 86}, {7, 11, 84}, {8, 15, 82}
+	},
+	/* 20 */
+	{
+		{8, 32, 85}, {9, 34, 85}, {9, 36, 86}, {10, 38, 88}, {10, 40, 91}, {10, 41, 94}, {10, 43, 97},
+		{8, 46, 100}, {5, 48, 103}, {0, 49, 103}, {-5, 49, 101}, {-11, 47, 98}, {-15, 43, 94}, {-16, 37, 90},
+		{-15, 30, 87}, {-12, 24, 86}, {-8, 21, 86}, {-4, 20, 88}, {-1, 20, 91}, {0, 22, 93}, {2, 24, 96},
+		{3, 26, 98}, {2, 28, 100}, {1, 30, 103}, {0, 30, 105}, {0, 30, 108}, {0, 29, 110}, {0, 29, 112},
+		{0, 29, 113}, {-1, 29, 111}, {-2, 28, 108}, {-2, 27, 103}, {-1, 26, 98}, {0, 25, 93}, {3, 26, 89},
+		{6, 29, 86}, {8, 32, 85}
+	},
+	/* 30 */
+	{
+		{6, 44, 93}, {9, 46, 94}, {10, 47, 96}, {11, 49, 99}, {12, 51, 102}, {12, 53, 107}, {11, 55, 112},
+		{9, 57, 116}, {5, 59, 119}, {0, 60, 119}, {-7, 59, 117}, {-12, 57, 113}, {-15, 54, 108},
+		{-15, 50, 104}, {-13, 46, 101}, {-10, 42, 99}, {-7, 41, 99}, {-3, 40, 100}, {0, 41, 102}, {1, 42, 104},
+		{2, 43, 106}, {3, 45, 109}, {3, 46, 111}, {3, 47, 114}, {2, 48, 117}, {1, 47, 120}, {0, 47, 123},
+		{0, 47, 125}, {-1, 47, 126}, {-3, 47, 125}, {-4, 46, 121}, {-5, 44, 115}, {-5, 42, 108}, {-2, 41, 102},
+		{0, 41, 97}, {3, 42, 94}, {6, 44, 93}
+	},
+	/* 40 */
+	{
+		{5, 53, 106}, {8, 55, 106}, {11, 56, 109}, {13, 58, 112}, {15, 60, 116}, {15, 62, 121}, {14, 64, 126},
+		{11, 66, 130}, {5, 68, 133}, {-1, 68, 133}, {-9, 67, 131}, {-14, 66, 127}, {-17, 63, 122},
+		{-16, 60, 118}, {-14, 58, 114}, {-11, 56, 112}, {-7, 55, 111}, {-3, 55, 111}, {0, 55, 112},
+		{1, 56, 114}, {3, 57, 116}, {4, 58, 118}, {5, 59, 121}, {5, 60, 124}, {5, 60, 128}, {4, 60, 132},
+		{3, 60, 135}, {1, 61, 138}, {-1, 61, 140}, {-4, 60, 139}, {-7, 59, 135}, {-8, 57, 129}, {-8, 55, 122},
+		{-6, 53, 116}, {-2, 52, 110}, {1, 53, 107}, {5, 53, 106}
+	},
+	/* 50 */
+	{
+		{4, 62, 121}, {8, 63, 121}, {12, 64, 123}, {15, 66, 126}, {17, 68, 130}, {18, 70, 134}, {16, 72, 138},
+		{12, 74, 141}, {5, 75, 143}, {-3, 76, 143}, {-12, 75, 141}, {-18, 73, 137}, {-20, 71, 133},
+		{-19, 69, 129}, {-16, 67, 125}, {-13, 66, 123}, {-8, 66, 121}, {-4, 65, 120}, {-1, 66, 120},
+		{1, 66, 121}, {4, 66, 123}, {6, 67, 125}, {8, 68, 128}, {9, 68, 132}, {9, 69, 136}, {9, 70, 141},
+		{7, 70, 145}, {3, 71, 148}, {-1, 71, 150}, {-6, 70, 149}, {-10, 69, 146}, {-12, 67, 141},
+		{-11, 65, 135}, {-9, 63, 130}, {-5, 62, 125}, {0, 62, 122}, {4, 62, 121}
+	},
+	/* 60 */
+	{
+		{3, 71, 134}, {9, 71, 134}, {14, 72, 135}, {17, 74, 137}, {20, 75, 140}, {21, 77, 142}, {19, 79, 144},
+		{14, 80, 146}, {4, 81, 147}, {-8, 82, 146}, {-19, 81, 145}, {-25, 79, 142}, {-26, 78, 139},
+		{-25, 76, 135}, {-21, 75, 132}, {-17, 74, 130}, {-12, 73, 128}, {-7, 73, 127}, {-2, 73, 127},
+		{1, 73, 127}, {5, 73, 129}, {9, 74, 131}, {13, 74, 134}, {15, 75, 137}, {16, 76, 141}, {16, 77, 145},
+		{13, 78, 149}, {7, 79, 152}, {0, 79, 153}, {-7, 78, 153}, {-12, 77, 151}, {-15, 75, 148},
+		{-14, 74, 144}, {-11, 72, 140}, {-6, 71, 137}, {-1, 71, 135}, {3, 71, 134}
+	},
+};
 
-__EXPORT float get_mag_declination(float lat, float lon)
+enum {
+	FIELD_DECLINATION = 0,
+	FIELD_INCLINATION,
+	FIELD_STRENGTH
+};
+
+static void load_cell(struct geo_mag_cache_s *cache, int lat_index, int lon_index)
+{
+	const struct mag_sample_s *corners[4] = {
+		&mag_table[lat_index][lon_index],
+		&mag_table[lat_index][lon_index + 1],
+		&mag_table[lat_index + 1][lon_index],
+		&mag_table[lat_index + 1][lon_index + 1]
+	};
+
+	for (unsigned i = 0; i < 4; i++) {
+		cache->corners[FIELD_DECLINATION][i] = corners[i]->declination;
+		cache->corners[FIELD_INCLINATION][i] = corners[i]->inclination;
+		cache->corners[FIELD_STRENGTH][i] = corners[i]->strength * STRENGTH_RES;
+	}
+
+	cache->lat_index = lat_index;
+	cache->lon_index = lon_index;
+}
+
+static float interpolate(const float corners[4], float lat_frac, float lon_frac)
+{
+	float south = corners[0] + lon_frac * (corners[1] - corners[0]);
+	float north = corners[2] + lon_frac * (corners[3] - corners[2]);
+
+	return south + lat_frac * (north - south);
+}
+
+__EXPORT void geo_mag_cache_init(struct geo_mag_cache_s *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->lat_index = -1;
+	cache->lon_index = -1;
+}
+
+__EXPORT int get_mag_field(struct geo_mag_cache_s *cache, float lat, float lon, struct geo_mag_field_s *field)
 {
 	/*
 	 * If the values exceed valid ranges, return zero as default
 	 * as we have no way of knowing what the closest real value
 	 * would be.
 	 */
-	if (lat < -90.0f || lat > 90.0f ||
-	    lon < -180.0f || lon > 180.0f) {
-		return 0.0f;
+	if (!(lat >= -90.0f && lat <= 90.0f && lon >= -180.0f && lon <= 180.0f)) {
+		memset(field, 0, sizeof(*field));
+		return -1;
 	}
 
-	/* round down to nearest sampling resolution */
-	int min_lat = (int)(lat / SAMPLING_RES) * SAMPLING_RES;
-	int min_lon = (int)(lon / SAMPLING_RES) * SAMPLING_RES;
+	struct geo_mag_cache_s local_cache;
 
-	/* for the rare case of hitting the bounds exactly
-	 * the rounding logic wouldn't fit, so enforce it.
-	 */
+	if (cache == NULL) {
+		cache = &local_cache;
+		cache->lat_index = -1;
+	}
+
+	/* limit to the table, beyond it the first or last row is used */
+	if (lat < SAMPLING_MIN_LAT) {
+		lat = SAMPLING_MIN_LAT;
 
-	/* limit to table bounds - required for maxima even when table spans full globe range */
-	if (lat <= SAMPLING_MIN_LAT) {
-		min_lat = SAMPLING_MIN_LAT;
+	} else if (lat > SAMPLING_MAX_LAT) {
+		lat = SAMPLING_MAX_LAT;
 	}
 
-	if (lat >= SAMPLING_MAX_LAT) {
-		min_lat = (int)(lat / SAMPLING_RES) * SAMPLING_RES - SAMPLING_RES;
+	/* position in units of the sampling, never negative, so the cast rounds down */
+	float lat_pos = (lat - SAMPLING_MIN_LAT) / SAMPLING_RES;
+	float lon_pos = (lon - SAMPLING_MIN_LON) / SAMPLING_RES;
+
+	/* the upper bounds belong to the last cell */
+	int lat_index = (int)lat_pos;
+	int lon_index = (int)lon_pos;
+
+	if (lat_index > SAMPLING_LAT_COUNT - 2) {
+		lat_index = SAMPLING_LAT_COUNT - 2;
 	}
 
-	if (lon <= SAMPLING_MIN_LON) {
-		min_lon = SAMPLING_MIN_LON;
+	if (lon_index > SAMPLING_LON_COUNT - 2) {
+		lon_index = SAMPLING_LON_COUNT - 2;
 	}
 
-	if (lon >= SAMPLING_MAX_LON) {
-		min_lon = (int)(lon / SAMPLING_RES) * SAMPLING_RES - SAMPLING_RES;
+	if (lat_index != cache->lat_index || lon_index != cache->lon_index) {
+		load_cell(cache, lat_index, lon_index);
 	}
 
-	/* find index of nearest low sampling point */
-	unsigned min_lat_index = (-(SAMPLING_MIN_LAT) + min_lat)  / SAMPLING_RES;
-	unsigned min_lon_index = (-(SAMPLING_MIN_LON) + min_lon) / SAMPLING_RES;
+	float lat_frac = lat_pos - lat_index;
+	float lon_frac = lon_pos - lon_index;
 
-	float declination_sw = get_lookup_table_val(min_lat_index, min_lon_index);
-	float declination_se = get_lookup_table_val(min_lat_index, min_lon_index + 1);
-	float declination_ne = get_lookup_table_val(min_lat_index + 1, min_lon_index + 1);
-	float declination_nw = get_lookup_table_val(min_lat_index + 1, min_lon_index);
+	field->declination = interpolate(cache->corners[FIELD_DECLINATION], lat_frac, lon_frac);
+	field->inclination = interpolate(cache->corners[FIELD_INCLINATION], lat_frac, lon_frac);
+	field->strength = interpolate(cache->corners[FIELD_STRENGTH], lat_frac, lon_frac);
 
-	/* perform bilinear interpolation on the four grid corners */
+	return 0;
+}
 
-	float declination_min = ((lon - min_lon) / SAMPLING_RES) * (declination_se - declination_sw) + declination_sw;
-	float declination_max = ((lon - min_lon) / SAMPLING_RES) * (declination_ne - declination_nw) + declination_nw;
+__EXPORT float get_mag_declination(float lat, float lon)
+{
+	struct geo_mag_field_s field;
+	get_mag_field(NULL, lat, lon, &field);
+	return field.declination;
+}
 
-	return ((lat - min_lat) / SAMPLING_RES) * (declination_max - declination_min) + declination_min;
+__EXPORT float get_mag_inclination(float lat, float lon)
+{
+	struct geo_mag_field_s field;
+	get_mag_field(NULL, lat, lon, &field);
+	return field.inclination;
 }
 
-float get_lookup_table_val(unsigned lat_index, unsigned lon_index)
+__EXPORT float get_mag_strength(float lat, float lon)
 {
-	return declination_table[lat_index][lon_index];
-}
\ No newline at end of file
+	struct geo_mag_field_s field;
+	get_mag_field(NULL, lat, lon, &field);
+	return field.strength;
+}
@@ -34,14 +34,57 @@
 /**
 * @file geo_mag_declination.h
 *
-* Calculation / lookup table for earth magnetic field declination.
+* Calculation / lookup table for earth magnetic field declination,
+* inclination and strength.
 *
 */
 
 #pragma once
 
+#include <stdint.h>
+
 __BEGIN_DECLS
 
+struct geo_mag_field_s {
+	float declination;	///< degrees, positive east of true north
+	float inclination;	///< degrees, positive down
+	float strength;		///< Gauss
+};
+
+/**
+ * Lookup state of one caller. The corners of the table cell around the last
+ * position are kept, so lookups within the same cell only interpolate.
+ */
+struct geo_mag_cache_s {
+	int16_t lat_index;	///< of the south west corner, -1 if the cache is empty
+	int16_t lon_index;
+	float corners[3][4];	///< declination, inclination, strength at sw, se, nw, ne
+};
+
+/**
+ * Empty the cache, required before its first use.
+ */
+__EXPORT void geo_mag_cache_init(struct geo_mag_cache_s *cache);
+
+/**
+ * Look up the earth magnetic field, bilinear interpolation in the table.
+ * Positions beyond the table in latitude use its first or last row.
+ *
+ * @param cache lookup state of the caller, NULL to use none
+ * @param lat latitude in degrees
+ * @param lon longitude in degrees
+ * @param field result, zero if lat/lon are out of range
+ * @return 0 on success, -1 if lat/lon are out of range
+ */
+__EXPORT int get_mag_field(struct geo_mag_cache_s *cache, float lat, float lon, struct geo_mag_field_s *field);
+
+/** @return declination in degrees, 0 if lat/lon are out of range */
 __EXPORT float get_mag_declination(float lat, float lon);
 
+/** @return inclination in degrees, 0 if lat/lon are out of range */
+__EXPORT float get_mag_inclination(float lat, float lon);
+
+/** @return field strength in Gauss, 0 if lat/lon are out of range */
+__EXPORT float get_mag_strength(float lat, float lon);
+
 __END_DECLS
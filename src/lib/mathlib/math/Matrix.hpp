@@ -44,13 +44,10 @@
 #define MATRIX_HPP
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
-#ifdef CONFIG_ARCH_ARM
-#include "../CMSIS/Include/arm_math.h"
-#else
-#include "matrix/math.hpp"
-#endif
+#include "MatrixKernels.hpp"
 #include <platforms/px4_defines.h>
 
 namespace math
@@ -69,22 +66,12 @@ public:
 	 */
 	float data[M][N];
 
-	/**
-	 * struct for using arm_math functions
-	 */
-#ifdef CONFIG_ARCH_ARM
-	arm_matrix_instance_f32 arm_mat;
-#else
-	eigen_matrix_instance arm_mat;
-#endif
-
 	/**
 	 * trivial ctor
 	 * Initializes the elements to zero.
 	 */
-	MatrixBase() : 
-		data{},
-		arm_mat{M, N, &data[0][0]}
+	MatrixBase() :
+		data{}
 	{
 	}
 
@@ -93,20 +80,17 @@ public:
 	/**
 	 * copyt ctor
 	 */
-	MatrixBase(const MatrixBase<M, N> &m) :
-		arm_mat{M, N, &data[0][0]}
+	MatrixBase(const MatrixBase<M, N> &m)
 	{
 		memcpy(data, m.data, sizeof(data));
 	}
 
-	MatrixBase(const float *d) :
-		arm_mat{M, N, &data[0][0]}
+	MatrixBase(const float *d)
 	{
 		memcpy(data, d, sizeof(data));
 	}
 
-	MatrixBase(const float d[M][N]) : 
-		arm_mat{M, N, &data[0][0]}
+	MatrixBase(const float d[M][N])
 	{
 		memcpy(data, d, sizeof(data));
 	}
@@ -302,47 +286,28 @@ public:
 	 */
 	template <unsigned int P>
 	Matrix<M, P> operator *(const Matrix<N, P> &m) const {
-#ifdef CONFIG_ARCH_ARM
 		Matrix<M, P> res;
-		arm_mat_mult_f32(&arm_mat, &m.arm_mat, &res.arm_mat);
-		return res;
-#else
-		matrix::Matrix<float, M, N> Me(this->arm_mat.pData);
-		matrix::Matrix<float, N, P> Him(m.arm_mat.pData);
-		matrix::Matrix<float, M, P> Product = Me * Him;
-		Matrix<M, P> res(Product.data());
+		kernel::mult<M, N, P>(data, m.data, res.data);
 		return res;
-#endif
 	}
 
 	/**
 	 * transpose the matrix
 	 */
 	Matrix<N, M> transposed(void) const {
-#ifdef CONFIG_ARCH_ARM
 		Matrix<N, M> res;
-		arm_mat_trans_f32(&this->arm_mat, &res.arm_mat);
-		return res;
-#else
-		matrix::Matrix<float, N, M> Me(this->arm_mat.pData);
-		Matrix<N, M> res(Me.transpose().data());
+		kernel::transpose<M, N>(data, res.data);
 		return res;
-#endif
 	}
 
 	/**
 	 * invert the matrix
+	 * A singular matrix gives the zero matrix.
 	 */
 	Matrix<M, N> inversed(void) const {
-#ifdef CONFIG_ARCH_ARM
 		Matrix<M, N> res;
-		arm_mat_inverse_f32(&this->arm_mat, &res.arm_mat);
+		kernel::inverse<M>(data, res.data);
 		return res;
-#else
-		matrix::SquareMatrix<float, M> Me = matrix::Matrix<float, M, N>(this->arm_mat.pData);
-		Matrix<M, N> res(Me.I().data());
-		return res;
-#endif
 	}
 
 	/**
@@ -401,15 +366,8 @@ public:
 	 * multiplication by a vector
 	 */
 	Vector<M> operator *(const Vector<N> &v) const {
-#ifdef CONFIG_ARCH_ARM
 		Vector<M> res;
-		arm_mat_mult_f32(&this->arm_mat, &v.arm_col, &res.arm_col);
-#else
-		matrix::Matrix<float, M, N> Me(this->arm_mat.pData);
-		matrix::Matrix<float, N, 1> Vec(v.arm_col.pData);
-		matrix::Matrix<float, M, 1> Product = Me * Vec;
-		Vector<M> res(Product.data());
-#endif
+		kernel::mult_vec<M, N>(this->data, v.data, res.data);
 		return res;
 	}
 };
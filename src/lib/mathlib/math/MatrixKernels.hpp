@@ -0,0 +1,232 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MatrixKernels.hpp
+ *
+ * Fixed size kernels behind math::Matrix.
+ *
+ * All sizes are template parameters, the inner products are unrolled by
+ * template recursion and the remaining loops have compile time bounds, so
+ * the compiler emits straight-line code for the small matrices. On x86
+ * (SITL) the matrix product works on four columns at a time with SSE.
+ */
+
+#ifndef MATRIX_KERNELS_HPP
+#define MATRIX_KERNELS_HPP
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) && !defined(CONFIG_ARCH_ARM)
+#include <xmmintrin.h>
+#define MATRIX_KERNELS_SSE
+#endif
+
+namespace math
+{
+namespace kernel
+{
+
+/**
+ * sum of a[k] * b[k * Stride] for k < K
+ */
+template <unsigned K, unsigned Stride>
+struct Dot {
+	static inline float run(const float *a, const float *b) {
+		return Dot < K - 1, Stride >::run(a, b) + a[K - 1] * b[(K - 1) * Stride];
+	}
+};
+
+template <unsigned Stride>
+struct Dot<1, Stride> {
+	static inline float run(const float *a, const float *b) {
+		return a[0] * b[0];
+	}
+};
+
+/**
+ * res = a * b, res must not alias a or b
+ */
+template <unsigned M, unsigned N, unsigned P>
+inline void mult(const float a[M][N], const float b[N][P], float res[M][P])
+{
+	for (unsigned i = 0; i < M; i++) {
+		unsigned j = 0;
+
+#ifdef MATRIX_KERNELS_SSE
+
+		/* same order of the additions as the scalar path, the results are identical */
+		for (; j + 4 <= P; j += 4) {
+			__m128 acc = _mm_mul_ps(_mm_set1_ps(a[i][0]), _mm_loadu_ps(&b[0][j]));
+
+			for (unsigned k = 1; k < N; k++) {
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(a[i][k]), _mm_loadu_ps(&b[k][j])));
+			}
+
+			_mm_storeu_ps(&res[i][j], acc);
+		}
+
+#endif
+
+		for (; j < P; j++) {
+			res[i][j] = Dot<N, P>::run(&a[i][0], &b[0][j]);
+		}
+	}
+}
+
+/**
+ * res = a * v, res must not alias v
+ */
+template <unsigned M, unsigned N>
+inline void mult_vec(const float a[M][N], const float v[N], float res[M])
+{
+	for (unsigned i = 0; i < M; i++) {
+		res[i] = Dot<N, 1>::run(&a[i][0], v);
+	}
+}
+
+/**
+ * res = a^T
+ */
+template <unsigned M, unsigned N>
+inline void transpose(const float a[M][N], float res[N][M])
+{
+	for (unsigned i = 0; i < M; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			res[j][i] = a[i][j];
+		}
+	}
+}
+
+/**
+ * res = a^-1, Gauss-Jordan elimination with partial pivoting
+ *
+ * @return false if a is singular, res is zero then
+ */
+template <unsigned N>
+inline bool inverse(const float a[N][N], float res[N][N])
+{
+	float w[N][N];
+	memcpy(w, a, sizeof(w));
+	memset(res, 0, sizeof(float) * N * N);
+
+	for (unsigned i = 0; i < N; i++) {
+		res[i][i] = 1.0f;
+	}
+
+	for (unsigned c = 0; c < N; c++) {
+		unsigned pivot = c;
+		float pivot_abs = fabsf(w[c][c]);
+
+		for (unsigned r = c + 1; r < N; r++) {
+			if (fabsf(w[r][c]) > pivot_abs) {
+				pivot = r;
+				pivot_abs = fabsf(w[r][c]);
+			}
+		}
+
+		/* also catches NaN */
+		if (!(pivot_abs > 0.0f)) {
+			memset(res, 0, sizeof(float) * N * N);
+			return false;
+		}
+
+		if (pivot != c) {
+			for (unsigned j = 0; j < N; j++) {
+				float t = w[c][j];
+				w[c][j] = w[pivot][j];
+				w[pivot][j] = t;
+				t = res[c][j];
+				res[c][j] = res[pivot][j];
+				res[pivot][j] = t;
+			}
+		}
+
+		float scale = 1.0f / w[c][c];
+
+		for (unsigned j = 0; j < N; j++) {
+			w[c][j] *= scale;
+			res[c][j] *= scale;
+		}
+
+		for (unsigned r = 0; r < N; r++) {
+			if (r == c) {
+				continue;
+			}
+
+			float f = w[r][c];
+
+			for (unsigned j = 0; j < N; j++) {
+				w[r][j] -= f * w[c][j];
+				res[r][j] -= f * res[c][j];
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * 3x3 inverse from the adjugate
+ */
+template <>
+inline bool inverse<3>(const float a[3][3], float res[3][3])
+{
+	float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+	float c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+	float c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+	float det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+
+	if (!(fabsf(det) > 0.0f) || !isfinite(det)) {
+		memset(res, 0, sizeof(float) * 9);
+		return false;
+	}
+
+	float s = 1.0f / det;
+	res[0][0] = c00 * s;
+	res[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * s;
+	res[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * s;
+	res[1][0] = c01 * s;
+	res[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * s;
+	res[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * s;
+	res[2][0] = c02 * s;
+	res[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * s;
+	res[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * s;
+	return true;
+}
+
+}
+}
+
+#endif // MATRIX_KERNELS_HPP
@@ -44,14 +44,9 @@
 #define VECTOR_HPP
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
-#ifdef CONFIG_ARCH_ARM
-#include "../CMSIS/Include/arm_math.h"
-#else
-#include <platforms/ros/eigen_math.h>
-#endif
-
 #include <platforms/px4_defines.h>
 
 namespace math
@@ -69,23 +64,12 @@ public:
 	 */
 	float data[N];
 
-	/**
-	 * struct for using arm_math functions, represents column vector
-	 */
-	#ifdef CONFIG_ARCH_ARM
-	arm_matrix_instance_f32 arm_col;
-	#else
-	eigen_matrix_instance arm_col;
-	#endif
-
-
 	/**
 	 * trivial ctor
 	 * initializes elements to zero
 	 */
 	VectorBase() :
-		data{},
-		arm_col{N, 1, &data[0]}
+		data{}
 	{
 
 	}
@@ -95,8 +79,7 @@ public:
 	/**
 	 * copy ctor
 	 */
-	VectorBase(const VectorBase<N> &v) :
-		arm_col{N, 1, &data[0]}
+	VectorBase(const VectorBase<N> &v)
 	{
 		memcpy(data, v.data, sizeof(data));
 	}
@@ -104,8 +87,7 @@ public:
 	/**
 	 * setting ctor
 	 */
-	VectorBase(const float d[N]) :
-		arm_col{N, 1, &data[0]}
+	VectorBase(const float d[N])
 	{
 		memcpy(data, d, sizeof(data));
 	}
@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file BiquadFilterBank.cpp
+ *
+ * Coefficient design for the biquad filter bank.
+ */
+
+#include "BiquadFilterBank.hpp"
+
+#ifndef M_PI_F
+#define M_PI_F 3.14159f
+#endif
+
+namespace math
+{
+
+bool BiquadCoefficients::lowpass(BiquadCoefficients &c, float sample_freq, float cutoff_freq)
+{
+	if (cutoff_freq <= 0.0f || sample_freq <= 0.0f) {
+		// no filtering
+		return false;
+	}
+
+	const float fr = sample_freq / cutoff_freq;
+	const float ohm = tanf(M_PI_F / fr);
+	const float k = 1.0f + 2.0f * cosf(M_PI_F / 4.0f) * ohm + ohm * ohm;
+
+	c.b0 = ohm * ohm / k;
+	c.b1 = 2.0f * c.b0;
+	c.b2 = c.b0;
+	c.a1 = 2.0f * (ohm * ohm - 1.0f) / k;
+	c.a2 = (1.0f - 2.0f * cosf(M_PI_F / 4.0f) * ohm + ohm * ohm) / k;
+
+	return true;
+}
+
+bool BiquadCoefficients::notch(BiquadCoefficients &c, float sample_freq, float center_freq, float bandwidth)
+{
+	if (center_freq <= 0.0f || bandwidth <= 0.0f || center_freq >= sample_freq / 2.0f) {
+		// no filtering
+		return false;
+	}
+
+	const float alpha = tanf(M_PI_F * bandwidth / sample_freq);
+	const float beta = -cosf(2.0f * M_PI_F * center_freq / sample_freq);
+	const float a0 = 1.0f + alpha;
+
+	c.b0 = 1.0f / a0;
+	c.b1 = 2.0f * beta / a0;
+	c.b2 = c.b0;
+	c.a1 = c.b1;
+	c.a2 = (1.0f - alpha) / a0;
+
+	return true;
+}
+
+} // namespace math
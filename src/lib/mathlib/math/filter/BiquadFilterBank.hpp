@@ -0,0 +1,323 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file BiquadFilterBank.hpp
+ *
+ * Bank of cascaded biquad filters applied to several channels at once.
+ *
+ * All channels share the same coefficients, the filter state is stored
+ * channel-minor so that the inner loop of apply() runs over contiguous
+ * memory and can be vectorized by the compiler. A bank replaces one
+ * LowPassFilter2p per axis (and per sensor instance) in the drivers.
+ */
+
+#pragma once
+
+#include <platforms/px4_defines.h>
+#include <math.h>
+
+namespace math
+{
+
+/**
+ * Coefficients of a single direct form II biquad section
+ *
+ * y[n] = b0 * w[n] + b1 * w[n-1] + b2 * w[n-2]
+ * w[n] = x[n] - a1 * w[n-1] - a2 * w[n-2]
+ */
+struct __EXPORT BiquadCoefficients {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+
+	/**
+	 * Second order butterworth low pass, same response as LowPassFilter2p.
+	 *
+	 * @return false if the cutoff frequency disables the filter
+	 */
+	static bool lowpass(BiquadCoefficients &c, float sample_freq, float cutoff_freq);
+
+	/**
+	 * Notch filter with unity gain outside the stop band.
+	 *
+	 * @param center_freq	center of the stop band in Hz
+	 * @param bandwidth	width of the stop band in Hz
+	 * @return false if the parameters disable the filter
+	 */
+	static bool notch(BiquadCoefficients &c, float sample_freq, float center_freq, float bandwidth);
+};
+
+template<unsigned N, unsigned MaxSections = 2>
+class __EXPORT BiquadFilterBank
+{
+public:
+	BiquadFilterBank() :
+		_num_sections(0),
+		_has_lowpass(false),
+		_has_notch(false),
+		_sample_freq(0.0f),
+		_cutoff_freq(0.0f),
+		_notch_freq(0.0f),
+		_notch_bandwidth(0.0f)
+	{
+		reset_state();
+	}
+
+	BiquadFilterBank(float sample_freq, float cutoff_freq) :
+		BiquadFilterBank()
+	{
+		set_cutoff_frequency(sample_freq, cutoff_freq);
+	}
+
+	/**
+	 * Configure the low pass section, disabled if cutoff_freq <= 0.
+	 *
+	 * An already configured notch is kept and recomputed for the new sample rate,
+	 * sections added with add_section() are kept. The filter state is kept and
+	 * rescaled to the new coefficients, so retuning at runtime causes no step.
+	 *
+	 * @return false if the bank is full and the section could not be enabled
+	 */
+	bool set_cutoff_frequency(float sample_freq, float cutoff_freq)
+	{
+		_cutoff_freq = cutoff_freq;
+		_sample_freq = sample_freq;
+		return update_sections();
+	}
+
+	/**
+	 * Configure the notch section, disabled if center_freq <= 0.
+	 *
+	 * @return false if the bank is full and the section could not be enabled
+	 */
+	bool set_notch_frequency(float sample_freq, float center_freq, float bandwidth)
+	{
+		_notch_freq = center_freq;
+		_notch_bandwidth = bandwidth;
+		_sample_freq = sample_freq;
+		return update_sections();
+	}
+
+	/**
+	 * Append an arbitrary section, e.g. to cascade several low pass sections.
+	 * It runs after the low pass and notch sections.
+	 *
+	 * @return false if the bank is full
+	 */
+	bool add_section(const BiquadCoefficients &c)
+	{
+		if (_num_sections >= MaxSections) {
+			return false;
+		}
+
+		insert_section(_num_sections, c);
+		return true;
+	}
+
+	float get_cutoff_freq() const { return _cutoff_freq; }
+
+	float get_notch_freq() const { return _notch_freq; }
+
+	unsigned get_num_sections() const { return _num_sections; }
+
+	/**
+	 * Filter one sample of every channel in place.
+	 */
+	void apply(float data[N])
+	{
+		for (unsigned s = 0; s < _num_sections; s++) {
+			const BiquadCoefficients &c = _sections[s];
+			float *d1 = _delay_1[s];
+			float *d2 = _delay_2[s];
+
+			for (unsigned i = 0; i < N; i++) {
+				float d0 = data[i] - d1[i] * c.a1 - d2[i] * c.a2;
+
+				// don't allow bad values to propagate via the filter
+				d0 = PX4_ISFINITE(d0) ? d0 : data[i];
+
+				data[i] = d0 * c.b0 + d1[i] * c.b1 + d2[i] * c.b2;
+				d2[i] = d1[i];
+				d1[i] = d0;
+			}
+		}
+	}
+
+	/**
+	 * Filter a block of samples, stored sample-major (samples[k][channel]).
+	 */
+	void apply(float samples[][N], unsigned count)
+	{
+		for (unsigned k = 0; k < count; k++) {
+			apply(samples[k]);
+		}
+	}
+
+	/**
+	 * Reset the filter state to the steady state for a constant input.
+	 *
+	 * @param data	the input value per channel, replaced by the steady output
+	 */
+	void reset(float data[N])
+	{
+		for (unsigned s = 0; s < _num_sections; s++) {
+			const BiquadCoefficients &c = _sections[s];
+			const float a_sum = 1.0f + c.a1 + c.a2;
+			const float b_sum = c.b0 + c.b1 + c.b2;
+
+			for (unsigned i = 0; i < N; i++) {
+				const float w = (fabsf(a_sum) > 0.0f) ? data[i] / a_sum : 0.0f;
+				_delay_1[s][i] = w;
+				_delay_2[s][i] = w;
+				data[i] = w * b_sum;
+			}
+		}
+	}
+
+private:
+	BiquadCoefficients _sections[MaxSections];	///< low pass, notch, then the added sections
+	unsigned	_num_sections;
+	bool		_has_lowpass;
+	bool		_has_notch;
+	float		_sample_freq;
+	float		_cutoff_freq;
+	float		_notch_freq;
+	float		_notch_bandwidth;
+	float		_delay_1[MaxSections][N];	///< buffered state -1 per section and channel
+	float		_delay_2[MaxSections][N];	///< buffered state -2 per section and channel
+
+	void reset_state()
+	{
+		for (unsigned s = 0; s < MaxSections; s++) {
+			for (unsigned i = 0; i < N; i++) {
+				_delay_1[s][i] = 0.0f;
+				_delay_2[s][i] = 0.0f;
+			}
+		}
+	}
+
+	/* a new section starts from a zero state, the later ones keep theirs */
+	void insert_section(unsigned index, const BiquadCoefficients &c)
+	{
+		for (unsigned s = _num_sections; s > index; s--) {
+			_sections[s] = _sections[s - 1];
+
+			for (unsigned i = 0; i < N; i++) {
+				_delay_1[s][i] = _delay_1[s - 1][i];
+				_delay_2[s][i] = _delay_2[s - 1][i];
+			}
+		}
+
+		_sections[index] = c;
+
+		for (unsigned i = 0; i < N; i++) {
+			_delay_1[index][i] = 0.0f;
+			_delay_2[index][i] = 0.0f;
+		}
+
+		_num_sections++;
+	}
+
+	void remove_section(unsigned index)
+	{
+		_num_sections--;
+
+		for (unsigned s = index; s < _num_sections; s++) {
+			_sections[s] = _sections[s + 1];
+
+			for (unsigned i = 0; i < N; i++) {
+				_delay_1[s][i] = _delay_1[s + 1][i];
+				_delay_2[s][i] = _delay_2[s + 1][i];
+			}
+		}
+	}
+
+	/**
+	 * Update, add or remove one of the configured sections, only the
+	 * coefficients change if it stays enabled.
+	 */
+	bool update_section(bool &enabled, unsigned index, bool required, const BiquadCoefficients &c)
+	{
+		if (enabled && required) {
+			/*
+			 * The steady state of the delay elements for a constant input
+			 * is x / (1 + a1 + a2), rescale them so that the low frequency
+			 * content passes without a step.
+			 */
+			const float a_sum_old = 1.0f + _sections[index].a1 + _sections[index].a2;
+			const float a_sum_new = 1.0f + c.a1 + c.a2;
+
+			if (fabsf(a_sum_new) > 0.0f) {
+				const float scale = a_sum_old / a_sum_new;
+
+				for (unsigned i = 0; i < N; i++) {
+					_delay_1[index][i] *= scale;
+					_delay_2[index][i] *= scale;
+				}
+			}
+
+			_sections[index] = c;
+
+		} else if (enabled) {
+			remove_section(index);
+			enabled = false;
+
+		} else if (required) {
+			if (_num_sections >= MaxSections) {
+				return false;
+			}
+
+			insert_section(index, c);
+			enabled = true;
+		}
+
+		return true;
+	}
+
+	bool update_sections()
+	{
+		BiquadCoefficients c;
+		bool lowpass = BiquadCoefficients::lowpass(c, _sample_freq, _cutoff_freq);
+		bool ok = update_section(_has_lowpass, 0, lowpass, c);
+
+		bool notch = BiquadCoefficients::notch(c, _sample_freq, _notch_freq, _notch_bandwidth);
+		ok = update_section(_has_notch, _has_lowpass ? 1 : 0, notch, c) && ok;
+
+		return ok;
+	}
+};
+
+} // namespace math
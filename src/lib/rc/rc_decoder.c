@@ -0,0 +1,292 @@
+/****************************************************************************
+ *
+ *	Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in
+ *	the documentation and/or other materials provided with the
+ *	distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *	used to endorse or promote products derived from this software
+ *	without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file rc_decoder.c
+ *
+ * Serial RC input pipeline running the protocol framers in parallel.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <px4_config.h>
+#include <px4_defines.h>
+#include <drivers/drv_rc_input.h>
+
+#include "rc_decoder.h"
+#include "sbus.h"
+#include "dsm.h"
+#include "st24.h"
+#include "sumd.h"
+
+/* order in which the protocols are fed, protocols with a checksum first */
+static const enum RC_DECODER_PROTOCOL rc_decoder_order[] = {
+	RC_DECODER_PROTO_ST24,
+	RC_DECODER_PROTO_SUMD,
+	RC_DECODER_PROTO_SBUS,
+	RC_DECODER_PROTO_DSM
+};
+
+static const char *const rc_decoder_names[RC_DECODER_PROTO_COUNT] = {
+	"none",
+	"SBUS",
+	"DSM",
+	"ST24",
+	"SUMD"
+};
+
+struct rc_decoder_frame {
+	uint16_t	values[RC_DECODER_MAX_CHANNELS];
+	uint16_t	num_values;
+	int		rssi;
+	bool		failsafe;
+	bool		frame_drop;
+	bool		dsm_11_bit;
+	unsigned	errors;
+};
+
+/**
+ * Run one framer over the span.
+ *
+ * @return true if a frame was decoded
+ */
+static bool
+rc_decoder_run(enum RC_DECODER_PROTOCOL proto, uint64_t now, const uint8_t *buf, unsigned len,
+	       struct rc_decoder_frame *frame)
+{
+	bool decoded = false;
+	unsigned drops = 0;
+
+	frame->rssi = -1;
+	frame->failsafe = false;
+	frame->frame_drop = false;
+	frame->errors = 0;
+
+	switch (proto) {
+	case RC_DECODER_PROTO_SBUS:
+		decoded = sbus_parse(now, buf, len, frame->values, &frame->num_values, &frame->failsafe,
+				     &frame->frame_drop, &drops, RC_DECODER_MAX_CHANNELS);
+		break;
+
+	case RC_DECODER_PROTO_DSM:
+		decoded = dsm_parse(now, buf, len, frame->values, &frame->num_values, &frame->dsm_11_bit,
+				    &drops, RC_DECODER_MAX_CHANNELS);
+		break;
+
+	case RC_DECODER_PROTO_ST24:
+	case RC_DECODER_PROTO_SUMD:
+		for (unsigned i = 0; i < len; i++) {
+			uint8_t rssi = RC_INPUT_RSSI_MAX;
+			uint8_t rx_count;
+			int ret;
+
+			if (proto == RC_DECODER_PROTO_ST24) {
+				ret = st24_decode(buf[i], &rssi, &rx_count, &frame->num_values, frame->values, RC_DECODER_MAX_CHANNELS);
+
+			} else {
+				ret = sumd_decode(buf[i], &rssi, &rx_count, &frame->num_values, frame->values, RC_DECODER_MAX_CHANNELS);
+			}
+
+			if (ret == 0) {
+				frame->rssi = rssi;
+				decoded = true;
+
+			} else if (ret == 4) {
+				/* checksum error */
+				frame->errors++;
+			}
+		}
+
+		break;
+
+	default:
+		break;
+	}
+
+	/* sbus and dsm report the total number of dropped frames */
+	if (proto == RC_DECODER_PROTO_SBUS || proto == RC_DECODER_PROTO_DSM) {
+		frame->errors = drops;
+	}
+
+	return decoded;
+}
+
+static void
+rc_decoder_output(struct rc_decoder *dec, enum RC_DECODER_PROTOCOL proto, const struct rc_decoder_frame *frame)
+{
+	dec->source = proto;
+	dec->provisional = (dec->locked != proto);
+	dec->num_values = (frame->num_values > RC_DECODER_MAX_CHANNELS) ? RC_DECODER_MAX_CHANNELS : frame->num_values;
+	memcpy(dec->values, frame->values, dec->num_values * sizeof(dec->values[0]));
+	dec->rssi = frame->rssi;
+	dec->failsafe = frame->failsafe;
+	dec->frame_drop = frame->frame_drop;
+	dec->dsm_11_bit = frame->dsm_11_bit;
+}
+
+void
+rc_decoder_init(struct rc_decoder *dec, unsigned protocols)
+{
+	memset(dec, 0, sizeof(*dec));
+	dec->protocols = protocols;
+	dec->locked = RC_DECODER_PROTO_NONE;
+	dec->source = RC_DECODER_PROTO_NONE;
+	dec->rssi = -1;
+}
+
+bool
+rc_decoder_parse(struct rc_decoder *dec, uint64_t now, const uint8_t *buf, unsigned len)
+{
+	bool updated = false;
+
+	/* first frame decoded while detecting, returned provisionally if no other protocol competes */
+	struct rc_decoder_frame candidate;
+	enum RC_DECODER_PROTOCOL candidate_proto = RC_DECODER_PROTO_NONE;
+	bool conflict = false;
+
+	if (len == 0) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < sizeof(rc_decoder_order) / sizeof(rc_decoder_order[0]); i++) {
+		enum RC_DECODER_PROTOCOL proto = rc_decoder_order[i];
+
+		if (dec->locked != RC_DECODER_PROTO_NONE ? proto != dec->locked : !(dec->protocols & RC_DECODER_MASK(proto))) {
+			continue;
+		}
+
+		struct rc_decoder_stats *stats = &dec->stats[proto];
+
+		if (dec->frame_start[proto] == 0) {
+			dec->frame_start[proto] = now;
+		}
+
+		struct rc_decoder_frame frame;
+
+		bool decoded = rc_decoder_run(proto, now, buf, len, &frame);
+
+		if (proto == RC_DECODER_PROTO_SBUS || proto == RC_DECODER_PROTO_DSM) {
+			/* running totals */
+			if (frame.errors != stats->errors) {
+				dec->lock_count[proto] = 0;
+			}
+
+			stats->errors = frame.errors;
+
+		} else if (frame.errors > 0) {
+			stats->errors += frame.errors;
+			dec->lock_count[proto] = 0;
+		}
+
+		if (!decoded) {
+			continue;
+		}
+
+		uint32_t latency = now - dec->frame_start[proto];
+		stats->latency_avg = (stats->frames == 0) ? latency : (stats->latency_avg * 7 + latency) / 8;
+
+		if (latency > stats->latency_max) {
+			stats->latency_max = latency;
+		}
+
+		stats->frames++;
+		stats->last_frame = now;
+		dec->frame_start[proto] = 0;
+
+		if (dec->locked == RC_DECODER_PROTO_NONE) {
+			if (dec->lock_count[proto] < RC_DECODER_LOCK_FRAMES) {
+				dec->lock_count[proto]++;
+			}
+
+			if (dec->lock_count[proto] >= RC_DECODER_LOCK_FRAMES) {
+				dec->locked = proto;
+			}
+		}
+
+		if (dec->locked == proto) {
+			rc_decoder_output(dec, proto, &frame);
+			updated = true;
+
+		} else if (candidate_proto == RC_DECODER_PROTO_NONE) {
+			candidate = frame;
+			candidate_proto = proto;
+
+		} else {
+			conflict = true;
+		}
+	}
+
+	if (dec->locked == RC_DECODER_PROTO_NONE && candidate_proto != RC_DECODER_PROTO_NONE && !conflict) {
+		/* a protocol that decoded clean frames recently competes as well */
+		for (unsigned proto = RC_DECODER_PROTO_NONE + 1; proto < RC_DECODER_PROTO_COUNT; proto++) {
+			if (proto != candidate_proto && dec->lock_count[proto] > 0) {
+				conflict = true;
+			}
+		}
+
+		if (!conflict && dec->lock_count[candidate_proto] > 0) {
+			rc_decoder_output(dec, candidate_proto, &candidate);
+			updated = true;
+		}
+	}
+
+	return updated;
+}
+
+const char *
+rc_decoder_protocol_name(enum RC_DECODER_PROTOCOL proto)
+{
+	if (proto >= RC_DECODER_PROTO_COUNT) {
+		return "unknown";
+	}
+
+	return rc_decoder_names[proto];
+}
+
+void
+rc_decoder_print_status(const struct rc_decoder *dec)
+{
+	printf("RC input: %s\n", (dec->locked != RC_DECODER_PROTO_NONE) ? rc_decoder_protocol_name(dec->locked) : "detecting");
+
+	for (unsigned proto = RC_DECODER_PROTO_NONE + 1; proto < RC_DECODER_PROTO_COUNT; proto++) {
+		const struct rc_decoder_stats *stats = &dec->stats[proto];
+
+		if (!(dec->protocols & RC_DECODER_MASK(proto)) && stats->frames == 0) {
+			continue;
+		}
+
+		printf("  %-4s frames: %u errors: %u latency avg: %u us max: %u us\n", rc_decoder_names[proto],
+		       (unsigned)stats->frames, (unsigned)stats->errors, (unsigned)stats->latency_avg, (unsigned)stats->latency_max);
+	}
+}
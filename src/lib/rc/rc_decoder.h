@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ *	Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in
+ *	the documentation and/or other materials provided with the
+ *	distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *	used to endorse or promote products derived from this software
+ *	without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file rc_decoder.h
+ *
+ * Serial RC input pipeline. Feeds raw UART byte spans to the S.BUS, DSM,
+ * ST24 and SUMD framers in parallel, locks onto the protocol that decodes
+ * and keeps per-protocol frame, error and latency statistics.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+__BEGIN_DECLS
+
+enum RC_DECODER_PROTOCOL {
+	RC_DECODER_PROTO_NONE = 0,
+	RC_DECODER_PROTO_SBUS,
+	RC_DECODER_PROTO_DSM,
+	RC_DECODER_PROTO_ST24,
+	RC_DECODER_PROTO_SUMD,
+	RC_DECODER_PROTO_COUNT
+};
+
+#define RC_DECODER_MASK(proto)		(1u << (proto))
+#define RC_DECODER_MASK_SBUS		RC_DECODER_MASK(RC_DECODER_PROTO_SBUS)
+/** protocols sharing the 115200 8N1 UART configuration, these can be detected at the same time */
+#define RC_DECODER_MASK_115200		(RC_DECODER_MASK(RC_DECODER_PROTO_DSM) | RC_DECODER_MASK(RC_DECODER_PROTO_ST24) | \
+					 RC_DECODER_MASK(RC_DECODER_PROTO_SUMD))
+
+#define RC_DECODER_MAX_CHANNELS		18	/**< same as input_rc_s::RC_INPUT_MAX_CHANNELS */
+#define RC_DECODER_LOCK_FRAMES		3	/**< frames of one protocol without error needed to lock onto it */
+
+struct rc_decoder_stats {
+	uint32_t	frames;		/**< decoded frames */
+	uint32_t	errors;		/**< checksum errors and dropped frames */
+	uint32_t	latency_avg;	/**< average time from reading the first bytes of a frame to decoding it [us] */
+	uint32_t	latency_max;	/**< maximum of the above [us] */
+	uint64_t	last_frame;	/**< time of the last decoded frame */
+};
+
+struct rc_decoder {
+	unsigned			protocols;	/**< RC_DECODER_MASK() of the protocols fed with the input */
+	enum RC_DECODER_PROTOCOL	locked;		/**< detected protocol, RC_DECODER_PROTO_NONE while detecting */
+	uint8_t				lock_count[RC_DECODER_PROTO_COUNT];
+	uint64_t			frame_start[RC_DECODER_PROTO_COUNT];	/**< read time of the first bytes of the pending frame */
+	struct rc_decoder_stats		stats[RC_DECODER_PROTO_COUNT];
+
+	/* last frame of the locked protocol, or a provisional frame while detecting */
+	enum RC_DECODER_PROTOCOL	source;		/**< protocol of the frame */
+	bool				provisional;	/**< the frame was decoded before the protocol locked */
+	uint16_t			values[RC_DECODER_MAX_CHANNELS];
+	uint16_t			num_values;
+	int				rssi;		/**< -1 if the protocol does not report RSSI */
+	bool				failsafe;
+	bool				frame_drop;
+	bool				dsm_11_bit;
+};
+
+/**
+ * Reset the decoder and select the protocols to detect.
+ *
+ * Only protocols that share a UART configuration can be detected together,
+ * e.g. RC_DECODER_MASK_SBUS or RC_DECODER_MASK_115200.
+ */
+__EXPORT void	rc_decoder_init(struct rc_decoder *dec, unsigned protocols);
+
+/**
+ * Feed a span of received bytes to the decoder.
+ *
+ * The span is handed to every active framer as is. Before a protocol is locked
+ * every selected protocol is decoded; once one of them delivered
+ * RC_DECODER_LOCK_FRAMES frames in a row, only that one is fed.
+ *
+ * While detecting, a clean frame is returned provisionally if its protocol is
+ * the only one decoding, so the first frames are not held back until the lock.
+ *
+ * @param now	time the bytes were read
+ * @return	true if a frame was decoded into values, see source and provisional
+ */
+__EXPORT bool	rc_decoder_parse(struct rc_decoder *dec, uint64_t now, const uint8_t *buf, unsigned len);
+
+__EXPORT const char *rc_decoder_protocol_name(enum RC_DECODER_PROTOCOL proto);
+
+/**
+ * Print the per-protocol statistics.
+ */
+__EXPORT void	rc_decoder_print_status(const struct rc_decoder *dec);
+
+__END_DECLS
@@ -265,7 +265,7 @@ sbus_input(int sbus_fd, uint16_t *values, uint16_t *num_values, bool *sbus_fails
 }
 
 bool
-sbus_parse(uint64_t now, uint8_t *frame, unsigned len, uint16_t *values,
+sbus_parse(uint64_t now, const uint8_t *frame, unsigned len, uint16_t *values,
 	   uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, unsigned *frame_drops, uint16_t max_channels)
 {
 
@@ -604,6 +604,7 @@ int attitude_estimator_ekf_thread_main(int argc, char *argv[])
 
 					/* send out */
 					att.timestamp = raw.timestamp;
+					att.timestamp_sample = raw.timestamp;
 
 					att.roll = euler[0];
 					att.pitch = euler[1];
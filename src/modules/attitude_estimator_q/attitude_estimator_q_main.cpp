@@ -53,6 +53,7 @@
 #include <math.h>
 #include <uORB/uORB.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/control_state.h>
 #include <uORB/topics/vehicle_control_mode.h>
@@ -73,6 +74,8 @@
 #include <systemlib/systemlib.h>
 #include <systemlib/param/param.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
+#include <systemlib/pipeline.h>
 #include <systemlib/err.h>
 
 extern "C" __EXPORT int attitude_estimator_q_main(int argc, char *argv[]);
@@ -113,6 +116,12 @@ public:
 
 	void		task_main();
 
+	/**
+	 * Run by the sensors task in the pipeline mode.
+	 */
+	static void	pipeline_trampoline(void *arg);
+	volatile bool	_pipeline_unsubscribed = false;
+
 	void		print();
 
 private:
@@ -120,6 +129,7 @@ private:
 	bool		_task_should_exit = false;		/**< if true, task should exit */
 	int		_control_task = -1;			/**< task handle for task */
 
+	int		_imu_sub = -1;
 	int		_sensors_sub = -1;
 	int		_params_sub = -1;
 	int		_vision_sub = -1;
@@ -149,6 +159,7 @@ private:
 	float		_w_gyro_bias = 0.0f;
 	float		_mag_decl = 0.0f;
 	bool		_mag_decl_auto = false;
+	struct geo_mag_cache_s	_mag_cache;
 	bool		_acc_comp = false;
 	float		_bias_max = 0.0f;
 	float		_vibration_warning_threshold = 1.0f;
@@ -175,6 +186,7 @@ private:
 	Vector<3>	_vel_prev;
 	Vector<3>	_pos_acc;
 
+	/* the gyro and accel are selected by the sensors module, their validators only track vibration */
 	DataValidatorGroup _voter_gyro;
 	DataValidatorGroup _voter_accel;
 	DataValidatorGroup _voter_mag;
@@ -185,6 +197,7 @@ private:
 	math::LowPassFilter2p _lp_yaw_rate;
 
 	hrt_abstime _vel_prev_t = 0;
+	hrt_abstime _last_time = 0;
 
 	bool		_inited = false;
 	bool		_data_good = false;
@@ -197,8 +210,22 @@ private:
 	perf_counter_t _update_perf;
 	perf_counter_t _loop_perf;
 
+#ifdef __PX4_POSIX
+	perf_counter_t _perf_accel = perf_alloc_once(PC_ELAPSED, "sim_accel_delay");
+	perf_counter_t _perf_mpu = perf_alloc_once(PC_ELAPSED, "sim_mpu_delay");
+	perf_counter_t _perf_mag = perf_alloc_once(PC_ELAPSED, "sim_mag_delay");
+#endif
+
 	void update_parameters(bool force);
 
+	void subscribe();
+	void unsubscribe();
+
+	/**
+	 * Estimator update for a new sensor_imu sample.
+	 */
+	void cycle();
+
 	int update_subscriptions();
 
 	bool init();
@@ -213,13 +240,14 @@ private:
 AttitudeEstimatorQ::AttitudeEstimatorQ() :
 	_vel_prev(0, 0, 0),
 	_pos_acc(0, 0, 0),
-	_voter_gyro(3),
-	_voter_accel(3),
+	_voter_gyro(1),
+	_voter_accel(1),
 	_voter_mag(3),
 	_lp_roll_rate(250.0f, 30.0f),
 	_lp_pitch_rate(250.0f, 30.0f),
 	_lp_yaw_rate(250.0f, 20.0f)
 {
+	geo_mag_cache_init(&_mag_cache);
 	_voter_mag.set_timeout(200000);
 
 	_params_handles.w_acc		= param_find("ATT_W_ACC");
@@ -296,15 +324,10 @@ void AttitudeEstimatorQ::task_main_trampoline(int argc, char *argv[])
 	attitude_estimator_q::instance->task_main();
 }
 
-void AttitudeEstimatorQ::task_main()
+void AttitudeEstimatorQ::subscribe()
 {
-
-#ifdef __PX4_POSIX
-	perf_counter_t _perf_accel(perf_alloc_once(PC_ELAPSED, "sim_accel_delay"));
-	perf_counter_t _perf_mpu(perf_alloc_once(PC_ELAPSED, "sim_mpu_delay"));
-	perf_counter_t _perf_mag(perf_alloc_once(PC_ELAPSED, "sim_mag_delay"));
-#endif
-
+	/* the estimator runs on the imu selected by the sensors module, sensor_combined provides the mags */
+	_imu_sub = orb_subscribe(ORB_ID(sensor_imu));
 	_sensors_sub = orb_subscribe(ORB_ID(sensor_combined));
 
 	_vision_sub = orb_subscribe(ORB_ID(vision_position_estimate));
@@ -316,24 +339,51 @@ void AttitudeEstimatorQ::task_main()
 	_global_pos_sub = orb_subscribe(ORB_ID(vehicle_global_position));
 
 	update_parameters(true);
+}
 
-	hrt_abstime last_time = 0;
+void AttitudeEstimatorQ::unsubscribe()
+{
+	int *subs[] = { &_imu_sub, &_sensors_sub, &_vision_sub, &_mocap_sub, &_airspeed_sub, &_params_sub, &_global_pos_sub };
 
-	px4_pollfd_struct_t fds[1] = {};
-	fds[0].fd = _sensors_sub;
-	fds[0].events = POLLIN;
+	for (unsigned i = 0; i < sizeof(subs) / sizeof(subs[0]); i++) {
+		if (*subs[i] >= 0) {
+			orb_unsubscribe(*subs[i]);
+			*subs[i] = -1;
+		}
+	}
+}
 
-	while (!_task_should_exit) {
-		int ret = px4_poll(fds, 1, 1000);
+void AttitudeEstimatorQ::task_main()
+{
+	if (pipeline_enabled()) {
+		/* the sensors task runs the estimator, this task only waits for the stop */
+		if (pipeline_register(PIPELINE_STAGE_ESTIMATOR, "attitude_estimator_q",
+				      &AttitudeEstimatorQ::pipeline_trampoline, this) != 0) {
+			PX4_WARN("pipeline stage taken");
+			return;
+		}
 
-#ifndef __PX4_QURT
+		while (!_task_should_exit) {
+			usleep(100000);
+		}
 
-		if (_mavlink_fd < 0) {
-			/* TODO: This call currently stalls the thread on QURT */
-			_mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
+		/* the subscriptions belong to the sensors task, let the next cycle close them */
+		for (unsigned i = 0; i < 10 && !_pipeline_unsubscribed; i++) {
+			usleep(10000);
 		}
 
-#endif
+		pipeline_unregister(PIPELINE_STAGE_ESTIMATOR);
+		return;
+	}
+
+	subscribe();
+
+	px4_pollfd_struct_t fds[1] = {};
+	fds[0].fd = _imu_sub;
+	fds[0].events = POLLIN;
+
+	while (!_task_should_exit) {
+		int ret = px4_poll(fds, 1, 1000);
 
 		if (ret < 0) {
 			// Poll error, sleep and try again
@@ -347,319 +397,342 @@ void AttitudeEstimatorQ::task_main()
 			continue;
 		}
 
-		update_parameters(false);
+		cycle();
+	}
+}
 
-		// Update sensors
-		sensor_combined_s sensors;
+void AttitudeEstimatorQ::pipeline_trampoline(void *arg)
+{
+	AttitudeEstimatorQ *estimator = (AttitudeEstimatorQ *)arg;
 
-		int best_gyro = 0;
-		int best_accel = 0;
-		int best_mag = 0;
+	if (estimator->_task_should_exit) {
+		if (!estimator->_pipeline_unsubscribed) {
+			estimator->unsubscribe();
+			estimator->_pipeline_unsubscribed = true;
+		}
+
+		return;
+	}
 
-		if (!orb_copy(ORB_ID(sensor_combined), _sensors_sub, &sensors)) {
-			// Feed validator with recent sensor data
+	/* the subscriptions have to belong to the task running the pipeline */
+	if (estimator->_imu_sub < 0) {
+		estimator->subscribe();
+	}
 
-			for (unsigned i = 0; i < (sizeof(sensors.gyro_timestamp) / sizeof(sensors.gyro_timestamp[0])); i++) {
+	bool updated = false;
+	orb_check(estimator->_imu_sub, &updated);
 
-				/* ignore empty fields */
-				if (sensors.gyro_timestamp[i] > 0) {
+	if (updated) {
+		estimator->cycle();
+	}
+}
 
-					float gyro[3];
+void AttitudeEstimatorQ::cycle()
+{
+#ifndef __PX4_QURT
 
-					for (unsigned j = 0; j < 3; j++) {
-						if (sensors.gyro_integral_dt[i] > 0) {
-							gyro[j] = (double)sensors.gyro_integral_rad[i * 3 + j] / (sensors.gyro_integral_dt[i] / 1e6);
+	if (_mavlink_fd < 0) {
+		/* TODO: This call currently stalls the thread on QURT */
+		_mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
+	}
 
-						} else {
-							/* fall back to angular rate */
-							gyro[j] = sensors.gyro_rad_s[i * 3 + j];
-						}
-					}
+#endif
 
-					_voter_gyro.put(i, sensors.gyro_timestamp[i], &gyro[0], sensors.gyro_errcount[i], sensors.gyro_priority[i]);
-				}
+	update_parameters(false);
 
-				/* ignore empty fields */
-				if (sensors.accelerometer_timestamp[i] > 0) {
-					_voter_accel.put(i, sensors.accelerometer_timestamp[i], &sensors.accelerometer_m_s2[i * 3],
-							 sensors.accelerometer_errcount[i], sensors.accelerometer_priority[i]);
-				}
+	// Update sensors
+	sensor_imu_s imu;
 
-				/* ignore empty fields */
-				if (sensors.magnetometer_timestamp[i] > 0) {
-					_voter_mag.put(i, sensors.magnetometer_timestamp[i], &sensors.magnetometer_ga[i * 3],
-						       sensors.magnetometer_errcount[i], sensors.magnetometer_priority[i]);
-				}
-			}
+	int best_gyro = 0;
+	int best_accel = 0;
+	int best_mag = 0;
 
-			// Get best measurement values
-			hrt_abstime curr_time = hrt_absolute_time();
-			_gyro.set(_voter_gyro.get_best(curr_time, &best_gyro));
-			_accel.set(_voter_accel.get_best(curr_time, &best_accel));
-			_mag.set(_voter_mag.get_best(curr_time, &best_mag));
+	if (!orb_copy(ORB_ID(sensor_imu), _imu_sub, &imu)) {
+		// Feed validator with recent sensor data
+		float gyro[3];
 
-			if (_accel.length() < 0.01f) {
-				warnx("WARNING: degenerate accel!");
-				continue;
-			}
+		for (unsigned j = 0; j < 3; j++) {
+			if (imu.gyro_integral_dt > 0) {
+				gyro[j] = (double)imu.gyro_integral_rad[j] / (imu.gyro_integral_dt / 1e6);
 
-			if (_mag.length() < 0.01f) {
-				warnx("WARNING: degenerate mag!");
-				continue;
+			} else {
+				/* fall back to angular rate */
+				gyro[j] = imu.gyro_rad_s[j];
 			}
+		}
 
-			_data_good = true;
+		/* the sensors module rates the instances, the error counts are not checked again here */
+		_voter_gyro.put(0, imu.timestamp, &gyro[0], 0, 100);
+		_voter_accel.put(0, imu.accelerometer_timestamp, &imu.accelerometer_m_s2[0], 0, 100);
 
-			if (!_failsafe) {
-				uint32_t flags = DataValidator::ERROR_FLAG_NO_ERROR;
+		bool sensors_updated = false;
+		orb_check(_sensors_sub, &sensors_updated);
 
-#ifdef __PX4_POSIX
-				perf_end(_perf_accel);
-				perf_end(_perf_mpu);
-				perf_end(_perf_mag);
-#endif
+		if (sensors_updated) {
+			sensor_combined_s sensors;
 
-				if (_voter_gyro.failover_count() > 0) {
-					_failsafe = true;
-					flags = _voter_gyro.failover_state();
-					mavlink_and_console_log_emergency(_mavlink_fd, "Gyro #%i failure :%s%s%s%s%s!",
-									  _voter_gyro.failover_index(),
-									  ((flags & DataValidator::ERROR_FLAG_NO_DATA) ? " No data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_STALE_DATA) ? " Stale data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_TIMEOUT) ? " Data timeout" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRCOUNT) ? " High error count" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRDENSITY) ? " High error density" : ""));
+			if (!orb_copy(ORB_ID(sensor_combined), _sensors_sub, &sensors)) {
+				for (unsigned i = 0; i < (sizeof(sensors.magnetometer_timestamp) / sizeof(sensors.magnetometer_timestamp[0])); i++) {
+					/* ignore empty fields */
+					if (sensors.magnetometer_timestamp[i] > 0) {
+						_voter_mag.put(i, sensors.magnetometer_timestamp[i], &sensors.magnetometer_ga[i * 3],
+							       sensors.magnetometer_errcount[i], sensors.magnetometer_priority[i]);
+					}
 				}
+			}
+		}
 
-				if (_voter_accel.failover_count() > 0) {
-					_failsafe = true;
-					flags = _voter_accel.failover_state();
-					mavlink_and_console_log_emergency(_mavlink_fd, "Accel #%i failure :%s%s%s%s%s!",
-									  _voter_accel.failover_index(),
-									  ((flags & DataValidator::ERROR_FLAG_NO_DATA) ? " No data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_STALE_DATA) ? " Stale data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_TIMEOUT) ? " Data timeout" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRCOUNT) ? " High error count" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRDENSITY) ? " High error density" : ""));
-				}
+		// Get best measurement values
+		hrt_abstime curr_time = hrt_absolute_time();
+		_gyro.set(_voter_gyro.get_best(curr_time, &best_gyro));
+		_accel.set(_voter_accel.get_best(curr_time, &best_accel));
+		_mag.set(_voter_mag.get_best(curr_time, &best_mag));
 
-				if (_voter_mag.failover_count() > 0) {
-					_failsafe = true;
-					flags = _voter_mag.failover_state();
-					mavlink_and_console_log_emergency(_mavlink_fd, "Mag #%i failure :%s%s%s%s%s!",
-									  _voter_mag.failover_index(),
-									  ((flags & DataValidator::ERROR_FLAG_NO_DATA) ? " No data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_STALE_DATA) ? " Stale data" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_TIMEOUT) ? " Data timeout" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRCOUNT) ? " High error count" : ""),
-									  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRDENSITY) ? " High error density" : ""));
-				}
+		if (_accel.length() < 0.01f) {
+			warnx("WARNING: degenerate accel!");
+			return;
+		}
 
-				if (_failsafe) {
-					mavlink_and_console_log_emergency(_mavlink_fd, "SENSOR FAILSAFE! RETURN TO LAND IMMEDIATELY");
-				}
+		if (_mag.length() < 0.01f) {
+			warnx("WARNING: degenerate mag!");
+			return;
+		}
+
+		_data_good = true;
+
+		if (!_failsafe) {
+			uint32_t flags = DataValidator::ERROR_FLAG_NO_ERROR;
+
+#ifdef __PX4_POSIX
+			perf_end(_perf_accel);
+			perf_end(_perf_mpu);
+			perf_end(_perf_mag);
+#endif
+
+			/* gyro and accel failures are handled by the selection in the sensors module */
+			if (_voter_mag.failover_count() > 0) {
+				_failsafe = true;
+				flags = _voter_mag.failover_state();
+				mavlink_and_console_log_emergency(_mavlink_fd, "Mag #%i failure :%s%s%s%s%s!",
+								  _voter_mag.failover_index(),
+								  ((flags & DataValidator::ERROR_FLAG_NO_DATA) ? " No data" : ""),
+								  ((flags & DataValidator::ERROR_FLAG_STALE_DATA) ? " Stale data" : ""),
+								  ((flags & DataValidator::ERROR_FLAG_TIMEOUT) ? " Data timeout" : ""),
+								  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRCOUNT) ? " High error count" : ""),
+								  ((flags & DataValidator::ERROR_FLAG_HIGH_ERRDENSITY) ? " High error density" : ""));
 			}
 
-			if (!_vibration_warning && (_voter_gyro.get_vibration_factor(curr_time) > _vibration_warning_threshold ||
-						    _voter_accel.get_vibration_factor(curr_time) > _vibration_warning_threshold ||
-						    _voter_mag.get_vibration_factor(curr_time) > _vibration_warning_threshold)) {
+			if (_failsafe) {
+				mavlink_and_console_log_emergency(_mavlink_fd, "SENSOR FAILSAFE! RETURN TO LAND IMMEDIATELY");
+			}
+		}
 
-				if (_vibration_warning_timestamp == 0) {
-					_vibration_warning_timestamp = curr_time;
+		if (!_vibration_warning && (_voter_gyro.get_vibration_factor(curr_time) > _vibration_warning_threshold ||
+					    _voter_accel.get_vibration_factor(curr_time) > _vibration_warning_threshold ||
+					    _voter_mag.get_vibration_factor(curr_time) > _vibration_warning_threshold)) {
 
-				} else if (hrt_elapsed_time(&_vibration_warning_timestamp) > 10000000) {
-					_vibration_warning = true;
-					mavlink_and_console_log_critical(_mavlink_fd, "HIGH VIBRATION! g: %d a: %d m: %d",
-									 (int)(100 * _voter_gyro.get_vibration_factor(curr_time)),
-									 (int)(100 * _voter_accel.get_vibration_factor(curr_time)),
-									 (int)(100 * _voter_mag.get_vibration_factor(curr_time)));
-				}
+			if (_vibration_warning_timestamp == 0) {
+				_vibration_warning_timestamp = curr_time;
 
-			} else {
-				_vibration_warning_timestamp = 0;
+			} else if (hrt_elapsed_time(&_vibration_warning_timestamp) > 10000000) {
+				_vibration_warning = true;
+				mavlink_and_console_log_critical(_mavlink_fd, "HIGH VIBRATION! g: %d a: %d m: %d",
+								 (int)(100 * _voter_gyro.get_vibration_factor(curr_time)),
+								 (int)(100 * _voter_accel.get_vibration_factor(curr_time)),
+								 (int)(100 * _voter_mag.get_vibration_factor(curr_time)));
 			}
+
+		} else {
+			_vibration_warning_timestamp = 0;
 		}
+	}
 
-		// Update vision and motion capture heading
-		bool vision_updated = false;
-		orb_check(_vision_sub, &vision_updated);
+	// Update vision and motion capture heading
+	bool vision_updated = false;
+	orb_check(_vision_sub, &vision_updated);
 
-		bool mocap_updated = false;
-		orb_check(_mocap_sub, &mocap_updated);
+	bool mocap_updated = false;
+	orb_check(_mocap_sub, &mocap_updated);
 
-		if (vision_updated) {
-			orb_copy(ORB_ID(vision_position_estimate), _vision_sub, &_vision);
-			math::Quaternion q(_vision.q);
+	if (vision_updated) {
+		orb_copy(ORB_ID(vision_position_estimate), _vision_sub, &_vision);
+		math::Quaternion q(_vision.q);
 
-			math::Matrix<3, 3> Rvis = q.to_dcm();
-			math::Vector<3> v(1.0f, 0.0f, 0.4f);
+		math::Matrix<3, 3> Rvis = q.to_dcm();
+		math::Vector<3> v(1.0f, 0.0f, 0.4f);
 
-			// Rvis is Rwr (robot respect to world) while v is respect to world.
-			// Hence Rvis must be transposed having (Rwr)' * Vw
-			// Rrw * Vw = vn. This way we have consistency
-			_vision_hdg = Rvis.transposed() * v;
-		}
+		// Rvis is Rwr (robot respect to world) while v is respect to world.
+		// Hence Rvis must be transposed having (Rwr)' * Vw
+		// Rrw * Vw = vn. This way we have consistency
+		_vision_hdg = Rvis.transposed() * v;
+	}
 
-		if (mocap_updated) {
-			orb_copy(ORB_ID(att_pos_mocap), _mocap_sub, &_mocap);
-			math::Quaternion q(_mocap.q);
-			math::Matrix<3, 3> Rmoc = q.to_dcm();
+	if (mocap_updated) {
+		orb_copy(ORB_ID(att_pos_mocap), _mocap_sub, &_mocap);
+		math::Quaternion q(_mocap.q);
+		math::Matrix<3, 3> Rmoc = q.to_dcm();
 
-			math::Vector<3> v(1.0f, 0.0f, 0.4f);
+		math::Vector<3> v(1.0f, 0.0f, 0.4f);
 
-			// Rmoc is Rwr (robot respect to world) while v is respect to world.
-			// Hence Rmoc must be transposed having (Rwr)' * Vw
-			// Rrw * Vw = vn. This way we have consistency
-			_mocap_hdg = Rmoc.transposed() * v;
-		}
+		// Rmoc is Rwr (robot respect to world) while v is respect to world.
+		// Hence Rmoc must be transposed having (Rwr)' * Vw
+		// Rrw * Vw = vn. This way we have consistency
+		_mocap_hdg = Rmoc.transposed() * v;
+	}
 
-		// Update airspeed
-		bool airspeed_updated = false;
-		orb_check(_airspeed_sub, &airspeed_updated);
+	// Update airspeed
+	bool airspeed_updated = false;
+	orb_check(_airspeed_sub, &airspeed_updated);
 
-		if (airspeed_updated) {
-			orb_copy(ORB_ID(airspeed), _airspeed_sub, &_airspeed);
-		}
+	if (airspeed_updated) {
+		orb_copy(ORB_ID(airspeed), _airspeed_sub, &_airspeed);
+	}
 
-		// Check for timeouts on data
-		if (_ext_hdg_mode == 1) {
-			_ext_hdg_good = _vision.timestamp_boot > 0 && (hrt_elapsed_time(&_vision.timestamp_boot) < 500000);
+	// Check for timeouts on data
+	if (_ext_hdg_mode == 1) {
+		_ext_hdg_good = _vision.timestamp_boot > 0 && (hrt_elapsed_time(&_vision.timestamp_boot) < 500000);
 
-		} else if (_ext_hdg_mode == 2) {
-			_ext_hdg_good = _mocap.timestamp_boot > 0 && (hrt_elapsed_time(&_mocap.timestamp_boot) < 500000);
-		}
+	} else if (_ext_hdg_mode == 2) {
+		_ext_hdg_good = _mocap.timestamp_boot > 0 && (hrt_elapsed_time(&_mocap.timestamp_boot) < 500000);
+	}
 
-		bool gpos_updated;
-		orb_check(_global_pos_sub, &gpos_updated);
+	bool gpos_updated;
+	orb_check(_global_pos_sub, &gpos_updated);
 
-		if (gpos_updated) {
-			orb_copy(ORB_ID(vehicle_global_position), _global_pos_sub, &_gpos);
+	if (gpos_updated) {
+		orb_copy(ORB_ID(vehicle_global_position), _global_pos_sub, &_gpos);
 
-			if (_mag_decl_auto && _gpos.eph < 20.0f && hrt_elapsed_time(&_gpos.timestamp) < 1000000) {
-				/* set magnetic declination automatically */
-				update_mag_declination(math::radians(get_mag_declination(_gpos.lat, _gpos.lon)));
+		if (_mag_decl_auto && _gpos.eph < 20.0f && hrt_elapsed_time(&_gpos.timestamp) < 1000000) {
+			/* set magnetic declination automatically */
+			struct geo_mag_field_s field;
+
+			if (get_mag_field(&_mag_cache, _gpos.lat, _gpos.lon, &field) == 0) {
+				update_mag_declination(math::radians(field.declination));
 			}
 		}
+	}
 
-		if (_acc_comp && _gpos.timestamp != 0 && hrt_absolute_time() < _gpos.timestamp + 20000 && _gpos.eph < 5.0f && _inited) {
-			/* position data is actual */
-			if (gpos_updated) {
-				Vector<3> vel(_gpos.vel_n, _gpos.vel_e, _gpos.vel_d);
-
-				/* velocity updated */
-				if (_vel_prev_t != 0 && _gpos.timestamp != _vel_prev_t) {
-					float vel_dt = (_gpos.timestamp - _vel_prev_t) / 1000000.0f;
-					/* calculate acceleration in body frame */
-					_pos_acc = _q.conjugate_inversed((vel - _vel_prev) / vel_dt);
-				}
+	if (_acc_comp && _gpos.timestamp != 0 && hrt_absolute_time() < _gpos.timestamp + 20000 && _gpos.eph < 5.0f && _inited) {
+		/* position data is actual */
+		if (gpos_updated) {
+			Vector<3> vel(_gpos.vel_n, _gpos.vel_e, _gpos.vel_d);
 
-				_vel_prev_t = _gpos.timestamp;
-				_vel_prev = vel;
+			/* velocity updated */
+			if (_vel_prev_t != 0 && _gpos.timestamp != _vel_prev_t) {
+				float vel_dt = (_gpos.timestamp - _vel_prev_t) / 1000000.0f;
+				/* calculate acceleration in body frame */
+				_pos_acc = _q.conjugate_inversed((vel - _vel_prev) / vel_dt);
 			}
 
-		} else {
-			/* position data is outdated, reset acceleration */
-			_pos_acc.zero();
-			_vel_prev.zero();
-			_vel_prev_t = 0;
+			_vel_prev_t = _gpos.timestamp;
+			_vel_prev = vel;
 		}
 
-		/* time from previous iteration */
-		hrt_abstime now = hrt_absolute_time();
-		float dt = (last_time > 0) ? ((now  - last_time) / 1000000.0f) : 0.00001f;
-		last_time = now;
+	} else {
+		/* position data is outdated, reset acceleration */
+		_pos_acc.zero();
+		_vel_prev.zero();
+		_vel_prev_t = 0;
+	}
 
-		if (dt > _dt_max) {
-			dt = _dt_max;
-		}
+	/* time from previous iteration */
+	hrt_abstime now = hrt_absolute_time();
+	float dt = (_last_time > 0) ? ((now  - _last_time) / 1000000.0f) : 0.00001f;
+	_last_time = now;
 
-		if (!update(dt)) {
-			continue;
-		}
+	if (dt > _dt_max) {
+		dt = _dt_max;
+	}
 
-		Vector<3> euler = _q.to_euler();
+	if (!update(dt)) {
+		return;
+	}
 
-		struct vehicle_attitude_s att = {};
-		att.timestamp = sensors.timestamp;
+	Vector<3> euler = _q.to_euler();
 
-		att.roll = euler(0);
-		att.pitch = euler(1);
-		att.yaw = euler(2);
+	struct vehicle_attitude_s att = {};
+	att.timestamp = imu.timestamp;
+	att.timestamp_sample = imu.timestamp;
 
-		att.rollspeed = _rates(0);
-		att.pitchspeed = _rates(1);
-		att.yawspeed = _rates(2);
+	att.roll = euler(0);
+	att.pitch = euler(1);
+	att.yaw = euler(2);
 
-		for (int i = 0; i < 3; i++) {
-			att.g_comp[i] = _accel(i) - _pos_acc(i);
-		}
+	att.rollspeed = _rates(0);
+	att.pitchspeed = _rates(1);
+	att.yawspeed = _rates(2);
 
-		/* copy offsets */
-		memcpy(&att.rate_offsets, _gyro_bias.data, sizeof(att.rate_offsets));
+	for (int i = 0; i < 3; i++) {
+		att.g_comp[i] = _accel(i) - _pos_acc(i);
+	}
 
-		Matrix<3, 3> R = _q.to_dcm();
+	/* copy offsets */
+	memcpy(&att.rate_offsets, _gyro_bias.data, sizeof(att.rate_offsets));
 
-		/* copy rotation matrix */
-		memcpy(&att.R[0], R.data, sizeof(att.R));
-		att.R_valid = true;
-		memcpy(&att.q[0], _q.data, sizeof(att.q));
-		att.q_valid = true;
+	Matrix<3, 3> R = _q.to_dcm();
 
-		att.rate_vibration = _voter_gyro.get_vibration_factor(hrt_absolute_time());
-		att.accel_vibration = _voter_accel.get_vibration_factor(hrt_absolute_time());
-		att.mag_vibration = _voter_mag.get_vibration_factor(hrt_absolute_time());
+	/* copy rotation matrix */
+	memcpy(&att.R[0], R.data, sizeof(att.R));
+	att.R_valid = true;
+	memcpy(&att.q[0], _q.data, sizeof(att.q));
+	att.q_valid = true;
 
-		/* the instance count is not used here */
-		int att_inst;
-		orb_publish_auto(ORB_ID(vehicle_attitude), &_att_pub, &att, &att_inst, ORB_PRIO_HIGH);
+	att.rate_vibration = _voter_gyro.get_vibration_factor(hrt_absolute_time());
+	att.accel_vibration = _voter_accel.get_vibration_factor(hrt_absolute_time());
+	att.mag_vibration = _voter_mag.get_vibration_factor(hrt_absolute_time());
 
-		{
-			struct control_state_s ctrl_state = {};
+	/* the instance count is not used here */
+	int att_inst;
+	orb_publish_auto(ORB_ID(vehicle_attitude), &_att_pub, &att, &att_inst, ORB_PRIO_HIGH);
 
-			ctrl_state.timestamp = sensors.timestamp;
+	{
+		struct control_state_s ctrl_state = {};
 
-			/* attitude quaternions for control state */
-			ctrl_state.q[0] = _q(0);
-			ctrl_state.q[1] = _q(1);
-			ctrl_state.q[2] = _q(2);
-			ctrl_state.q[3] = _q(3);
+		ctrl_state.timestamp = imu.timestamp;
+		ctrl_state.timestamp_sample = imu.timestamp;
 
-			/* attitude rates for control state */
-			ctrl_state.roll_rate = _lp_roll_rate.apply(_rates(0));
+		/* attitude quaternions for control state */
+		ctrl_state.q[0] = _q(0);
+		ctrl_state.q[1] = _q(1);
+		ctrl_state.q[2] = _q(2);
+		ctrl_state.q[3] = _q(3);
 
-			ctrl_state.pitch_rate = _lp_pitch_rate.apply(_rates(1));
+		/* attitude rates for control state */
+		ctrl_state.roll_rate = _lp_roll_rate.apply(_rates(0));
 
-			ctrl_state.yaw_rate = _lp_yaw_rate.apply(_rates(2));
+		ctrl_state.pitch_rate = _lp_pitch_rate.apply(_rates(1));
 
-			/* Airspeed - take airspeed measurement directly here as no wind is estimated */
-			if (PX4_ISFINITE(_airspeed.indicated_airspeed_m_s) && hrt_absolute_time() - _airspeed.timestamp < 1e6
-			    && _airspeed.timestamp > 0) {
-				ctrl_state.airspeed = _airspeed.indicated_airspeed_m_s;
-				ctrl_state.airspeed_valid = true;
+		ctrl_state.yaw_rate = _lp_yaw_rate.apply(_rates(2));
 
-			} else {
-				ctrl_state.airspeed_valid = false;
-			}
+		/* Airspeed - take airspeed measurement directly here as no wind is estimated */
+		if (PX4_ISFINITE(_airspeed.indicated_airspeed_m_s) && hrt_absolute_time() - _airspeed.timestamp < 1e6
+		    && _airspeed.timestamp > 0) {
+			ctrl_state.airspeed = _airspeed.indicated_airspeed_m_s;
+			ctrl_state.airspeed_valid = true;
 
-			/* the instance count is not used here */
-			int ctrl_inst;
-			/* publish to control state topic */
-			orb_publish_auto(ORB_ID(control_state), &_ctrl_state_pub, &ctrl_state, &ctrl_inst, ORB_PRIO_HIGH);
+		} else {
+			ctrl_state.airspeed_valid = false;
 		}
 
-		{
-			struct estimator_status_s est = {};
+		/* the instance count is not used here */
+		int ctrl_inst;
+		/* publish to control state topic */
+		orb_publish_auto(ORB_ID(control_state), &_ctrl_state_pub, &ctrl_state, &ctrl_inst, ORB_PRIO_HIGH);
+		latency_record(LATENCY_STAGE_ESTIMATOR, ctrl_state.timestamp_sample);
+	}
 
-			est.timestamp = sensors.timestamp;
-			est.vibe[0] = _voter_accel.get_vibration_offset(est.timestamp, 0);
-			est.vibe[1] = _voter_accel.get_vibration_offset(est.timestamp, 1);
-			est.vibe[2] = _voter_accel.get_vibration_offset(est.timestamp, 2);
+	{
+		struct estimator_status_s est = {};
 
-			/* the instance count is not used here */
-			int est_inst;
-			/* publish to control state topic */
-			orb_publish_auto(ORB_ID(estimator_status), &_est_state_pub, &est, &est_inst, ORB_PRIO_HIGH);
-		}
+		est.timestamp = imu.timestamp;
+		est.vibe[0] = _voter_accel.get_vibration_offset(est.timestamp, 0);
+		est.vibe[1] = _voter_accel.get_vibration_offset(est.timestamp, 1);
+		est.vibe[2] = _voter_accel.get_vibration_offset(est.timestamp, 2);
+
+		/* the instance count is not used here */
+		int est_inst;
+		/* publish to control state topic */
+		orb_publish_auto(ORB_ID(estimator_status), &_est_state_pub, &est, &est_inst, ORB_PRIO_HIGH);
 	}
 }
 
@@ -36,6 +36,12 @@
 *
 * Preflight check for main system components
 *
+* The sensor checks are described by a table. All instances of all sensor
+* types are checked concurrently: the device is only opened for the
+* calibration and self test ioctls, and a passed device check is reused as
+* long as the calibration parameters are unchanged and the instance keeps
+* publishing fresh data without new errors.
+*
 * @author Lorenz Meier <lorenz@px4.io>
 * @author Johan Jansen <jnsn.johan@gmail.com>
 */
@@ -50,6 +56,8 @@
 #include <errno.h>
 #include <math.h>
 #include <poll.h>
+#include <pthread.h>
+#include <stddef.h>
 
 #include <systemlib/err.h>
 #include <systemlib/param/param.h>
@@ -63,6 +71,10 @@
 #include <drivers/drv_airspeed.h>
 
 #include <uORB/topics/airspeed.h>
+#include <uORB/topics/sensor_accel.h>
+#include <uORB/topics/sensor_baro.h>
+#include <uORB/topics/sensor_gyro.h>
+#include <uORB/topics/sensor_mag.h>
 #include <uORB/topics/vehicle_gps_position.h>
 
 #include <mavlink/mavlink_log.h>
@@ -76,9 +88,22 @@ using namespace DriverFramework;
 namespace Commander
 {
 
-static int check_calibration(DevHandle &h, const char* param_template, int &devid)
+/**
+ * Check the calibration of a device.
+ *
+ * Also returns the calibration param that holds the device id, or the param
+ * of the given instance if no param holds it, with the generation read before
+ * its value. A change of that param invalidates the cached result.
+ */
+static int check_calibration(DevHandle &h, const char* param_template, unsigned instance, int &devid,
+			     param_t &cal_param, uint32_t &cal_generation)
 {
 	bool calibration_found;
+	char s[20];
+
+	sprintf(s, param_template, instance);
+	cal_param = param_find(s);
+	cal_generation = param_get_generation(cal_param);
 
 	/* new style: ask device for calibration state */
 	int ret = h.ioctl(SENSORIOCCALTEST, 0);
@@ -87,12 +112,11 @@ static int check_calibration(DevHandle &h, const char* param_template, int &devi
 	
 	devid = h.ioctl(DEVIOCGDEVICEID, 0);
 
-	char s[20];
-	int instance = 0;
+	int slot = 0;
 
-	/* old style transition: check param values */
-	while (!calibration_found) {
-		sprintf(s, param_template, instance);
+	/* old style transition: check param values, always done to find the param of the device */
+	while (true) {
+		sprintf(s, param_template, slot);
 		param_t parm = param_find(s);
 
 		/* if the calibration param is not present, abort */
@@ -100,6 +124,8 @@ static int check_calibration(DevHandle &h, const char* param_template, int &devi
 			break;
 		}
 
+		uint32_t generation = param_get_generation(parm);
+
 		/* if param get succeeds */
 		int calibration_devid;
 		if (!param_get(parm, &(calibration_devid))) {
@@ -107,221 +133,304 @@ static int check_calibration(DevHandle &h, const char* param_template, int &devi
 			/* if the devid matches, exit early */
 			if (devid == calibration_devid) {
 				calibration_found = true;
+				cal_param = parm;
+				cal_generation = generation;
 				break;
 			}
 		}
-		instance++;
+		slot++;
 	}
 
 	return !calibration_found;
 }
 
-static bool magnometerCheck(int mavlink_fd, unsigned instance, bool optional, int &device_id, bool report_fail)
-{
-	bool success = true;
-
-	char s[30];
-	sprintf(s, "%s%u", MAG_BASE_DEVICE_PATH, instance);
-	DevHandle h;
-	DevMgr::getHandle(s, h);
+enum check_result_t {
+	CHECK_OK = 0,
+	CHECK_MISSING,
+	CHECK_UNCALIBRATED,
+	CHECK_SELFTEST_FAILED,
+	CHECK_RANGE,
+	CHECK_READ_FAILED
+};
 
-	if (!h.isValid()) {
-		if (!optional) {
-			if (report_fail) {
-				mavlink_and_console_log_critical(mavlink_fd,
-							 "PREFLIGHT FAIL: NO MAG SENSOR #%u", instance);
-			}
-		}
+/**
+ * One sensor type, checked on every instance up to optional_count.
+ */
+struct sensor_check_s {
+	const char *name;		///< as used in the messages, e.g. "ACCEL"
+	const char *prime_name;		///< for the missing primary sensor warning
+	const char *device_path;	///< base path, the instance number is appended
+	const char *cal_param;		///< template of the calibration device id params, nullptr if there is no calibration
+	const char *prime_param;
+	int selftest_ioctl;		///< 0 if the driver has no self test
+	const struct orb_metadata *topic;
+	size_t timestamp_offset;	///< of the timestamp in the uORB message
+	size_t error_count_offset;	///< of the error count in the uORB message
+	unsigned mandatory_count;
+	unsigned optional_count;
+};
+
+enum sensor_type_t {
+	SENSOR_MAG = 0,
+	SENSOR_ACCEL,
+	SENSOR_GYRO,
+	SENSOR_BARO,
+	SENSOR_TYPE_COUNT
+};
+
+static const sensor_check_s sensor_checks[SENSOR_TYPE_COUNT] = {
+	{
+		"MAG", "compass", MAG_BASE_DEVICE_PATH, "CAL_MAG%u_ID", "CAL_MAG_PRIME", MAGIOCSELFTEST,
+		ORB_ID(sensor_mag), offsetof(sensor_mag_s, timestamp), offsetof(sensor_mag_s, error_count),
+		max_mandatory_mag_count, max_optional_mag_count
+	},
+	{
+		"ACCEL", "accelerometer", ACCEL_BASE_DEVICE_PATH, "CAL_ACC%u_ID", "CAL_ACC_PRIME", ACCELIOCSELFTEST,
+		ORB_ID(sensor_accel), offsetof(sensor_accel_s, timestamp), offsetof(sensor_accel_s, error_count),
+		max_mandatory_accel_count, max_optional_accel_count
+	},
+	{
+		"GYRO", "gyro", GYRO_BASE_DEVICE_PATH, "CAL_GYRO%u_ID", "CAL_GYRO_PRIME", GYROIOCSELFTEST,
+		ORB_ID(sensor_gyro), offsetof(sensor_gyro_s, timestamp), offsetof(sensor_gyro_s, error_count),
+		max_mandatory_gyro_count, max_optional_gyro_count
+	},
+	{
+		// TODO: There is no baro calibration yet, since no external baros exist
+		"BARO", "barometer", BARO_BASE_DEVICE_PATH, nullptr, "CAL_BARO_PRIME", 0,
+		ORB_ID(sensor_baro), offsetof(sensor_baro_s, timestamp), offsetof(sensor_baro_s, error_count),
+		max_mandatory_baro_count, max_optional_baro_count
+	},
+};
+
+static const unsigned max_instance_count = 3;
+
+/* a cached result is only used while the instance publishes at least this often */
+static const hrt_abstime sensor_data_timeout = 500 * 1000;
 
-		return false;
-	}
+/**
+ * State of one sensor instance, kept between the checks.
+ */
+struct sensor_state_s {
+	int sub;			///< uORB subscription, -1 until the instance is advertised
+	int device_id;
+	check_result_t result;
+	bool valid;			///< the last device check passed and can be reused
+	bool cached;			///< the last result was taken from the cache
+	param_t cal_param;		///< calibration param of the device, PARAM_INVALID if there is none
+	uint32_t param_generation;	///< of cal_param at the last device check
+	uint64_t error_count;		///< reported by the driver at the last device check
+	hrt_abstime duration;		///< time taken by the last check
+};
 
-	int ret = check_calibration(h, "CAL_MAG%u_ID", device_id);
+/**
+ * Device check of one instance, run by a worker thread.
+ */
+struct device_job_s {
+	const sensor_check_s *check;
+	unsigned instance;
+	sensor_state_s *state;
+	pthread_t thread;
+	bool started;
+};
+
+struct aux_timing_s {
+	const char *name;
+	bool enabled;
+	bool passed;
+	hrt_abstime duration;
+};
+
+enum aux_check_t {
+	AUX_AIRSPEED = 0,
+	AUX_RC,
+	AUX_GNSS,
+	AUX_CHECK_COUNT
+};
+
+/* serializes the callers, the commander main and low priority threads both run checks */
+static pthread_mutex_t check_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool states_initialized = false;
+static sensor_state_s sensor_states[SENSOR_TYPE_COUNT][max_instance_count];
+static aux_timing_s aux_timing[AUX_CHECK_COUNT] = {
+	{"AIRSPEED", false, false, 0},
+	{"RC", false, false, 0},
+	{"GNSS", false, false, 0},
+};
+static hrt_abstime last_check_duration = 0;
+static int gps_sub = -1;
+
+/* workers only run a few ioctls and param lookups */
+static const size_t device_job_stack_size = 1200;
 
-	if (ret) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: MAG #%u UNCALIBRATED", instance);
+/**
+ * Copy the latest sample of an instance.
+ *
+ * @return true if the instance publishes and the sample is recent
+ */
+static bool sensor_sample(const sensor_check_s &check, unsigned instance, sensor_state_s &state, void *buf)
+{
+	if (state.sub < 0) {
+		if (orb_exists(check.topic, instance) != OK) {
+			return false;
 		}
-		success = false;
-		goto out;
-	}
 
-	ret = h.ioctl(MAGIOCSELFTEST, 0);
+		state.sub = orb_subscribe_multi(check.topic, instance);
 
-	if (ret != OK) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: MAG #%u SELFTEST FAILED", instance);
+		if (state.sub < 0) {
+			return false;
 		}
-		success = false;
-		goto out;
 	}
 
-out:
-	DevMgr::releaseHandle(h);
-	return success;
+	if (orb_copy(check.topic, state.sub, buf) != OK) {
+		return false;
+	}
+
+	hrt_abstime timestamp;
+	memcpy(&timestamp, (const uint8_t *)buf + check.timestamp_offset, sizeof(timestamp));
+
+	return timestamp != 0 && hrt_elapsed_time(&timestamp) < sensor_data_timeout;
 }
 
-static bool accelerometerCheck(int mavlink_fd, unsigned instance, bool optional, bool dynamic, int &device_id, bool report_fail)
+static uint64_t sensor_error_count(const sensor_check_s &check, const void *buf)
 {
-	bool success = true;
+	uint64_t error_count;
+	memcpy(&error_count, (const uint8_t *)buf + check.error_count_offset, sizeof(error_count));
+	return error_count;
+}
+
+static check_result_t deviceCheck(const sensor_check_s &check, unsigned instance, sensor_state_s &state)
+{
+	state.cal_param = PARAM_INVALID;
+	state.param_generation = 0;
 
 	char s[30];
-	sprintf(s, "%s%u", ACCEL_BASE_DEVICE_PATH, instance);
+	sprintf(s, "%s%u", check.device_path, instance);
 	DevHandle h;
 	DevMgr::getHandle(s, h);
 
 	if (!h.isValid()) {
-		if (!optional) {
-			if (report_fail) {
-				mavlink_and_console_log_critical(mavlink_fd,
-							 "PREFLIGHT FAIL: NO ACCEL SENSOR #%u", instance);
-			}
-		}
-
-		return false;
+		return CHECK_MISSING;
 	}
 
-	int ret = check_calibration(h, "CAL_ACC%u_ID", device_id);
+	check_result_t result = CHECK_OK;
 
-	if (ret) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: ACCEL #%u UNCALIBRATED", instance);
-		}
-		success = false;
-		goto out;
-	}
+	if (check.cal_param == nullptr) {
+		state.device_id = -1000;
 
-	ret = h.ioctl(ACCELIOCSELFTEST, 0);
-
-	if (ret != OK) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: ACCEL #%u TEST FAILED: %d", instance, ret);
-		}
-		success = false;
-		goto out;
+	} else if (check_calibration(h, check.cal_param, instance, state.device_id, state.cal_param,
+				     state.param_generation)) {
+		result = CHECK_UNCALIBRATED;
 	}
 
-#ifdef __PX4_NUTTX
-	if (dynamic) {
-		/* check measurement result range */
-		struct accel_report acc;
-		ret = h.read(&acc, sizeof(acc));
-
-		if (ret == sizeof(acc)) {
-			/* evaluate values */
-			float accel_magnitude = sqrtf(acc.x * acc.x + acc.y * acc.y + acc.z * acc.z);
-
-			if (accel_magnitude < 4.0f || accel_magnitude > 15.0f /* m/s^2 */) {
-				if (report_fail) {
-					mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: ACCEL RANGE, hold still on arming");
-				}
-				/* this is frickin' fatal */
-				success = false;
-				goto out;
-			}
-		} else {
-			if (report_fail) {
-				mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: ACCEL READ");
-			}
-			/* this is frickin' fatal */
-			success = false;
-			goto out;
-		}
+	if (result == CHECK_OK && check.selftest_ioctl != 0 && h.ioctl(check.selftest_ioctl, 0) != OK) {
+		result = CHECK_SELFTEST_FAILED;
 	}
-#endif
 
-out:
 	DevMgr::releaseHandle(h);
-	return success;
+	return result;
 }
 
-static bool gyroCheck(int mavlink_fd, unsigned instance, bool optional, int &device_id, bool report_fail)
+static void *device_job_main(void *arg)
 {
-	bool success = true;
+	device_job_s *job = (device_job_s *)arg;
+	hrt_abstime start = hrt_absolute_time();
 
-	char s[30];
-	sprintf(s, "%s%u", GYRO_BASE_DEVICE_PATH, instance);
-	DevHandle h;
-	DevMgr::getHandle(s, h);
+	job->state->result = deviceCheck(*job->check, job->instance, *job->state);
+	job->state->duration = hrt_elapsed_time(&start);
 
-	if (!h.isValid()) {
-		if (!optional) {
-			if (report_fail) {
-				mavlink_and_console_log_critical(mavlink_fd,
-							 "PREFLIGHT FAIL: NO GYRO SENSOR #%u", instance);
-			}
-		}
+	return nullptr;
+}
 
+/**
+ * Decide if the last device check of an instance still holds, otherwise
+ * prepare a device check for it.
+ *
+ * @return true if a device check is required
+ */
+static bool prepareSensorCheck(const sensor_check_s &check, unsigned instance, sensor_state_s &state)
+{
+	union {
+		sensor_mag_s mag;
+		sensor_accel_s accel;
+		sensor_gyro_s gyro;
+		sensor_baro_s baro;
+	} sample;
+
+	hrt_abstime start = hrt_absolute_time();
+	/* only the calibration of this instance invalidates its result */
+	uint32_t generation = param_get_generation(state.cal_param);
+	bool publishing = sensor_sample(check, instance, state, &sample);
+	uint64_t error_count = publishing ? sensor_error_count(check, &sample) : 0;
+
+	if (state.valid && publishing && generation == state.param_generation && error_count == state.error_count) {
+		state.result = CHECK_OK;
+		state.cached = true;
+		state.duration = hrt_elapsed_time(&start);
 		return false;
 	}
 
-	int ret = check_calibration(h, "CAL_GYRO%u_ID", device_id);
+	state.valid = false;
+	state.cached = false;
+	state.device_id = -1;
+	state.error_count = error_count;
+	return true;
+}
 
-	if (ret) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: GYRO #%u UNCALIBRATED", instance);
-		}
-		success = false;
-		goto out;
+#ifdef __PX4_NUTTX
+static bool accelerometerRangeCheck(unsigned instance, sensor_state_s &state, check_result_t &result)
+{
+	sensor_accel_s acc;
+
+	if (!sensor_sample(sensor_checks[SENSOR_ACCEL], instance, state, &acc)) {
+		result = CHECK_READ_FAILED;
+		return false;
 	}
 
-	ret = h.ioctl(GYROIOCSELFTEST, 0);
+	/* evaluate values */
+	float accel_magnitude = sqrtf(acc.x * acc.x + acc.y * acc.y + acc.z * acc.z);
 
-	if (ret != OK) {
-		if (report_fail) {
-			mavlink_and_console_log_critical(mavlink_fd,
-						 "PREFLIGHT FAIL: GYRO #%u SELFTEST FAILED", instance);
-		}
-		success = false;
-		goto out;
+	if (accel_magnitude < 4.0f || accel_magnitude > 15.0f /* m/s^2 */) {
+		result = CHECK_RANGE;
+		return false;
 	}
 
-out:
-	DevMgr::releaseHandle(h);
-	return success;
+	return true;
 }
+#endif
 
-static bool baroCheck(int mavlink_fd, unsigned instance, bool optional, int &device_id, bool report_fail)
+static void reportSensorFailure(int mavlink_fd, const sensor_check_s &check, unsigned instance, bool optional,
+				check_result_t result)
 {
-	bool success = true;
-
-	char s[30];
-	sprintf(s, "%s%u", BARO_BASE_DEVICE_PATH, instance);
-	DevHandle h;
-	DevMgr::getHandle(s, h);
-
-	if (!h.isValid()) {
+	switch (result) {
+	case CHECK_MISSING:
 		if (!optional) {
-			if (report_fail) {
-				mavlink_and_console_log_critical(mavlink_fd,
-							 "PREFLIGHT FAIL: NO BARO SENSOR #%u", instance);
-			}
+			mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: NO %s SENSOR #%u", check.name, instance);
 		}
 
-		return false;
-	}
+		break;
 
-	device_id = -1000;
+	case CHECK_UNCALIBRATED:
+		mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: %s #%u UNCALIBRATED", check.name, instance);
+		break;
 
-	// TODO: There is no baro calibration yet, since no external baros exist
-	// int ret = check_calibration(fd, "CAL_BARO%u_ID");
+	case CHECK_SELFTEST_FAILED:
+		mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: %s #%u SELFTEST FAILED", check.name, instance);
+		break;
 
-	// if (ret) {
-	// 	mavlink_and_console_log_critical(mavlink_fd,
-	// 					 "PREFLIGHT FAIL: BARO #%u UNCALIBRATED", instance);
-	// 	success = false;
-	// 	goto out;
-	// }
+	case CHECK_RANGE:
+		/* this is frickin' fatal */
+		mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: %s RANGE, hold still on arming", check.name);
+		break;
 
-//out:
+	case CHECK_READ_FAILED:
+		/* this is frickin' fatal */
+		mavlink_and_console_log_critical(mavlink_fd, "PREFLIGHT FAIL: %s READ", check.name);
+		break;
 
-	DevMgr::releaseHandle(h);
-	return success;
+	default:
+		break;
+	}
 }
 
 static bool airspeedCheck(int mavlink_fd, bool optional, bool report_fail)
@@ -365,21 +474,29 @@ static bool gnssCheck(int mavlink_fd, bool report_fail)
 {
 	bool success = true;
 
-	int gpsSub = orb_subscribe(ORB_ID(vehicle_gps_position));
-
-	//Wait up to 2000ms to allow the driver to detect a GNSS receiver module
-	px4_pollfd_struct_t fds[1];
-	fds[0].fd = gpsSub;
-	fds[0].events = POLLIN;
-	if(px4_poll(fds, 1, 2000) <= 0) {
-		success = false;
+	/* the subscription is kept, a receiver that already publishes passes without waiting */
+	if (gps_sub < 0) {
+		gps_sub = orb_subscribe(ORB_ID(vehicle_gps_position));
 	}
-	else {
-		struct vehicle_gps_position_s gps;
-		if ( (OK != orb_copy(ORB_ID(vehicle_gps_position), gpsSub, &gps)) ||
-		    (hrt_elapsed_time(&gps.timestamp_position) > 1000000)) {
+
+	struct vehicle_gps_position_s gps;
+
+	if ((OK != orb_copy(ORB_ID(vehicle_gps_position), gps_sub, &gps)) ||
+	    (hrt_elapsed_time(&gps.timestamp_position) > 1000000)) {
+
+		//Wait up to 2000ms to allow the driver to detect a GNSS receiver module
+		px4_pollfd_struct_t fds[1];
+		fds[0].fd = gps_sub;
+		fds[0].events = POLLIN;
+		if(px4_poll(fds, 1, 2000) <= 0) {
 			success = false;
 		}
+		else {
+			if ( (OK != orb_copy(ORB_ID(vehicle_gps_position), gps_sub, &gps)) ||
+			    (hrt_elapsed_time(&gps.timestamp_position) > 1000000)) {
+				success = false;
+			}
+		}
 	}
 
 	//Report failure to detect module
@@ -389,7 +506,6 @@ static bool gnssCheck(int mavlink_fd, bool report_fail)
 		}
 	}
 
-	px4_close(gpsSub);
 	return success;
 }
 
@@ -397,148 +513,177 @@ bool preflightCheck(int mavlink_fd, bool checkMag, bool checkAcc, bool checkGyro
 		    bool checkBaro, bool checkAirspeed, bool checkRC, bool checkGNSS, bool checkDynamic, bool reportFailures)
 {
 	bool failed = false;
+	const bool enabled[SENSOR_TYPE_COUNT] = { checkMag, checkAcc, checkGyro, checkBaro };
 
-	/* ---- MAG ---- */
-	if (checkMag) {
-		bool prime_found = false;
-		int32_t prime_id = 0;
-		param_get(param_find("CAL_MAG_PRIME"), &prime_id);
+	pthread_mutex_lock(&check_mutex);
 
-		/* check all sensors, but fail only for mandatory ones */
-		for (unsigned i = 0; i < max_optional_mag_count; i++) {
-			bool required = (i < max_mandatory_mag_count);
-			int device_id = -1;
+	hrt_abstime check_start = hrt_absolute_time();
 
-			if (!magnometerCheck(mavlink_fd, i, !required, device_id, reportFailures) && required) {
-				failed = true;
+	if (!states_initialized) {
+		for (unsigned t = 0; t < SENSOR_TYPE_COUNT; t++) {
+			for (unsigned i = 0; i < max_instance_count; i++) {
+				memset(&sensor_states[t][i], 0, sizeof(sensor_states[t][i]));
+				sensor_states[t][i].sub = -1;
+				sensor_states[t][i].device_id = -1;
+				sensor_states[t][i].cal_param = PARAM_INVALID;
 			}
+		}
 
-			if (device_id == prime_id) {
-				prime_found = true;
-			}
+		states_initialized = true;
+	}
+
+	/* ---- SENSORS: start the device checks the cache can't answer ---- */
+	device_job_s jobs[SENSOR_TYPE_COUNT * max_instance_count];
+	unsigned job_count = 0;
+
+	pthread_attr_t job_attr;
+	pthread_attr_init(&job_attr);
+	pthread_attr_setstacksize(&job_attr, device_job_stack_size);
+
+	for (unsigned t = 0; t < SENSOR_TYPE_COUNT; t++) {
+		if (!enabled[t]) {
+			continue;
 		}
 
-		/* check if the primary device is present */
-		if (!prime_found && prime_id != 0) {
-			if (reportFailures) {
-				mavlink_and_console_log_critical(mavlink_fd, "Warning: Primary compass not found");
+		for (unsigned i = 0; i < sensor_checks[t].optional_count; i++) {
+			if (!prepareSensorCheck(sensor_checks[t], i, sensor_states[t][i])) {
+				continue;
+			}
+
+			device_job_s &job = jobs[job_count++];
+			job.check = &sensor_checks[t];
+			job.instance = i;
+			job.state = &sensor_states[t][i];
+			job.started = (pthread_create(&job.thread, &job_attr, device_job_main, &job) == 0);
+
+			if (!job.started) {
+				/* no thread available, check it in the caller */
+				device_job_main(&job);
 			}
-			failed = true;
 		}
 	}
 
-	/* ---- ACCEL ---- */
-	if (checkAcc) {
-		bool prime_found = false;
-		int32_t prime_id = 0;
-		param_get(param_find("CAL_ACC_PRIME"), &prime_id);
+	pthread_attr_destroy(&job_attr);
 
-		/* check all sensors, but fail only for mandatory ones */
-		for (unsigned i = 0; i < max_optional_accel_count; i++) {
-			bool required = (i < max_mandatory_accel_count);
-			int device_id = -1;
+	/* ---- the uORB based checks run while the workers wait for the devices ---- */
 
-			if (!accelerometerCheck(mavlink_fd, i, !required, checkDynamic, device_id, reportFailures) && required) {
-				failed = true;
-			}
+	/* ---- AIRSPEED ---- */
+	aux_timing[AUX_AIRSPEED].enabled = checkAirspeed;
 
-			if (device_id == prime_id) {
-				prime_found = true;
-			}
+	if (checkAirspeed) {
+		hrt_abstime start = hrt_absolute_time();
+		aux_timing[AUX_AIRSPEED].passed = airspeedCheck(mavlink_fd, true, reportFailures);
+		aux_timing[AUX_AIRSPEED].duration = hrt_elapsed_time(&start);
+
+		if (!aux_timing[AUX_AIRSPEED].passed) {
+			failed = true;
 		}
+	}
 
-		/* check if the primary device is present */
-		if (!prime_found && prime_id != 0) {
+	/* ---- RC CALIBRATION ---- */
+	aux_timing[AUX_RC].enabled = checkRC;
+
+	if (checkRC) {
+		hrt_abstime start = hrt_absolute_time();
+		aux_timing[AUX_RC].passed = (rc_calibration_check(mavlink_fd, reportFailures) == OK);
+		aux_timing[AUX_RC].duration = hrt_elapsed_time(&start);
+
+		if (!aux_timing[AUX_RC].passed) {
 			if (reportFailures) {
-				mavlink_and_console_log_critical(mavlink_fd, "Warning: Primary accelerometer not found");
+				mavlink_and_console_log_critical(mavlink_fd, "RC calibration check failed");
 			}
 			failed = true;
 		}
 	}
 
-	/* ---- GYRO ---- */
-	if (checkGyro) {
-		bool prime_found = false;
-		int32_t prime_id = 0;
-		param_get(param_find("CAL_GYRO_PRIME"), &prime_id);
+	/* ---- Global Navigation Satellite System receiver ---- */
+	aux_timing[AUX_GNSS].enabled = checkGNSS;
 
-		/* check all sensors, but fail only for mandatory ones */
-		for (unsigned i = 0; i < max_optional_gyro_count; i++) {
-			bool required = (i < max_mandatory_gyro_count);
-			int device_id = -1;
+	if (checkGNSS) {
+		hrt_abstime start = hrt_absolute_time();
+		aux_timing[AUX_GNSS].passed = gnssCheck(mavlink_fd, reportFailures);
+		aux_timing[AUX_GNSS].duration = hrt_elapsed_time(&start);
 
-			if (!gyroCheck(mavlink_fd, i, !required, device_id, reportFailures) && required) {
-				failed = true;
-			}
+		if (!aux_timing[AUX_GNSS].passed) {
+			failed = true;
+		}
+	}
 
-			if (device_id == prime_id) {
-				prime_found = true;
-			}
+	/* ---- SENSORS: collect the device checks ---- */
+	for (unsigned j = 0; j < job_count; j++) {
+		if (jobs[j].started) {
+			pthread_join(jobs[j].thread, nullptr);
 		}
 
-		/* check if the primary device is present */
-		if (!prime_found && prime_id != 0) {
-			if (reportFailures) {
-				mavlink_and_console_log_critical(mavlink_fd, "Warning: Primary gyro not found");
+		sensor_state_s &state = *jobs[j].state;
+
+		if (state.result == CHECK_OK) {
+			/* the self test may have counted errors, compare against the count after it */
+			union {
+				sensor_mag_s mag;
+				sensor_accel_s accel;
+				sensor_gyro_s gyro;
+				sensor_baro_s baro;
+			} sample;
+
+			if (sensor_sample(*jobs[j].check, jobs[j].instance, state, &sample)) {
+				state.error_count = sensor_error_count(*jobs[j].check, &sample);
+				state.valid = true;
 			}
-			failed = true;
 		}
 	}
 
-	/* ---- BARO ---- */
-	if (checkBaro) {
+	/* ---- SENSORS: evaluate and report in table order ---- */
+	for (unsigned t = 0; t < SENSOR_TYPE_COUNT; t++) {
+		if (!enabled[t]) {
+			continue;
+		}
+
+		const sensor_check_s &check = sensor_checks[t];
 		bool prime_found = false;
 		int32_t prime_id = 0;
-		param_get(param_find("CAL_BARO_PRIME"), &prime_id);
+		param_get(param_find(check.prime_param), &prime_id);
 
 		/* check all sensors, but fail only for mandatory ones */
-		for (unsigned i = 0; i < max_optional_baro_count; i++) {
-			bool required = (i < max_mandatory_baro_count);
-			int device_id = -1;
+		for (unsigned i = 0; i < check.optional_count; i++) {
+			bool required = (i < check.mandatory_count);
+			sensor_state_s &state = sensor_states[t][i];
+			check_result_t result = state.result;
 
-			if (!baroCheck(mavlink_fd, i, !required, device_id, reportFailures) && required) {
-				failed = true;
+#ifdef __PX4_NUTTX
+			/* check measurement result range, this is never cached */
+			if (t == SENSOR_ACCEL && checkDynamic && result == CHECK_OK) {
+				accelerometerRangeCheck(i, state, result);
 			}
+#endif
 
-			if (device_id == prime_id) {
-				prime_found = true;
-			}
-		}
+			if (result != CHECK_OK) {
+				if (reportFailures) {
+					reportSensorFailure(mavlink_fd, check, i, !required, result);
+				}
 
-		// TODO there is no logic in place to calibrate the primary baro yet
-		// // check if the primary device is present 
-		if (!prime_found && prime_id != 0) {
-			if (reportFailures) {
-				mavlink_and_console_log_critical(mavlink_fd, "warning: primary barometer not operational");
+				if (required) {
+					failed = true;
+				}
 			}
-			failed = true;
-		}
-	}
 
-	/* ---- AIRSPEED ---- */
-	if (checkAirspeed) {
-		if (!airspeedCheck(mavlink_fd, true, reportFailures)) {
-			failed = true;
+			if (state.device_id == prime_id) {
+				prime_found = true;
+			}
 		}
-	}
 
-	/* ---- RC CALIBRATION ---- */
-	if (checkRC) {
-		if (rc_calibration_check(mavlink_fd, reportFailures) != OK) {
+		/* check if the primary device is present */
+		if (!prime_found && prime_id != 0) {
 			if (reportFailures) {
-				mavlink_and_console_log_critical(mavlink_fd, "RC calibration check failed");
+				mavlink_and_console_log_critical(mavlink_fd, "Warning: Primary %s not found", check.prime_name);
 			}
 			failed = true;
 		}
 	}
 
-	/* ---- Global Navigation Satellite System receiver ---- */
-	if (checkGNSS) {
-		if (!gnssCheck(mavlink_fd, reportFailures)) {
-			failed = true;
-		}
-	}
+	last_check_duration = hrt_elapsed_time(&check_start);
 
+	pthread_mutex_unlock(&check_mutex);
 
 #ifdef __PX4_QURT
 	// WARNING: Preflight checks are important and should be added back when
@@ -551,4 +696,41 @@ bool preflightCheck(int mavlink_fd, bool checkMag, bool checkAcc, bool checkGyro
 	return !failed;
 }
 
+void preflightCheckStatus()
+{
+	static const char *const result_names[] = { "ok", "missing", "uncalibrated", "selftest failed", "range", "read failed" };
+
+	pthread_mutex_lock(&check_mutex);
+
+	if (!states_initialized) {
+		pthread_mutex_unlock(&check_mutex);
+		PX4_INFO("preflight check not run yet");
+		return;
+	}
+
+	PX4_INFO("last preflight check: %.1f ms", (double)last_check_duration / 1e3);
+
+	for (unsigned t = 0; t < SENSOR_TYPE_COUNT; t++) {
+		for (unsigned i = 0; i < sensor_checks[t].optional_count; i++) {
+			const sensor_state_s &state = sensor_states[t][i];
+
+			if (state.result == CHECK_MISSING && i >= sensor_checks[t].mandatory_count) {
+				continue;
+			}
+
+			PX4_INFO("%-8s #%u id %8d: %-15s %7.1f ms%s", sensor_checks[t].name, i, state.device_id,
+				 result_names[state.result], (double)state.duration / 1e3, state.cached ? " (cached)" : "");
+		}
+	}
+
+	for (unsigned a = 0; a < AUX_CHECK_COUNT; a++) {
+		if (aux_timing[a].enabled) {
+			PX4_INFO("%-8s             : %-15s %7.1f ms", aux_timing[a].name, aux_timing[a].passed ? "ok" : "failed",
+				 (double)aux_timing[a].duration / 1e3);
+		}
+	}
+
+	pthread_mutex_unlock(&check_mutex);
+}
+
 }
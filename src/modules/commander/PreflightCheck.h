@@ -49,6 +49,9 @@ namespace Commander
 * The function won't fail the test if optional sensors are not found, however,
 * it will fail the test if optional sensors are found but not in working condition.
 *
+* All sensor instances are checked concurrently. A sensor that passed before is
+* not opened again while its calibration is unchanged and it keeps publishing.
+*
 * @param mavlink_fd
 *   Mavlink output file descriptor for feedback when a sensor fails
 * @param checkMag
@@ -69,6 +72,11 @@ namespace Commander
 bool preflightCheck(int mavlink_fd, bool checkMag, bool checkAcc,
     bool checkGyro, bool checkBaro, bool checkAirspeed, bool checkRC, bool checkGNSS, bool checkDynamic, bool reportFailures = false);
 
+/**
+* Print the result and duration of every check of the last preflight check
+**/
+void preflightCheckStatus();
+
 const unsigned max_mandatory_gyro_count = 1;
 const unsigned max_optional_gyro_count = 3;
 
@@ -97,6 +97,7 @@
 #include <uORB/topics/vehicle_land_detected.h>
 #include <uORB/topics/input_rc.h>
 #include <uORB/topics/vehicle_command_ack.h>
+#include <uORB/topics/task_load.h>
 
 #include <drivers/drv_led.h>
 #include <drivers/drv_hrt.h>
@@ -107,6 +108,7 @@
 #include <systemlib/systemlib.h>
 #include <systemlib/err.h>
 #include <systemlib/cpuload.h>
+#include <systemlib/printload.h>
 #include <systemlib/rc_check.h>
 #include <geo/geo.h>
 #include <systemlib/state_table.h>
@@ -209,6 +211,13 @@ static manual_control_setpoint_s _last_sp_man = {};
 
 static struct vtol_vehicle_status_s vtol_status = {};
 
+#ifndef __PX4_NUTTX
+/* the POSIX builds sample the load of the threads from the OS */
+static struct print_load_s load_state;
+static struct task_load_s task_load;
+static orb_advert_t task_load_pub = nullptr;
+#endif
+
 /**
  * The daemon app only briefly exists to start
  * the background job. The stack size assigned in the
@@ -392,6 +401,7 @@ int commander_main(int argc, char *argv[])
 		warnx("Preflight check: %s", (checkres == 0) ? "OK" : "FAILED");
 		checkres = preflight_check(&status, mavlink_fd_local, true, true);
 		warnx("Prearm check: %s", (checkres == 0) ? "OK" : "FAILED");
+		Commander::preflightCheckStatus();
 		px4_close(mavlink_fd_local);
 		return 0;
 	}
@@ -1325,7 +1335,11 @@ int commander_thread_main(int argc, char *argv[])
 	bool low_battery_voltage_actions_done = false;
 	bool critical_battery_voltage_actions_done = false;
 
+#ifdef __PX4_NUTTX
 	hrt_abstime last_idle_time = 0;
+#else
+	init_print_load_s(hrt_absolute_time(), &load_state);
+#endif
 
 	bool status_changed = true;
 	bool param_init_forced = true;
@@ -2009,6 +2023,7 @@ int commander_thread_main(int argc, char *argv[])
 		}
 
 		if (counter % (1000000 / COMMANDER_MONITORING_INTERVAL) == 0) {
+#ifdef __PX4_NUTTX
 			/* compute system load */
 			uint64_t interval_runtime = system_load.tasks[0].total_runtime - last_idle_time;
 
@@ -2017,6 +2032,21 @@ int commander_thread_main(int argc, char *argv[])
 			}
 
 			last_idle_time = system_load.tasks[0].total_runtime;
+#else
+
+			/* load of the flight stack process, relative to all cores */
+			if (print_load_sample(hrt_absolute_time(), &load_state, &task_load) == 0) {
+				status.load = task_load.load / (task_load.cpu_count > 0 ? task_load.cpu_count : 1);
+
+				if (task_load_pub != nullptr) {
+					orb_publish(ORB_ID(task_load), task_load_pub, &task_load);
+
+				} else {
+					task_load_pub = orb_advertise(ORB_ID(task_load), &task_load);
+				}
+			}
+
+#endif
 		}
 
 		/* if battery voltage is getting lower, warn using buzzer, etc. */
@@ -41,6 +41,7 @@
 #include "commander_helper.h"
 #include "calibration_routines.h"
 #include "calibration_messages.h"
+#include "mag_calibration_fit.h"
 
 #include <px4_posix.h>
 #include <px4_time.h>
@@ -68,9 +69,10 @@ static const int ERROR = -1;
 
 static const char *sensor_name = "mag";
 static constexpr unsigned max_mags = 3;
-static constexpr float mag_sphere_radius = 0.2f;
 static constexpr unsigned int calibration_sides = 6;			///< The total number of sides
-static constexpr unsigned int calibration_total_points = 240;		///< The total points per magnetometer
+static constexpr unsigned int calibration_total_points = 384;		///< The total points per magnetometer
+static constexpr unsigned int calibration_points_perbin = 3;		///< Samples per orientation bin, further samples are duplicates
+static constexpr unsigned int calibration_fit_interval = 8;		///< Update the fit center used for binning every n samples
 static constexpr unsigned int calibraton_duration_seconds = 42; 	///< The total duration the routine is allowed to take
 
 static constexpr float MAG_MAX_OFFSET_LEN = 0.6f;	///< The maximum measurement range is ~1.4 Ga, the earth field is ~0.6 Ga, so an offset larger than ~0.8-0.6 Ga means the mag will saturate in some directions.
@@ -82,6 +84,13 @@ int32_t device_id_primary = 0;
 
 calibrate_return mag_calibrate_all(int mavlink_fd, int32_t (&device_ids)[max_mags]);
 
+/// Samples and fit of one magnetometer
+struct mag_cal_s {
+	struct mag_sample_bins_s	bins;		///< Accepted samples per orientation
+	struct ellipsoid_fit_s		fit;		///< Incremental fit of the accepted samples
+	float				center[3];	///< Latest fit center, used for binning
+};
+
 /// Data passed to calibration worker routine
 typedef struct  {
 	int		mavlink_fd;
@@ -92,9 +101,7 @@ typedef struct  {
 	uint64_t	calibration_interval_perside_useconds;
 	unsigned int	calibration_counter_total[max_mags];
 	bool		side_data_collected[detect_orientation_side_count];
-	float*		x[max_mags];
-	float*		y[max_mags];
-	float*		z[max_mags];
+	struct mag_cal_s	*cal[max_mags];
 } mag_worker_data_t;
 
 
@@ -212,22 +219,35 @@ int do_mag_calibration(int mavlink_fd)
 	return result;
 }
 
-static bool reject_sample(float sx, float sy, float sz, float x[], float y[], float z[], unsigned count, unsigned max_count)
+/**
+ * Check whether a sample is a duplicate of the samples collected so far.
+ *
+ * @return the orientation bin of the sample, -1 to reject it
+ */
+static int reject_sample(const struct mag_cal_s *cal, float x, float y, float z)
 {
-	float min_sample_dist = fabsf(5.4f * mag_sphere_radius / sqrtf(max_count)) / 3.0f;
+	int bin = mag_sample_bins_index(x, y, z, cal->center);
 
-	for (size_t i = 0; i < count; i++) {
-		float dx = sx - x[i];
-		float dy = sy - y[i];
-		float dz = sz - z[i];
-		float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+	if (bin < 0 || mag_sample_bins_full(&cal->bins, bin, calibration_points_perbin)) {
+		return -1;
+	}
+
+	return bin;
+}
 
-		if (dist < min_sample_dist) {
-			return true;
+/* accept a sample, refitting the center used for binning as the samples arrive */
+static void accept_sample(struct mag_cal_s *cal, int bin, float x, float y, float z)
+{
+	mag_sample_bins_add(&cal->bins, bin);
+	ellipsoid_fit_add(&cal->fit, x, y, z);
+
+	if (cal->fit.n % calibration_fit_interval == 0) {
+		struct ellipsoid_fit_result_s result;
+
+		if (ellipsoid_fit_solve(&cal->fit, &result) == 0 || ellipsoid_fit_solve_sphere(&cal->fit, &result) == 0) {
+			memcpy(cal->center, result.center, sizeof(cal->center));
 		}
 	}
-
-	return false;
 }
 
 static unsigned progress_percentage(mag_worker_data_t* worker_data) {
@@ -337,38 +357,30 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 		
 		if (poll_ret > 0) {
 
-			int prev_count[max_mags];
+			struct mag_report mag[max_mags];
+			int bin[max_mags];
 			bool rejected = false;
 
 			for (size_t cur_mag=0; cur_mag<max_mags; cur_mag++) {
 
-				prev_count[cur_mag] = worker_data->calibration_counter_total[cur_mag];
-
 				if (worker_data->sub_mag[cur_mag] >= 0) {
-					struct mag_report mag;
-
-					orb_copy(ORB_ID(sensor_mag), worker_data->sub_mag[cur_mag], &mag);
+					orb_copy(ORB_ID(sensor_mag), worker_data->sub_mag[cur_mag], &mag[cur_mag]);
 
 					// Check if this measurement is good to go in
-					rejected = rejected || reject_sample(mag.x, mag.y, mag.z,
-						worker_data->x[cur_mag], worker_data->y[cur_mag], worker_data->z[cur_mag],
-						worker_data->calibration_counter_total[cur_mag],
-						calibration_sides * worker_data->calibration_points_perside);
-					
-					worker_data->x[cur_mag][worker_data->calibration_counter_total[cur_mag]] = mag.x;
-					worker_data->y[cur_mag][worker_data->calibration_counter_total[cur_mag]] = mag.y;
-					worker_data->z[cur_mag][worker_data->calibration_counter_total[cur_mag]] = mag.z;
-					worker_data->calibration_counter_total[cur_mag]++;
+					bin[cur_mag] = reject_sample(worker_data->cal[cur_mag], mag[cur_mag].x, mag[cur_mag].y, mag[cur_mag].z);
+					rejected = rejected || (bin[cur_mag] < 0);
 				}
 			}
 
-			// Keep calibration of all mags in lockstep
-			if (rejected) {
-				// Reset counts, since one of the mags rejected the measurement
+			// Keep calibration of all mags in lockstep, only take the measurement if no mag rejected it
+			if (!rejected) {
 				for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
-					worker_data->calibration_counter_total[cur_mag] = prev_count[cur_mag];
+					if (worker_data->sub_mag[cur_mag] >= 0) {
+						accept_sample(worker_data->cal[cur_mag], bin[cur_mag], mag[cur_mag].x, mag[cur_mag].y, mag[cur_mag].z);
+						worker_data->calibration_counter_total[cur_mag]++;
+					}
 				}
-			} else {
+
 				calibration_counter_side++;
 
 				// Progress indicator for side
@@ -389,6 +401,23 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 	}
 	
 	if (result == calibrate_return_ok) {
+		// Coverage and quality of the fit so far
+		for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
+			if (worker_data->sub_mag[cur_mag] >= 0) {
+				struct ellipsoid_fit_result_s fit;
+
+				if (ellipsoid_fit_solve(&worker_data->cal[cur_mag]->fit, &fit) == 0) {
+					mavlink_and_console_log_info(worker_data->mavlink_fd, "[cal] mag #%u coverage %u%%, fit error %.1f%%",
+								     (unsigned)cur_mag, mag_sample_bins_coverage(&worker_data->cal[cur_mag]->bins),
+								     (double)(100.0f * fit.residual));
+
+				} else {
+					mavlink_and_console_log_info(worker_data->mavlink_fd, "[cal] mag #%u coverage %u%%",
+								     (unsigned)cur_mag, mag_sample_bins_coverage(&worker_data->cal[cur_mag]->bins));
+				}
+			}
+		}
+
 		mavlink_and_console_log_info(worker_data->mavlink_fd, "[cal] %s side done, rotate to a different side", detect_orientation_str(orientation));
 		
 		worker_data->done_count++;
@@ -423,23 +452,22 @@ calibrate_return mag_calibrate_all(int mavlink_fd, int32_t (&device_ids)[max_mag
 		worker_data.sub_mag[cur_mag] = -1;
 		
 		// Initialize to no memory allocated
-		worker_data.x[cur_mag] = NULL;
-		worker_data.y[cur_mag] = NULL;
-		worker_data.z[cur_mag] = NULL;
+		worker_data.cal[cur_mag] = NULL;
 		worker_data.calibration_counter_total[cur_mag] = 0;
 	}
 
-	const unsigned int calibration_points_maxcount = calibration_sides * worker_data.calibration_points_perside;
-	
 	char str[30];
 	
+	// Samples are binned and fitted as they arrive, so the memory needed does not depend on the number of points
 	for (size_t cur_mag=0; cur_mag<max_mags; cur_mag++) {
-		worker_data.x[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
-		worker_data.y[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
-		worker_data.z[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
-		if (worker_data.x[cur_mag] == NULL || worker_data.y[cur_mag] == NULL || worker_data.z[cur_mag] == NULL) {
+		worker_data.cal[cur_mag] = reinterpret_cast<struct mag_cal_s *>(malloc(sizeof(struct mag_cal_s)));
+		if (worker_data.cal[cur_mag] == NULL) {
 			mavlink_and_console_log_critical(mavlink_fd, "[cal] ERROR: out of memory");
 			result = calibrate_return_error;
+		} else {
+			mag_sample_bins_reset(&worker_data.cal[cur_mag]->bins);
+			ellipsoid_fit_reset(&worker_data.cal[cur_mag]->fit);
+			memset(worker_data.cal[cur_mag]->center, 0, sizeof(worker_data.cal[cur_mag]->center));
 		}
 	}
 
@@ -507,23 +535,30 @@ calibrate_return mag_calibrate_all(int mavlink_fd, int32_t (&device_ids)[max_mag
 	float sphere_x[max_mags];
 	float sphere_y[max_mags];
 	float sphere_z[max_mags];
-	float sphere_radius[max_mags];
 	
-	// Sphere fit the data to get calibration values
+	// The fit has been updated with every sample, solving it is all that is left
 	if (result == calibrate_return_ok) {
 		for (unsigned cur_mag=0; cur_mag<max_mags; cur_mag++) {
 			if (device_ids[cur_mag] != 0) {
 				// Mag in this slot is available and we should have values for it to calibrate
-				
-				sphere_fit_least_squares(worker_data.x[cur_mag], worker_data.y[cur_mag], worker_data.z[cur_mag],
-							 worker_data.calibration_counter_total[cur_mag],
-							 100, 0.0f,
-							 &sphere_x[cur_mag], &sphere_y[cur_mag], &sphere_z[cur_mag],
-							 &sphere_radius[cur_mag]);
+				struct ellipsoid_fit_result_s fit;
+				bool ellipsoid = (ellipsoid_fit_solve(&worker_data.cal[cur_mag]->fit, &fit) == 0);
+
+				// Fall back to a sphere if the data does not determine the ellipsoid
+				if (!ellipsoid && ellipsoid_fit_solve_sphere(&worker_data.cal[cur_mag]->fit, &fit) != 0) {
+					fit.center[0] = NAN;
+					fit.center[1] = NAN;
+					fit.center[2] = NAN;
+				}
+
+				sphere_x[cur_mag] = fit.center[0];
+				sphere_y[cur_mag] = fit.center[1];
+				sphere_z[cur_mag] = fit.center[2];
 				
 				if (!PX4_ISFINITE(sphere_x[cur_mag]) || !PX4_ISFINITE(sphere_y[cur_mag]) || !PX4_ISFINITE(sphere_z[cur_mag])) {
 					mavlink_and_console_log_emergency(mavlink_fd, "ERROR: Retry calibration (sphere NaN, #%u)", cur_mag);
 					result = calibrate_return_error;
+					continue;
 				}
 
 				if (fabsf(sphere_x[cur_mag]) > MAG_MAX_OFFSET_LEN ||
@@ -534,58 +569,19 @@ calibrate_return mag_calibrate_all(int mavlink_fd, int32_t (&device_ids)[max_mag
 						(double)sphere_y[cur_mag], (double)sphere_z[cur_mag], cur_mag);
 					result = calibrate_return_ok;
 				}
-			}
-		}
-	}
-
-	// Print uncalibrated data points
-	if (result == calibrate_return_ok) {
-
-		printf("RAW DATA:\n--------------------\n");
-		for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
-
-			if (worker_data.calibration_counter_total[cur_mag] == 0) {
-				continue;
-			}
 
-			printf("RAW: MAG %u with %u samples:\n", (unsigned)cur_mag, (unsigned)worker_data.calibration_counter_total[cur_mag]);
-
-			for (size_t i = 0; i < worker_data.calibration_counter_total[cur_mag]; i++) {
-				float x = worker_data.x[cur_mag][i];
-				float y = worker_data.y[cur_mag][i];
-				float z = worker_data.z[cur_mag][i];
-				printf("%8.4f, %8.4f, %8.4f\n", (double)x, (double)y, (double)z);
+				printf("MAG %u: %u samples, coverage %u%%, %s fit\n", cur_mag, worker_data.calibration_counter_total[cur_mag],
+				       mag_sample_bins_coverage(&worker_data.cal[cur_mag]->bins), ellipsoid ? "ellipsoid" : "sphere");
+				printf("CENTER: %8.4f, %8.4f, %8.4f\n", (double)fit.center[0], (double)fit.center[1], (double)fit.center[2]);
+				printf("RADII: %8.4f, %8.4f, %8.4f\n", (double)fit.radii[0], (double)fit.radii[1], (double)fit.radii[2]);
+				printf("FIT ERROR: %8.4f\n", (double)fit.residual);
 			}
-
-			printf(">>>>>>>\n");
-		}
-
-		printf("CALIBRATED DATA:\n--------------------\n");
-		for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
-
-			if (worker_data.calibration_counter_total[cur_mag] == 0) {
-				continue;
-			}
-
-			printf("Calibrated: MAG %u with %u samples:\n", (unsigned)cur_mag, (unsigned)worker_data.calibration_counter_total[cur_mag]);
-
-			for (size_t i = 0; i < worker_data.calibration_counter_total[cur_mag]; i++) {
-				float x = worker_data.x[cur_mag][i] - sphere_x[cur_mag];
-				float y = worker_data.y[cur_mag][i] - sphere_y[cur_mag];
-				float z = worker_data.z[cur_mag][i] - sphere_z[cur_mag];
-				printf("%8.4f, %8.4f, %8.4f\n", (double)x, (double)y, (double)z);
-			}
-
-			printf("SPHERE RADIUS: %8.4f\n", (double)sphere_radius[cur_mag]);
-			printf(">>>>>>>\n");
 		}
 	}
-	
-	// Data points are no longer needed
+
+	// Samples are no longer needed
 	for (size_t cur_mag=0; cur_mag<max_mags; cur_mag++) {
-		free(worker_data.x[cur_mag]);
-		free(worker_data.y[cur_mag]);
-		free(worker_data.z[cur_mag]);
+		free(worker_data.cal[cur_mag]);
 	}
 	
 	if (result == calibrate_return_ok) {
@@ -0,0 +1,342 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mag_calibration_fit.cpp
+ *
+ * Orientation binned sample store and incremental ellipsoid fit used by
+ * the magnetometer calibration.
+ */
+
+#include "mag_calibration_fit.h"
+
+#include <math.h>
+#include <string.h>
+
+/* smallest pivot relative to the largest diagonal element accepted by the solver */
+static constexpr double fit_pivot_min = 1e-10;
+
+/* samples needed before a fit is attempted */
+static constexpr unsigned fit_min_samples = 12;
+
+/* largest ratio between the semi axes accepted from the ellipsoid fit */
+static constexpr float fit_max_axis_ratio = 2.0f;
+
+void mag_sample_bins_reset(struct mag_sample_bins_s *bins)
+{
+	memset(bins, 0, sizeof(*bins));
+}
+
+int mag_sample_bins_index(float x, float y, float z, const float center[3])
+{
+	float dx = x - center[0];
+	float dy = y - center[1];
+	float dz = z - center[2];
+	float norm = sqrtf(dx * dx + dy * dy + dz * dz);
+
+	if (!(norm > 1e-6f)) {
+		return -1;
+	}
+
+	/* bands uniform in z are of equal area on the sphere */
+	int band = (int)((dz / norm + 1.0f) * 0.5f * mag_bins_elevation);
+
+	if (band < 0) {
+		band = 0;
+
+	} else if (band >= (int)mag_bins_elevation) {
+		band = mag_bins_elevation - 1;
+	}
+
+	int sector = (int)((atan2f(dy, dx) + (float)M_PI) / (2.0f * (float)M_PI) * mag_bins_azimuth);
+
+	if (sector < 0) {
+		sector = 0;
+
+	} else if (sector >= (int)mag_bins_azimuth) {
+		sector = mag_bins_azimuth - 1;
+	}
+
+	return band * mag_bins_azimuth + sector;
+}
+
+bool mag_sample_bins_full(const struct mag_sample_bins_s *bins, int index, unsigned max_per_bin)
+{
+	return bins->count[index] >= max_per_bin;
+}
+
+void mag_sample_bins_add(struct mag_sample_bins_s *bins, int index)
+{
+	if (bins->count[index] == 0) {
+		bins->occupied++;
+	}
+
+	if (bins->count[index] < UINT8_MAX) {
+		bins->count[index]++;
+	}
+
+	bins->total++;
+}
+
+unsigned mag_sample_bins_coverage(const struct mag_sample_bins_s *bins)
+{
+	return (100 * bins->occupied) / mag_bins_count;
+}
+
+void ellipsoid_fit_reset(struct ellipsoid_fit_s *fit)
+{
+	memset(fit, 0, sizeof(*fit));
+}
+
+void ellipsoid_fit_add(struct ellipsoid_fit_s *fit, float x, float y, float z)
+{
+	const double phi[6] = {(double)x * x, (double)y * y, (double)z * z, x, y, z};
+
+	/* M is symmetric, accumulate the upper triangle only */
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = i; j < 6; j++) {
+			fit->M[i][j] += phi[i] * phi[j];
+		}
+
+		fit->v[i] += phi[i];
+	}
+
+	fit->n++;
+}
+
+/* solve A * x = b in place by gaussian elimination with partial pivoting */
+template<unsigned N>
+static int solve(double A[N][N], double b[N], double x[N])
+{
+	double scale = 0.0;
+
+	for (unsigned i = 0; i < N; i++) {
+		if (fabs(A[i][i]) > scale) {
+			scale = fabs(A[i][i]);
+		}
+	}
+
+	for (unsigned c = 0; c < N; c++) {
+		unsigned p = c;
+
+		for (unsigned r = c + 1; r < N; r++) {
+			if (fabs(A[r][c]) > fabs(A[p][c])) {
+				p = r;
+			}
+		}
+
+		if (!(fabs(A[p][c]) > fit_pivot_min * scale)) {
+			return -1;
+		}
+
+		if (p != c) {
+			for (unsigned j = 0; j < N; j++) {
+				double t = A[c][j];
+				A[c][j] = A[p][j];
+				A[p][j] = t;
+			}
+
+			double t = b[c];
+			b[c] = b[p];
+			b[p] = t;
+		}
+
+		for (unsigned r = c + 1; r < N; r++) {
+			double f = A[r][c] / A[c][c];
+
+			for (unsigned j = c; j < N; j++) {
+				A[r][j] -= f * A[c][j];
+			}
+
+			b[r] -= f * b[c];
+		}
+	}
+
+	for (int r = N - 1; r >= 0; r--) {
+		double s = b[r];
+
+		for (unsigned j = r + 1; j < N; j++) {
+			s -= A[r][j] * x[j];
+		}
+
+		x[r] = s / A[r][r];
+	}
+
+	return 0;
+}
+
+/* element of the symmetric sum, only the upper triangle is accumulated */
+static inline double fit_M(const struct ellipsoid_fit_s *fit, unsigned i, unsigned j)
+{
+	return (i <= j) ? fit->M[i][j] : fit->M[j][i];
+}
+
+int ellipsoid_fit_solve(const struct ellipsoid_fit_s *fit, struct ellipsoid_fit_result_s *result)
+{
+	if (fit->n < fit_min_samples) {
+		return -1;
+	}
+
+	double A[6][6];
+	double b[6];
+	double theta[6];
+
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = 0; j < 6; j++) {
+			A[i][j] = fit_M(fit, i, j);
+		}
+
+		b[i] = fit->v[i];
+	}
+
+	if (solve<6>(A, b, theta) != 0) {
+		return -1;
+	}
+
+	/* a*(x-cx)^2 + b*(y-cy)^2 + c*(z-cz)^2 = G */
+	double G = 1.0;
+	double center[3];
+
+	for (unsigned i = 0; i < 3; i++) {
+		if (!(theta[i] > 0.0)) {
+			return -1;
+		}
+
+		center[i] = -theta[3 + i] / (2.0 * theta[i]);
+		G += theta[i] * center[i] * center[i];
+	}
+
+	float r_min = 0.0f;
+	float r_max = 0.0f;
+
+	for (unsigned i = 0; i < 3; i++) {
+		result->center[i] = (float)center[i];
+		result->radii[i] = (float)sqrt(G / theta[i]);
+
+		if (i == 0 || result->radii[i] < r_min) {
+			r_min = result->radii[i];
+		}
+
+		if (i == 0 || result->radii[i] > r_max) {
+			r_max = result->radii[i];
+		}
+	}
+
+	/* poorly covered data fits degenerate ellipsoids */
+	if (!(r_max < fit_max_axis_ratio * r_min)) {
+		return -1;
+	}
+
+	/* sum of (phi' * theta - 1)^2 = theta' * M * theta - 2 * theta' * v + n,
+	 * phi' * theta - 1 is G times the relative squared radius error */
+	double sq = fit->n;
+
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = 0; j < 6; j++) {
+			sq += theta[i] * fit_M(fit, i, j) * theta[j];
+		}
+
+		sq -= 2.0 * theta[i] * fit->v[i];
+	}
+
+	result->residual = (sq > 0.0) ? (float)(sqrt(sq / fit->n) / (2.0 * G)) : 0.0f;
+
+	return 0;
+}
+
+int ellipsoid_fit_solve_sphere(const struct ellipsoid_fit_s *fit, struct ellipsoid_fit_result_s *result)
+{
+	if (fit->n < fit_min_samples) {
+		return -1;
+	}
+
+	/* w = x^2 + y^2 + z^2 = 2*A*x + 2*B*y + 2*C*z + D, linear in psi = [2x 2y 2z 1] */
+	double A[4][4];
+	double b[4];
+	double p[4];
+
+	for (unsigned i = 0; i < 3; i++) {
+		for (unsigned j = 0; j < 3; j++) {
+			A[i][j] = 4.0 * fit_M(fit, 3 + i, 3 + j);
+		}
+
+		A[i][3] = 2.0 * fit->v[3 + i];
+		A[3][i] = A[i][3];
+
+		/* sum of w * x_i */
+		b[i] = 2.0 * (fit_M(fit, 0, 3 + i) + fit_M(fit, 1, 3 + i) + fit_M(fit, 2, 3 + i));
+	}
+
+	A[3][3] = fit->n;
+	b[3] = fit->v[0] + fit->v[1] + fit->v[2];
+
+	/* sum of w^2 */
+	double w2 = fit_M(fit, 0, 0) + fit_M(fit, 1, 1) + fit_M(fit, 2, 2) +
+		    2.0 * (fit_M(fit, 0, 1) + fit_M(fit, 0, 2) + fit_M(fit, 1, 2));
+
+	/* keep the unmodified system for the residual */
+	double A0[4][4];
+	double b0[4];
+	memcpy(A0, A, sizeof(A));
+	memcpy(b0, b, sizeof(b));
+
+	if (solve<4>(A, b, p) != 0) {
+		return -1;
+	}
+
+	double r2 = p[3] + p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+
+	if (!(r2 > 0.0)) {
+		return -1;
+	}
+
+	for (unsigned i = 0; i < 3; i++) {
+		result->center[i] = (float)p[i];
+		result->radii[i] = (float)sqrt(r2);
+	}
+
+	/* sum of (w - psi' * p)^2, w - psi' * p is r^2 times the relative squared radius error */
+	double sq = w2;
+
+	for (unsigned i = 0; i < 4; i++) {
+		for (unsigned j = 0; j < 4; j++) {
+			sq += p[i] * A0[i][j] * p[j];
+		}
+
+		sq -= 2.0 * p[i] * b0[i];
+	}
+
+	result->residual = (sq > 0.0) ? (float)(sqrt(sq / fit->n) / (2.0 * r2)) : 0.0f;
+
+	return 0;
+}
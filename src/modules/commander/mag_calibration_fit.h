@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mag_calibration_fit.h
+ *
+ * Orientation binned sample store and incremental ellipsoid fit used by
+ * the magnetometer calibration.
+ *
+ * Samples are binned by the direction of the field relative to the current
+ * fit center on a fixed grid of equal area bins, so checking a new sample
+ * for duplicates is a single lookup. Accepted samples are accumulated into
+ * the normal equations of an axis aligned ellipsoid fit, the fit can be
+ * solved at any time without keeping the samples.
+ */
+
+#ifndef MAG_CALIBRATION_FIT_H_
+#define MAG_CALIBRATION_FIT_H_
+
+#include <stdint.h>
+
+static const unsigned mag_bins_elevation = 8;		///< Bands of equal area over the z component of the field direction
+static const unsigned mag_bins_azimuth = 16;		///< Sectors per band
+static const unsigned mag_bins_count = mag_bins_elevation * mag_bins_azimuth;
+
+/// Number of samples per bin and bins with at least one sample
+struct mag_sample_bins_s {
+	uint8_t		count[mag_bins_count];
+	unsigned	occupied;
+	unsigned	total;
+};
+
+/// Normal equations of the fit a*x^2 + b*y^2 + c*z^2 + d*x + e*y + f*z = 1
+struct ellipsoid_fit_s {
+	double		M[6][6];	///< Sum of phi * phi', phi = [x^2 y^2 z^2 x y z]
+	double		v[6];		///< Sum of phi
+	unsigned	n;		///< Number of samples
+};
+
+/// Result of solving the fit
+struct ellipsoid_fit_result_s {
+	float		center[3];	///< Offsets [Ga]
+	float		radii[3];	///< Semi axes [Ga]
+	float		residual;	///< RMS of the relative radius error of the samples
+};
+
+/// Empty the sample store
+void mag_sample_bins_reset(struct mag_sample_bins_s *bins);
+
+/// Bin of a sample for the given fit center
+///	@return Bin index, -1 if the sample is at the center
+int mag_sample_bins_index(float x, float y, float z, const float center[3]);
+
+/// Check whether a bin already holds the maximum number of samples
+bool mag_sample_bins_full(const struct mag_sample_bins_s *bins, int index, unsigned max_per_bin);
+
+/// Add a sample to a bin
+void mag_sample_bins_add(struct mag_sample_bins_s *bins, int index);
+
+/// Coverage of the sphere of field directions
+///	@return Percentage of bins holding at least one sample
+unsigned mag_sample_bins_coverage(const struct mag_sample_bins_s *bins);
+
+/// Reset the fit
+void ellipsoid_fit_reset(struct ellipsoid_fit_s *fit);
+
+/// Accumulate a sample into the fit, O(1) in the number of samples
+void ellipsoid_fit_add(struct ellipsoid_fit_s *fit, float x, float y, float z);
+
+/// Solve the ellipsoid fit for the samples so far.
+///	@return 0 on success, -1 if the samples do not determine an ellipsoid yet
+int ellipsoid_fit_solve(const struct ellipsoid_fit_s *fit, struct ellipsoid_fit_result_s *result);
+
+/// Solve a sphere fit from the same sums, for when the coverage is too poor for the ellipsoid.
+///	@return 0 on success, -1 if the samples do not determine a sphere
+int ellipsoid_fit_solve_sphere(const struct ellipsoid_fit_s *fit, struct ellipsoid_fit_result_s *result);
+
+#endif /* MAG_CALIBRATION_FIT_H_ */
@@ -49,7 +49,8 @@ namespace control
 {
 
 BlockParamBase::BlockParamBase(Block *parent, const char *name, bool parent_prefix) :
-	_handle(PARAM_INVALID)
+	_handle(PARAM_INVALID),
+	_generation(0)
 {
 	char fullname[blockNameLengthMax];
 
@@ -106,9 +107,9 @@ void BlockParam<T>::set(T val)
 template <class T>
 void BlockParam<T>::update()
 {
-	if (_handle != PARAM_INVALID) {
-		param_get(_handle, &_val);
-
+	// only copy values that changed in the param store since the last update,
+	// so a single param_set doesn't re-read every param of every block
+	if (_handle != PARAM_INVALID && param_get_if_changed(_handle, &_val, &_generation) > 0) {
 		if (_extern_address != NULL) {
 			*_extern_address = _val;
 		}
@@ -66,6 +66,7 @@ public:
 	const char *getName() { return param_name(_handle); }
 protected:
 	param_t _handle;
+	uint32_t _generation; /**< generation of the value last read from the param store */
 };
 
 /**
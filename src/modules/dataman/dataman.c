@@ -66,6 +66,8 @@ __EXPORT int dataman_main(int argc, char *argv[]);
 __EXPORT ssize_t dm_read(dm_item_t item, unsigned char index, void *buffer, size_t buflen);
 __EXPORT ssize_t dm_write(dm_item_t  item, unsigned char index, dm_persitence_t persistence, const void *buffer,
 			  size_t buflen);
+__EXPORT ssize_t dm_write_batch(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buffer,
+				size_t buflen, unsigned num);
 __EXPORT int dm_clear(dm_item_t item);
 __EXPORT void dm_lock(dm_item_t item);
 __EXPORT void dm_unlock(dm_item_t item);
@@ -77,6 +79,7 @@ typedef enum {
 	dm_read_func,
 	dm_clear_func,
 	dm_restart_func,
+	dm_write_batch_func,
 	dm_number_of_funcs
 } dm_function_t;
 
@@ -107,6 +110,14 @@ typedef struct {
 		struct {
 			dm_reset_reason reason;
 		} restart_params;
+		struct {
+			dm_item_t item;
+			unsigned char index;
+			dm_persitence_t persistence;
+			const void *buf;
+			size_t count;
+			unsigned num;
+		} write_batch_params;
 	};
 } work_q_item_t;
 
@@ -320,9 +331,9 @@ calculate_offset(dm_item_t item, unsigned char index)
  * The total size must not exceed k_sector_size
  */
 
-/* write to the data manager file */
+/* write to the data manager file, sync only flushes the file if set */
 static ssize_t
-_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count)
+_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count, bool sync)
 {
 	unsigned char buffer[k_sector_size];
 	size_t len;
@@ -358,7 +369,9 @@ _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const v
 	/* Seek to the right spot in the data manager file and write the data item */
 	if (lseek(g_task_fd, offset, SEEK_SET) == offset)
 		if ((len = write(g_task_fd, buffer, count)) == count) {
-			fsync(g_task_fd);        /* Make sure data is written to physical media */
+			if (sync) {
+				fsync(g_task_fd);        /* Make sure data is written to physical media */
+			}
 		}
 
 	/* Make sure the write succeeded */
@@ -370,6 +383,33 @@ _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const v
 	return count - DM_SECTOR_HDR_SIZE;
 }
 
+/* write consecutive items of the same size to the data manager file with a single flush at the end */
+static ssize_t
+_write_batch(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count,
+	     unsigned num)
+{
+	/* Check the whole range up front so that a batch is not written partially */
+	if (item >= DM_KEY_NUM_KEYS || num == 0 || (unsigned)index + num > g_per_item_max_index[item]) {
+		return -1;
+	}
+
+	const unsigned char *data = (const unsigned char *)buf;
+	ssize_t result = 0;
+
+	for (unsigned i = 0; i < num; i++) {
+		if (_write(item, index + i, persistence, data + i * count, count, false) != (ssize_t)count) {
+			result = -1;
+			break;
+		}
+
+		result += count;
+	}
+
+	fsync(g_task_fd);        /* Make sure data is written to physical media */
+
+	return result;
+}
+
 /* Retrieve from the data manager file */
 static ssize_t
 _read(dm_item_t item, unsigned char index, void *buf, size_t count)
@@ -568,6 +608,35 @@ dm_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const
 	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
 }
 
+/** Write a number of consecutive items to the data manager file */
+__EXPORT ssize_t
+dm_write_batch(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count,
+	       unsigned num)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if ((g_fd < 0) || g_task_should_exit) {
+		return -1;
+	}
+
+	/* get a work item and queue up a batch write request */
+	if ((work = create_work_item()) == NULL) {
+		return -1;
+	}
+
+	work->func = dm_write_batch_func;
+	work->write_batch_params.item = item;
+	work->write_batch_params.index = index;
+	work->write_batch_params.persistence = persistence;
+	work->write_batch_params.buf = buf;
+	work->write_batch_params.count = count;
+	work->write_batch_params.num = num;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
 /** Retrieve from the data manager file */
 __EXPORT ssize_t
 dm_read(dm_item_t item, unsigned char index, void *buf, size_t count)
@@ -801,7 +870,15 @@ task_main(int argc, char *argv[])
 				g_func_counts[dm_write_func]++;
 				work->result =
 					_write(work->write_params.item, work->write_params.index, work->write_params.persistence, work->write_params.buf,
-					       work->write_params.count);
+					       work->write_params.count, true);
+				break;
+
+			case dm_write_batch_func:
+				g_func_counts[dm_write_batch_func]++;
+				work->result =
+					_write_batch(work->write_batch_params.item, work->write_batch_params.index,
+						     work->write_batch_params.persistence, work->write_batch_params.buf,
+						     work->write_batch_params.count, work->write_batch_params.num);
 				break;
 
 			case dm_read_func:
@@ -885,6 +962,7 @@ status(void)
 	warnx("Reads    %d", g_func_counts[dm_read_func]);
 	warnx("Clears   %d", g_func_counts[dm_clear_func]);
 	warnx("Restarts %d", g_func_counts[dm_restart_func]);
+	warnx("Batches  %d", g_func_counts[dm_write_batch_func]);
 	warnx("Max Q lengths work %d, free %d", g_work_q.max_size, g_free_q.max_size);
 }
 
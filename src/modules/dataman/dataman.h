@@ -110,6 +110,17 @@ dm_write(
 	size_t buflen			/* Length in bytes of data to retrieve */
 );
 
+/** write a number of consecutive items of the same size to the data manager store, synced once */
+__EXPORT ssize_t
+dm_write_batch(
+	dm_item_t  item,		/* The item type to store */
+	unsigned char index,		/* The index of the first item */
+	dm_persitence_t persistence,	/* The persistence level of these items */
+	const void *buffer,		/* Pointer to caller data buffer holding num items back to back */
+	size_t buflen,			/* Length in bytes of a single item */
+	unsigned num			/* Number of items to store */
+);
+
 /** Lock all items of this type */
 __EXPORT void
 dm_lock(
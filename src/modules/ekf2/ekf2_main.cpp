@@ -58,6 +58,7 @@
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
+#include <systemlib/latency.h>
 #include <mathlib/mathlib.h>
 #include <mathlib/math/filter/LowPassFilter2p.hpp>
 #include <mavlink/mavlink_log.h>
@@ -66,6 +67,7 @@
 #include <controllib/uorb/blocks.hpp>
 
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
 #include <uORB/topics/vehicle_gps_position.h>
 #include <uORB/topics/airspeed.h>
 #include <uORB/topics/vehicle_attitude.h>
@@ -131,6 +133,7 @@ private:
 	bool 	_replay_mode;	// should we use replay data from a log
 	int 	_publish_replay_mode;	// defines if we should publish replay messages
 
+	int		_imu_sub = -1;
 	int		_sensors_sub = -1;
 	int		_gps_sub = -1;
 	int		_airspeed_sub = -1;
@@ -300,7 +303,8 @@ void Ekf2::print_status()
 
 void Ekf2::task_main()
 {
-	// subscribe to relevant topics
+	// subscribe to relevant topics, the imu selected by the sensors module drives the filter
+	_imu_sub = orb_subscribe(ORB_ID(sensor_imu));
 	_sensors_sub = orb_subscribe(ORB_ID(sensor_combined));
 	_gps_sub = orb_subscribe(ORB_ID(vehicle_gps_position));
 	_airspeed_sub = orb_subscribe(ORB_ID(airspeed));
@@ -310,7 +314,7 @@ void Ekf2::task_main()
 	_range_finder_sub = orb_subscribe(ORB_ID(distance_sensor));
 
 	px4_pollfd_struct_t fds[2] = {};
-	fds[0].fd = _sensors_sub;
+	fds[0].fd = _imu_sub;
 	fds[0].events = POLLIN;
 	fds[1].fd = _params_sub;
 	fds[1].events = POLLIN;
@@ -321,6 +325,7 @@ void Ekf2::task_main()
 	// initialize data structures outside of loop
 	// because they will else not always be
 	// properly populated
+	sensor_imu_s imu = {};
 	sensor_combined_s sensors = {};
 	vehicle_gps_position_s gps = {};
 	airspeed_s airspeed = {};
@@ -355,14 +360,22 @@ void Ekf2::task_main()
 			continue;
 		}
 
+		bool sensors_updated = false;
 		bool gps_updated = false;
 		bool airspeed_updated = false;
 		bool vehicle_status_updated = false;
 		bool optical_flow_updated = false;
 		bool range_finder_updated = false;
 
-		orb_copy(ORB_ID(sensor_combined), _sensors_sub, &sensors);
-		// update all other topics if they have new data
+		orb_copy(ORB_ID(sensor_imu), _imu_sub, &imu);
+
+		// update all other topics if they have new data, sensor_combined provides mag and baro
+		orb_check(_sensors_sub, &sensors_updated);
+
+		if (sensors_updated) {
+			orb_copy(ORB_ID(sensor_combined), _sensors_sub, &sensors);
+		}
+
 		orb_check(_gps_sub, &gps_updated);
 
 		if (gps_updated) {
@@ -390,14 +403,14 @@ void Ekf2::task_main()
 		// in replay mode we are getting the actual timestamp from the sensor topic
 		hrt_abstime now = 0;
 		if (_replay_mode) {
-			now = sensors.timestamp;
+			now = imu.timestamp;
 		} else {
 			now = hrt_absolute_time();
 		}
 
 		// push imu data into estimator
-		_ekf->setIMUData(now, sensors.gyro_integral_dt[0], sensors.accelerometer_integral_dt[0],
-				 &sensors.gyro_integral_rad[0], &sensors.accelerometer_integral_m_s[0]);
+		_ekf->setIMUData(now, imu.gyro_integral_dt, imu.accelerometer_integral_dt,
+				 &imu.gyro_integral_rad[0], &imu.accelerometer_integral_m_s[0]);
 
 		// read mag data
 		_ekf->setMagData(sensors.magnetometer_timestamp[0], &sensors.magnetometer_ga[0]);
@@ -467,6 +480,7 @@ void Ekf2::task_main()
 		// generate vehicle attitude data
 		struct vehicle_attitude_s att = {};
 		att.timestamp = hrt_absolute_time();
+		att.timestamp_sample = imu.timestamp;
 
 		_ekf->copy_quaternion(att.q);
 		matrix::Quaternion<float> q(att.q[0], att.q[1], att.q[2], att.q[3]);
@@ -537,9 +551,10 @@ void Ekf2::task_main()
 		// generate control state data
 		control_state_s ctrl_state = {};
 		ctrl_state.timestamp = hrt_absolute_time();
-		ctrl_state.roll_rate = _lp_roll_rate.apply(sensors.gyro_rad_s[0]);
-		ctrl_state.pitch_rate = _lp_pitch_rate.apply(sensors.gyro_rad_s[1]);
-		ctrl_state.yaw_rate = _lp_yaw_rate.apply(sensors.gyro_rad_s[2]);
+		ctrl_state.timestamp_sample = imu.timestamp;
+		ctrl_state.roll_rate = _lp_roll_rate.apply(imu.gyro_rad_s[0]);
+		ctrl_state.pitch_rate = _lp_pitch_rate.apply(imu.gyro_rad_s[1]);
+		ctrl_state.yaw_rate = _lp_yaw_rate.apply(imu.gyro_rad_s[2]);
 
 		ctrl_state.q[0] = q(0);
 		ctrl_state.q[1] = q(1);
@@ -554,6 +569,8 @@ void Ekf2::task_main()
 			orb_publish(ORB_ID(control_state), _control_state_pub, &ctrl_state);
 		}
 
+		latency_record(LATENCY_STAGE_ESTIMATOR, ctrl_state.timestamp_sample);
+
 		// generate vehicle attitude data
 		att.q[0] = q(0);
 		att.q[1] = q(1);
@@ -561,9 +578,9 @@ void Ekf2::task_main()
 		att.q[3] = q(3);
 		att.q_valid = true;
 
-		att.rollspeed = sensors.gyro_rad_s[0];
-		att.pitchspeed = sensors.gyro_rad_s[1];
-		att.yawspeed = sensors.gyro_rad_s[2];
+		att.rollspeed = imu.gyro_rad_s[0];
+		att.pitchspeed = imu.gyro_rad_s[1];
+		att.yawspeed = imu.gyro_rad_s[2];
 
 		// publish vehicle attitude data
 		if (_att_pub == nullptr) {
@@ -661,12 +678,12 @@ void Ekf2::task_main()
 		if (publish_replay_message) {
 			struct ekf2_replay_s replay = {};
 			replay.time_ref = now;
-			replay.gyro_integral_dt = sensors.gyro_integral_dt[0];
-			replay.accelerometer_integral_dt = sensors.accelerometer_integral_dt[0];
+			replay.gyro_integral_dt = imu.gyro_integral_dt;
+			replay.accelerometer_integral_dt = imu.accelerometer_integral_dt;
 			replay.magnetometer_timestamp = sensors.magnetometer_timestamp[0];
 			replay.baro_timestamp = sensors.baro_timestamp[0];
-			memcpy(&replay.gyro_integral_rad[0], &sensors.gyro_integral_rad[0], sizeof(replay.gyro_integral_rad));
-			memcpy(&replay.accelerometer_integral_m_s[0], &sensors.accelerometer_integral_m_s[0], sizeof(replay.accelerometer_integral_m_s));
+			memcpy(&replay.gyro_integral_rad[0], &imu.gyro_integral_rad[0], sizeof(replay.gyro_integral_rad));
+			memcpy(&replay.accelerometer_integral_m_s[0], &imu.accelerometer_integral_m_s[0], sizeof(replay.accelerometer_integral_m_s));
 			memcpy(&replay.magnetometer_ga[0], &sensors.magnetometer_ga[0], sizeof(replay.magnetometer_ga));
 			replay.baro_alt_meter = sensors.baro_alt_meter[0];
 
@@ -58,6 +58,7 @@
 
 #include <uORB/topics/ekf2_replay.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
 #include <uORB/topics/vehicle_gps_position.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/ekf2_innovations.h>
@@ -126,6 +127,7 @@ private:
 	bool	_task_should_exit = false;
 
 	orb_advert_t _sensors_pub;
+	orb_advert_t _imu_pub;
 	orb_advert_t _gps_pub;
 	orb_advert_t _status_pub;
 	orb_advert_t _flow_pub;
@@ -192,6 +194,7 @@ private:
 
 Ekf2Replay::Ekf2Replay(char *logfile) :
 	_sensors_pub(nullptr),
+	_imu_pub(nullptr),
 	_gps_pub(nullptr),
 	_status_pub(nullptr),
 	_flow_pub(nullptr),
@@ -265,6 +268,23 @@ void Ekf2Replay::publishEstimatorInput()
 	} else if (_sensors_pub != nullptr) {
 		orb_publish(ORB_ID(sensor_combined), _sensors_pub, &_sensors);
 	}
+
+	/* the estimator runs on the selected imu, the log holds the first instance */
+	struct sensor_imu_s imu = {};
+	imu.timestamp = _sensors.timestamp;
+	imu.accelerometer_timestamp = _sensors.timestamp;
+	imu.gyro_integral_dt = _sensors.gyro_integral_dt[0];
+	imu.accelerometer_integral_dt = _sensors.accelerometer_integral_dt[0];
+	memcpy(&imu.gyro_integral_rad[0], &_sensors.gyro_integral_rad[0], sizeof(imu.gyro_integral_rad));
+	memcpy(&imu.accelerometer_integral_m_s[0], &_sensors.accelerometer_integral_m_s[0],
+	       sizeof(imu.accelerometer_integral_m_s));
+
+	if (_imu_pub == nullptr) {
+		_imu_pub = orb_advertise(ORB_ID(sensor_imu), &imu);
+
+	} else {
+		orb_publish(ORB_ID(sensor_imu), _imu_pub, &imu);
+	}
 }
 
 void Ekf2Replay::parseMessage(uint8_t *source, uint8_t *destination, uint8_t type)
@@ -63,6 +63,7 @@
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
+#include <systemlib/latency.h>
 #include <mathlib/mathlib.h>
 #include <mathlib/math/filter/LowPassFilter2p.hpp>
 #include <mavlink/mavlink_log.h>
@@ -831,6 +832,7 @@ void AttitudePositionEstimatorEKF::publishAttitude()
 	}
 
 	_att.timestamp = _last_sensor_timestamp;
+	_att.timestamp_sample = _last_sensor_timestamp;
 	_att.q[0] = _ekf->states[0];
 	_att.q[1] = _ekf->states[1];
 	_att.q[2] = _ekf->states[2];
@@ -899,6 +901,7 @@ void AttitudePositionEstimatorEKF::publishControlState()
 
 	/* Attitude */
 	_ctrl_state.timestamp = _last_sensor_timestamp;
+	_ctrl_state.timestamp_sample = _last_sensor_timestamp;
 	_ctrl_state.q[0] = _ekf->states[0];
 	_ctrl_state.q[1] = _ekf->states[1];
 	_ctrl_state.q[2] = _ekf->states[2];
@@ -942,6 +945,8 @@ void AttitudePositionEstimatorEKF::publishControlState()
 		/* advertise and publish */
 		_ctrl_state_pub = orb_advertise(ORB_ID(control_state), &_ctrl_state);
 	}
+
+	latency_record(LATENCY_STAGE_ESTIMATOR, _ctrl_state.timestamp_sample);
 }
 
 void AttitudePositionEstimatorEKF::publishLocalPosition()
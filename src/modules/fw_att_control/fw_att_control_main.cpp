@@ -77,6 +77,7 @@
 #include <systemlib/pid/pid.h>
 #include <geo/geo.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
 #include <systemlib/systemlib.h>
 #include <mathlib/mathlib.h>
 
@@ -1223,9 +1224,9 @@ FixedwingAttitudeControl::task_main()
 
 			/* lazily publish the setpoint only once available */
 			_actuators.timestamp = hrt_absolute_time();
-			_actuators.timestamp_sample = _ctrl_state.timestamp;
+			_actuators.timestamp_sample = _ctrl_state.timestamp_sample;
 			_actuators_airframe.timestamp = hrt_absolute_time();
-			_actuators_airframe.timestamp_sample = _ctrl_state.timestamp;
+			_actuators_airframe.timestamp_sample = _ctrl_state.timestamp_sample;
 
 			/* Only publish if any of the proper modes are enabled */
 			if (_vcontrol_mode.flag_control_rates_enabled ||
@@ -1234,6 +1235,7 @@ FixedwingAttitudeControl::task_main()
 				/* publish the actuator controls */
 				if (_actuators_0_pub != nullptr) {
 					orb_publish(_actuators_id, _actuators_0_pub, &_actuators);
+					latency_record(LATENCY_STAGE_CONTROLLER, _actuators.timestamp_sample);
 
 				} else if (_actuators_id) {
 					_actuators_0_pub = orb_advertise(_actuators_id, &_actuators);
@@ -3,6 +3,7 @@
 #include <fcntl.h>
 #include <systemlib/err.h>
 #include <matrix/math.hpp>
+#include "lpe_kalman.hpp"
 
 static const int 		REQ_BARO_INIT_COUNT = 100;
 static const int 		REQ_FLOW_INIT_COUNT = 20;
@@ -954,65 +955,36 @@ void BlockLocalPositionEstimator::predict()
 		_u = Vector3f(0, 0, 0);
 	}
 
-	// dynamics matrix
-	Matrix<float, n_x, n_x>  A; // state dynamics matrix
-	A.setZero();
-	// derivative of position is velocity
-	A(X_x, X_vx) = 1;
-	A(X_y, X_vy) = 1;
-	A(X_z, X_vz) = 1;
+	// input noise variance, B * R * B' only acts on the velocity block
+	Vector3f var_u(_accel_xy_stddev.get() * _accel_xy_stddev.get(),
+		       _accel_xy_stddev.get() * _accel_xy_stddev.get(),
+		       _accel_z_stddev.get() * _accel_z_stddev.get());
 
-	// derivative of velocity is accelerometer acceleration
-	// (in input matrix) - bias (in body frame)
-	Matrix3f R_att(_sub_att.get().R);
-	A(X_vx, X_bx) = -R_att(0, 0);
-	A(X_vx, X_by) = -R_att(0, 1);
-	A(X_vx, X_bz) = -R_att(0, 2);
-
-	A(X_vy, X_bx) = -R_att(1, 0);
-	A(X_vy, X_by) = -R_att(1, 1);
-	A(X_vy, X_bz) = -R_att(1, 2);
-
-	A(X_vz, X_bx) = -R_att(2, 0);
-	A(X_vz, X_by) = -R_att(2, 1);
-	A(X_vz, X_bz) = -R_att(2, 2);
-
-	// input matrix
-	Matrix<float, n_x, n_u>  B; // input matrix
-	B.setZero();
-	B(X_vx, U_ax) = 1;
-	B(X_vy, U_ay) = 1;
-	B(X_vz, U_az) = 1;
-
-	// input noise covariance matrix
-	Matrix<float, n_u, n_u> R;
-	R.setZero();
-	R(U_ax, U_ax) = _accel_xy_stddev.get() * _accel_xy_stddev.get();
-	R(U_ay, U_ay) = _accel_xy_stddev.get() * _accel_xy_stddev.get();
-	R(U_az, U_az) = _accel_z_stddev.get() * _accel_z_stddev.get();
-
-	// process noise power matrix
-	Matrix<float, n_x, n_x>  Q;
-	Q.setZero();
-	Q(X_x, X_x) = _pn_p_noise_power.get();
-	Q(X_y, X_y) = _pn_p_noise_power.get();
-	Q(X_z, X_z) = _pn_p_noise_power.get();
-	Q(X_vx, X_vx) = _pn_v_noise_power.get();
-	Q(X_vy, X_vy) = _pn_v_noise_power.get();
-	Q(X_vz, X_vz) = _pn_v_noise_power.get();
+	// process noise power, diagonal
+	Vector<float, n_x> q;
+	q(X_x) = _pn_p_noise_power.get();
+	q(X_y) = _pn_p_noise_power.get();
+	q(X_z) = _pn_p_noise_power.get();
+	q(X_vx) = _pn_v_noise_power.get();
+	q(X_vy) = _pn_v_noise_power.get();
+	q(X_vz) = _pn_v_noise_power.get();
 
 	// technically, the noise is in the body frame,
 	// but the components are all the same, so
 	// ignoring for now
-	Q(X_bx, X_bx) = _pn_b_noise_power.get();
-	Q(X_by, X_by) = _pn_b_noise_power.get();
-	Q(X_bz, X_bz) = _pn_b_noise_power.get();
+	q(X_bx) = _pn_b_noise_power.get();
+	q(X_by) = _pn_b_noise_power.get();
+	q(X_bz) = _pn_b_noise_power.get();
 
 	// terrain random walk noise
-	Q(X_tz, X_tz) = _pn_t_noise_power.get();
+	q(X_tz) = _pn_t_noise_power.get();
 
-	// continuous time kalman filter prediction
-	Vector<float, n_x> dx = (A * _x + B * _u) * getDt();
+	// continuous time kalman filter prediction, derivative of position
+	// is velocity, derivative of velocity is accelerometer acceleration
+	// (input) - bias (in body frame), see lpe_kalman.hpp
+	Matrix3f R_att(_sub_att.get().R);
+	Vector<float, n_x> dx;
+	lpe::predict<n_x, X_x, X_vx, X_bx>(_x, _P, R_att, _u, var_u, q, getDt(), dx);
 
 	// only predict for components we have
 	// valid measurements for
@@ -1030,8 +1002,6 @@ void BlockLocalPositionEstimator::predict()
 
 	// propagate
 	_x += dx;
-	_P += (A * _P + _P * A.transpose() +
-	       B * R * B.transpose() + Q) * getDt();
 
 	// propagate delayed state
 	//if (_time_last_hist == 0 || _time_last_hist - _timeStamp > 1000) {
@@ -1082,10 +1052,9 @@ void BlockLocalPositionEstimator::correctFlow()
 	}
 
 	// flow measurement matrix and noise matrix
-	Matrix<float, n_y_flow, n_x> C;
-	C.setZero();
-	C(Y_flow_x, X_x) = 1;
-	C(Y_flow_y, X_y) = 1;
+	lpe::Measurement<n_x, n_y_flow> C;
+	C.set(Y_flow_x, X_x, 1);
+	C.set(Y_flow_y, X_y, 1);
 
 	Matrix<float, n_y_flow, n_y_flow> R;
 	R.setZero();
@@ -1143,8 +1112,8 @@ void BlockLocalPositionEstimator::correctFlow()
 	Vector<float, 2> r = y - C * _x;
 
 	// residual covariance, (inverse)
-	Matrix<float, n_y_flow, n_y_flow> S_I =
-		inv<float, n_y_flow>(C * _P * C.transpose() + R);
+	C.project(_P);
+	Matrix<float, n_y_flow, n_y_flow> S_I = C.S_I(R);
 
 	// fault detection
 	float beta = (r.transpose() * (S_I * r))(0, 0);
@@ -1164,10 +1133,9 @@ void BlockLocalPositionEstimator::correctFlow()
 
 	// kalman filter correction if no fault
 	if (_flowFault < FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_flow> K =
-			_P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_flow> K = C.gain(S_I);
 		_x += K * r;
-		_P -= K * C * _P;
+		C.update(_P, K);
 
 	} else {
 		// reset flow integral to current estimate of position
@@ -1217,12 +1185,11 @@ void BlockLocalPositionEstimator::correctSonar()
 	}
 
 	// sonar measurement matrix and noise matrix
-	Matrix<float, n_y_sonar, n_x> C;
-	C.setZero();
+	lpe::Measurement<n_x, n_y_sonar> C;
 	// y = -(z - tz)
 	// TODO could add trig to make this an EKF correction
-	C(Y_sonar_z, X_z) = -1; // measured altitude, negative down dir.
-	C(Y_sonar_z, X_tz) = 1; // measured altitude, negative down dir.
+	C.set(Y_sonar_z, X_z, -1); // measured altitude, negative down dir.
+	C.set(Y_sonar_z, X_tz, 1); // measured altitude, negative down dir.
 
 	// covariance matrix
 	Matrix<float, n_y_sonar, n_y_sonar> R;
@@ -1239,8 +1206,8 @@ void BlockLocalPositionEstimator::correctSonar()
 	Vector<float, n_y_sonar> r = y - C * _x;
 
 	// residual covariance, (inverse)
-	Matrix<float, n_y_sonar, n_y_sonar> S_I =
-		inv<float, n_y_sonar>(C * _P * C.transpose() + R);
+	C.project(_P);
+	Matrix<float, n_y_sonar, n_y_sonar> S_I = C.S_I(R);
 
 	// fault detection
 	float beta = (r.transpose()  * (S_I * r))(0, 0);
@@ -1260,8 +1227,7 @@ void BlockLocalPositionEstimator::correctSonar()
 
 	// kalman filter correction if no fault
 	if (_sonarFault < FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_sonar> K =
-			_P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_sonar> K = C.gain(S_I);
 		Vector<float, n_x> dx = K * r;
 
 		if (!_canEstimateXY) {
@@ -1272,7 +1238,7 @@ void BlockLocalPositionEstimator::correctSonar()
 		}
 
 		_x += dx;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 
 }
@@ -1285,17 +1251,16 @@ void BlockLocalPositionEstimator::correctBaro()
 	_time_last_baro = _timeStamp;
 
 	// baro measurement matrix
-	Matrix<float, n_y_baro, n_x> C;
-	C.setZero();
-	C(Y_baro_z, X_z) = -1; // measured altitude, negative down dir.
+	lpe::Measurement<n_x, n_y_baro> C;
+	C.set(Y_baro_z, X_z, -1); // measured altitude, negative down dir.
 
 	Matrix<float, n_y_baro, n_y_baro> R;
 	R.setZero();
 	R(0, 0) = _baro_stddev.get() * _baro_stddev.get();
 
 	// residual
-	Matrix<float, n_y_baro, n_y_baro> S_I =
-		inv<float, n_y_baro>((C * _P * C.transpose()) + R);
+	C.project(_P);
+	Matrix<float, n_y_baro, n_y_baro> S_I = C.S_I(R);
 	Vector<float, n_y_baro> r = y - (C * _x);
 
 	// fault detection
@@ -1309,7 +1274,7 @@ void BlockLocalPositionEstimator::correctBaro()
 		}
 
 		// lower baro trust
-		S_I = inv<float, n_y_baro>((C * _P * C.transpose()) + R * 10);
+		S_I = C.S_I(R * 10);
 
 	} else if (_baroFault) {
 		_baroFault = FAULT_NONE;
@@ -1319,7 +1284,7 @@ void BlockLocalPositionEstimator::correctBaro()
 
 	// kalman filter correction if no fault
 	if (_baroFault < FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_baro> K = _P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_baro> K = C.gain(S_I);
 		Vector<float, n_x> dx = K * r;
 
 		if (!_canEstimateXY) {
@@ -1330,7 +1295,7 @@ void BlockLocalPositionEstimator::correctBaro()
 		}
 
 		_x += dx;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 }
 
@@ -1355,12 +1320,11 @@ void BlockLocalPositionEstimator::correctLidar()
 
 	_time_last_lidar = _timeStamp;
 
-	Matrix<float, n_y_lidar, n_x> C;
-	C.setZero();
+	lpe::Measurement<n_x, n_y_lidar> C;
 	// y = -(z - tz)
 	// TODO could add trig to make this an EKF correction
-	C(Y_lidar_z, X_z) = -1; // measured altitude, negative down dir.
-	C(Y_lidar_z, X_tz) = 1; // measured altitude, negative down dir.
+	C.set(Y_lidar_z, X_z, -1); // measured altitude, negative down dir.
+	C.set(Y_lidar_z, X_tz, 1); // measured altitude, negative down dir.
 
 	// use parameter covariance unless sensor provides reasonable value
 	Matrix<float, n_y_lidar, n_y_lidar> R;
@@ -1381,7 +1345,8 @@ void BlockLocalPositionEstimator::correctLidar()
 	       cosf(_sub_att.get().pitch);
 
 	// residual
-	Matrix<float, n_y_lidar, n_y_lidar> S_I = inv<float, n_y_lidar>((C * _P * C.transpose()) + R);
+	C.project(_P);
+	Matrix<float, n_y_lidar, n_y_lidar> S_I = C.S_I(R);
 	Vector<float, n_y_lidar> r = y - C * _x;
 
 	// fault detection
@@ -1402,7 +1367,7 @@ void BlockLocalPositionEstimator::correctLidar()
 
 	// kalman filter correction if no fault
 	if (_lidarFault < FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_lidar> K = _P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_lidar> K = C.gain(S_I);
 		Vector<float, n_x> dx = K * r;
 
 		if (!_canEstimateXY) {
@@ -1413,7 +1378,7 @@ void BlockLocalPositionEstimator::correctLidar()
 		}
 
 		_x += dx;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 }
 
@@ -1452,14 +1417,13 @@ void BlockLocalPositionEstimator::correctGps()
 	y(5) = _sub_gps.get().vel_d_m_s;
 
 	// gps measurement matrix, measures position and velocity
-	Matrix<float, n_y_gps, n_x> C;
-	C.setZero();
-	C(Y_gps_x, X_x) = 1;
-	C(Y_gps_y, X_y) = 1;
-	C(Y_gps_z, X_z) = 1;
-	C(Y_gps_vx, X_vx) = 1;
-	C(Y_gps_vy, X_vy) = 1;
-	C(Y_gps_vz, X_vz) = 1;
+	lpe::Measurement<n_x, n_y_gps> C;
+	C.set(Y_gps_x, X_x, 1);
+	C.set(Y_gps_y, X_y, 1);
+	C.set(Y_gps_z, X_z, 1);
+	C.set(Y_gps_vx, X_vx, 1);
+	C.set(Y_gps_vy, X_vy, 1);
+	C.set(Y_gps_vz, X_vz, 1);
 
 	// gps covariance matrix
 	Matrix<float, n_y_gps, n_y_gps> R;
@@ -1504,7 +1468,8 @@ void BlockLocalPositionEstimator::correctGps()
 
 	// residual
 	Vector<float, n_y_gps> r = y - C * _x;
-	Matrix<float, n_y_gps, n_y_gps> S_I = inv<float, 6>(C * _P * C.transpose() + R);
+	C.project(_P);
+	Matrix<float, n_y_gps, n_y_gps> S_I = C.S_I(R);
 
 	// fault detection
 	float beta = (r.transpose() * (S_I * r))(0, 0);
@@ -1536,9 +1501,9 @@ void BlockLocalPositionEstimator::correctGps()
 
 	// kalman filter correction if no hard fault
 	if (_gpsFault < FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_gps> K = _P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_gps> K = C.gain(S_I);
 		_x += K * r;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 }
 
@@ -1553,11 +1518,10 @@ void BlockLocalPositionEstimator::correctVision()
 	_time_last_vision_p = _sub_vision_pos.get().timestamp_boot;
 
 	// vision measurement matrix, measures position
-	Matrix<float, n_y_vision, n_x> C;
-	C.setZero();
-	C(Y_vision_x, X_x) = 1;
-	C(Y_vision_y, X_y) = 1;
-	C(Y_vision_z, X_z) = 1;
+	lpe::Measurement<n_x, n_y_vision> C;
+	C.set(Y_vision_x, X_x, 1);
+	C.set(Y_vision_y, X_y, 1);
+	C.set(Y_vision_z, X_z, 1);
 
 	// noise matrix
 	Matrix<float, n_y_vision, n_y_vision> R;
@@ -1567,7 +1531,8 @@ void BlockLocalPositionEstimator::correctVision()
 	R(Y_vision_z, Y_vision_z) = _vision_z_stddev.get() * _vision_z_stddev.get();
 
 	// residual
-	Matrix<float, n_y_vision, n_y_vision> S_I = inv<float, n_y_vision>((C * _P * C.transpose()) + R);
+	C.project(_P);
+	Matrix<float, n_y_vision, n_y_vision> S_I = C.S_I(R);
 	Matrix<float, n_y_vision, 1> r = y - C * _x;
 
 	// fault detection
@@ -1581,7 +1546,7 @@ void BlockLocalPositionEstimator::correctVision()
 		}
 
 		// trust less
-		S_I = inv<float, n_y_vision>((C * _P * C.transpose()) + R * 10);
+		S_I = C.S_I(R * 10);
 
 	} else if (_visionFault) {
 		_visionFault = FAULT_NONE;
@@ -1591,9 +1556,9 @@ void BlockLocalPositionEstimator::correctVision()
 
 	// kalman filter correction if no fault
 	if (_visionFault <  FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_vision> K = _P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_vision> K = C.gain(S_I);
 		_x += K * r;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 }
 
@@ -1608,11 +1573,10 @@ void BlockLocalPositionEstimator::correctMocap()
 	_time_last_mocap = _sub_mocap.get().timestamp_boot;
 
 	// mocap measurement matrix, measures position
-	Matrix<float, n_y_mocap, n_x> C;
-	C.setZero();
-	C(Y_mocap_x, X_x) = 1;
-	C(Y_mocap_y, X_y) = 1;
-	C(Y_mocap_z, X_z) = 1;
+	lpe::Measurement<n_x, n_y_mocap> C;
+	C.set(Y_mocap_x, X_x, 1);
+	C.set(Y_mocap_y, X_y, 1);
+	C.set(Y_mocap_z, X_z, 1);
 
 	// noise matrix
 	Matrix<float, n_y_mocap, n_y_mocap> R;
@@ -1624,7 +1588,8 @@ void BlockLocalPositionEstimator::correctMocap()
 	R(Y_mocap_z, Y_mocap_z) = mocap_p_var;
 
 	// residual
-	Matrix<float, n_y_mocap, n_y_mocap> S_I = inv<float, n_y_mocap>((C * _P * C.transpose()) + R);
+	C.project(_P);
+	Matrix<float, n_y_mocap, n_y_mocap> S_I = C.S_I(R);
 	Matrix<float, n_y_mocap, 1> r = y - C * _x;
 
 	// fault detection
@@ -1638,7 +1603,7 @@ void BlockLocalPositionEstimator::correctMocap()
 		}
 
 		// trust less
-		S_I = inv<float, n_y_mocap>((C * _P * C.transpose()) + R * 10);
+		S_I = C.S_I(R * 10);
 
 	} else if (_mocapFault) {
 		_mocapFault = FAULT_NONE;
@@ -1648,8 +1613,8 @@ void BlockLocalPositionEstimator::correctMocap()
 
 	// kalman filter correction if no fault
 	if (_mocapFault <  FAULT_SEVERE) {
-		Matrix<float, n_x, n_y_mocap> K = _P * C.transpose() * S_I;
+		Matrix<float, n_x, n_y_mocap> K = C.gain(S_I);
 		_x += K * r;
-		_P -= K * C * _P;
+		C.update(_P, K);
 	}
 }
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <string.h>
+#include <matrix/math.hpp>
+
+//
+// Kalman filter kernels for the local position estimator that exploit
+// the structure of its model instead of forming dense products.
+//
+// The state is laid out as three position components starting at P0,
+// three velocity components starting at V0 and three accelerometer
+// bias components (body frame) starting at B0, any further states
+// (e.g. terrain) only have process noise. The dynamics are
+//
+//	A = [ 0  I  0      ]      B = [ 0 ]
+//	    [ 0  0  -R_att ]          [ I ]
+//	    [ 0  0  0      ]          [ 0 ]
+//
+// and every measurement row has at most two non-zero entries
+// (selection of a state, or -z + tz for the rangefinders).
+//
+namespace lpe
+{
+
+using matrix::Matrix;
+using matrix::Vector;
+
+//
+// continuous time prediction over dt
+//
+//	dx = (A * x + B * u) * dt
+//	P += (A * P + P * A' + B * R * B' + Q) * dt
+//
+// only the position and velocity rows and columns of P are touched by
+// A, B * R * B' is diagonal in the velocity block and Q is diagonal,
+// dx is returned so the caller can mask components it can't estimate
+//
+template<size_t N_X, size_t P0, size_t V0, size_t B0>
+void predict(const Vector<float, N_X> &x, Matrix<float, N_X, N_X> &P,
+	     const Matrix<float, 3, 3> &R_att, const Vector<float, 3> &u,
+	     const Vector<float, 3> &var_u, const Vector<float, N_X> &q,
+	     float dt, Vector<float, N_X> &dx)
+{
+	dx.setZero();
+
+	for (size_t i = 0; i < 3; i++) {
+		float bias = 0;
+
+		for (size_t j = 0; j < 3; j++) {
+			bias += R_att(i, j) * x(B0 + j);
+		}
+
+		dx(P0 + i) = x(V0 + i) * dt;
+		dx(V0 + i) = (u(i) - bias) * dt;
+	}
+
+	// non-zero rows of A * P, taken from P before it is updated
+	float AP[6][N_X];
+
+	for (size_t i = 0; i < 3; i++) {
+		for (size_t c = 0; c < N_X; c++) {
+			AP[i][c] = P(V0 + i, c);
+			AP[3 + i][c] = -(R_att(i, 0) * P(B0, c) +
+					 R_att(i, 1) * P(B0 + 1, c) +
+					 R_att(i, 2) * P(B0 + 2, c));
+		}
+	}
+
+	// P += (A * P + (A * P)') * dt
+	for (size_t k = 0; k < 6; k++) {
+		size_t row = (k < 3) ? P0 + k : V0 + k - 3;
+
+		for (size_t c = 0; c < N_X; c++) {
+			float d = AP[k][c] * dt;
+			P(row, c) += d;
+			P(c, row) += d;
+		}
+	}
+
+	for (size_t i = 0; i < 3; i++) {
+		P(V0 + i, V0 + i) += var_u(i) * dt;
+	}
+
+	for (size_t i = 0; i < N_X; i++) {
+		P(i, i) += q(i) * dt;
+	}
+}
+
+//
+// inverse of a symmetric positive definite matrix (residual covariance)
+// by cholesky decomposition, falls back to the generic inverse if the
+// matrix is not positive definite
+//
+template<size_t N>
+Matrix<float, N, N> inv_spd(const Matrix<float, N, N> &S)
+{
+	if (N == 1) {
+		Matrix<float, N, N> S_I;
+		S_I(0, 0) = 1.0f / S(0, 0);
+		return S_I;
+	}
+
+	// S = L * L', L lower triangular
+	float L[N][N] = {};
+
+	for (size_t j = 0; j < N; j++) {
+		float d = S(j, j);
+
+		for (size_t k = 0; k < j; k++) {
+			d -= L[j][k] * L[j][k];
+		}
+
+		if (!(d > 0)) {
+			return matrix::inv<float, N>(S);
+		}
+
+		L[j][j] = sqrtf(d);
+
+		for (size_t i = j + 1; i < N; i++) {
+			float s = S(i, j);
+
+			for (size_t k = 0; k < j; k++) {
+				s -= L[i][k] * L[j][k];
+			}
+
+			L[i][j] = s / L[j][j];
+		}
+	}
+
+	// L^-1, also lower triangular
+	float L_I[N][N] = {};
+
+	for (size_t j = 0; j < N; j++) {
+		L_I[j][j] = 1.0f / L[j][j];
+
+		for (size_t i = j + 1; i < N; i++) {
+			float s = 0;
+
+			for (size_t k = j; k < i; k++) {
+				s -= L[i][k] * L_I[k][j];
+			}
+
+			L_I[i][j] = s / L[i][i];
+		}
+	}
+
+	// S^-1 = L^-T * L^-1
+	Matrix<float, N, N> S_I;
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j <= i; j++) {
+			float s = 0;
+
+			for (size_t k = i; k < N; k++) {
+				s += L_I[k][i] * L_I[k][j];
+			}
+
+			S_I(i, j) = s;
+			S_I(j, i) = s;
+		}
+	}
+
+	return S_I;
+}
+
+//
+// measurement y = C * x where each row of C has at most two non-zero
+// entries, the products with P only read the columns C refers to
+//
+template<size_t N_X, size_t N_Y>
+class Measurement
+{
+public:
+	Measurement() :
+		_idx(),
+		_coef(),
+		_PCt(),
+		_CPCt()
+	{
+	}
+
+	// add coef * x(state) to measurement row
+	void set(size_t row, size_t state, float coef)
+	{
+		size_t k = (_coef[row][0] == 0) ? 0 : 1;
+		_idx[row][k] = state;
+		_coef[row][k] = coef;
+	}
+
+	// C * x
+	Vector<float, N_Y> operator*(const Vector<float, N_X> &x) const
+	{
+		Vector<float, N_Y> y;
+
+		for (size_t r = 0; r < N_Y; r++) {
+			y(r) = _coef[r][0] * x(_idx[r][0]) + _coef[r][1] * x(_idx[r][1]);
+		}
+
+		return y;
+	}
+
+	// compute P * C' and C * P * C' for the current covariance
+	void project(const Matrix<float, N_X, N_X> &P)
+	{
+		for (size_t i = 0; i < N_X; i++) {
+			for (size_t r = 0; r < N_Y; r++) {
+				_PCt(i, r) = _coef[r][0] * P(i, _idx[r][0]) + _coef[r][1] * P(i, _idx[r][1]);
+			}
+		}
+
+		for (size_t r = 0; r < N_Y; r++) {
+			for (size_t c = 0; c < N_Y; c++) {
+				_CPCt(r, c) = _coef[r][0] * _PCt(_idx[r][0], c) + _coef[r][1] * _PCt(_idx[r][1], c);
+			}
+		}
+	}
+
+	// residual covariance inverse, (C * P * C' + R)^-1
+	Matrix<float, N_Y, N_Y> S_I(const Matrix<float, N_Y, N_Y> &R) const
+	{
+		return inv_spd<N_Y>(_CPCt + R);
+	}
+
+	// kalman gain, P * C' * S_I
+	Matrix<float, N_X, N_Y> gain(const Matrix<float, N_Y, N_Y> &S_I) const
+	{
+		return _PCt * S_I;
+	}
+
+	// P -= K * C * P, with C * P = (P * C')' for the symmetric P
+	void update(Matrix<float, N_X, N_X> &P, const Matrix<float, N_X, N_Y> &K) const
+	{
+		for (size_t i = 0; i < N_X; i++) {
+			for (size_t j = i; j < N_X; j++) {
+				float s = 0;
+
+				for (size_t r = 0; r < N_Y; r++) {
+					s += K(i, r) * _PCt(j, r);
+				}
+
+				P(i, j) -= s;
+
+				if (j != i) {
+					P(j, i) -= s;
+				}
+			}
+		}
+	}
+
+private:
+	size_t _idx[N_Y][2];
+	float _coef[N_Y][2];
+	Matrix<float, N_X, N_Y> _PCt;
+	Matrix<float, N_Y, N_Y> _CPCt;
+};
+
+} // namespace lpe
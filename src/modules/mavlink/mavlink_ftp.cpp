@@ -463,6 +463,7 @@ MavlinkFTP::_workOpen(PayloadHeader* payload, int oflag)
 	_session_info.fd = fd;
 	_session_info.file_size = fileSize;
 	_session_info.stream_download = false;
+	_session_info.mission_import = (oflag & O_WRONLY) && strcmp(filename, MAVLINK_MISSION_IMPORT_FILE) == 0;
 
 	payload->session = 0;
 	payload->size = sizeof(uint32_t);
@@ -654,6 +655,14 @@ MavlinkFTP::_workTerminate(PayloadHeader* payload)
 	::close(_session_info.fd);
 	_session_info.fd = -1;
 	_session_info.stream_download = false;
+
+	if (_session_info.mission_import) {
+		_session_info.mission_import = false;
+#ifndef MAVLINK_FTP_UNIT_TEST
+		/* a complete mission file was uploaded, replace the active mission with it */
+		_mavlink->get_mission_manager()->import_mission_file(MAVLINK_MISSION_IMPORT_FILE);
+#endif
+	}
 	
 	payload->size = 0;
 
@@ -668,6 +677,7 @@ MavlinkFTP::_workReset(PayloadHeader* payload)
 		::close(_session_info.fd);
 		_session_info.fd = -1;
 		_session_info.stream_download = false;
+		_session_info.mission_import = false;
 	}
 
 	payload->size = 0;
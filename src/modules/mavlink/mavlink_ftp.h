@@ -166,6 +166,7 @@ private:
 		uint16_t	stream_seq_number;
 		uint8_t		stream_target_system_id;
 		unsigned	stream_chunk_transmitted;
+		bool		mission_import;		///< Session writes the mission import file
 	};
 	struct SessionInfo _session_info;	///< Session info, fd=-1 for no active session
 	
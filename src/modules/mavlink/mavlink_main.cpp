@@ -136,6 +136,7 @@ Mavlink::Mavlink() :
 	_generate_rc(false),
 	_use_hil_gps(false),
 	_forward_externalsp(false),
+	_mission_window(1),
 	_is_usb_uart(false),
 	_wait_to_transmit(false),
 	_received_messages(false),
@@ -197,6 +198,7 @@ Mavlink::Mavlink() :
 	_param_system_type(MAV_TYPE_FIXED_WING),
 	_param_use_hil_gps(0),
 	_param_forward_externalsp(0),
+	_param_mission_window(0),
 	_system_type(0),
 
 	/* performance counters */
@@ -538,6 +540,7 @@ void Mavlink::mavlink_update_system(void)
 		_param_system_type = param_find("MAV_TYPE");
 		_param_use_hil_gps = param_find("MAV_USEHILGPS");
 		_param_forward_externalsp = param_find("MAV_FWDEXTSP");
+		_param_mission_window = param_find("MAV_MIS_WINDOW");
 
 		/* test param - needs to be referenced, but is unused */
 		(void)param_find("MAV_TEST_PAR");
@@ -593,6 +596,17 @@ void Mavlink::mavlink_update_system(void)
 	param_get(_param_forward_externalsp, &forward_externalsp);
 
 	_forward_externalsp = (bool)forward_externalsp;
+
+	int32_t mission_window;
+	param_get(_param_mission_window, &mission_window);
+
+	if (mission_window >= 1 && mission_window <= MAVLINK_MISSION_WINDOW_MAX) {
+		_mission_window = mission_window;
+	}
+
+	if (_mission_manager != nullptr) {
+		_mission_manager->set_window(_mission_window);
+	}
 }
 
 int Mavlink::get_system_id()
@@ -1748,6 +1762,7 @@ Mavlink::task_main(int argc, char *argv[])
 	_mission_manager = (MavlinkMissionManager *) MavlinkMissionManager::new_instance(this);
 	_mission_manager->set_interval(interval_from_rate(10.0f));
 	_mission_manager->set_verbose(_verbose);
+	_mission_manager->set_window(_mission_window);
 	LL_APPEND(_streams, _mission_manager);
 
 	switch (_mode) {
@@ -163,6 +163,8 @@ public:
 
 	bool			get_forward_externalsp() { return _forward_externalsp; }
 
+	MavlinkMissionManager	*get_mission_manager() { return _mission_manager; }
+
 	bool			get_flow_control_enabled() { return _flow_control_enabled; }
 
 	bool			get_forwarding_on() { return _forwarding_on; }
@@ -371,6 +373,7 @@ private:
 	bool			_generate_rc;		/**< Generate RC messages from manual input MAVLink messages */
 	bool			_use_hil_gps;		/**< Accept GPS HIL messages (for example from an external motion capturing system to fake indoor gps) */
 	bool			_forward_externalsp;	/**< Forward external setpoint messages to controllers directly if in offboard mode */
+	unsigned		_mission_window;	/**< Number of mission items requested at once during mission upload */
 	bool			_is_usb_uart;		/**< Port is USB */
 	bool			_wait_to_transmit;  	/**< Wait to transmit until received messages. */
 	bool			_received_messages;	/**< Whether we've received valid mavlink messages. */
@@ -466,6 +469,7 @@ private:
 	param_t			_param_system_type;
 	param_t			_param_use_hil_gps;
 	param_t			_param_forward_externalsp;
+	param_t			_param_mission_window;
 
 	unsigned		_system_type;
 
@@ -44,6 +44,8 @@
 #include "mavlink_main.h"
 
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 #include <lib/geo/geo.h>
 #include <systemlib/err.h>
 #include <drivers/drv_hrt.h>
@@ -85,11 +87,21 @@ MavlinkMissionManager::MavlinkMissionManager(Mavlink *mavlink) : MavlinkStream(m
 	_transfer_current_seq(0),
 	_transfer_partner_sysid(0),
 	_transfer_partner_compid(0),
+	_window(1),
+	_transfer_window(1),
+	_transfer_received(0),
+	_transfer_items(nullptr),
+	_transfer_items_size(0),
+	_use_int(false),
 	_offboard_mission_sub(-1),
 	_mission_result_sub(-1),
 	_offboard_mission_pub(nullptr),
 	_slow_rate_limiter(_interval / 10.0f),
 	_verbose(false)
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	, _utSendMsgFunc(nullptr),
+	_worker_data(nullptr)
+#endif
 {
 	_offboard_mission_sub = orb_subscribe(ORB_ID(offboard_mission));
 	_mission_result_sub = orb_subscribe(ORB_ID(mission_result));
@@ -100,8 +112,32 @@ MavlinkMissionManager::MavlinkMissionManager(Mavlink *mavlink) : MavlinkStream(m
 MavlinkMissionManager::~MavlinkMissionManager()
 {
 	close(_mission_result_sub);
+
+	delete[] _transfer_items;
+}
+
+void
+MavlinkMissionManager::set_window(unsigned window)
+{
+	if (window < 1) {
+		window = 1;
+
+	} else if (window > MAVLINK_MISSION_WINDOW_MAX) {
+		window = MAVLINK_MISSION_WINDOW_MAX;
+	}
+
+	_window = window;
 }
 
+#ifdef MAVLINK_MISSION_UNIT_TEST
+void
+MavlinkMissionManager::set_unittest_worker(SendMessageFunc_t sendMsgFunc, void *worker_data)
+{
+	_utSendMsgFunc = sendMsgFunc;
+	_worker_data = worker_data;
+}
+#endif
+
 unsigned
 MavlinkMissionManager::get_size()
 {
@@ -109,7 +145,8 @@ MavlinkMissionManager::get_size()
 		return MAVLINK_MSG_ID_MISSION_ITEM_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 
 	} else if (_state == MAVLINK_WPM_STATE_GETLIST) {
-		return MAVLINK_MSG_ID_MISSION_REQUEST + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+		/* a whole block of requests may go out at once */
+		return _transfer_window * (MAVLINK_MSG_ID_MISSION_REQUEST_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES);
 
 	} else {
 		return 0;
@@ -172,13 +209,44 @@ MavlinkMissionManager::update_active_mission(int dataman_id, unsigned count, int
 	} else {
 		warnx("WPM: ERROR: can't save mission state");
 		if (_filesystem_errcount++ < FILESYSTEM_ERRCOUNT_NOTIFY_LIMIT) {
-			_mavlink->send_statustext_critical("Mission storage: Unable to write to microSD");
+			send_statustext_critical("Mission storage: Unable to write to microSD");
 		}
 
 		return ERROR;
 	}
 }
 
+void
+MavlinkMissionManager::send_message(uint8_t msgid, const void *msg)
+{
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	// Unit test hook is set, call that instead
+	_utSendMsgFunc(msgid, msg, _worker_data);
+#else
+	_mavlink->send_message(msgid, msg);
+#endif
+}
+
+void
+MavlinkMissionManager::send_statustext_critical(const char *string)
+{
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	warnx("WPM: %s", string);
+#else
+	_mavlink->send_statustext_critical(string);
+#endif
+}
+
+void
+MavlinkMissionManager::send_statustext_info(const char *string)
+{
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	warnx("WPM: %s", string);
+#else
+	_mavlink->send_statustext_info(string);
+#endif
+}
+
 void
 MavlinkMissionManager::send_mission_ack(uint8_t sysid, uint8_t compid, uint8_t type)
 {
@@ -188,7 +256,7 @@ MavlinkMissionManager::send_mission_ack(uint8_t sysid, uint8_t compid, uint8_t t
 	wpa.target_component = compid;
 	wpa.type = type;
 
-	_mavlink->send_message(MAVLINK_MSG_ID_MISSION_ACK, &wpa);
+	send_message(MAVLINK_MSG_ID_MISSION_ACK, &wpa);
 
 	if (_verbose) { warnx("WPM: Send MISSION_ACK type %u to ID %u", wpa.type, wpa.target_system); }
 }
@@ -202,7 +270,7 @@ MavlinkMissionManager::send_mission_current(uint16_t seq)
 
 		wpc.seq = seq;
 
-		_mavlink->send_message(MAVLINK_MSG_ID_MISSION_CURRENT, &wpc);
+		send_message(MAVLINK_MSG_ID_MISSION_CURRENT, &wpc);
 
 	} else if (seq == 0 && _count == 0) {
 		/* don't broadcast if no WPs */
@@ -210,7 +278,7 @@ MavlinkMissionManager::send_mission_current(uint16_t seq)
 	} else {
 		if (_verbose) { warnx("WPM: Send MISSION_CURRENT ERROR: seq %u out of bounds", seq); }
 
-		_mavlink->send_statustext_critical("ERROR: wp index out of bounds");
+		send_statustext_critical("ERROR: wp index out of bounds");
 	}
 }
 
@@ -226,7 +294,7 @@ MavlinkMissionManager::send_mission_count(uint8_t sysid, uint8_t compid, uint16_
 	wpc.target_component = compid;
 	wpc.count = _count;
 
-	_mavlink->send_message(MAVLINK_MSG_ID_MISSION_COUNT, &wpc);
+	send_message(MAVLINK_MSG_ID_MISSION_COUNT, &wpc);
 
 	if (_verbose) { warnx("WPM: Send MISSION_COUNT %u to ID %u", wpc.count, wpc.target_system); }
 }
@@ -241,6 +309,24 @@ MavlinkMissionManager::send_mission_item(uint8_t sysid, uint8_t compid, uint16_t
 	if (dm_read(dm_item, seq, &mission_item, sizeof(struct mission_item_s)) == sizeof(struct mission_item_s)) {
 		_time_last_sent = hrt_absolute_time();
 
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+		if (_use_int) {
+			mavlink_mission_item_int_t wp;
+			format_mavlink_mission_item_int(&mission_item, &wp);
+
+			wp.target_system = sysid;
+			wp.target_component = compid;
+			wp.seq = seq;
+			wp.current = (_current_seq == seq) ? 1 : 0;
+
+			send_message(MAVLINK_MSG_ID_MISSION_ITEM_INT, &wp);
+
+			if (_verbose) { warnx("WPM: Send MISSION_ITEM_INT seq %u to ID %u", wp.seq, wp.target_system); }
+
+			return;
+		}
+#endif
+
 		/* create mission_item_s from mavlink_mission_item_t */
 		mavlink_mission_item_t wp;
 		format_mavlink_mission_item(&mission_item, &wp);
@@ -250,14 +336,14 @@ MavlinkMissionManager::send_mission_item(uint8_t sysid, uint8_t compid, uint16_t
 		wp.seq = seq;
 		wp.current = (_current_seq == seq) ? 1 : 0;
 
-		_mavlink->send_message(MAVLINK_MSG_ID_MISSION_ITEM, &wp);
+		send_message(MAVLINK_MSG_ID_MISSION_ITEM, &wp);
 
 		if (_verbose) { warnx("WPM: Send MISSION_ITEM seq %u to ID %u", wp.seq, wp.target_system); }
 
 	} else {
 		send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
 		if (_filesystem_errcount++ < FILESYSTEM_ERRCOUNT_NOTIFY_LIMIT) {
-			_mavlink->send_statustext_critical("Mission storage: Unable to read from microSD");
+			send_statustext_critical("Mission storage: Unable to read from microSD");
 		}
 
 		if (_verbose) { warnx("WPM: Send MISSION_ITEM ERROR: could not read seq %u from dataman ID %i", seq, _dataman_id); }
@@ -271,23 +357,144 @@ MavlinkMissionManager::send_mission_request(uint8_t sysid, uint8_t compid, uint1
 	if (seq < _max_count) {
 		_time_last_sent = hrt_absolute_time();
 
+#ifdef MAVLINK_MSG_ID_MISSION_REQUEST_INT
+		if (_use_int) {
+			mavlink_mission_request_int_t wpr;
+			wpr.target_system = sysid;
+			wpr.target_component = compid;
+			wpr.seq = seq;
+
+			send_message(MAVLINK_MSG_ID_MISSION_REQUEST_INT, &wpr);
+
+			if (_verbose) { warnx("WPM: Send MISSION_REQUEST_INT seq %u to ID %u", wpr.seq, wpr.target_system); }
+
+			return;
+		}
+#endif
+
 		mavlink_mission_request_t wpr;
 		wpr.target_system = sysid;
 		wpr.target_component = compid;
 		wpr.seq = seq;
 
-		_mavlink->send_message(MAVLINK_MSG_ID_MISSION_REQUEST, &wpr);
+		send_message(MAVLINK_MSG_ID_MISSION_REQUEST, &wpr);
 
 		if (_verbose) { warnx("WPM: Send MISSION_REQUEST seq %u to ID %u", wpr.seq, wpr.target_system); }
 
 	} else {
-		_mavlink->send_statustext_critical("ERROR: Waypoint index exceeds list capacity");
+		send_statustext_critical("ERROR: Waypoint index exceeds list capacity");
 
 		if (_verbose) { warnx("WPM: Send MISSION_REQUEST ERROR: seq %u exceeds list capacity", seq); }
 	}
 }
 
 
+unsigned
+MavlinkMissionManager::block_length()
+{
+	unsigned remaining = _transfer_count - _transfer_seq;
+
+	return (remaining < _transfer_window) ? remaining : _transfer_window;
+}
+
+
+void
+MavlinkMissionManager::request_block()
+{
+	unsigned len = block_length();
+
+	for (unsigned i = 0; i < len; i++) {
+		if (!(_transfer_received & (1u << i))) {
+			send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq + i);
+		}
+	}
+}
+
+
+bool
+MavlinkMissionManager::reserve_transfer_items()
+{
+	if (_transfer_items_size < _transfer_window) {
+		delete[] _transfer_items;
+		_transfer_items = new mission_item_s[_transfer_window];
+		_transfer_items_size = (_transfer_items != nullptr) ? _transfer_window : 0;
+	}
+
+	return _transfer_items != nullptr;
+}
+
+
+bool
+MavlinkMissionManager::write_transfer_block(unsigned len)
+{
+	dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id);
+
+	/* the whole block is synced to the storage once */
+	return dm_write_batch(dm_item, _transfer_seq, DM_PERSIST_POWER_ON_RESET, _transfer_items,
+			      sizeof(struct mission_item_s), len) == (ssize_t)(len * sizeof(struct mission_item_s));
+}
+
+
+void
+MavlinkMissionManager::end_transfer(uint8_t ack_type)
+{
+	send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, ack_type);
+	_state = MAVLINK_WPM_STATE_IDLE;
+	_transfer_in_progress = false;
+}
+
+
+void
+MavlinkMissionManager::store_transfer_item(uint16_t seq, const struct mission_item_s *mission_item, bool current)
+{
+	unsigned slot = seq - _transfer_seq;
+
+	_transfer_items[slot] = *mission_item;
+	_transfer_received |= (1u << slot);
+
+	/* waypoint marked as current */
+	if (current) {
+		_transfer_current_seq = seq;
+	}
+
+	if (_verbose) { warnx("WPM: MISSION_ITEM seq %u received", seq); }
+
+	unsigned len = block_length();
+
+	if (_transfer_received != (1u << len) - 1) {
+		/* wait for the rest of the block */
+		return;
+	}
+
+	if (!write_transfer_block(len)) {
+		if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: error writing seq %u-%u to dataman ID %i", _transfer_seq, _transfer_seq + len - 1, _transfer_dataman_id); }
+
+		send_statustext_critical("Unable to write on micro SD");
+		end_transfer(MAV_MISSION_ERROR);
+		return;
+	}
+
+	_transfer_seq += len;
+	_transfer_received = 0;
+
+	if (_transfer_seq == _transfer_count) {
+		/* got all new mission items successfully */
+		if (_verbose) { warnx("WPM: MISSION_ITEM got all %u items, current_seq=%u, changing state to MAVLINK_WPM_STATE_IDLE", _transfer_count, _transfer_current_seq); }
+
+		if (update_active_mission(_transfer_dataman_id, _transfer_count, _transfer_current_seq) == OK) {
+			end_transfer(MAV_MISSION_ACCEPTED);
+
+		} else {
+			end_transfer(MAV_MISSION_ERROR);
+		}
+
+	} else {
+		/* request next block */
+		request_block();
+	}
+}
+
+
 void
 MavlinkMissionManager::send_mission_item_reached(uint16_t seq)
 {
@@ -295,7 +502,7 @@ MavlinkMissionManager::send_mission_item_reached(uint16_t seq)
 
 	wp_reached.seq = seq;
 
-	_mavlink->send_message(MAVLINK_MSG_ID_MISSION_ITEM_REACHED, &wp_reached);
+	send_message(MAVLINK_MSG_ID_MISSION_ITEM_REACHED, &wp_reached);
 
 	if (_verbose) { warnx("WPM: Send MISSION_ITEM_REACHED reached_seq %u", wp_reached.seq); }
 }
@@ -335,15 +542,20 @@ MavlinkMissionManager::send(const hrt_abstime now)
 
 	/* check for timed-out operations */
 	if (_state != MAVLINK_WPM_STATE_IDLE && hrt_elapsed_time(&_time_last_recv) > _action_timeout) {
-		_mavlink->send_statustext_critical("Operation timeout");
+		send_statustext_critical("Operation timeout");
 
 		if (_verbose) { warnx("WPM: Last operation (state=%u) timed out, changing state to MAVLINK_WPM_STATE_IDLE", _state); }
 
+		if (_state == MAVLINK_WPM_STATE_GETLIST) {
+			/* release the transfer lock, otherwise no further upload is accepted */
+			_transfer_in_progress = false;
+		}
+
 		_state = MAVLINK_WPM_STATE_IDLE;
 
 	} else if (_state == MAVLINK_WPM_STATE_GETLIST && hrt_elapsed_time(&_time_last_sent) > _retry_timeout) {
-		/* try to request item again after timeout */
-		send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
+		/* try to request the missing items of the block again after timeout */
+		request_block();
 
 	} else if (_state == MAVLINK_WPM_STATE_SENDLIST && hrt_elapsed_time(&_time_last_sent) > _retry_timeout) {
 		if (_transfer_seq == 0) {
@@ -386,6 +598,18 @@ MavlinkMissionManager::handle_message(const mavlink_message_t *msg)
 		handle_mission_item(msg);
 		break;
 
+#ifdef MAVLINK_MSG_ID_MISSION_REQUEST_INT
+	case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+		handle_mission_request_int(msg);
+		break;
+#endif
+
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+	case MAVLINK_MSG_ID_MISSION_ITEM_INT:
+		handle_mission_item_int(msg);
+		break;
+#endif
+
 	case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
 		handle_mission_clear_all(msg);
 		break;
@@ -411,7 +635,7 @@ MavlinkMissionManager::handle_mission_ack(const mavlink_message_t *msg)
 					if (_verbose) { warnx("WPM: MISSION_ACK OK all items sent, switch to state IDLE"); }
 
 				} else {
-					_mavlink->send_statustext_critical("WPM: ERR: not all items sent -> IDLE");
+					send_statustext_critical("WPM: ERR: not all items sent -> IDLE");
 
 					if (_verbose) { warnx("WPM: MISSION_ACK ERROR: not all items sent, switch to state IDLE anyway"); }
 				}
@@ -420,7 +644,7 @@ MavlinkMissionManager::handle_mission_ack(const mavlink_message_t *msg)
 			}
 
 		} else {
-			_mavlink->send_statustext_critical("REJ. WP CMD: partner id mismatch");
+			send_statustext_critical("REJ. WP CMD: partner id mismatch");
 
 			if (_verbose) {
 				warnx("WPM: MISSION_ACK ERR: ID mismatch");
@@ -447,19 +671,19 @@ MavlinkMissionManager::handle_mission_set_current(const mavlink_message_t *msg)
 				} else {
 					if (_verbose) { warnx("WPM: MISSION_SET_CURRENT seq=%d ERROR", wpc.seq); }
 
-					_mavlink->send_statustext_critical("WPM: WP CURR CMD: Error setting ID");
+					send_statustext_critical("WPM: WP CURR CMD: Error setting ID");
 				}
 
 			} else {
 				if (_verbose) { warnx("WPM: MISSION_SET_CURRENT seq=%d ERROR: not in list", wpc.seq); }
 
-				_mavlink->send_statustext_critical("WPM: WP CURR CMD: Not in list");
+				send_statustext_critical("WPM: WP CURR CMD: Not in list");
 			}
 
 		} else {
 			if (_verbose) { warnx("WPM: MISSION_SET_CURRENT ERROR: busy"); }
 
-			_mavlink->send_statustext_critical("WPM: IGN WP CURR CMD: Busy");
+			send_statustext_critical("WPM: IGN WP CURR CMD: Busy");
 		}
 	}
 }
@@ -493,7 +717,7 @@ MavlinkMissionManager::handle_mission_request_list(const mavlink_message_t *msg)
 		} else {
 			if (_verbose) { warnx("WPM: MISSION_REQUEST_LIST ERROR: busy"); }
 
-			_mavlink->send_statustext_critical("IGN REQUEST LIST: Busy");
+			send_statustext_critical("IGN REQUEST LIST: Busy");
 		}
 	}
 }
@@ -506,66 +730,80 @@ MavlinkMissionManager::handle_mission_request(const mavlink_message_t *msg)
 	mavlink_msg_mission_request_decode(msg, &wpr);
 
 	if (CHECK_SYSID_COMPID_MISSION(wpr)) {
-		if (msg->sysid == _transfer_partner_sysid && msg->compid == _transfer_partner_compid) {
-			if (_state == MAVLINK_WPM_STATE_SENDLIST) {
-				_time_last_recv = hrt_absolute_time();
-
-				/* _transfer_seq contains sequence of expected request */
-				if (wpr.seq == _transfer_seq && _transfer_seq < _transfer_count) {
-					if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST seq %u from ID %u", wpr.seq, msg->sysid); }
-
-					_transfer_seq++;
+		handle_mission_request_seq(msg, wpr.seq, false);
+	}
+}
 
-				} else if (wpr.seq == _transfer_seq - 1) {
-					if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST seq %u from ID %u (again)", wpr.seq, msg->sysid); }
 
-				} else {
-					if (_transfer_seq > 0 && _transfer_seq < _transfer_count) {
-						if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u from ID %u unexpected, must be %i or %i", wpr.seq, msg->sysid, _transfer_seq - 1, _transfer_seq); }
+#ifdef MAVLINK_MSG_ID_MISSION_REQUEST_INT
+void
+MavlinkMissionManager::handle_mission_request_int(const mavlink_message_t *msg)
+{
+	mavlink_mission_request_int_t wpr;
+	mavlink_msg_mission_request_int_decode(msg, &wpr);
 
-					} else if (_transfer_seq <= 0) {
-						if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u from ID %u unexpected, must be %i", wpr.seq, msg->sysid, _transfer_seq); }
+	if (CHECK_SYSID_COMPID_MISSION(wpr)) {
+		handle_mission_request_seq(msg, wpr.seq, true);
+	}
+}
+#endif
 
-					} else {
-						if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u from ID %u unexpected, must be %i", wpr.seq, msg->sysid, _transfer_seq - 1); }
-					}
 
-					_state = MAVLINK_WPM_STATE_IDLE;
+void
+MavlinkMissionManager::handle_mission_request_seq(const mavlink_message_t *msg, uint16_t seq, bool use_int)
+{
+	if (msg->sysid == _transfer_partner_sysid && msg->compid == _transfer_partner_compid) {
+		if (_state == MAVLINK_WPM_STATE_SENDLIST) {
+			_time_last_recv = hrt_absolute_time();
+			_use_int = use_int;
 
-					send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
-					_mavlink->send_statustext_critical("WPM: REJ. CMD: Req. WP was unexpected");
-					return;
-				}
+			/* _transfer_seq contains sequence of expected request, a pipelining partner may ask up to a window ahead */
+			if (seq >= _transfer_seq && seq < _transfer_seq + _window && seq < _transfer_count) {
+				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST seq %u from ID %u", seq, msg->sysid); }
 
-				/* double check bounds in case of items count changed */
-				if (wpr.seq < _count) {
-					send_mission_item(_transfer_partner_sysid, _transfer_partner_compid, wpr.seq);
+				_transfer_seq = seq + 1;
 
-				} else {
-					if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u out of bound [%u, %u]", (unsigned)wpr.seq, (unsigned)wpr.seq, (unsigned)_count - 1); }
+			} else if (seq < _transfer_seq) {
+				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST seq %u from ID %u (again)", seq, msg->sysid); }
 
-					_state = MAVLINK_WPM_STATE_IDLE;
+			} else {
+				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u from ID %u unexpected, must be below %u", seq, msg->sysid, _transfer_seq + _window); }
 
-					send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
-					_mavlink->send_statustext_critical("WPM: REJ. CMD: Req. WP was unexpected");
-				}
+				_state = MAVLINK_WPM_STATE_IDLE;
 
-			} else if (_state == MAVLINK_WPM_STATE_IDLE) {
-				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: no transfer"); }
+				send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
+				send_statustext_critical("WPM: REJ. CMD: Req. WP was unexpected");
+				return;
+			}
 
-				_mavlink->send_statustext_critical("IGN MISSION_ITEM_REQUEST: No active transfer");
+			/* double check bounds in case of items count changed */
+			if (seq < _count) {
+				send_mission_item(_transfer_partner_sysid, _transfer_partner_compid, seq);
 
 			} else {
-				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: busy (state %d).", _state); }
+				if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: seq %u out of bound [%u, %u]", (unsigned)seq, (unsigned)seq, (unsigned)_count - 1); }
+
+				_state = MAVLINK_WPM_STATE_IDLE;
 
-				_mavlink->send_statustext_critical("WPM: REJ. CMD: Busy");
+				send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
+				send_statustext_critical("WPM: REJ. CMD: Req. WP was unexpected");
 			}
 
+		} else if (_state == MAVLINK_WPM_STATE_IDLE) {
+			if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: no transfer"); }
+
+			send_statustext_critical("IGN MISSION_ITEM_REQUEST: No active transfer");
+
 		} else {
-			_mavlink->send_statustext_critical("WPM: REJ. CMD: partner id mismatch");
+			if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: busy (state %d).", _state); }
 
-			if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: rejected, partner ID mismatch"); }
+			send_statustext_critical("WPM: REJ. CMD: Busy");
 		}
+
+	} else {
+		send_statustext_critical("WPM: REJ. CMD: partner id mismatch");
+
+		if (_verbose) { warnx("WPM: MISSION_ITEM_REQUEST ERROR: rejected, partner ID mismatch"); }
 	}
 }
 
@@ -615,6 +853,15 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 			_transfer_count = wpc.count;
 			_transfer_dataman_id = _dataman_id == 0 ? 1 : 0;	// use inactive storage for transmission
 			_transfer_current_seq = -1;
+			_transfer_window = _window;
+			_transfer_received = 0;
+			_use_int = false;
+
+			if (!reserve_transfer_items()) {
+				warnx("WPM: MISSION_COUNT ERROR: out of memory");
+				end_transfer(MAV_MISSION_ERROR);
+				return;
+			}
 
 		} else if (_state == MAVLINK_WPM_STATE_GETLIST) {
 			_time_last_recv = hrt_absolute_time();
@@ -623,23 +870,23 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 				/* looks like our MISSION_REQUEST was lost, try again */
 				if (_verbose) { warnx("WPM: MISSION_COUNT %u from ID %u (again)", wpc.count, msg->sysid); }
 
-				_mavlink->send_statustext_info("WP CMD OK TRY AGAIN");
+				send_statustext_info("WP CMD OK TRY AGAIN");
 
 			} else {
 				if (_verbose) { warnx("WPM: MISSION_COUNT ERROR: busy, already receiving seq %u", _transfer_seq); }
 
-				_mavlink->send_statustext_critical("WPM: REJ. CMD: Busy");
+				send_statustext_critical("WPM: REJ. CMD: Busy");
 				return;
 			}
 
 		} else {
 			if (_verbose) { warnx("WPM: MISSION_COUNT ERROR: busy, state %i", _state); }
 
-			_mavlink->send_statustext_critical("WPM: IGN MISSION_COUNT: Busy");
+			send_statustext_critical("WPM: IGN MISSION_COUNT: Busy");
 			return;
 		}
 
-		send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
+		request_block();
 	}
 }
 
@@ -651,82 +898,90 @@ MavlinkMissionManager::handle_mission_item(const mavlink_message_t *msg)
 	mavlink_msg_mission_item_decode(msg, &wp);
 
 	if (CHECK_SYSID_COMPID_MISSION(wp)) {
-		if (_state == MAVLINK_WPM_STATE_GETLIST) {
-			_time_last_recv = hrt_absolute_time();
-
-			if (wp.seq != _transfer_seq) {
-				if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u was not the expected %u", wp.seq, _transfer_seq); }
+		if (!accept_mission_item(wp.seq)) {
+			return;
+		}
 
-				/* don't send request here, it will be performed in eventloop after timeout */
-				return;
-			}
+		struct mission_item_s mission_item = {};
+		int ret = parse_mavlink_mission_item(&wp, &mission_item);
 
-		} else if (_state == MAVLINK_WPM_STATE_IDLE) {
-			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: no transfer"); }
+		if (ret != OK) {
+			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u invalid item", wp.seq); }
 
-			_mavlink->send_statustext_critical("IGN MISSION_ITEM: No transfer");
+			send_statustext_critical("IGN MISSION_ITEM: Busy");
+			end_transfer(ret);
 			return;
+		}
 
-		} else {
-			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: busy, state %i", _state); }
+		store_transfer_item(wp.seq, &mission_item, wp.current);
+	}
+}
 
-			_mavlink->send_statustext_critical("IGN MISSION_ITEM: Busy");
+
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+void
+MavlinkMissionManager::handle_mission_item_int(const mavlink_message_t *msg)
+{
+	mavlink_mission_item_int_t wp;
+	mavlink_msg_mission_item_int_decode(msg, &wp);
+
+	if (CHECK_SYSID_COMPID_MISSION(wp)) {
+		if (!accept_mission_item(wp.seq)) {
 			return;
 		}
 
+		/* the partner speaks MISSION_ITEM_INT, request the remaining items the same way */
+		_use_int = true;
+
 		struct mission_item_s mission_item = {};
-		int ret = parse_mavlink_mission_item(&wp, &mission_item);
+		int ret = parse_mavlink_mission_item_int(&wp, &mission_item);
 
 		if (ret != OK) {
-			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u invalid item", wp.seq); }
+			if (_verbose) { warnx("WPM: MISSION_ITEM_INT ERROR: seq %u invalid item", wp.seq); }
 
-			_mavlink->send_statustext_critical("IGN MISSION_ITEM: Busy");
-
-			send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, ret);
-			_state = MAVLINK_WPM_STATE_IDLE;
-			_transfer_in_progress = false;
+			send_statustext_critical("IGN MISSION_ITEM: Busy");
+			end_transfer(ret);
 			return;
 		}
 
-		dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id);
+		store_transfer_item(wp.seq, &mission_item, wp.current);
+	}
+}
+#endif
 
-		if (dm_write(dm_item, wp.seq, DM_PERSIST_POWER_ON_RESET, &mission_item, sizeof(struct mission_item_s)) != sizeof(struct mission_item_s)) {
-			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: error writing seq %u to dataman ID %i", wp.seq, _transfer_dataman_id); }
 
-			send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
-			_mavlink->send_statustext_critical("Unable to write on micro SD");
-			_state = MAVLINK_WPM_STATE_IDLE;
-			_transfer_in_progress = false;
-			return;
-		}
+bool
+MavlinkMissionManager::accept_mission_item(uint16_t seq)
+{
+	if (_state == MAVLINK_WPM_STATE_GETLIST) {
+		_time_last_recv = hrt_absolute_time();
 
-		/* waypoint marked as current */
-		if (wp.current) {
-			_transfer_current_seq = wp.seq;
+		if (seq < _transfer_seq || seq >= _transfer_seq + block_length()) {
+			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u not in the requested block [%u, %u]", seq, _transfer_seq, _transfer_seq + block_length() - 1); }
+
+			/* don't send request here, it will be performed in eventloop after timeout */
+			return false;
 		}
 
-		if (_verbose) { warnx("WPM: MISSION_ITEM seq %u received", wp.seq); }
+		if (_transfer_received & (1u << (seq - _transfer_seq))) {
+			if (_verbose) { warnx("WPM: MISSION_ITEM seq %u received again", seq); }
 
-		_transfer_seq = wp.seq + 1;
+			return false;
+		}
 
-		if (_transfer_seq == _transfer_count) {
-			/* got all new mission items successfully */
-			if (_verbose) { warnx("WPM: MISSION_ITEM got all %u items, current_seq=%u, changing state to MAVLINK_WPM_STATE_IDLE", _transfer_count, _transfer_current_seq); }
+		return true;
 
-			_state = MAVLINK_WPM_STATE_IDLE;
+	} else if (_state == MAVLINK_WPM_STATE_IDLE) {
+		if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: no transfer"); }
 
-			if (update_active_mission(_transfer_dataman_id, _transfer_count, _transfer_current_seq) == OK) {
-				send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ACCEPTED);
+		send_statustext_critical("IGN MISSION_ITEM: No transfer");
+		return false;
 
-			} else {
-				send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
-			}
-			_transfer_in_progress = false;
+	} else {
+		if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: busy, state %i", _state); }
 
-		} else {
-			/* request next item */
-			send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
-		}
+		send_statustext_critical("IGN MISSION_ITEM: Busy");
+		return false;
 	}
 }
 
@@ -752,7 +1007,7 @@ MavlinkMissionManager::handle_mission_clear_all(const mavlink_message_t *msg)
 			}
 
 		} else {
-			_mavlink->send_statustext_critical("WPM: IGN CLEAR CMD: Busy");
+			send_statustext_critical("WPM: IGN CLEAR CMD: Busy");
 
 			if (_verbose) { warnx("WPM: CLEAR_ALL IGNORED: busy"); }
 		}
@@ -883,6 +1138,217 @@ MavlinkMissionManager::format_mavlink_mission_item(const struct mission_item_s *
 }
 
 
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+int
+MavlinkMissionManager::parse_mavlink_mission_item_int(const mavlink_mission_item_int_t *mavlink_mission_item, struct mission_item_s *mission_item)
+{
+	/* everything but the coordinates is shared with MISSION_ITEM */
+	mavlink_mission_item_t wp;
+	wp.param1 = mavlink_mission_item->param1;
+	wp.param2 = mavlink_mission_item->param2;
+	wp.param3 = mavlink_mission_item->param3;
+	wp.param4 = mavlink_mission_item->param4;
+	wp.x = (float)mavlink_mission_item->x;
+	wp.y = (float)mavlink_mission_item->y;
+	wp.z = mavlink_mission_item->z;
+	wp.seq = mavlink_mission_item->seq;
+	wp.command = mavlink_mission_item->command;
+	wp.frame = mavlink_mission_item->frame;
+	wp.current = mavlink_mission_item->current;
+	wp.autocontinue = mavlink_mission_item->autocontinue;
+
+	/* integer frames are stored like their float counterparts */
+	if (wp.frame == MAV_FRAME_GLOBAL_INT) {
+		wp.frame = MAV_FRAME_GLOBAL;
+
+	} else if (wp.frame == MAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+		wp.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+	}
+
+	int ret = parse_mavlink_mission_item(&wp, mission_item);
+
+	/* take the coordinates at full precision instead of the float conversion */
+	if (ret == MAV_MISSION_ACCEPTED && wp.frame != MAV_FRAME_MISSION) {
+		mission_item->lat = mavlink_mission_item->x * 1e-7;
+		mission_item->lon = mavlink_mission_item->y * 1e-7;
+	}
+
+	return ret;
+}
+
+
+int
+MavlinkMissionManager::format_mavlink_mission_item_int(const struct mission_item_s *mission_item, mavlink_mission_item_int_t *mavlink_mission_item)
+{
+	mavlink_mission_item_t wp = {};
+	format_mavlink_mission_item(mission_item, &wp);
+
+	mavlink_mission_item->param1 = wp.param1;
+	mavlink_mission_item->param2 = wp.param2;
+	mavlink_mission_item->param3 = wp.param3;
+	mavlink_mission_item->param4 = wp.param4;
+	mavlink_mission_item->z = wp.z;
+	mavlink_mission_item->command = wp.command;
+	mavlink_mission_item->frame = wp.frame;
+	mavlink_mission_item->autocontinue = wp.autocontinue;
+
+	if (mission_item->frame == MAV_FRAME_MISSION) {
+		mavlink_mission_item->x = (int32_t)wp.x;
+		mavlink_mission_item->y = (int32_t)wp.y;
+
+	} else {
+		mavlink_mission_item->x = (int32_t)round(mission_item->lat * 1e7);
+		mavlink_mission_item->y = (int32_t)round(mission_item->lon * 1e7);
+	}
+
+	return OK;
+}
+#endif
+
+
+int
+MavlinkMissionManager::import_mission_file(const char *filename)
+{
+	if (_state != MAVLINK_WPM_STATE_IDLE || _transfer_in_progress) {
+		if (_verbose) { warnx("WPM: mission import ERROR: busy, state %i", _state); }
+
+		send_statustext_critical("WPM: IGN mission import: Busy");
+		return ERROR;
+	}
+
+	FILE *fp = fopen(filename, "r");
+
+	if (fp == nullptr) {
+		if (_verbose) { warnx("WPM: mission import ERROR: can't open %s", filename); }
+
+		return ERROR;
+	}
+
+	_transfer_in_progress = true;
+	_transfer_dataman_id = _dataman_id == 0 ? 1 : 0;	// use inactive storage for the import
+	_transfer_seq = 0;
+	_transfer_current_seq = -1;
+	_transfer_window = _window;
+
+	int ret = reserve_transfer_items() ? OK : ERROR;
+	bool header = false;
+	unsigned block = 0;
+	char line[160];
+
+	while (ret == OK && fgets(line, sizeof(line), fp) != nullptr) {
+		if (!header) {
+			header = (strncmp(line, "QGC WPL 110", 11) == 0);
+
+			if (!header) {
+				warnx("WPM: mission import ERROR: not a QGC WPL 110 file");
+				ret = ERROR;
+			}
+
+			continue;
+		}
+
+		/* skip empty lines */
+		if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+			continue;
+		}
+
+		unsigned seq, current, frame, command, autocontinue;
+		float param1, param2, param3, param4, z;
+		double x, y;
+
+		if (sscanf(line, "%u %u %u %u %f %f %f %f %lf %lf %f %u", &seq, &current, &frame, &command,
+			   &param1, &param2, &param3, &param4, &x, &y, &z, &autocontinue) != 12) {
+			warnx("WPM: mission import ERROR: malformed item %u", _transfer_seq + block);
+			ret = ERROR;
+			break;
+		}
+
+		if (seq != _transfer_seq + block || seq >= _max_count) {
+			warnx("WPM: mission import ERROR: item %u out of sequence", seq);
+			ret = ERROR;
+			break;
+		}
+
+		mavlink_mission_item_t wp;
+		wp.param1 = param1;
+		wp.param2 = param2;
+		wp.param3 = param3;
+		wp.param4 = param4;
+		wp.x = (float)x;
+		wp.y = (float)y;
+		wp.z = z;
+		wp.seq = seq;
+		wp.command = command;
+		wp.frame = frame;
+		wp.current = current;
+		wp.autocontinue = autocontinue;
+
+		struct mission_item_s *mission_item = &_transfer_items[block];
+		memset(mission_item, 0, sizeof(*mission_item));
+
+		if (parse_mavlink_mission_item(&wp, mission_item) != MAV_MISSION_ACCEPTED) {
+			warnx("WPM: mission import ERROR: seq %u invalid item", seq);
+			ret = ERROR;
+			break;
+		}
+
+		/* the file has the coordinates at full precision */
+		if (wp.frame != MAV_FRAME_MISSION) {
+			mission_item->lat = x;
+			mission_item->lon = y;
+		}
+
+		if (current) {
+			_transfer_current_seq = seq;
+		}
+
+		/* write the items to dataman a block at a time */
+		if (++block == _transfer_window) {
+			if (!write_transfer_block(block)) {
+				ret = ERROR;
+				break;
+			}
+
+			_transfer_seq += block;
+			block = 0;
+		}
+	}
+
+	fclose(fp);
+
+	if (ret == OK && block > 0) {
+		if (write_transfer_block(block)) {
+			_transfer_seq += block;
+
+		} else {
+			ret = ERROR;
+		}
+	}
+
+	if (ret == OK && header) {
+		ret = update_active_mission(_transfer_dataman_id, _transfer_seq, _transfer_current_seq);
+
+	} else {
+		ret = ERROR;
+	}
+
+	_transfer_in_progress = false;
+
+	if (ret == OK) {
+		if (_verbose) { warnx("WPM: imported %u mission items from %s", _transfer_seq, filename); }
+
+		send_statustext_info("Mission imported");
+
+		/* let the partners know about the new mission */
+		send_mission_count(_transfer_partner_sysid, _transfer_partner_compid, _count);
+
+	} else {
+		send_statustext_critical("Mission import failed");
+	}
+
+	return ret;
+}
+
 void MavlinkMissionManager::check_active_mission(void)
 {
 	if(!(_my_dataman_id==_dataman_id))
@@ -42,6 +42,7 @@
 
 #pragma once
 
+#include <px4_defines.h>
 #include <uORB/uORB.h>
 
 #include "mavlink_bridge_header.h"
@@ -66,6 +67,11 @@ enum MAVLINK_WPM_CODES {
 
 #define MAVLINK_MISSION_PROTOCOL_TIMEOUT_DEFAULT 5000000    ///< Protocol communication action timeout in useconds
 #define MAVLINK_MISSION_RETRY_TIMEOUT_DEFAULT 500000        ///< Protocol communication retry timeout in useconds
+#define MAVLINK_MISSION_WINDOW_MAX 16                       ///< Maximum number of mission items requested at once
+#define MAVLINK_MISSION_IMPORT_FILE PX4_ROOTFSDIR"/fs/microsd/etc/mission.txt" ///< Mission file imported after an FTP upload
+
+struct mission_item_s;
+class MavlinkMissionTest;
 
 class MavlinkMissionManager : public MavlinkStream {
 public:
@@ -97,8 +103,31 @@ public:
 
 	void set_verbose(bool v) { _verbose = v; }
 
+	/**
+	 * Set the number of mission items requested at once during an upload.
+	 * Takes effect with the next transfer.
+	 */
+	void set_window(unsigned window);
+
 	void check_active_mission(void);
 
+	/**
+	 * Replace the active mission with the items of a QGC WPL 110 mission file.
+	 *
+	 * @param filename mission file, one tab separated item per line
+	 * @return OK on success, ERROR if busy or the file is invalid
+	 */
+	int import_mission_file(const char *filename);
+
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	typedef void (*SendMessageFunc_t)(uint8_t msgid, const void *msg, void *worker_data);
+
+	/// @brief Sets up the manager to run in unit test mode.
+	///	@param sendMsgFunc Function which will be called to handle outgoing mavlink messages.
+	///	@param worker_data Data to pass to worker
+	void set_unittest_worker(SendMessageFunc_t sendMsgFunc, void *worker_data);
+#endif
+
 private:
 	enum MAVLINK_WPM_STATES _state;					///< Current state
 
@@ -125,6 +154,13 @@ private:
 	unsigned		_transfer_partner_compid;		///< Partner component ID for current transmission
 	static bool		_transfer_in_progress;			///< Global variable checking for current transmission
 
+	unsigned		_window;				///< Number of items requested at once for new transmissions
+	unsigned		_transfer_window;			///< Number of items requested at once in current transmission
+	uint32_t		_transfer_received;			///< Bitmask of the received items in the current block
+	struct mission_item_s	*_transfer_items;			///< Items of the current block, written to dataman at once
+	unsigned		_transfer_items_size;			///< Number of allocated items in _transfer_items
+	bool			_use_int;				///< Partner talks MISSION_ITEM_INT, reply in kind
+
 	int			_offboard_mission_sub;
 	int			_mission_result_sub;
 	orb_advert_t		_offboard_mission_pub;
@@ -133,6 +169,11 @@ private:
 
 	bool _verbose;
 
+#ifdef MAVLINK_MISSION_UNIT_TEST
+	SendMessageFunc_t	_utSendMsgFunc;		///< Unit test override for mavlink message sending
+	void			*_worker_data;		///< Additional parameter to _utSendMsgFunc
+#endif
+
 	static constexpr unsigned int	FILESYSTEM_ERRCOUNT_NOTIFY_LIMIT = 2;	///< Error count limit before stopping to report FS errors
 
 	/* do not allow top copying this class */
@@ -143,6 +184,15 @@ private:
 
 	int update_active_mission(int dataman_id, unsigned count, int seq);
 
+	/**
+	 *  @brief Sends a message to the transfer partner, or hands it to the unit test
+	 */
+	void send_message(uint8_t msgid, const void *msg);
+
+	void send_statustext_critical(const char *string);
+
+	void send_statustext_info(const char *string);
+
 	/**
 	 *  @brief Sends an waypoint ack message
 	 */
@@ -165,6 +215,36 @@ private:
 
 	void send_mission_request(uint8_t sysid, uint8_t compid, uint16_t seq);
 
+	/**
+	 *  @brief Requests all items of the current block which have not been received yet
+	 */
+	void request_block();
+
+	/**
+	 *  @brief Number of items in the block starting at _transfer_seq
+	 */
+	unsigned block_length();
+
+	/**
+	 *  @brief Stores a received item of the current block, writes the block once complete
+	 */
+	void store_transfer_item(uint16_t seq, const struct mission_item_s *mission_item, bool current);
+
+	/**
+	 *  @brief Ends the current transmission and releases the transfer lock
+	 */
+	void end_transfer(uint8_t ack_type);
+
+	/**
+	 *  @brief Makes sure the block buffer holds _transfer_window items
+	 */
+	bool reserve_transfer_items();
+
+	/**
+	 *  @brief Writes the first len buffered items to dataman at _transfer_seq
+	 */
+	bool write_transfer_block(unsigned len);
+
 	/**
 	 *  @brief emits a message that a waypoint reached
 	 *
@@ -182,10 +262,27 @@ private:
 
 	void handle_mission_request(const mavlink_message_t *msg);
 
+#ifdef MAVLINK_MSG_ID_MISSION_REQUEST_INT
+	void handle_mission_request_int(const mavlink_message_t *msg);
+#endif
+
+	void handle_mission_request_seq(const mavlink_message_t *msg, uint16_t seq, bool use_int);
+
 	void handle_mission_count(const mavlink_message_t *msg);
 
 	void handle_mission_item(const mavlink_message_t *msg);
 
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+	void handle_mission_item_int(const mavlink_message_t *msg);
+#endif
+
+	/**
+	 *  @brief Checks an incoming item against the state of the transmission
+	 *
+	 *  @return true if the item belongs to the current block and was not received yet
+	 */
+	bool accept_mission_item(uint16_t seq);
+
 	void handle_mission_clear_all(const mavlink_message_t *msg);
 
 	/**
@@ -198,8 +295,23 @@ private:
 	 */
 	int format_mavlink_mission_item(const struct mission_item_s *mission_item, mavlink_mission_item_t *mavlink_mission_item);
 
+#ifdef MAVLINK_MSG_ID_MISSION_ITEM_INT
+	/**
+	 * Parse mavlink MISSION_ITEM_INT message to get mission_item_s, keeping the full coordinate precision.
+	 */
+	int parse_mavlink_mission_item_int(const mavlink_mission_item_int_t *mavlink_mission_item, struct mission_item_s *mission_item);
+
+	/**
+	 * Format mission_item_s as mavlink MISSION_ITEM_INT message.
+	 */
+	int format_mavlink_mission_item_int(const struct mission_item_s *mission_item, mavlink_mission_item_int_t *mavlink_mission_item);
+#endif
+
 protected:
 	explicit MavlinkMissionManager(Mavlink *mavlink);
 
 	void send(const hrt_abstime t);
+
+	// Mission test needs to be able to create instances and call send
+	friend class MavlinkMissionTest;
 };
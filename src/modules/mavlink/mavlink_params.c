@@ -90,6 +90,21 @@ PARAM_DEFINE_INT32(MAV_USEHILGPS, 0);
  */
 PARAM_DEFINE_INT32(MAV_FWDEXTSP, 1);
 
+/**
+ * Mission upload window
+ *
+ * Number of mission items requested at once while a mission is uploaded.
+ * Values above 1 keep several requests in flight, which shortens uploads
+ * over links with a high latency. Ground stations which only answer the
+ * most recent request still work, but retry more often, so the default
+ * keeps the classic one item at a time transfer.
+ *
+ * @min 1
+ * @max 16
+ * @group MAVLink
+ */
+PARAM_DEFINE_INT32(MAV_MIS_WINDOW, 1);
+
 /**
  * Test parameter
  *
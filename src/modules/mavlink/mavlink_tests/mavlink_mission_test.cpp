@@ -0,0 +1,343 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/// @file mavlink_mission_test.cpp
+/// @brief Loopback tests and upload benchmark for the mission manager.
+///
+/// A simulated ground station answers the mission protocol over a link with
+/// configurable latency and speed. The link runs on simulated time, only the
+/// processing time of the mission manager (including the dataman writes) is
+/// taken from the real clock. Note that the tests replace the active mission,
+/// the previous mission state is restored afterwards.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <dataman/dataman.h>
+#include <navigator/navigation.h>
+
+#include "mavlink_mission_test.h"
+
+#define TEST_HOME_LAT	47.3977419
+#define TEST_HOME_LON	8.5455938
+
+const char MavlinkMissionTest::_unittest_mission_file[] = PX4_ROOTFSDIR"/fs/microsd/mission_unit_test.txt";
+
+MavlinkMissionTest::MavlinkMissionTest() :
+	_mission_manager(nullptr),
+	_link{},
+	_link_count(0),
+	_now(0),
+	_vehicle_tx_free(0),
+	_gcs_tx_free(0),
+	_latency(0),
+	_baudrate(57600),
+	_ack_type(-1),
+	_overflow(false),
+	_saved_mission{},
+	_saved_mission_valid(false)
+{
+}
+
+MavlinkMissionTest::~MavlinkMissionTest()
+{
+
+}
+
+/// @brief Called before every test to initialize the mission manager.
+void MavlinkMissionTest::_init(void)
+{
+	_saved_mission_valid = (dm_read(DM_KEY_MISSION_STATE, 0, &_saved_mission, sizeof(mission_s)) == sizeof(mission_s));
+
+	_mission_manager = (MavlinkMissionManager *)MavlinkMissionManager::new_instance(nullptr);
+	_mission_manager->set_unittest_worker(MavlinkMissionTest::send_message_handler, this);
+}
+
+/// @brief Called after every test to take down the mission manager.
+void MavlinkMissionTest::_cleanup(void)
+{
+	delete _mission_manager;
+	_mission_manager = nullptr;
+
+	if (_saved_mission_valid) {
+		dm_write(DM_KEY_MISSION_STATE, 0, DM_PERSIST_POWER_ON_RESET, &_saved_mission, sizeof(mission_s));
+	}
+
+	unlink(_unittest_mission_file);
+}
+
+void MavlinkMissionTest::send_message_handler(uint8_t msgid, const void *msg, void *worker_data)
+{
+	MavlinkMissionTest *mission_test = (MavlinkMissionTest *)worker_data;
+	mission_test->_send_message_handler(msgid, msg);
+}
+
+/// @brief Puts the messages of the mission manager onto the simulated link.
+void MavlinkMissionTest::_send_message_handler(uint8_t msgid, const void *msg)
+{
+	switch (msgid) {
+	case MAVLINK_MSG_ID_MISSION_REQUEST:
+		_queue(false, msgid, ((const mavlink_mission_request_t *)msg)->seq, 0, MAVLINK_MSG_ID_MISSION_REQUEST_LEN);
+		break;
+
+	case MAVLINK_MSG_ID_MISSION_ACK:
+		_queue(false, msgid, 0, ((const mavlink_mission_ack_t *)msg)->type, MAVLINK_MSG_ID_MISSION_ACK_LEN);
+		break;
+
+	default:
+		// Status messages are not part of the transfer
+		break;
+	}
+}
+
+/// @brief Queues a message which arrives after the link latency once the sender is done transmitting.
+void MavlinkMissionTest::_queue(bool to_vehicle, uint8_t msgid, uint16_t seq, uint8_t type, unsigned len)
+{
+	if (_link_count == _queue_size) {
+		_overflow = true;
+		return;
+	}
+
+	uint64_t *tx_free = to_vehicle ? &_gcs_tx_free : &_vehicle_tx_free;
+	uint64_t tx_time = (uint64_t)(len + MAVLINK_NUM_NON_PAYLOAD_BYTES) * 10 * 1000000 / _baudrate;
+
+	*tx_free = ((*tx_free > _now) ? *tx_free : _now) + tx_time;
+
+	LinkMessage &link_msg = _link[_link_count++];
+	link_msg.arrival = *tx_free + _latency;
+	link_msg.msgid = msgid;
+	link_msg.seq = seq;
+	link_msg.type = type;
+	link_msg.to_vehicle = to_vehicle;
+}
+
+/// @brief Waypoints spaced 1 m apart in north direction.
+void MavlinkMissionTest::_make_item(uint16_t seq, mavlink_mission_item_t *item)
+{
+	memset(item, 0, sizeof(*item));
+
+	item->target_system = mavlink_system.sysid;
+	item->target_component = MAV_COMP_ID_ALL;
+	item->seq = seq;
+	item->frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+	item->command = (seq == 0) ? MAV_CMD_NAV_TAKEOFF : MAV_CMD_NAV_WAYPOINT;
+	item->current = (seq == 0) ? 1 : 0;
+	item->autocontinue = 1;
+	item->x = TEST_HOME_LAT + seq * 1e-5;
+	item->y = TEST_HOME_LON;
+	item->z = 50.0f;
+}
+
+/// @brief Uploads a mission through the simulated link.
+///	@param count Number of mission items
+///	@param window Number of items requested at once
+///	@param elapsed Returned simulated upload time [us]
+///	@return true if the mission was accepted
+bool MavlinkMissionTest::_upload(unsigned count, unsigned window, uint64_t *elapsed)
+{
+	_mission_manager->set_window(window);
+
+	_link_count = 0;
+	_now = 0;
+	_vehicle_tx_free = 0;
+	_gcs_tx_free = 0;
+	_ack_type = -1;
+	_overflow = false;
+
+	mavlink_message_t msg;
+	mavlink_mission_count_t mission_count;
+	mission_count.target_system = mavlink_system.sysid;
+	mission_count.target_component = MAV_COMP_ID_ALL;
+	mission_count.count = count;
+	mavlink_msg_mission_count_encode(clientSystemId, clientComponentId, &msg, &mission_count);
+	_mission_manager->handle_message(&msg);
+
+	while (_ack_type < 0 && _link_count > 0 && !_overflow) {
+		// deliver the message which arrives first
+		unsigned next = 0;
+
+		for (unsigned i = 1; i < _link_count; i++) {
+			if (_link[i].arrival < _link[next].arrival) {
+				next = i;
+			}
+		}
+
+		LinkMessage link_msg = _link[next];
+		_link[next] = _link[--_link_count];
+		_now = link_msg.arrival;
+
+		if (link_msg.to_vehicle) {
+			mavlink_mission_item_t item;
+			_make_item(link_msg.seq, &item);
+			mavlink_msg_mission_item_encode(clientSystemId, clientComponentId, &msg, &item);
+
+			// the vehicle is busy for the time it takes to process the item
+			hrt_abstime start = hrt_absolute_time();
+			_mission_manager->handle_message(&msg);
+			_now += hrt_absolute_time() - start;
+
+		} else if (link_msg.msgid == MAVLINK_MSG_ID_MISSION_REQUEST) {
+			// the ground station answers every request right away
+			_queue(true, MAVLINK_MSG_ID_MISSION_ITEM, link_msg.seq, 0, MAVLINK_MSG_ID_MISSION_ITEM_LEN);
+
+		} else if (link_msg.msgid == MAVLINK_MSG_ID_MISSION_ACK) {
+			_ack_type = link_msg.type;
+		}
+	}
+
+	*elapsed = _now;
+
+	return !_overflow && _ack_type == MAV_MISSION_ACCEPTED;
+}
+
+/// @brief Compares the active mission with the uploaded items.
+bool MavlinkMissionTest::_check_mission(unsigned count, double tolerance)
+{
+	struct mission_s mission;
+
+	if (dm_read(DM_KEY_MISSION_STATE, 0, &mission, sizeof(mission_s)) != sizeof(mission_s) ||
+	    mission.count != count || mission.current_seq != 0) {
+		warnx("mission state mismatch");
+		return false;
+	}
+
+	for (unsigned seq = 0; seq < count; seq++) {
+		struct mission_item_s mission_item;
+
+		if (dm_read(DM_KEY_WAYPOINTS_OFFBOARD(mission.dataman_id), seq, &mission_item,
+			    sizeof(mission_item_s)) != sizeof(mission_item_s)) {
+			warnx("item %u not stored", seq);
+			return false;
+		}
+
+		if (fabs(mission_item.lat - (TEST_HOME_LAT + seq * 1e-5)) > tolerance ||
+		    fabs(mission_item.lon - TEST_HOME_LON) > tolerance ||
+		    mission_item.nav_cmd != ((seq == 0) ? NAV_CMD_TAKEOFF : NAV_CMD_WAYPOINT)) {
+			warnx("item %u mismatch", seq);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// @brief Tests a classic one item at a time upload.
+bool MavlinkMissionTest::_upload_test(void)
+{
+	uint64_t elapsed;
+
+	ut_assert("Upload not accepted", _upload(10, 1, &elapsed));
+	ut_assert("Stored mission differs", _check_mission(10, 1e-5));
+
+	return true;
+}
+
+/// @brief Tests windowed uploads, including a last block which is not full.
+bool MavlinkMissionTest::_upload_window_test(void)
+{
+	uint64_t elapsed;
+
+	ut_assert("Upload not accepted", _upload(37, 8, &elapsed));
+	ut_assert("Stored mission differs", _check_mission(37, 1e-5));
+
+	ut_assert("Upload not accepted", _upload(3, MAVLINK_MISSION_WINDOW_MAX, &elapsed));
+	ut_assert("Stored mission differs", _check_mission(3, 1e-5));
+
+	return true;
+}
+
+/// @brief Tests the import of a mission file with full precision coordinates.
+bool MavlinkMissionTest::_import_test(void)
+{
+	const unsigned count = 25;
+
+	FILE *fp = fopen(_unittest_mission_file, "w");
+	ut_assert("Can't create mission file", fp != nullptr);
+
+	fprintf(fp, "QGC WPL 110\n");
+
+	for (unsigned seq = 0; seq < count; seq++) {
+		fprintf(fp, "%u\t%u\t%u\t%u\t0\t0\t0\t0\t%.8f\t%.8f\t50\t1\n", seq, (seq == 0) ? 1 : 0,
+			MAV_FRAME_GLOBAL_RELATIVE_ALT, (seq == 0) ? MAV_CMD_NAV_TAKEOFF : MAV_CMD_NAV_WAYPOINT,
+			TEST_HOME_LAT + seq * 1e-5, TEST_HOME_LON);
+	}
+
+	fclose(fp);
+
+	_mission_manager->set_window(MAVLINK_MISSION_WINDOW_MAX);
+	ut_compare("Import failed", _mission_manager->import_mission_file(_unittest_mission_file), OK);
+	ut_assert("Imported mission differs", _check_mission(count, 1e-7));
+
+	return true;
+}
+
+/// @brief Measures the upload time of a large mission over a slow telemetry radio.
+bool MavlinkMissionTest::_upload_benchmark(void)
+{
+	const unsigned count = DM_KEY_WAYPOINTS_OFFBOARD_0_MAX;
+	const unsigned windows[] = {1, 4, MAVLINK_MISSION_WINDOW_MAX};
+	uint64_t elapsed[sizeof(windows) / sizeof(windows[0])];
+
+	_latency = 150000;
+	_baudrate = 57600;
+
+	for (unsigned i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+		ut_assert("Upload not accepted", _upload(count, windows[i], &elapsed[i]));
+		ut_assert("Stored mission differs", _check_mission(count, 1e-5));
+
+		warnx("%u items, window %2u, %u ms latency, %u baud: %.2f s", count, windows[i],
+		      (unsigned)(_latency / 1000), (unsigned)_baudrate, (double)elapsed[i] / 1e6);
+	}
+
+	ut_assert("Window did not speed up the upload", elapsed[2] < elapsed[0]);
+
+	_latency = 0;
+
+	return true;
+}
+
+bool MavlinkMissionTest::run_tests(void)
+{
+	ut_run_test(_upload_test);
+	ut_run_test(_upload_window_test);
+	ut_run_test(_import_test);
+	ut_run_test(_upload_benchmark);
+
+	return (_tests_failed == 0);
+}
+
+ut_declare_test(mavlink_mission_test, MavlinkMissionTest)
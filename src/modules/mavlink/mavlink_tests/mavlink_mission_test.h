@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/// @file mavlink_mission_test.h
+/// @brief Loopback tests and upload benchmark for the mission manager.
+
+#pragma once
+
+#include <unit_test/unit_test.h>
+#include <uORB/topics/mission.h>
+#include "../mavlink_bridge_header.h"
+#include "../mavlink_mission.h"
+
+class MavlinkMissionTest : public UnitTest
+{
+public:
+	MavlinkMissionTest();
+	virtual ~MavlinkMissionTest();
+
+	virtual bool run_tests(void);
+
+	static void send_message_handler(uint8_t msgid, const void *msg, void *worker_data);
+
+	static const uint8_t clientSystemId = 255;	///< System ID of the simulated ground station
+	static const uint8_t clientComponentId = 0;	///< Component ID of the simulated ground station
+
+	// We don't want any of these
+	MavlinkMissionTest(const MavlinkMissionTest &);
+	MavlinkMissionTest &operator=(const MavlinkMissionTest &);
+
+private:
+	virtual void _init(void);
+	virtual void _cleanup(void);
+
+	bool _upload_test(void);
+	bool _upload_window_test(void);
+	bool _import_test(void);
+	bool _upload_benchmark(void);
+
+	/// A message in flight on the simulated link
+	struct LinkMessage {
+		uint64_t	arrival;	///< Time the message is received at the other end [us]
+		uint8_t		msgid;
+		uint16_t	seq;		///< Item sequence for requests and items
+		uint8_t		type;		///< Result for acks
+		bool		to_vehicle;	///< Direction of the message
+	};
+
+	void _send_message_handler(uint8_t msgid, const void *msg);
+	void _queue(bool to_vehicle, uint8_t msgid, uint16_t seq, uint8_t type, unsigned len);
+	void _make_item(uint16_t seq, mavlink_mission_item_t *item);
+	bool _upload(unsigned count, unsigned window, uint64_t *elapsed);
+	bool _check_mission(unsigned count, double tolerance);
+
+	static const unsigned	_queue_size = 64;
+
+	MavlinkMissionManager	*_mission_manager;
+
+	LinkMessage	_link[_queue_size];	///< Messages in flight in both directions
+	unsigned	_link_count;
+	uint64_t	_now;			///< Simulated time [us]
+	uint64_t	_vehicle_tx_free;	///< Simulated time the vehicle can send the next message [us]
+	uint64_t	_gcs_tx_free;		///< Simulated time the ground station can send the next message [us]
+	uint32_t	_latency;		///< One way latency of the link [us]
+	uint32_t	_baudrate;		///< Link speed, 10 bits per byte
+	int		_ack_type;		///< Received MISSION_ACK type, -1 if none
+	bool		_overflow;		///< Link queue overflowed
+
+	struct mission_s	_saved_mission;	///< Mission state restored after each test
+	bool			_saved_mission_valid;
+
+	static const char	_unittest_mission_file[];
+};
+
+bool mavlink_mission_test(void);
@@ -38,10 +38,14 @@
 #include <systemlib/err.h>
 
 #include "mavlink_ftp_test.h"
+#include "mavlink_mission_test.h"
 
 extern "C" __EXPORT int mavlink_tests_main(int argc, char *argv[]);
 
 int mavlink_tests_main(int argc, char *argv[])
 {
-	return mavlink_ftp_test() ? 0 : -1;
+	bool success = mavlink_ftp_test();
+	success = mavlink_mission_test() && success;
+
+	return success ? 0 : -1;
 }
@@ -85,6 +85,8 @@
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
+#include <systemlib/pipeline.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/circuit_breaker.h>
 #include <lib/mathlib/mathlib.h>
@@ -128,6 +130,7 @@ private:
 
 	bool	_task_should_exit;		/**< if true, task_main() should exit */
 	int		_control_task;			/**< task handle */
+	volatile bool	_pipeline_unsubscribed;		/**< the pipeline closed the subscriptions on exit */
 
 	int		_ctrl_state_sub;		/**< control state subscription */
 	int		_v_att_sp_sub;			/**< vehicle attitude setpoint subscription */
@@ -160,7 +163,6 @@ private:
 	struct mc_att_ctrl_status_s 		_controller_status; /**< controller status */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
-	perf_counter_t	_controller_latency_perf;
 
 	math::Vector<3>		_rates_prev;	/**< angular rates on previous step */
 	math::Vector<3>		_rates_sp_prev; /**< previous rates setpoint */
@@ -293,6 +295,19 @@ private:
 	 * Main attitude control task.
 	 */
 	void		task_main();
+
+	/**
+	 * Run by the sensors task in the pipeline mode.
+	 */
+	static void	pipeline_trampoline(void *arg);
+
+	void		subscribe();
+	void		unsubscribe();
+
+	/**
+	 * Controller update for a new control_state.
+	 */
+	void		cycle();
 };
 
 namespace mc_att_control
@@ -305,15 +320,18 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 
 	_task_should_exit(false),
 	_control_task(-1),
+	_pipeline_unsubscribed(false),
 
 	/* subscriptions */
 	_ctrl_state_sub(-1),
 	_v_att_sp_sub(-1),
+	_v_rates_sp_sub(-1),
 	_v_control_mode_sub(-1),
 	_params_sub(-1),
 	_manual_control_sp_sub(-1),
 	_armed_sub(-1),
 	_vehicle_status_sub(-1),
+	_motor_limits_sub(-1),
 
 	/* publications */
 	_v_rates_sp_pub(nullptr),
@@ -326,7 +344,6 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 
 	/* performance counters */
 	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control")),
-	_controller_latency_perf(perf_alloc_once(PC_ELAPSED, "ctrl_latency")),
 	_ts_opt_recovery(nullptr)
 
 {
@@ -804,12 +821,8 @@ MulticopterAttitudeControl::task_main_trampoline(int argc, char *argv[])
 }
 
 void
-MulticopterAttitudeControl::task_main()
+MulticopterAttitudeControl::subscribe()
 {
-
-	/*
-	 * do subscriptions
-	 */
 	_v_att_sp_sub = orb_subscribe(ORB_ID(vehicle_attitude_setpoint));
 	_v_rates_sp_sub = orb_subscribe(ORB_ID(vehicle_rates_setpoint));
 	_ctrl_state_sub = orb_subscribe(ORB_ID(control_state));
@@ -822,6 +835,53 @@ MulticopterAttitudeControl::task_main()
 
 	/* initialize parameters cache */
 	parameters_update();
+}
+
+void
+MulticopterAttitudeControl::unsubscribe()
+{
+	int *subs[] = { &_v_att_sp_sub, &_v_rates_sp_sub, &_ctrl_state_sub, &_v_control_mode_sub, &_params_sub,
+			&_manual_control_sp_sub, &_armed_sub, &_vehicle_status_sub, &_motor_limits_sub
+		      };
+
+	for (unsigned i = 0; i < sizeof(subs) / sizeof(subs[0]); i++) {
+		if (*subs[i] >= 0) {
+			orb_unsubscribe(*subs[i]);
+			*subs[i] = -1;
+		}
+	}
+}
+
+void
+MulticopterAttitudeControl::task_main()
+{
+	if (pipeline_enabled()) {
+		/* the sensors task runs the controller, this task only waits for the stop */
+		if (pipeline_register(PIPELINE_STAGE_CONTROLLER, "mc_att_control",
+				      &MulticopterAttitudeControl::pipeline_trampoline, this) == 0) {
+			while (!_task_should_exit) {
+				usleep(100000);
+			}
+
+			/* the subscriptions belong to the sensors task, let the next cycle close them */
+			for (unsigned i = 0; i < 10 && !_pipeline_unsubscribed; i++) {
+				usleep(10000);
+			}
+
+			pipeline_unregister(PIPELINE_STAGE_CONTROLLER);
+
+		} else {
+			warnx("pipeline stage taken");
+		}
+
+		_control_task = -1;
+		return;
+	}
+
+	/*
+	 * do subscriptions
+	 */
+	subscribe();
 
 	/* wakeup source: vehicle attitude */
 	px4_pollfd_struct_t fds[1];
@@ -847,155 +907,189 @@ MulticopterAttitudeControl::task_main()
 			continue;
 		}
 
-		perf_begin(_loop_perf);
-
 		/* run controller on attitude changes */
 		if (fds[0].revents & POLLIN) {
-			static uint64_t last_run = 0;
-			float dt = (hrt_absolute_time() - last_run) / 1000000.0f;
-			last_run = hrt_absolute_time();
+			cycle();
+		}
+	}
 
-			/* guard against too small (< 2ms) and too large (> 20ms) dt's */
-			if (dt < 0.002f) {
-				dt = 0.002f;
+	_control_task = -1;
+	return;
+}
 
-			} else if (dt > 0.02f) {
-				dt = 0.02f;
-			}
+void
+MulticopterAttitudeControl::pipeline_trampoline(void *arg)
+{
+	MulticopterAttitudeControl *control = (MulticopterAttitudeControl *)arg;
 
-			/* copy attitude and control state topics */
-			orb_copy(ORB_ID(control_state), _ctrl_state_sub, &_ctrl_state);
-
-			/* check for updates in other topics */
-			parameter_update_poll();
-			vehicle_control_mode_poll();
-			arming_status_poll();
-			vehicle_manual_poll();
-			vehicle_status_poll();
-			vehicle_motor_limits_poll();
-
-			/* Check if we are in rattitude mode and the pilot is above the threshold on pitch
-			 * or roll (yaw can rotate 360 in normal att control).  If both are true don't
-			 * even bother running the attitude controllers */
-			if (_vehicle_status.main_state == vehicle_status_s::MAIN_STATE_RATTITUDE) {
-				if (fabsf(_manual_control_sp.y) > _params.rattitude_thres ||
-				    fabsf(_manual_control_sp.x) > _params.rattitude_thres) {
-					_v_control_mode.flag_control_attitude_enabled = false;
-				}
-			}
+	if (control->_task_should_exit) {
+		if (!control->_pipeline_unsubscribed) {
+			control->unsubscribe();
+			control->_pipeline_unsubscribed = true;
+		}
 
-			if (_v_control_mode.flag_control_attitude_enabled) {
-
-				if (_ts_opt_recovery == nullptr) {
-					// the  tailsitter recovery instance has not been created, thus, the vehicle
-					// is not a tailsitter, do normal attitude control
-					control_attitude(dt);
-
-				} else {
-					vehicle_attitude_setpoint_poll();
-					_thrust_sp = _v_att_sp.thrust;
-					math::Quaternion q(_ctrl_state.q[0], _ctrl_state.q[1], _ctrl_state.q[2], _ctrl_state.q[3]);
-					math::Quaternion q_sp(&_v_att_sp.q_d[0]);
-					_ts_opt_recovery->setAttGains(_params.att_p, _params.yaw_ff);
-					_ts_opt_recovery->calcOptimalRates(q, q_sp, _v_att_sp.yaw_sp_move_rate, _rates_sp);
-
-					/* limit rates */
-					for (int i = 0; i < 3; i++) {
-						_rates_sp(i) = math::constrain(_rates_sp(i), -_params.mc_rate_max(i), _params.mc_rate_max(i));
-					}
-				}
+		return;
+	}
 
-				/* publish attitude rates setpoint */
-				_v_rates_sp.roll = _rates_sp(0);
-				_v_rates_sp.pitch = _rates_sp(1);
-				_v_rates_sp.yaw = _rates_sp(2);
-				_v_rates_sp.thrust = _thrust_sp;
-				_v_rates_sp.timestamp = hrt_absolute_time();
+	/* the subscriptions have to belong to the task running the pipeline */
+	if (control->_ctrl_state_sub < 0) {
+		control->subscribe();
+	}
 
-				if (_v_rates_sp_pub != nullptr) {
-					orb_publish(_rates_sp_id, _v_rates_sp_pub, &_v_rates_sp);
+	/* only a control_state published by the estimator stage is new here */
+	bool updated = false;
+	orb_check(control->_ctrl_state_sub, &updated);
 
-				} else if (_rates_sp_id) {
-					_v_rates_sp_pub = orb_advertise(_rates_sp_id, &_v_rates_sp);
-				}
+	if (updated) {
+		control->cycle();
+	}
+}
 
-				//}
+void
+MulticopterAttitudeControl::cycle()
+{
+	perf_begin(_loop_perf);
 
-			} else {
-				/* attitude controller disabled, poll rates setpoint topic */
-				if (_v_control_mode.flag_control_manual_enabled) {
-					/* manual rates control - ACRO mode */
-					_rates_sp = math::Vector<3>(_manual_control_sp.y, -_manual_control_sp.x,
-								    _manual_control_sp.r).emult(_params.acro_rate_max);
-					_thrust_sp = math::min(_manual_control_sp.z, MANUAL_THROTTLE_MAX_MULTICOPTER);
-
-					/* publish attitude rates setpoint */
-					_v_rates_sp.roll = _rates_sp(0);
-					_v_rates_sp.pitch = _rates_sp(1);
-					_v_rates_sp.yaw = _rates_sp(2);
-					_v_rates_sp.thrust = _thrust_sp;
-					_v_rates_sp.timestamp = hrt_absolute_time();
-
-					if (_v_rates_sp_pub != nullptr) {
-						orb_publish(_rates_sp_id, _v_rates_sp_pub, &_v_rates_sp);
-
-					} else if (_rates_sp_id) {
-						_v_rates_sp_pub = orb_advertise(_rates_sp_id, &_v_rates_sp);
-					}
-
-				} else {
-					/* attitude controller disabled, poll rates setpoint topic */
-					vehicle_rates_setpoint_poll();
-					_rates_sp(0) = _v_rates_sp.roll;
-					_rates_sp(1) = _v_rates_sp.pitch;
-					_rates_sp(2) = _v_rates_sp.yaw;
-					_thrust_sp = _v_rates_sp.thrust;
-				}
+	static uint64_t last_run = 0;
+	float dt = (hrt_absolute_time() - last_run) / 1000000.0f;
+	last_run = hrt_absolute_time();
+
+	/* guard against too small (< 2ms) and too large (> 20ms) dt's */
+	if (dt < 0.002f) {
+		dt = 0.002f;
+
+	} else if (dt > 0.02f) {
+		dt = 0.02f;
+	}
+
+	/* copy attitude and control state topics */
+	orb_copy(ORB_ID(control_state), _ctrl_state_sub, &_ctrl_state);
+
+	/* check for updates in other topics */
+	parameter_update_poll();
+	vehicle_control_mode_poll();
+	arming_status_poll();
+	vehicle_manual_poll();
+	vehicle_status_poll();
+	vehicle_motor_limits_poll();
+
+	/* Check if we are in rattitude mode and the pilot is above the threshold on pitch
+	 * or roll (yaw can rotate 360 in normal att control).  If both are true don't
+	 * even bother running the attitude controllers */
+	if (_vehicle_status.main_state == vehicle_status_s::MAIN_STATE_RATTITUDE) {
+		if (fabsf(_manual_control_sp.y) > _params.rattitude_thres ||
+		    fabsf(_manual_control_sp.x) > _params.rattitude_thres) {
+			_v_control_mode.flag_control_attitude_enabled = false;
+		}
+	}
+
+	if (_v_control_mode.flag_control_attitude_enabled) {
+
+		if (_ts_opt_recovery == nullptr) {
+			// the  tailsitter recovery instance has not been created, thus, the vehicle
+			// is not a tailsitter, do normal attitude control
+			control_attitude(dt);
+
+		} else {
+			vehicle_attitude_setpoint_poll();
+			_thrust_sp = _v_att_sp.thrust;
+			math::Quaternion q(_ctrl_state.q[0], _ctrl_state.q[1], _ctrl_state.q[2], _ctrl_state.q[3]);
+			math::Quaternion q_sp(&_v_att_sp.q_d[0]);
+			_ts_opt_recovery->setAttGains(_params.att_p, _params.yaw_ff);
+			_ts_opt_recovery->calcOptimalRates(q, q_sp, _v_att_sp.yaw_sp_move_rate, _rates_sp);
+
+			/* limit rates */
+			for (int i = 0; i < 3; i++) {
+				_rates_sp(i) = math::constrain(_rates_sp(i), -_params.mc_rate_max(i), _params.mc_rate_max(i));
 			}
+		}
 
-			if (_v_control_mode.flag_control_rates_enabled) {
-				control_attitude_rates(dt);
+		/* publish attitude rates setpoint */
+		_v_rates_sp.roll = _rates_sp(0);
+		_v_rates_sp.pitch = _rates_sp(1);
+		_v_rates_sp.yaw = _rates_sp(2);
+		_v_rates_sp.thrust = _thrust_sp;
+		_v_rates_sp.timestamp = hrt_absolute_time();
 
-				/* publish actuator controls */
-				_actuators.control[0] = (PX4_ISFINITE(_att_control(0))) ? _att_control(0) : 0.0f;
-				_actuators.control[1] = (PX4_ISFINITE(_att_control(1))) ? _att_control(1) : 0.0f;
-				_actuators.control[2] = (PX4_ISFINITE(_att_control(2))) ? _att_control(2) : 0.0f;
-				_actuators.control[3] = (PX4_ISFINITE(_thrust_sp)) ? _thrust_sp : 0.0f;
-				_actuators.timestamp = hrt_absolute_time();
-				_actuators.timestamp_sample = _ctrl_state.timestamp;
+		if (_v_rates_sp_pub != nullptr) {
+			orb_publish(_rates_sp_id, _v_rates_sp_pub, &_v_rates_sp);
 
-				_controller_status.roll_rate_integ = _rates_int(0);
-				_controller_status.pitch_rate_integ = _rates_int(1);
-				_controller_status.yaw_rate_integ = _rates_int(2);
-				_controller_status.timestamp = hrt_absolute_time();
+		} else if (_rates_sp_id) {
+			_v_rates_sp_pub = orb_advertise(_rates_sp_id, &_v_rates_sp);
+		}
 
-				if (!_actuators_0_circuit_breaker_enabled) {
-					if (_actuators_0_pub != nullptr) {
+		//}
 
-						orb_publish(_actuators_id, _actuators_0_pub, &_actuators);
-						perf_end(_controller_latency_perf);
+	} else {
+		/* attitude controller disabled, poll rates setpoint topic */
+		if (_v_control_mode.flag_control_manual_enabled) {
+			/* manual rates control - ACRO mode */
+			_rates_sp = math::Vector<3>(_manual_control_sp.y, -_manual_control_sp.x,
+						    _manual_control_sp.r).emult(_params.acro_rate_max);
+			_thrust_sp = math::min(_manual_control_sp.z, MANUAL_THROTTLE_MAX_MULTICOPTER);
+
+			/* publish attitude rates setpoint */
+			_v_rates_sp.roll = _rates_sp(0);
+			_v_rates_sp.pitch = _rates_sp(1);
+			_v_rates_sp.yaw = _rates_sp(2);
+			_v_rates_sp.thrust = _thrust_sp;
+			_v_rates_sp.timestamp = hrt_absolute_time();
+
+			if (_v_rates_sp_pub != nullptr) {
+				orb_publish(_rates_sp_id, _v_rates_sp_pub, &_v_rates_sp);
+
+			} else if (_rates_sp_id) {
+				_v_rates_sp_pub = orb_advertise(_rates_sp_id, &_v_rates_sp);
+			}
 
-					} else if (_actuators_id) {
-						_actuators_0_pub = orb_advertise(_actuators_id, &_actuators);
-					}
+		} else {
+			/* attitude controller disabled, poll rates setpoint topic */
+			vehicle_rates_setpoint_poll();
+			_rates_sp(0) = _v_rates_sp.roll;
+			_rates_sp(1) = _v_rates_sp.pitch;
+			_rates_sp(2) = _v_rates_sp.yaw;
+			_thrust_sp = _v_rates_sp.thrust;
+		}
+	}
 
-				}
+	if (_v_control_mode.flag_control_rates_enabled) {
+		control_attitude_rates(dt);
 
-				/* publish controller status */
-				if (_controller_status_pub != nullptr) {
-					orb_publish(ORB_ID(mc_att_ctrl_status), _controller_status_pub, &_controller_status);
+		/* publish actuator controls */
+		_actuators.control[0] = (PX4_ISFINITE(_att_control(0))) ? _att_control(0) : 0.0f;
+		_actuators.control[1] = (PX4_ISFINITE(_att_control(1))) ? _att_control(1) : 0.0f;
+		_actuators.control[2] = (PX4_ISFINITE(_att_control(2))) ? _att_control(2) : 0.0f;
+		_actuators.control[3] = (PX4_ISFINITE(_thrust_sp)) ? _thrust_sp : 0.0f;
+		_actuators.timestamp = hrt_absolute_time();
+		_actuators.timestamp_sample = _ctrl_state.timestamp_sample;
 
-				} else {
-					_controller_status_pub = orb_advertise(ORB_ID(mc_att_ctrl_status), &_controller_status);
-				}
+		_controller_status.roll_rate_integ = _rates_int(0);
+		_controller_status.pitch_rate_integ = _rates_int(1);
+		_controller_status.yaw_rate_integ = _rates_int(2);
+		_controller_status.timestamp = hrt_absolute_time();
+
+		if (!_actuators_0_circuit_breaker_enabled) {
+			if (_actuators_0_pub != nullptr) {
+
+				orb_publish(_actuators_id, _actuators_0_pub, &_actuators);
+				latency_record(LATENCY_STAGE_CONTROLLER, _actuators.timestamp_sample);
+
+			} else if (_actuators_id) {
+				_actuators_0_pub = orb_advertise(_actuators_id, &_actuators);
 			}
+
 		}
 
-		perf_end(_loop_perf);
+		/* publish controller status */
+		if (_controller_status_pub != nullptr) {
+			orb_publish(ORB_ID(mc_att_ctrl_status), _controller_status_pub, &_controller_status);
+
+		} else {
+			_controller_status_pub = orb_advertise(ORB_ID(mc_att_ctrl_status), &_controller_status);
+		}
 	}
 
-	_control_task = -1;
-	return;
+	perf_end(_loop_perf);
 }
 
 int
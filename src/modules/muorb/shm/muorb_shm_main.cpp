@@ -0,0 +1,129 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file muorb_shm_main.cpp
+ *
+ * Connects uORB to another PX4 process on the same host through shared memory.
+ *
+ * One process starts the channel with -c and owns the segment, the other one
+ * attaches to it with the same name.
+ */
+
+#include <string.h>
+#include <px4_log.h>
+#include "modules/uORB/uORBManager.hpp"
+#include "uORBShmChannel.hpp"
+
+extern "C" { __EXPORT int muorb_shm_main(int argc, char *argv[]); }
+
+static void usage()
+{
+	PX4_INFO("Usage: muorb_shm 'start' [-c] [<segment name>], 'stop', 'status'");
+	PX4_INFO("  -c  create the segment (one of the two processes)");
+}
+
+int
+muorb_shm_main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		usage();
+		return -EINVAL;
+	}
+
+	if (!strcmp(argv[1], "start")) {
+		if (uORB::ShmChannel::isInstance() && uORB::ShmChannel::GetInstance()->isConnected()) {
+			PX4_WARN("muorb_shm already running");
+			return OK;
+		}
+
+		bool create = false;
+		const char *name = "/px4_muorb";
+
+		for (int i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "-c")) {
+				create = true;
+
+			} else {
+				name = argv[i];
+			}
+		}
+
+		uORB::ShmChannel *channel = uORB::ShmChannel::GetInstance();
+		int ret = channel->open(name, create);
+
+		if (ret != 0) {
+			PX4_ERR("can't %s %s: %s", create ? "create" : "attach to", name, strerror(-ret));
+			return ret;
+		}
+
+		// register the shared memory channel with UORB.
+		uORB::Manager::get_instance()->set_uorb_communicator(channel);
+
+		ret = channel->Start();
+
+		if (ret != 0) {
+			uORB::Manager::get_instance()->set_uorb_communicator(nullptr);
+			channel->close();
+		}
+
+		return ret;
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		if (uORB::ShmChannel::isInstance() && uORB::ShmChannel::GetInstance()->isConnected()) {
+			/* publishers stop sending before the receive thread is stopped and the segment unmapped */
+			uORB::Manager::get_instance()->set_uorb_communicator(nullptr);
+			uORB::ShmChannel::GetInstance()->close();
+
+		} else {
+			PX4_WARN("muorb_shm not running");
+		}
+
+		return OK;
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		if (uORB::ShmChannel::isInstance()) {
+			uORB::ShmChannel::GetInstance()->print_status();
+
+		} else {
+			PX4_INFO("muorb_shm not running");
+		}
+
+		return OK;
+	}
+
+	usage();
+	return -EINVAL;
+}
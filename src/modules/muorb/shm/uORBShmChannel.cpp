@@ -0,0 +1,642 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file uORBShmChannel.cpp
+ *
+ * Shared memory uORB communicator channel.
+ */
+
+#include "uORBShmChannel.hpp"
+#include <px4_log.h>
+#include <px4_tasks.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __PX4_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+static const uint32_t SHM_MAGIC = 0x4d524f55;	// "UORM"
+static const uint32_t SHM_VERSION = 1;
+
+static const uint32_t TOPIC_FREE = 0;
+static const uint32_t TOPIC_WRITING = 1;
+static const uint32_t TOPIC_VALID = 2;
+
+static const uint16_t MSG_TYPE_ADD_SUBSCRIBER = 1;
+static const uint16_t MSG_TYPE_REMOVE_SUBSCRIBER = 2;
+static const uint16_t MSG_TYPE_DATA = 3;
+
+/* receive thread wakes up at least this often to check for Stop() */
+static const unsigned RECV_TIMEOUT_MS = 100;
+
+/// Each record in a ring starts with this header, records are 8 byte aligned
+struct RecordHeader {
+	uint16_t type;
+	uint16_t topic;
+	uint32_t length;	///< payload, or the rate for add subscription
+};
+
+/// Single producer, single consumer byte ring, positions are free running
+struct uORB::ShmChannel::Ring {
+	uint32_t head;		///< bytes written, only advanced by the sending process
+	uint32_t waiting;	///< the receiving process sleeps on head
+	uint8_t _pad0[56];
+	uint32_t tail;		///< bytes consumed, only advanced by the receiving process
+	uint8_t _pad1[60];
+	uint8_t data[RING_SIZE];
+};
+
+struct uORB::ShmChannel::Segment {
+	uint32_t magic;
+	uint32_t version;
+	pid_t pid[2];		///< owner and attached process
+
+	struct {
+		uint32_t state;
+		char name[TOPIC_NAME_MAX];
+	} topics[TOPICS_MAX];
+
+	Ring ring[2];		///< ring[i] is received by pid[i]
+};
+
+uORB::ShmChannel *uORB::ShmChannel::_InstancePtr = nullptr;
+
+static inline uint32_t record_size(uint32_t payload)
+{
+	return sizeof(RecordHeader) + ((payload + 7) & ~7u);
+}
+
+static uint32_t name_hash(const char *name)
+{
+	/* FNV-1a */
+	uint32_t h = 2166136261u;
+
+	while (*name) {
+		h = (h ^ (uint8_t) * name++) * 16777619u;
+	}
+
+	return h;
+}
+
+static void wait_for_change(uint32_t *addr, uint32_t value, unsigned timeout_ms)
+{
+#ifdef __PX4_LINUX
+	struct timespec ts = { 0, (long)timeout_ms * 1000000 };
+	/* not FUTEX_PRIVATE_FLAG, the word is shared with another process */
+	syscall(SYS_futex, addr, FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+	(void)addr;
+	(void)value;
+	(void)timeout_ms;
+	usleep(1000);
+#endif
+}
+
+static void wake(uint32_t *addr)
+{
+#ifdef __PX4_LINUX
+	syscall(SYS_futex, addr, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+	(void)addr;
+#endif
+}
+
+uORB::ShmChannel::ShmChannel() :
+	_RxHandler(nullptr),
+	_RecvThread(),
+	_ThreadStarted(false),
+	_ThreadShouldExit(false),
+	_Segment(nullptr),
+	_Owner(false),
+	_Name(),
+	_TxTopics(),
+	_SentCount(0),
+	_DroppedCount(0),
+	_ReceivedCount(0),
+	_WakeupCount(0)
+{
+	pthread_mutex_init(&_SendMutex, nullptr);
+}
+
+uORB::ShmChannel::~ShmChannel()
+{
+	close();
+	pthread_mutex_destroy(&_SendMutex);
+}
+
+int uORB::ShmChannel::open(const char *name, bool create)
+{
+	if (_Segment != nullptr) {
+		return -EBUSY;
+	}
+
+	int fd;
+
+	if (create) {
+		/* remove a segment left behind by a previous run */
+		shm_unlink(name);
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+	} else {
+		fd = shm_open(name, O_RDWR, 0);
+	}
+
+	if (fd < 0) {
+		return -errno;
+	}
+
+	if (create && ftruncate(fd, sizeof(Segment)) != 0) {
+		int ret = -errno;
+		::close(fd);
+		shm_unlink(name);
+		return ret;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Segment)) {
+		::close(fd);
+		return -EINVAL;
+	}
+
+	void *mem = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (mem == MAP_FAILED) {
+		return -errno;
+	}
+
+	Segment *segment = (Segment *)mem;
+
+	if (create) {
+		/* ftruncate zero filled the segment, publish it by setting the magic last */
+		segment->version = SHM_VERSION;
+		segment->pid[0] = getpid();
+		__atomic_store_n(&segment->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	} else {
+		if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || segment->version != SHM_VERSION) {
+			munmap(mem, sizeof(Segment));
+			return -EPROTO;
+		}
+
+		pid_t peer = segment->pid[1];
+
+		if (peer != 0 && peer != getpid() && kill(peer, 0) == 0) {
+			munmap(mem, sizeof(Segment));
+			return -EBUSY;
+		}
+
+		if (peer != 0) {
+			/* drop whatever was left for a previous instance that went away */
+			Ring *ring = &segment->ring[1];
+			__atomic_store_n(&ring->tail, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+		}
+
+		segment->pid[1] = getpid();
+	}
+
+	_Segment = segment;
+	_Owner = create;
+	strncpy(_Name, name, sizeof(_Name) - 1);
+	memset(_TxTopics, 0, sizeof(_TxTopics));
+
+	return 0;
+}
+
+void uORB::ShmChannel::close()
+{
+	if (_ThreadStarted) {
+		Stop();
+	}
+
+	if (_Segment == nullptr) {
+		return;
+	}
+
+	pthread_mutex_lock(&_SendMutex);
+
+	if (!_Owner) {
+		_Segment->pid[1] = 0;
+	}
+
+	munmap(_Segment, sizeof(Segment));
+	_Segment = nullptr;
+
+	if (_Owner) {
+		shm_unlink(_Name);
+	}
+
+	pthread_mutex_unlock(&_SendMutex);
+}
+
+uORB::ShmChannel::Ring *uORB::ShmChannel::rx_ring()
+{
+	return &_Segment->ring[_Owner ? 0 : 1];
+}
+
+uORB::ShmChannel::Ring *uORB::ShmChannel::tx_ring()
+{
+	return &_Segment->ring[_Owner ? 1 : 0];
+}
+
+int uORB::ShmChannel::topic_id(const char *name)
+{
+	if (strlen(name) >= TOPIC_NAME_MAX) {
+		return -1;
+	}
+
+	const unsigned mask = sizeof(_TxTopics) / sizeof(_TxTopics[0]) - 1;
+	unsigned slot = name_hash(name) & mask;
+
+	/* ids already used by this process */
+	while (_TxTopics[slot] != 0) {
+		int id = _TxTopics[slot] - 1;
+
+		if (strcmp(_Segment->topics[id].name, name) == 0) {
+			return id;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	/*
+	 * Look the name up in the shared table or claim a free entry. If both
+	 * processes add the same name at the same time it may end up twice in
+	 * the table, which is harmless: the receiver only maps ids to names.
+	 */
+	for (unsigned i = 0; i < TOPICS_MAX; i++) {
+		uint32_t state = __atomic_load_n(&_Segment->topics[i].state, __ATOMIC_ACQUIRE);
+
+		if (state == TOPIC_FREE) {
+			uint32_t expected = TOPIC_FREE;
+
+			if (__atomic_compare_exchange_n(&_Segment->topics[i].state, &expected, TOPIC_WRITING, false,
+							__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				strcpy(_Segment->topics[i].name, name);
+				__atomic_store_n(&_Segment->topics[i].state, TOPIC_VALID, __ATOMIC_RELEASE);
+
+			} else {
+				state = expected;
+			}
+		}
+
+		if (state != TOPIC_WRITING && strcmp(_Segment->topics[i].name, name) == 0) {
+			_TxTopics[slot] = i + 1;
+			return i;
+		}
+	}
+
+	PX4_ERR("shm channel: topic table full, can't add %s", name);
+	return -1;
+}
+
+bool uORB::ShmChannel::write_record(Ring *ring, uint32_t &head, uint16_t type, const char *messageName,
+				    uint32_t length, const uint8_t *data)
+{
+	uint32_t payload = (type == MSG_TYPE_DATA) ? length : 0;
+
+	if (payload > MESSAGE_MAX) {
+		return false;
+	}
+
+	int id = topic_id(messageName);
+
+	if (id < 0) {
+		return false;
+	}
+
+	uint32_t size = record_size(payload);
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	if (RING_SIZE - (head - tail) < size) {
+		/* the remote process is not keeping up, drop like a full uORB queue would */
+		_DroppedCount++;
+		return false;
+	}
+
+	/* headers never wrap, records are aligned and the ring size is a multiple of it */
+	uint32_t pos = head & (RING_SIZE - 1);
+	RecordHeader *hdr = (RecordHeader *)&ring->data[pos];
+	hdr->type = type;
+	hdr->topic = id;
+	hdr->length = length;
+
+	if (payload > 0) {
+		pos = (pos + sizeof(RecordHeader)) & (RING_SIZE - 1);
+		uint32_t first = RING_SIZE - pos;
+
+		if (first >= payload) {
+			memcpy(&ring->data[pos], data, payload);
+
+		} else {
+			memcpy(&ring->data[pos], data, first);
+			memcpy(&ring->data[0], data + first, payload - first);
+		}
+	}
+
+	head += size;
+	_SentCount++;
+	return true;
+}
+
+void uORB::ShmChannel::commit(Ring *ring, uint32_t head)
+{
+	/* publish the records, then check if the receiver needs a wakeup (pairs with recv_thread) */
+	__atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) {
+		wake(&ring->head);
+	}
+}
+
+int16_t uORB::ShmChannel::send(uint16_t type, const char *messageName, uint32_t length, const uint8_t *data)
+{
+	pthread_mutex_lock(&_SendMutex);
+
+	if (_Segment == nullptr) {
+		pthread_mutex_unlock(&_SendMutex);
+		return -1;
+	}
+
+	Ring *ring = tx_ring();
+	uint32_t head = ring->head;
+	bool written = write_record(ring, head, type, messageName, length, data);
+
+	if (written) {
+		commit(ring, head);
+	}
+
+	pthread_mutex_unlock(&_SendMutex);
+	return written ? 0 : -1;
+}
+
+int32_t uORB::ShmChannel::send_messages(int32_t count, const char *const messageNames[], const int32_t lengths[],
+					uint8_t *const data[])
+{
+	pthread_mutex_lock(&_SendMutex);
+
+	if (_Segment == nullptr) {
+		pthread_mutex_unlock(&_SendMutex);
+		return 0;
+	}
+
+	Ring *ring = tx_ring();
+	uint32_t head = ring->head;
+	int32_t sent = 0;
+
+	while (sent < count && lengths[sent] >= 0 &&
+	       write_record(ring, head, MSG_TYPE_DATA, messageNames[sent], lengths[sent], data[sent])) {
+		sent++;
+	}
+
+	/* the whole batch becomes visible at once, with at most one wakeup */
+	if (sent > 0) {
+		commit(ring, head);
+	}
+
+	pthread_mutex_unlock(&_SendMutex);
+	return sent;
+}
+
+int16_t uORB::ShmChannel::add_subscription(const char *messageName, int32_t msgRateInHz)
+{
+	return send(MSG_TYPE_ADD_SUBSCRIBER, messageName, msgRateInHz, nullptr);
+}
+
+int16_t uORB::ShmChannel::remove_subscription(const char *messageName)
+{
+	return send(MSG_TYPE_REMOVE_SUBSCRIBER, messageName, 0, nullptr);
+}
+
+int16_t uORB::ShmChannel::register_handler(uORBCommunicator::IChannelRxHandler *handler)
+{
+	_RxHandler = handler;
+	return 0;
+}
+
+int16_t uORB::ShmChannel::send_message(const char *messageName, int32_t length, uint8_t *data)
+{
+	if (length < 0) {
+		return -1;
+	}
+
+	return send(MSG_TYPE_DATA, messageName, length, data);
+}
+
+int uORB::ShmChannel::Start()
+{
+	if (_Segment == nullptr || _ThreadStarted) {
+		return -1;
+	}
+
+	_ThreadShouldExit = false;
+	pthread_attr_t recv_thread_attr;
+	pthread_attr_init(&recv_thread_attr);
+
+	/* the priority is only applied with an explicit policy, otherwise the creator's is inherited */
+	struct sched_param param;
+	(void)pthread_attr_getschedparam(&recv_thread_attr, &param);
+	param.sched_priority = SCHED_PRIORITY_MAX - 80;
+	(void)pthread_attr_setinheritsched(&recv_thread_attr, PTHREAD_EXPLICIT_SCHED);
+	(void)pthread_attr_setschedpolicy(&recv_thread_attr, SCHED_FIFO);
+	(void)pthread_attr_setschedparam(&recv_thread_attr, &param);
+
+	int ret = pthread_create(&_RecvThread, &recv_thread_attr, thread_start, (void *)this);
+	pthread_attr_destroy(&recv_thread_attr);
+
+	if (ret == EPERM) {
+		/* like px4_task_spawn_cmd, run with the default policy without realtime permissions */
+		PX4_WARN("no permission for a realtime receive thread, using the default priority");
+		ret = pthread_create(&_RecvThread, nullptr, thread_start, (void *)this);
+	}
+
+	if (ret != 0) {
+		PX4_ERR("Error creating the receive thread for muorb_shm");
+		return -1;
+	}
+
+	_ThreadStarted = true;
+	return 0;
+}
+
+void uORB::ShmChannel::Stop()
+{
+	if (!_ThreadStarted) {
+		return;
+	}
+
+	_ThreadShouldExit = true;
+	wake(&rx_ring()->head);
+	pthread_join(_RecvThread, NULL);
+	_ThreadStarted = false;
+}
+
+void *uORB::ShmChannel::thread_start(void *handler)
+{
+	if (handler != nullptr) {
+		((uORB::ShmChannel *)handler)->recv_thread();
+	}
+
+	return 0;
+}
+
+void uORB::ShmChannel::recv_thread()
+{
+	Ring *ring = rx_ring();
+
+	while (!_ThreadShouldExit) {
+		uint32_t tail = ring->tail;
+		uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+		if (head == tail) {
+			/* announce that we sleep, then check again so no wakeup is lost (pairs with send) */
+			__atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+			head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+
+			if (head == tail) {
+				wait_for_change(&ring->head, head, RECV_TIMEOUT_MS);
+				_WakeupCount++;
+			}
+
+			__atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		while (tail != head && !_ThreadShouldExit) {
+			uint32_t pos = tail & (RING_SIZE - 1);
+			RecordHeader hdr = *(RecordHeader *)&ring->data[pos];
+			uint32_t payload = (hdr.type == MSG_TYPE_DATA) ? hdr.length : 0;
+			uint32_t size = record_size(payload);
+
+			if (payload > MESSAGE_MAX || size > head - tail || hdr.topic >= TOPICS_MAX) {
+				PX4_ERR("shm channel: corrupt record, dropping %u bytes", (unsigned)(head - tail));
+				tail = head;
+				break;
+			}
+
+			const uint8_t *data = nullptr;
+
+			if (payload > 0) {
+				pos = (pos + sizeof(RecordHeader)) & (RING_SIZE - 1);
+				uint32_t first = RING_SIZE - pos;
+
+				if (first >= payload) {
+					/* the record is ours until tail moves past it, no copy needed */
+					data = &ring->data[pos];
+
+				} else {
+					memcpy(_RxBuffer, &ring->data[pos], first);
+					memcpy(_RxBuffer + first, &ring->data[0], payload - first);
+					data = _RxBuffer;
+				}
+			}
+
+			dispatch(hdr.type, hdr.topic, hdr.length, data);
+
+			/* release every record right away, so the sender gets the space back early */
+			tail += size;
+			__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+		}
+
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+void uORB::ShmChannel::dispatch(uint16_t type, uint16_t topic, uint32_t length, const uint8_t *data)
+{
+	/* the sender made the entry valid before publishing the record */
+	if (__atomic_load_n(&_Segment->topics[topic].state, __ATOMIC_ACQUIRE) != TOPIC_VALID) {
+		return;
+	}
+
+	const char *name = _Segment->topics[topic].name;
+	_ReceivedCount++;
+
+	if (_RxHandler == nullptr) {
+		return;
+	}
+
+	switch (type) {
+	case MSG_TYPE_ADD_SUBSCRIBER:
+		_RxHandler->process_add_subscription(name, length);
+		break;
+
+	case MSG_TYPE_REMOVE_SUBSCRIBER:
+		_RxHandler->process_remove_subscription(name);
+		break;
+
+	case MSG_TYPE_DATA:
+		_RxHandler->process_received_message(name, length, (uint8_t *)data);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void uORB::ShmChannel::print_status()
+{
+	if (_Segment == nullptr) {
+		PX4_INFO("not connected");
+		return;
+	}
+
+	unsigned topics = 0;
+
+	for (unsigned i = 0; i < TOPICS_MAX; i++) {
+		if (__atomic_load_n(&_Segment->topics[i].state, __ATOMIC_ACQUIRE) == TOPIC_VALID) {
+			topics++;
+		}
+	}
+
+	Ring *rx = rx_ring();
+	Ring *tx = tx_ring();
+
+	PX4_INFO("segment %s (%s), peer pid %d, %u topics", _Name, _Owner ? "owner" : "attached",
+		 (int)_Segment->pid[_Owner ? 1 : 0], topics);
+	PX4_INFO("sent %u, dropped %u, received %u, wakeups %u", (unsigned)_SentCount, (unsigned)_DroppedCount,
+		 (unsigned)_ReceivedCount, (unsigned)_WakeupCount);
+	PX4_INFO("rx ring %u / %u bytes, tx ring %u / %u bytes", (unsigned)(rx->head - rx->tail), RING_SIZE,
+		 (unsigned)(tx->head - tx->tail), RING_SIZE);
+}
@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file uORBShmChannel.hpp
+ *
+ * uORB communicator channel between two processes on the same host.
+ *
+ * Both processes map a named POSIX shared memory segment holding a table of
+ * topic names and one ring buffer per direction. Messages carry the index of
+ * the topic in the table instead of its name. A process sleeps on the
+ * write position of its receive ring (futex) and is woken by the sender
+ * only when it is actually waiting.
+ */
+
+#ifndef _uORBShmChannel_hpp_
+#define _uORBShmChannel_hpp_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "uORB/uORBCommunicator.hpp"
+
+namespace uORB
+{
+class ShmChannel;
+}
+
+class uORB::ShmChannel : public uORBCommunicator::IChannel
+{
+public:
+	static const unsigned TOPIC_NAME_MAX = 64;	///< including the terminating zero
+	static const unsigned TOPICS_MAX = 256;
+	static const unsigned RING_SIZE = 64 * 1024;	///< bytes per direction, power of two
+	static const unsigned MESSAGE_MAX = 4096;	///< largest payload of a data message
+
+	ShmChannel();
+	virtual ~ShmChannel();
+
+	/**
+	 * static method to get the IChannel Implementor.
+	 */
+	static uORB::ShmChannel *GetInstance()
+	{
+		if (_InstancePtr == nullptr) {
+			_InstancePtr = new uORB::ShmChannel();
+		}
+
+		return _InstancePtr;
+	}
+
+	/**
+	 * Static method to check if there is an instance.
+	 */
+	static bool isInstance()
+	{
+		return (_InstancePtr != nullptr);
+	}
+
+	/**
+	 * Map the shared memory segment.
+	 *
+	 * @param name
+	 * 	Name of the segment, e.g. "/px4_muorb".
+	 * @param create
+	 * 	true for the process that owns the segment (creates and removes it),
+	 * 	false for the process attaching to it.
+	 * @return
+	 * 	0 on success, -errno otherwise.
+	 */
+	int open(const char *name, bool create);
+
+	/**
+	 * Unmap the segment, the owner also removes it.
+	 */
+	void close();
+
+	bool isConnected() const { return _Segment != nullptr; }
+
+	virtual int16_t add_subscription(const char *messageName, int32_t msgRateInHz);
+
+	virtual int16_t remove_subscription(const char *messageName);
+
+	virtual int16_t register_handler(uORBCommunicator::IChannelRxHandler *handler);
+
+	/**
+	 * @brief Sends the data message over the communication link.
+	 * @return
+	 *  0 = success; the message is in the ring of the remote process.
+	 *  otherwise = failure, e.g. the ring is full (the message is dropped).
+	 */
+	virtual int16_t send_message(const char *messageName, int32_t length, uint8_t *data);
+
+	/**
+	 * @brief Sends several data messages with a single wakeup of the remote.
+	 * @return
+	 *  The number of messages sent, the ones after the first failure are dropped.
+	 */
+	virtual int32_t send_messages(int32_t count, const char *const messageNames[], const int32_t lengths[],
+				      uint8_t *const data[]);
+
+	/**
+	 * Start the receive thread.
+	 */
+	int Start();
+	void Stop();
+
+	void print_status();
+
+private:
+	struct Segment;
+	struct Ring;
+
+	static uORB::ShmChannel *_InstancePtr;
+
+	uORBCommunicator::IChannelRxHandler *_RxHandler;
+	pthread_t _RecvThread;
+	bool _ThreadStarted;
+	volatile bool _ThreadShouldExit;
+
+	Segment *_Segment;
+	bool _Owner;
+	char _Name[TOPIC_NAME_MAX];
+
+	/// serializes the writers of this process into the transmit ring
+	pthread_mutex_t _SendMutex;
+
+	/// topic ids of the names sent so far, open addressing on the name hash, 0 = empty
+	uint16_t _TxTopics[2 * TOPICS_MAX];
+
+	uint8_t _RxBuffer[MESSAGE_MAX];
+
+	uint32_t _SentCount;
+	uint32_t _DroppedCount;
+	uint32_t _ReceivedCount;
+	uint32_t _WakeupCount;
+
+	Ring *rx_ring();
+	Ring *tx_ring();
+
+	int topic_id(const char *name);
+	int16_t send(uint16_t type, const char *messageName, uint32_t length, const uint8_t *data);
+	bool write_record(Ring *ring, uint32_t &head, uint16_t type, const char *messageName, uint32_t length,
+			  const uint8_t *data);
+	void commit(Ring *ring, uint32_t head);
+
+	static void *thread_start(void *handler);
+	void recv_thread();
+	void dispatch(uint16_t type, uint16_t topic, uint32_t length, const uint8_t *data);
+};
+
+#endif /* _uORBShmChannel_hpp_ */
@@ -71,6 +71,12 @@ Geofence::Geofence() :
 	_altitude_min(0),
 	_altitude_max(0),
 	_vertices_count(0),
+	_vertices{},
+	_vertices_loaded(false),
+	_lat_min(0.0f),
+	_lat_max(0.0f),
+	_lon_min(0.0f),
+	_lon_max(0.0f),
 	_param_action(this, "ACTION"),
 	_param_altitude_mode(this, "ALTMODE"),
 	_param_source(this, "SOURCE"),
@@ -199,28 +205,27 @@ bool Geofence::inside_polygon(double lat, double lon, float altitude)
 			 * PNPOLY - Point Inclusion in Polygon Test
 			 * W. Randolph Franklin (WRF) */
 
-			bool c = false;
+			if (!loadVertices()) {
+				return false;
+			}
 
-			struct fence_vertex_s temp_vertex_i;
-			struct fence_vertex_s temp_vertex_j;
+			/* the crossing test below can only succeed inside the bounding box */
+			if (lat < (double)_lat_min || lat > (double)_lat_max || lon < (double)_lon_min || lon > (double)_lon_max) {
+				return false;
+			}
 
-			/* Red until fence is finished */
-			for (unsigned i = 0, j = _vertices_count - 1; i < _vertices_count; j = i++) {
-				if (dm_read(DM_KEY_FENCE_POINTS, i, &temp_vertex_i, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
+			bool c = false;
 
-				if (dm_read(DM_KEY_FENCE_POINTS, j, &temp_vertex_j, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
+			for (unsigned i = 0, j = _vertices_count - 1; i < _vertices_count; j = i++) {
+				const struct fence_vertex_s &vertex_i = _vertices[i];
+				const struct fence_vertex_s &vertex_j = _vertices[j];
 
 				// skip vertex 0 (return point)
-				if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-				    (lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-				     (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
+				if (((double)vertex_i.lon >= lon) != ((double)vertex_j.lon >= lon) &&
+				    (lat <= (double)(vertex_j.lat - vertex_i.lat) * (lon - (double)vertex_i.lon) /
+				     (double)(vertex_j.lon - vertex_i.lon) + (double)vertex_i.lat)) {
 					c = !c;
 				}
-
 			}
 
 			return c;
@@ -236,6 +241,31 @@ bool Geofence::inside_polygon(double lat, double lon, float altitude)
 	}
 }
 
+bool
+Geofence::loadVertices()
+{
+	if (_vertices_loaded) {
+		return true;
+	}
+
+	for (unsigned i = 0; i < _vertices_count; i++) {
+		if (dm_read(DM_KEY_FENCE_POINTS, i, &_vertices[i], sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
+			return false;
+		}
+
+		if (i == 0 || _vertices[i].lat < _lat_min) { _lat_min = _vertices[i].lat; }
+
+		if (i == 0 || _vertices[i].lat > _lat_max) { _lat_max = _vertices[i].lat; }
+
+		if (i == 0 || _vertices[i].lon < _lon_min) { _lon_min = _vertices[i].lon; }
+
+		if (i == 0 || _vertices[i].lon > _lon_max) { _lon_max = _vertices[i].lon; }
+	}
+
+	_vertices_loaded = true;
+	return true;
+}
+
 bool
 Geofence::valid()
 {
@@ -263,6 +293,7 @@ Geofence::addPoint(int argc, char *argv[])
 
 	if ((argc == 1) && (strcmp("-clear", argv[0]) == 0)) {
 		dm_clear(DM_KEY_FENCE_POINTS);
+		_vertices_loaded = false;
 		publishFence(0);
 		return;
 	}
@@ -290,6 +321,8 @@ Geofence::addPoint(int argc, char *argv[])
 	vertex.lon = (float)lon;
 
 	if (dm_write(DM_KEY_FENCE_POINTS, ix, DM_PERSIST_POWER_ON_RESET, &vertex, sizeof(vertex)) == sizeof(vertex)) {
+		_vertices_loaded = false;
+
 		if (last) {
 			publishFence((unsigned)ix + 1);
 		}
@@ -325,7 +358,7 @@ Geofence::loadFromFile(const char *filename)
 	clearDm();
 
 	/* open the mixer definition file */
-	fp = fopen(GEOFENCE_FILENAME, "r");
+	fp = fopen(filename, "r");
 
 	if (fp == NULL) {
 		return ERROR;
@@ -402,6 +435,7 @@ Geofence::loadFromFile(const char *filename)
 	/* Check if import was successful */
 	if (gotVertical && pointCounter > 0) {
 		_vertices_count = pointCounter;
+		_vertices_loaded = false;
 		warnx("Geofence: imported successfully");
 		mavlink_log_info(_mavlinkFd, "Geofence imported");
 		rc = OK;
@@ -419,5 +453,6 @@ error:
 int Geofence::clearDm()
 {
 	dm_clear(DM_KEY_FENCE_POINTS);
+	_vertices_loaded = false;
 	return OK;
 }
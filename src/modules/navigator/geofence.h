@@ -121,6 +121,16 @@ private:
 
 	unsigned _vertices_count;
 
+	/* copy of the fence polygon in the dataman, reloaded after the fence changed */
+	struct fence_vertex_s _vertices[fence_s::GEOFENCE_MAX_VERTICES];
+	bool _vertices_loaded;
+
+	/* bounding box of the polygon, points outside of it are outside of the fence */
+	float _lat_min;
+	float _lat_max;
+	float _lon_min;
+	float _lon_max;
+
 	/* Params */
 	control::BlockParamInt _param_action;
 	control::BlockParamInt _param_altitude_mode;
@@ -135,6 +145,13 @@ private:
 
 	bool inside(double lat, double lon, float altitude);
 	bool inside(const struct vehicle_global_position_s &global_position);
+
+	/**
+	 * Read the fence polygon from the dataman into _vertices if it changed.
+	 *
+	 * @return true if the polygon is available
+	 */
+	bool loadVertices();
 	bool inside(const struct vehicle_global_position_s &global_position, float baro_altitude_amsl);
 };
 
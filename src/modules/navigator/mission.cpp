@@ -257,6 +257,9 @@ Mission::update_offboard_mission()
 		 * however warnings are issued to the gcs via mavlink from inside the MissionFeasiblityChecker */
 		dm_item_t dm_current = DM_KEY_WAYPOINTS_OFFBOARD(_offboard_mission.dataman_id);
 
+		/* the mission in the dataman changed, do not use the copy of the checker */
+		_missionFeasibilityChecker.invalidateMission();
+
 		failed = !_missionFeasibilityChecker.checkMissionFeasible(_navigator->get_mavlink_fd(), (_navigator->get_vstatus()->is_rotary_wing || _navigator->get_vstatus()->is_vtol),
 				dm_current, (size_t) _offboard_mission.count, _navigator->get_geofence(),
 				_navigator->get_home_position()->alt, _navigator->home_position_valid(),
@@ -265,6 +268,7 @@ Mission::update_offboard_mission()
 				_navigator->get_vstatus()->condition_landed);
 
 		_navigator->get_mission_result()->valid = !failed;
+		_navigator->get_mission_result()->validation_time = _missionFeasibilityChecker.getValidationTime();
 		if (!failed) {
 			/* reset mission failure if we have an updated valid mission */
 			_navigator->get_mission_result()->mission_failure = false;
@@ -1034,6 +1038,7 @@ Mission::check_mission_valid()
 				_param_dist_1wp.get(), _navigator->get_mission_result()->warning, _navigator->get_acceptance_radius(),
 				_navigator->get_vstatus()->condition_landed);
 
+		_navigator->get_mission_result()->validation_time = _missionFeasibilityChecker.getValidationTime();
 		_navigator->increment_mission_instance_count();
 		_navigator->set_mission_result_updated();
 
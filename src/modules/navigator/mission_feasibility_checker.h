@@ -46,12 +46,24 @@
 #include <uORB/topics/mission.h>
 #include <uORB/topics/navigation_capabilities.h>
 #include <dataman/dataman.h>
+#include <drivers/drv_hrt.h>
 #include "geofence.h"
 
 
 class MissionFeasibilityChecker
 {
 private:
+	/* the fields of a mission item the checks look at */
+	struct feasibility_item_s {
+		double lat;
+		double lon;
+		float altitude;
+		float acceptance_radius;
+		float params[2];		/**< actuator number and value of DO_SET_SERVO */
+		uint16_t nav_cmd;
+		bool altitude_is_relative;
+	};
+
 	int		_mavlink_fd;
 
 	int _capabilities_sub;
@@ -61,33 +73,59 @@ private:
 	bool _dist_1wp_ok;
 	void init();
 
-	/* Checks for all airframes */
-	bool checkGeofence(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence);
-	bool checkHomePositionAltitude(dm_item_t dm_current, size_t nMissionItems, float home_alt, bool home_valid, bool &warning_issued, bool throw_error = false);
-	bool checkMissionItemValidity(dm_item_t dm_current, size_t nMissionItems, bool condition_landed);
-	bool check_dist_1wp(dm_item_t dm_current, size_t nMissionItems, double curr_lat, double curr_lon, float dist_first_wp, bool &warning_issued);
+	/* mission as last read from the dataman */
+	feasibility_item_s *_items;
+	size_t _items_alloc;
+	size_t _items_count;
+	dm_item_t _items_dm;
+	bool _items_valid;
+
+	hrt_abstime _validation_time;
+
+	bool loadMission(dm_item_t dm_current, size_t nMissionItems);
+
+	/* Checks for all airframes, called for each mission item in turn */
+	bool checkGeofence(size_t index, Geofence &geofence);
+	bool checkHomePositionAltitude(size_t index, float home_alt, bool home_valid, bool &warning_issued, bool throw_error = false);
+	bool checkMissionItemValidity(size_t index, bool condition_landed);
+	bool check_dist_1wp(size_t index, double curr_lat, double curr_lon, float dist_first_wp, bool &warning_issued, bool &done);
 	bool isPositionCommand(unsigned cmd);
 
 	/* Checks specific to fixedwing airframes */
-	bool checkMissionFeasibleFixedwing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt, bool home_valid);
-	bool checkFixedWingLanding(dm_item_t dm_current, size_t nMissionItems);
+	bool checkFixedWingLanding(size_t index, bool &done);
 	void updateNavigationCapabilities();
 
 	/* Checks specific to rotarywing airframes */
-	bool checkMissionFeasibleRotarywing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt, bool home_valid, float default_acceptance_rad);
+	bool checkRotarywingTakeoff(size_t index, float home_alt, float default_acceptance_rad);
+
+	/* do not allow to copy due to ptr data members */
+	MissionFeasibilityChecker(const MissionFeasibilityChecker &);
+	MissionFeasibilityChecker operator=(const MissionFeasibilityChecker &);
 public:
 
 	MissionFeasibilityChecker();
-	~MissionFeasibilityChecker() {}
+	~MissionFeasibilityChecker();
 
 	/*
 	 * Returns true if mission is feasible and false otherwise
+	 *
+	 * The mission is read from the dataman once and all checks are run in a single pass over it.
+	 * Later calls for the same dm_current and nMissionItems reuse it until invalidateMission() is called.
 	 */
 	bool checkMissionFeasible(int mavlink_fd, bool isRotarywing, dm_item_t dm_current,
 		size_t nMissionItems, Geofence &geofence, float home_alt, bool home_valid,
 		double curr_lat, double curr_lon, float max_waypoint_distance, bool &warning_issued, float default_acceptance_rad,
 		bool condition_landed);
 
+	/*
+	 * Force the next check to read the mission from the dataman, call when the mission changed
+	 */
+	void invalidateMission() { _items_valid = false; }
+
+	/*
+	 * Time the last checkMissionFeasible() call took
+	 */
+	hrt_abstime getValidationTime() const { return _validation_time; }
 };
 
 
@@ -595,6 +595,8 @@ Navigator::status()
 	} else {
 		warnx("Geofence not set (no /etc/geofence.txt on microsd) or not valid");
 	}
+
+	warnx("Mission check took %u us", (unsigned)_mission_result.validation_time);
 }
 
 void
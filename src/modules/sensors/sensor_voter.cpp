@@ -0,0 +1,280 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sensor_voter.cpp
+ *
+ * Selection of the primary instance of a redundant sensor.
+ */
+
+#include "sensor_voter.h"
+
+#include <math.h>
+#include <string.h>
+#include <px4_log.h>
+
+/* filter constants per update, the sensors task updates at the gyro rate */
+static const float INCONSISTENCY_FILTER = 0.05f;
+static const float ERROR_DENSITY_FILTER = 0.02f;
+static const float ERROR_DENSITY_LIMIT = 0.1f;
+
+SensorVoter::SensorVoter(const char *name, hrt_abstime timeout, float inconsistency_limit,
+			 hrt_abstime switch_delay) :
+	_name(name),
+	_timeout(timeout),
+	_inconsistency_limit(inconsistency_limit),
+	_switch_delay(switch_delay),
+	_selected(-1),
+	_candidate(-1),
+	_candidate_since(0),
+	_switch_count(0),
+	_last_switch(0)
+{
+	memset(_instances, 0, sizeof(_instances));
+
+	for (unsigned i = 0; i < INSTANCES_MAX; i++) {
+		_instances[i].health = HEALTH_NO_DATA;
+	}
+}
+
+void
+SensorVoter::put(unsigned instance, hrt_abstime timestamp, const float value[3], uint64_t error_count,
+		 uint32_t priority)
+{
+	if (instance >= INSTANCES_MAX) {
+		return;
+	}
+
+	Instance &s = _instances[instance];
+
+	float new_errors = (s.has_data && error_count > s.error_count) ? 1.0f : 0.0f;
+	s.error_density += (new_errors - s.error_density) * ERROR_DENSITY_FILTER;
+
+	s.timestamp = timestamp;
+	s.value[0] = value[0];
+	s.value[1] = value[1];
+	s.value[2] = value[2];
+	s.error_count = error_count;
+	s.priority = priority;
+	s.has_data = true;
+}
+
+static float median(float *v, unsigned count)
+{
+	if (count == 1) {
+		return v[0];
+	}
+
+	if (count == 2) {
+		return 0.5f * (v[0] + v[1]);
+	}
+
+	/* three values */
+	if ((v[0] <= v[1] && v[1] <= v[2]) || (v[2] <= v[1] && v[1] <= v[0])) {
+		return v[1];
+	}
+
+	if ((v[1] <= v[0] && v[0] <= v[2]) || (v[2] <= v[0] && v[0] <= v[1])) {
+		return v[0];
+	}
+
+	return v[2];
+}
+
+void
+SensorVoter::rate(hrt_abstime now)
+{
+	unsigned fresh[INSTANCES_MAX];
+	unsigned fresh_count = 0;
+
+	for (unsigned i = 0; i < INSTANCES_MAX; i++) {
+		const Instance &s = _instances[i];
+
+		if (s.has_data && (s.timestamp >= now || now - s.timestamp <= _timeout)) {
+			fresh[fresh_count++] = i;
+		}
+	}
+
+	/* distance of every fresh instance to the median of all of them */
+	if (fresh_count > 1) {
+		float m[3];
+
+		for (unsigned axis = 0; axis < 3; axis++) {
+			float v[INSTANCES_MAX];
+
+			for (unsigned j = 0; j < fresh_count; j++) {
+				v[j] = _instances[fresh[j]].value[axis];
+			}
+
+			m[axis] = median(v, fresh_count);
+		}
+
+		for (unsigned j = 0; j < fresh_count; j++) {
+			Instance &s = _instances[fresh[j]];
+			float d0 = s.value[0] - m[0];
+			float d1 = s.value[1] - m[1];
+			float d2 = s.value[2] - m[2];
+			float distance = sqrtf(d0 * d0 + d1 * d1 + d2 * d2);
+			s.inconsistency += (distance - s.inconsistency) * INCONSISTENCY_FILTER;
+		}
+
+	} else if (fresh_count == 1) {
+		/* nothing to compare with */
+		_instances[fresh[0]].inconsistency = 0.0f;
+	}
+
+	for (unsigned i = 0; i < INSTANCES_MAX; i++) {
+		Instance &s = _instances[i];
+
+		if (!s.has_data) {
+			s.health = HEALTH_NO_DATA;
+
+		} else if (s.timestamp < now && now - s.timestamp > _timeout) {
+			s.health = HEALTH_TIMEOUT;
+
+		} else if (s.error_density > ERROR_DENSITY_LIMIT) {
+			s.health = HEALTH_ERRORS;
+
+		} else if (s.inconsistency > _inconsistency_limit) {
+			s.health = HEALTH_INCONSISTENT;
+
+		} else {
+			s.health = HEALTH_OK;
+		}
+	}
+}
+
+bool
+SensorVoter::better(unsigned a, unsigned b) const
+{
+	bool a_ok = (_instances[a].health == HEALTH_OK);
+	bool b_ok = (_instances[b].health == HEALTH_OK);
+
+	if (a_ok != b_ok) {
+		return a_ok;
+	}
+
+	/* equal priorities never replace each other, only a failure does */
+	return _instances[a].priority > _instances[b].priority;
+}
+
+bool
+SensorVoter::update(hrt_abstime now)
+{
+	rate(now);
+
+	int best = -1;
+
+	for (unsigned i = 0; i < INSTANCES_MAX; i++) {
+		if (_instances[i].has_data && (best < 0 || better(i, best))) {
+			best = i;
+		}
+	}
+
+	if (best < 0) {
+		return false;
+	}
+
+	if (_selected < 0) {
+		_selected = best;
+		_last_switch = now;
+		return true;
+	}
+
+	if (best == _selected || !better(best, _selected)) {
+		_candidate = -1;
+		return false;
+	}
+
+	if (_candidate != best) {
+		_candidate = best;
+		_candidate_since = now;
+	}
+
+	/* leave a failed selection at once, a healthy one only for a candidate that stays better */
+	if (_instances[_selected].health != HEALTH_OK || now - _candidate_since >= _switch_delay) {
+		_selected = best;
+		_candidate = -1;
+		_switch_count++;
+		_last_switch = now;
+		return true;
+	}
+
+	return false;
+}
+
+const char *
+SensorVoter::health_str(Health health)
+{
+	switch (health) {
+	case HEALTH_OK:
+		return "ok";
+
+	case HEALTH_NO_DATA:
+		return "no data";
+
+	case HEALTH_TIMEOUT:
+		return "timeout";
+
+	case HEALTH_ERRORS:
+		return "errors";
+
+	case HEALTH_INCONSISTENT:
+		return "inconsistent";
+	}
+
+	return "unknown";
+}
+
+void
+SensorVoter::print_status() const
+{
+	hrt_abstime now = hrt_absolute_time();
+
+	PX4_INFO("%s: selected #%d, %u switches, last %.1f s ago", _name, _selected, _switch_count,
+		 (_selected >= 0) ? (double)(now - _last_switch) / 1e6 : 0.0);
+
+	for (unsigned i = 0; i < INSTANCES_MAX; i++) {
+		const Instance &s = _instances[i];
+
+		if (!s.has_data) {
+			continue;
+		}
+
+		PX4_INFO("  #%u%s prio %3u %-12s inconsistency %.4f, error density %.2f, errors %llu, age %llu us",
+			 i, ((int)i == _selected) ? "*" : " ", (unsigned)s.priority, health_str(s.health),
+			 (double)s.inconsistency, (double)s.error_density, (unsigned long long)s.error_count,
+			 (unsigned long long)(now > s.timestamp ? now - s.timestamp : 0));
+	}
+}
@@ -0,0 +1,126 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+/**
+ * @file sensor_voter.h
+ *
+ * Selection of the primary instance of a redundant sensor.
+ *
+ * Every instance is rated on its own (data timeout, error density) and
+ * against the others (inconsistency: low pass filtered distance to the
+ * per axis median of all fresh instances). The selection only moves away
+ * from a healthy instance after the better candidate has been preferred
+ * for a while, so a noisy instance can't make the selection flip.
+ */
+
+#include <stdint.h>
+#include <drivers/drv_hrt.h>
+
+class SensorVoter
+{
+public:
+	static const unsigned INSTANCES_MAX = 3;
+
+	enum Health {
+		HEALTH_OK = 0,
+		HEALTH_NO_DATA,
+		HEALTH_TIMEOUT,
+		HEALTH_ERRORS,
+		HEALTH_INCONSISTENT
+	};
+
+	/**
+	 * @param name			Used in the status output, e.g. "gyro"
+	 * @param timeout		An instance without new data for this long is unhealthy, in us
+	 * @param inconsistency_limit	An instance further from the median than this is unhealthy, in sensor units
+	 * @param switch_delay		Time a better candidate must be preferred before a healthy selection is left, in us
+	 */
+	SensorVoter(const char *name, hrt_abstime timeout, float inconsistency_limit, hrt_abstime switch_delay);
+
+	/**
+	 * Feed a new sample of an instance.
+	 */
+	void		put(unsigned instance, hrt_abstime timestamp, const float value[3], uint64_t error_count,
+			    uint32_t priority);
+
+	/**
+	 * Rate the instances and update the selection.
+	 *
+	 * @return		true if the selected instance changed
+	 */
+	bool		update(hrt_abstime now);
+
+	/**
+	 * @return		the selected instance, -1 before any data arrived
+	 */
+	int		selected() const { return _selected; }
+
+	Health		health(unsigned instance) const { return _instances[instance].health; }
+	float		inconsistency(unsigned instance) const { return _instances[instance].inconsistency; }
+	unsigned	switch_count() const { return _switch_count; }
+
+	void		print_status() const;
+
+	static const char *health_str(Health health);
+
+private:
+	struct Instance {
+		hrt_abstime timestamp;
+		float value[3];
+		uint64_t error_count;
+		uint32_t priority;
+		float error_density;	///< low pass of the samples with new errors
+		float inconsistency;
+		Health health;
+		bool has_data;
+	};
+
+	const char	*_name;
+	hrt_abstime	_timeout;
+	float		_inconsistency_limit;
+	hrt_abstime	_switch_delay;
+
+	Instance	_instances[INSTANCES_MAX];
+
+	int		_selected;
+	int		_candidate;		///< instance preferred over the selection, -1 if none
+	hrt_abstime	_candidate_since;
+	unsigned	_switch_count;
+	hrt_abstime	_last_switch;
+
+	void		rate(hrt_abstime now);
+	bool		better(unsigned a, unsigned b) const;
+};
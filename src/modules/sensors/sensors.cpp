@@ -40,6 +40,11 @@
  * layer of the PX4 Flight Core. Individual sensors can be accessed directly as
  * well instead of relying on the sensor_combined topic.
  *
+ * sensor_combined is published by the sensors task on every sample of the
+ * selected gyro, which only touches the gyro and accel topics. Mag, baro,
+ * airspeed, ADC, r/c and parameters are handled by a lower priority thread
+ * and merged into the next publication.
+ *
  * @author Lorenz Meier <lorenz@px4.io>
  * @author Julian Oes <julian@px4.io>
  * @author Thomas Gubler <thomas@px4.io>
@@ -65,6 +70,7 @@
 #include <stdio.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <mathlib/mathlib.h>
 
 #include <px4_adc.h>
@@ -83,6 +89,8 @@
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
+#include <systemlib/pipeline.h>
 #include <conversion/rotation.h>
 
 #include <systemlib/airspeed.h>
@@ -91,6 +99,7 @@
 
 #include <uORB/uORB.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
 #include <uORB/topics/rc_channels.h>
 #include <uORB/topics/manual_control_setpoint.h>
 #include <uORB/topics/actuator_controls.h>
@@ -104,6 +113,7 @@
 #include <DevMgr.hpp>
 
 #include "sensors_init.h"
+#include "sensor_voter.h"
 
 using namespace DriverFramework;
 
@@ -141,6 +151,27 @@ using namespace DriverFramework;
 
 #define SENSOR_COUNT_MAX		3
 
+/**
+ * Selection of the primary gyro and accelerometer, see SensorVoter.
+ * The timeout covers a few samples at the slowest IMU rate of 250 Hz,
+ * the inconsistency limits are well above the noise and calibration
+ * residuals of the supported sensors.
+ */
+#define IMU_VOTER_TIMEOUT_US		(20 * 1000)	/**< an instance without data for this long is unhealthy */
+#define IMU_VOTER_SWITCH_DELAY_US	(500 * 1000)	/**< a better instance must stay better this long */
+#define GYRO_INCONSISTENCY_LIMIT	0.1f		/**< distance to the median of the gyros [rad/s] */
+#define ACCEL_INCONSISTENCY_LIMIT	1.0f		/**< distance to the median of the accels [m/s^2] */
+
+/**
+ * Stack of the slow path thread. Its deepest chain is slow_main() into
+ * parameter_update_poll() / parameters_update() with the calibration ioctls
+ * and the mavlink log calls, or rc_poll() into set_params_from_rc() and
+ * param_set(). This is the chain the single sensors task used to run on its
+ * 2000 bytes, below a task_main() frame that also held the sensor_combined
+ * report, which the slow path keeps in the object (_slow_path_raw) instead.
+ */
+#define SLOW_PATH_STACK_SIZE		1900
+
 /* oddly, ERROR is not defined for c++ */
 #ifdef ERROR
 # undef ERROR
@@ -176,6 +207,11 @@ public:
 	 */
 	int		start();
 
+	/**
+	 * Print the health and selection of the sensor instances.
+	 */
+	void		print_status();
+
 private:
 	static const unsigned _rc_max_chan_count =
 		input_rc_s::RC_INPUT_MAX_CHANNELS;	/**< maximum number of r/c channels we handle */
@@ -212,8 +248,8 @@ private:
 	int 		_sensors_task;			/**< task handle for sensor task */
 
 	bool		_hil_enabled;			/**< if true, HIL is active */
-	bool		_publishing;			/**< if true, we are publishing sensor data */
-	bool		_armed;				/**< arming status of the vehicle */
+	volatile bool	_publishing;			/**< if true, we are publishing sensor data, written by the slow path */
+	volatile bool	_armed;				/**< arming status of the vehicle, written by the slow path */
 
 	int		_gyro_sub[SENSOR_COUNT_MAX];	/**< raw gyro data subscription */
 	int		_accel_sub[SENSOR_COUNT_MAX];	/**< raw accel data subscription */
@@ -232,6 +268,7 @@ private:
 	int 		_manual_control_sub;		/**< notification of manual control updates */
 
 	orb_advert_t	_sensor_pub;			/**< combined sensor data topic */
+	orb_advert_t	_sensor_imu_pub;		/**< selected imu data topic */
 	orb_advert_t	_manual_control_pub;		/**< manual control signal topic */
 	orb_advert_t	_actuator_group_3_pub;		/**< manual control as actuator topic */
 	orb_advert_t	_rc_pub;			/**< raw r/c control topic */
@@ -240,9 +277,27 @@ private:
 	orb_advert_t	_diff_pres_pub;			/**< differential_pressure */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
+	perf_counter_t	_latency_perf;			/**< gyro sample to sensor_combined publication */
+	perf_counter_t	_slow_perf;			/**< slow path performance counter */
+
+	pthread_t	_slow_thread;			/**< slow sensors, rc, adc and parameters */
+	bool		_slow_thread_started;
+	pthread_mutex_t	_slow_mutex;			/**< protects the hand-over between the two paths */
+	struct sensor_combined_s _slow_raw;		/**< slow sensor fields for the imu path, guarded by _slow_mutex */
+	struct sensor_combined_s _slow_path_raw;	/**< combined data owned by the slow path */
+	uint32_t	_slow_generation;		/**< incremented with every update of _slow_raw */
+	uint32_t	_slow_generation_merged;	/**< generation of _slow_raw last merged by the imu path */
+	math::Matrix<3, 3>	_board_rotation_update;	/**< new board rotation for the imu path, guarded by _slow_mutex */
+	uint32_t	_rotation_generation;		/**< incremented with every update of _board_rotation_update */
+	uint32_t	_rotation_generation_imu;	/**< generation of _board_rotation_imu */
+	volatile bool	_imu_params_reload;		/**< the imu path found new sensors, the slow path reloads the calibration */
 
 	DataValidator	_airspeed_validator;		/**< data validator to monitor airspeed */
 
+	SensorVoter	_gyro_voter;			/**< selection of the primary gyro */
+	SensorVoter	_accel_voter;			/**< selection of the primary accelerometer */
+	struct sensor_imu_s _sensor_imu;		/**< data of the selected gyro and accelerometer */
+
 	struct rc_channels_s _rc;			/**< r/c channel data */
 	struct battery_status_s _battery_status;	/**< battery status */
 	struct baro_report _barometer;			/**< barometer data */
@@ -252,6 +307,7 @@ private:
 	float _param_rc_values[rc_parameter_map_s::RC_PARAM_MAP_NCHAN];	/**< parameter values for RC control */
 
 	math::Matrix<3, 3>	_board_rotation;	/**< rotation matrix for the orientation that the board is mounted */
+	math::Matrix<3, 3>	_board_rotation_imu;	/**< copy of _board_rotation owned by the imu path */
 	math::Matrix<3, 3>	_mag_rotation[3];	/**< rotation matrix for the orientation that the external mag0 is mounted */
 
 	uint64_t _battery_discharged;			/**< battery discharged current in mA*ms */
@@ -443,6 +499,15 @@ private:
 	 */
 	void		diff_pres_poll(struct sensor_combined_s &raw);
 
+	/**
+	 * Update the gyro and accelerometer selection and publish the selected data.
+	 *
+	 * @param raw			Combined sensor data structure with the
+	 *				data of all instances.
+	 * @return			true if the selected gyro changed.
+	 */
+	bool		imu_select(struct sensor_combined_s &raw);
+
 	/**
 	 * Check for changes in vehicle control mode.
 	 */
@@ -466,15 +531,35 @@ private:
 	 */
 	void		adc_poll(struct sensor_combined_s &raw);
 
+	/**
+	 * Take the latest slow sensor data and board rotation from the slow path,
+	 * without ever waiting for it.
+	 *
+	 * @param raw			Combined sensor data structure into which
+	 *				the slow sensor fields are copied.
+	 */
+	void		slow_merge(struct sensor_combined_s &raw);
+
 	/**
 	 * Shim for calling task_main from task_create.
 	 */
 	static void	task_main_trampoline(int argc, char *argv[]);
 
 	/**
-	 * Main sensor collection task.
+	 * Main sensor collection task, publishes sensor_combined on every sample
+	 * of the selected gyro and only touches the imu topics.
 	 */
 	void		task_main();
+
+	/**
+	 * Shim for calling slow_main from pthread_create.
+	 */
+	static void	*slow_main_trampoline(void *arg);
+
+	/**
+	 * Slow path: mag, baro, airspeed, adc, r/c and parameters at a lower priority.
+	 */
+	void		slow_main();
 };
 
 namespace sensors
@@ -510,6 +595,7 @@ Sensors::Sensors() :
 
 	/* publications */
 	_sensor_pub(nullptr),
+	_sensor_imu_pub(nullptr),
 	_manual_control_pub(nullptr),
 	_actuator_group_3_pub(nullptr),
 	_rc_pub(nullptr),
@@ -519,10 +605,21 @@ Sensors::Sensors() :
 
 	/* performance counters */
 	_loop_perf(perf_alloc(PC_ELAPSED, "sensor task update")),
+	_latency_perf(perf_alloc(PC_ELAPSED, "sensor imu latency")),
+	_slow_perf(perf_alloc(PC_ELAPSED, "sensor slow update")),
+	_slow_thread_started(false),
+	_slow_generation(0),
+	_slow_generation_merged(0),
+	_rotation_generation(0),
+	_rotation_generation_imu(0),
+	_imu_params_reload(false),
 	_airspeed_validator(),
+	_gyro_voter("gyro", IMU_VOTER_TIMEOUT_US, GYRO_INCONSISTENCY_LIMIT, IMU_VOTER_SWITCH_DELAY_US),
+	_accel_voter("accel", IMU_VOTER_TIMEOUT_US, ACCEL_INCONSISTENCY_LIMIT, IMU_VOTER_SWITCH_DELAY_US),
 
 	_param_rc_values{},
 	_board_rotation{},
+	_board_rotation_imu{},
 	_mag_rotation{},
 
 	_battery_discharged(0),
@@ -537,6 +634,10 @@ Sensors::Sensors() :
 	}
 
 	memset(&_rc, 0, sizeof(_rc));
+	memset(&_sensor_imu, 0, sizeof(_sensor_imu));
+	memset(&_slow_raw, 0, sizeof(_slow_raw));
+	memset(&_slow_path_raw, 0, sizeof(_slow_path_raw));
+	pthread_mutex_init(&_slow_mutex, nullptr);
 	memset(&_diff_pres, 0, sizeof(_diff_pres));
 	memset(&_parameters, 0, sizeof(_parameters));
 	memset(&_rc_parameter_map, 0, sizeof(_rc_parameter_map));
@@ -912,6 +1013,12 @@ Sensors::parameters_update()
 
 	_board_rotation = board_rotation_offset * _board_rotation;
 
+	/* hand the rotation over to the imu path */
+	pthread_mutex_lock(&_slow_mutex);
+	_board_rotation_update = _board_rotation;
+	_rotation_generation++;
+	pthread_mutex_unlock(&_slow_mutex);
+
 	/* update barometer qnh setting */
 	param_get(_parameter_handles.baro_qnh, &(_parameters.baro_qnh));
 	DevHandle h_baro;
@@ -966,14 +1073,14 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 			orb_copy(ORB_ID(sensor_accel), _accel_sub[i], &accel_report);
 
 			math::Vector<3> vect(accel_report.x, accel_report.y, accel_report.z);
-			vect = _board_rotation * vect;
+			vect = _board_rotation_imu * vect;
 
 			raw.accelerometer_m_s2[i * 3 + 0] = vect(0);
 			raw.accelerometer_m_s2[i * 3 + 1] = vect(1);
 			raw.accelerometer_m_s2[i * 3 + 2] = vect(2);
 
 			math::Vector<3> vect_int(accel_report.x_integral, accel_report.y_integral, accel_report.z_integral);
-			vect_int = _board_rotation * vect_int;
+			vect_int = _board_rotation_imu * vect_int;
 
 			raw.accelerometer_integral_m_s[i * 3 + 0] = vect_int(0);
 			raw.accelerometer_integral_m_s[i * 3 + 1] = vect_int(1);
@@ -988,6 +1095,9 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 			raw.accelerometer_timestamp[i] = accel_report.timestamp;
 			raw.accelerometer_errcount[i] = accel_report.error_count;
 			raw.accelerometer_temp[i] = accel_report.temperature;
+
+			_accel_voter.put(i, accel_report.timestamp, &raw.accelerometer_m_s2[i * 3], accel_report.error_count,
+					 raw.accelerometer_priority[i]);
 		}
 	}
 }
@@ -1005,14 +1115,14 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 			orb_copy(ORB_ID(sensor_gyro), _gyro_sub[i], &gyro_report);
 
 			math::Vector<3> vect(gyro_report.x, gyro_report.y, gyro_report.z);
-			vect = _board_rotation * vect;
+			vect = _board_rotation_imu * vect;
 
 			raw.gyro_rad_s[i * 3 + 0] = vect(0);
 			raw.gyro_rad_s[i * 3 + 1] = vect(1);
 			raw.gyro_rad_s[i * 3 + 2] = vect(2);
 
 			math::Vector<3> vect_int(gyro_report.x_integral, gyro_report.y_integral, gyro_report.z_integral);
-			vect_int = _board_rotation * vect_int;
+			vect_int = _board_rotation_imu * vect_int;
 
 			raw.gyro_integral_rad[i * 3 + 0] = vect_int(0);
 			raw.gyro_integral_rad[i * 3 + 1] = vect_int(1);
@@ -1026,12 +1136,16 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 
 			raw.gyro_timestamp[i] = gyro_report.timestamp;
 
-			if (i == 0) {
+			/* sensor_combined is timed by the selected gyro, the first one until the voter has data */
+			if ((int)i == _gyro_voter.selected() || (i == 0 && _gyro_voter.selected() < 0)) {
 				raw.timestamp = gyro_report.timestamp;
 			}
 
 			raw.gyro_errcount[i] = gyro_report.error_count;
 			raw.gyro_temp[i] = gyro_report.temperature;
+
+			_gyro_voter.put(i, gyro_report.timestamp, &raw.gyro_rad_s[i * 3], gyro_report.error_count,
+					raw.gyro_priority[i]);
 		}
 	}
 }
@@ -1137,6 +1251,118 @@ Sensors::diff_pres_poll(struct sensor_combined_s &raw)
 	}
 }
 
+bool
+Sensors::imu_select(struct sensor_combined_s &raw)
+{
+	hrt_abstime now = hrt_absolute_time();
+
+	bool gyro_switched = _gyro_voter.update(now);
+	bool accel_switched = _accel_voter.update(now);
+
+	int gyro = _gyro_voter.selected();
+	int accel = _accel_voter.selected();
+
+	/* the first selection is not a switch */
+	if (gyro_switched && _gyro_voter.switch_count() > 0) {
+		warnx("gyro #%d selected (%s)", gyro, SensorVoter::health_str(_gyro_voter.health(gyro)));
+	}
+
+	if (accel_switched && _accel_voter.switch_count() > 0) {
+		warnx("accel #%d selected (%s)", accel, SensorVoter::health_str(_accel_voter.health(accel)));
+	}
+
+	/* publish once per sample of the selected gyro */
+	if (gyro < 0 || accel < 0 || raw.gyro_timestamp[gyro] == _sensor_imu.timestamp) {
+		return gyro_switched;
+	}
+
+	_sensor_imu.timestamp = raw.gyro_timestamp[gyro];
+	_sensor_imu.gyro_integral_dt = raw.gyro_integral_dt[gyro];
+	_sensor_imu.accelerometer_timestamp = raw.accelerometer_timestamp[accel];
+	_sensor_imu.accelerometer_integral_dt = raw.accelerometer_integral_dt[accel];
+
+	for (unsigned axis = 0; axis < 3; axis++) {
+		_sensor_imu.gyro_rad_s[axis] = raw.gyro_rad_s[gyro * 3 + axis];
+		_sensor_imu.gyro_integral_rad[axis] = raw.gyro_integral_rad[gyro * 3 + axis];
+		_sensor_imu.accelerometer_m_s2[axis] = raw.accelerometer_m_s2[accel * 3 + axis];
+		_sensor_imu.accelerometer_integral_m_s[axis] = raw.accelerometer_integral_m_s[accel * 3 + axis];
+	}
+
+	_sensor_imu.gyro_switch_count = _gyro_voter.switch_count();
+	_sensor_imu.accel_switch_count = _accel_voter.switch_count();
+	_sensor_imu.gyro_instance = gyro;
+	_sensor_imu.accel_instance = accel;
+
+	if (_publishing) {
+		if (_sensor_imu_pub != nullptr) {
+			orb_publish(ORB_ID(sensor_imu), _sensor_imu_pub, &_sensor_imu);
+
+		} else {
+			_sensor_imu_pub = orb_advertise(ORB_ID(sensor_imu), &_sensor_imu);
+		}
+	}
+
+	return gyro_switched;
+}
+
+/**
+ * Copy the fields of sensor_combined written by the slow path.
+ */
+static void
+copy_slow_fields(struct sensor_combined_s &dst, const struct sensor_combined_s &src)
+{
+#define COPY_FIELD(field) memcpy(&dst.field, &src.field, sizeof(dst.field))
+	COPY_FIELD(magnetometer_raw);
+	COPY_FIELD(magnetometer_ga);
+	COPY_FIELD(magnetometer_mode);
+	COPY_FIELD(magnetometer_range_ga);
+	COPY_FIELD(magnetometer_cuttoff_freq_hz);
+	COPY_FIELD(magnetometer_timestamp);
+	COPY_FIELD(magnetometer_priority);
+	COPY_FIELD(magnetometer_errcount);
+	COPY_FIELD(magnetometer_temp);
+	COPY_FIELD(baro_pres_mbar);
+	COPY_FIELD(baro_alt_meter);
+	COPY_FIELD(baro_temp_celcius);
+	COPY_FIELD(baro_timestamp);
+	COPY_FIELD(baro_priority);
+	COPY_FIELD(baro_errcount);
+	COPY_FIELD(adc_voltage_v);
+	COPY_FIELD(adc_mapping);
+	COPY_FIELD(mcu_temp_celcius);
+	COPY_FIELD(differential_pressure_pa);
+	COPY_FIELD(differential_pressure_timestamp);
+	COPY_FIELD(differential_pressure_filtered_pa);
+	COPY_FIELD(differential_pressure_priority);
+	COPY_FIELD(differential_pressure_errcount);
+#undef COPY_FIELD
+}
+
+void
+Sensors::slow_merge(struct sensor_combined_s &raw)
+{
+	if (_slow_generation == _slow_generation_merged && _rotation_generation == _rotation_generation_imu) {
+		return;
+	}
+
+	/* the slow path only holds the lock for a copy, if it does just try again on the next sample */
+	if (pthread_mutex_trylock(&_slow_mutex) != 0) {
+		return;
+	}
+
+	if (_slow_generation != _slow_generation_merged) {
+		copy_slow_fields(raw, _slow_raw);
+		_slow_generation_merged = _slow_generation;
+	}
+
+	if (_rotation_generation != _rotation_generation_imu) {
+		_board_rotation_imu = _board_rotation_update;
+		_rotation_generation_imu = _rotation_generation;
+	}
+
+	pthread_mutex_unlock(&_slow_mutex);
+}
+
 void
 Sensors::vehicle_control_mode_poll()
 {
@@ -2083,9 +2309,41 @@ Sensors::task_main()
 	parameter_update_poll(true /* forced */);
 	rc_parameter_map_poll(true /* forced */);
 
+	/* the imu path starts with the initial slow values and rotation */
+	pthread_mutex_lock(&_slow_mutex);
+	copy_slow_fields(_slow_raw, raw);
+	_board_rotation_imu = _board_rotation_update;
+	_rotation_generation_imu = _rotation_generation;
+	pthread_mutex_unlock(&_slow_mutex);
+
 	/* advertise the sensor_combined topic and make the initial publication */
 	_sensor_pub = orb_advertise(ORB_ID(sensor_combined), &raw);
 
+	_task_should_exit = false;
+
+	/* start the slow path, below the priority of the imu path */
+	pthread_attr_t slow_attr;
+	pthread_attr_init(&slow_attr);
+	pthread_attr_setstacksize(&slow_attr, SLOW_PATH_STACK_SIZE);
+
+#ifndef __PX4_QURT
+	// This is not supported by QURT (yet).
+	struct sched_param param;
+	(void)pthread_attr_getschedparam(&slow_attr, &param);
+
+	param.sched_priority = SCHED_PRIORITY_DEFAULT;
+	(void)pthread_attr_setschedparam(&slow_attr, &param);
+#endif
+
+	/* the slow path gets its own copy, it owns the slow fields from now on */
+	memcpy(&_slow_path_raw, &raw, sizeof(_slow_path_raw));
+	_slow_thread_started = (pthread_create(&_slow_thread, &slow_attr, &Sensors::slow_main_trampoline, nullptr) == 0);
+	pthread_attr_destroy(&slow_attr);
+
+	if (!_slow_thread_started) {
+		warnx("slow path start failed");
+	}
+
 	/* wakeup source(s) */
 	px4_pollfd_struct_t fds[1] = {};
 
@@ -2093,8 +2351,6 @@ Sensors::task_main()
 	fds[0].fd = _gyro_sub[0];
 	fds[0].events = POLLIN;
 
-	_task_should_exit = false;
-
 	raw.timestamp = 0;
 
 	uint64_t _last_config_update = hrt_absolute_time();
@@ -2122,60 +2378,128 @@ Sensors::task_main()
 
 		perf_begin(_loop_perf);
 
-		/* check vehicle status for changes to publication state */
-		vehicle_control_mode_poll();
-
 		/* the timestamp of the raw struct is updated by the gyro_poll() method */
 		/* copy most recent sensor data */
 		gyro_poll(raw);
 		accel_poll(raw);
-		mag_poll(raw);
-		baro_poll(raw);
 
-		// FIXME TODO: this needs more thinking, otherwise we spam the console and keep switching.
-		/* Work out if main gyro timed out and fail over to alternate gyro.
-		 * However, don't do this if the secondary is not available. */
-		if (hrt_elapsed_time(&raw.gyro_timestamp[0]) > 20 * 1000 && _gyro_sub[1] >= 0) {
-			warnx("gyro has timed out");
+		/* vote on the gyros and accels, the loop is paced by the selected gyro */
+		if (imu_select(raw)) {
+			fds[0].fd = _gyro_sub[_gyro_voter.selected()];
+		}
+
+		/* mag, baro, airspeed and adc as last updated by the slow path */
+		slow_merge(raw);
 
-			/* If the secondary failed as well, go to the tertiary, also only if available. */
-			if (hrt_elapsed_time(&raw.gyro_timestamp[1]) > 20 * 1000 && _gyro_sub[2] >= 0) {
-				fds[0].fd = _gyro_sub[2];
-				warnx("failing over to third gyro");
+		/* Inform other processes that new data is available to copy */
+		if (_publishing && raw.timestamp > 0) {
+			orb_publish(ORB_ID(sensor_combined), _sensor_pub, &raw);
+
+			/* from the driver sample of the selected gyro to its publication */
+			perf_set(_latency_perf, hrt_absolute_time() - raw.timestamp);
+			latency_record(LATENCY_STAGE_SENSORS, raw.timestamp);
+
+			/* run the estimator, controller and mixer registered for the pipeline mode */
+			pipeline_run();
+		}
 
-			} else if (_gyro_sub[1] >= 0) {
-				fds[0].fd = _gyro_sub[1];
-				warnx("failing over to second gyro");
+		/* keep adding imu sensors as long as we are not armed,
+		 * the slow path looks for the other ones
+		 */
+		if (!_armed && hrt_elapsed_time(&_last_config_update) > 500 * 1000) {
+			unsigned gcount_prev = _gyro_count;
+			unsigned acount_prev = _accel_count;
+
+			_gyro_count = init_sensor_class(ORB_ID(sensor_gyro), &_gyro_sub[0],
+							&raw.gyro_priority[0], &raw.gyro_errcount[0]);
+
+			_accel_count = init_sensor_class(ORB_ID(sensor_accel), &_accel_sub[0],
+							 &raw.accelerometer_priority[0], &raw.accelerometer_errcount[0]);
+
+			if (gcount_prev != _gyro_count || acount_prev != _accel_count) {
+				/* the slow path applies the calibration to the new sensors */
+				_imu_params_reload = true;
 			}
+
+			_last_config_update = hrt_absolute_time();
 		}
 
+		perf_end(_loop_perf);
+	}
+
+	if (_slow_thread_started) {
+		pthread_join(_slow_thread, nullptr);
+	}
+
+	warnx("exiting.");
+	_sensors_task = -1;
+	px4_task_exit(ret);
+}
+
+void *
+Sensors::slow_main_trampoline(void *arg)
+{
+	sensors::g_sensors->slow_main();
+	return nullptr;
+}
+
+void
+Sensors::slow_main()
+{
+	struct sensor_combined_s &raw = _slow_path_raw;
+
+	/* r/c input is the most latency sensitive data on this path, wake up on it */
+	px4_pollfd_struct_t fds[1] = {};
+	fds[0].fd = _rc_sub;
+	fds[0].events = POLLIN;
+
+	uint64_t last_config_update = hrt_absolute_time();
+
+	while (!_task_should_exit) {
+
+		/* wait for up to 10ms, the slow sensors are checked at least at 100 Hz */
+		px4_poll(&fds[0], (sizeof(fds) / sizeof(fds[0])), 10);
+
+		perf_begin(_slow_perf);
+
+		/* check vehicle status for changes to publication state */
+		vehicle_control_mode_poll();
+
+		mag_poll(raw);
+		baro_poll(raw);
+
 		/* check battery voltage */
 		adc_poll(raw);
 
 		diff_pres_poll(raw);
 
-		/* Inform other processes that new data is available to copy */
-		if (_publishing && raw.timestamp > 0) {
-			orb_publish(ORB_ID(sensor_combined), _sensor_pub, &raw);
-		}
+		/* hand the slow fields over to the imu path */
+		pthread_mutex_lock(&_slow_mutex);
+		copy_slow_fields(_slow_raw, raw);
+		_slow_generation++;
+		pthread_mutex_unlock(&_slow_mutex);
 
 		/* keep adding sensors as long as we are not armed,
 		 * when not adding sensors poll for param updates
 		 */
-		if (!_armed && hrt_elapsed_time(&_last_config_update) > 500 * 1000) {
-			_gyro_count = init_sensor_class(ORB_ID(sensor_gyro), &_gyro_sub[0],
-							&raw.gyro_priority[0], &raw.gyro_errcount[0]);
+		if (!_armed && hrt_elapsed_time(&last_config_update) > 500 * 1000) {
+			unsigned mcount_prev = _mag_count;
+			unsigned bcount_prev = _baro_count;
 
 			_mag_count = init_sensor_class(ORB_ID(sensor_mag), &_mag_sub[0],
 						       &raw.magnetometer_priority[0], &raw.magnetometer_errcount[0]);
 
-			_accel_count = init_sensor_class(ORB_ID(sensor_accel), &_accel_sub[0],
-							 &raw.accelerometer_priority[0], &raw.accelerometer_errcount[0]);
-
 			_baro_count = init_sensor_class(ORB_ID(sensor_baro), &_baro_sub[0],
 							&raw.baro_priority[0], &raw.baro_errcount[0]);
 
-			_last_config_update = hrt_absolute_time();
+			if (mcount_prev != _mag_count || bcount_prev != _baro_count || _imu_params_reload) {
+				_imu_params_reload = false;
+
+				/* reload calibration params */
+				parameter_update_poll(true);
+			}
+
+			last_config_update = hrt_absolute_time();
 
 		} else {
 
@@ -2189,12 +2513,19 @@ Sensors::task_main()
 		/* Look for new r/c input data */
 		rc_poll();
 
-		perf_end(_loop_perf);
+		perf_end(_slow_perf);
 	}
+}
 
-	warnx("exiting.");
-	_sensors_task = -1;
-	px4_task_exit(ret);
+void
+Sensors::print_status()
+{
+	warnx("gyros: %u, accels: %u, mags: %u, baros: %u", _gyro_count, _accel_count, _mag_count, _baro_count);
+	_gyro_voter.print_status();
+	_accel_voter.print_status();
+	perf_print_counter(_loop_perf);
+	perf_print_counter(_latency_perf);
+	perf_print_counter(_slow_perf);
 }
 
 int
@@ -2206,7 +2537,7 @@ Sensors::start()
 	_sensors_task = px4_task_spawn_cmd("sensors",
 					   SCHED_DEFAULT,
 					   SCHED_PRIORITY_MAX - 5,
-					   2000,
+					   2000 + (pipeline_enabled() ? PIPELINE_STACK_SIZE : 0),
 					   (px4_main_t)&Sensors::task_main_trampoline,
 					   nullptr);
 
@@ -2267,6 +2598,7 @@ int sensors_main(int argc, char *argv[])
 	if (!strcmp(argv[1], "status")) {
 		if (sensors::g_sensors) {
 			warnx("is running");
+			sensors::g_sensors->print_status();
 			return 0;
 
 		} else {
@@ -0,0 +1,249 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file latency.c
+ *
+ * Latency of the control pipeline stages.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/control_latency.h>
+#include "latency.h"
+
+#define LATENCY_PUBLISH_INTERVAL_US	1000000
+
+struct latency_stats {
+	uint32_t	count;
+	uint64_t	total_us;
+	uint32_t	max_us;
+	uint32_t	last_us;
+	uint32_t	buckets[LATENCY_BUCKETS];
+};
+
+static struct latency_stats latency_stages[LATENCY_STAGE_COUNT];
+static uint64_t latency_last_sample;
+static hrt_abstime latency_last_publish;
+static orb_advert_t latency_pub;
+
+static const char *const latency_names[LATENCY_STAGE_COUNT] = {
+	"driver",
+	"sensors",
+	"estimator",
+	"controller",
+	"output"
+};
+
+const char *
+latency_stage_name(enum latency_stage stage)
+{
+	return (stage < LATENCY_STAGE_COUNT) ? latency_names[stage] : "unknown";
+}
+
+static unsigned
+latency_bucket(uint32_t latency_us)
+{
+	unsigned bucket = 0;
+	uint32_t limit = LATENCY_BUCKET_MIN_US;
+
+	while (latency_us >= limit && bucket < LATENCY_BUCKETS - 1) {
+		limit <<= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+static uint32_t
+latency_bucket_limit(unsigned bucket)
+{
+	return (uint32_t)LATENCY_BUCKET_MIN_US << bucket;
+}
+
+static void
+latency_publish(hrt_abstime now)
+{
+	struct control_latency_s report;
+	memset(&report, 0, sizeof(report));
+
+	report.timestamp = now;
+	report.last_sample = latency_last_sample;
+
+	for (unsigned s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		const struct latency_stats *stats = &latency_stages[s];
+
+		report.count[s] = stats->count;
+		report.mean_us[s] = (stats->count > 0) ? (float)stats->total_us / stats->count : 0.0f;
+		report.p50_us[s] = latency_percentile(s, 50.0f);
+		report.p99_us[s] = latency_percentile(s, 99.0f);
+		report.max_us[s] = stats->max_us;
+		report.last_us[s] = stats->last_us;
+	}
+
+	if (latency_pub != NULL) {
+		orb_publish(ORB_ID(control_latency), latency_pub, &report);
+
+	} else {
+		latency_pub = orb_advertise(ORB_ID(control_latency), &report);
+	}
+}
+
+void
+latency_record(enum latency_stage stage, uint64_t sample_timestamp)
+{
+	if (stage >= LATENCY_STAGE_COUNT || sample_timestamp == 0) {
+		return;
+	}
+
+	hrt_abstime now = hrt_absolute_time();
+
+	/* replayed or simulated samples can be ahead of the clock */
+	uint32_t latency_us = (now > sample_timestamp) ? (uint32_t)(now - sample_timestamp) : 0;
+
+	struct latency_stats *stats = &latency_stages[stage];
+	stats->buckets[latency_bucket(latency_us)]++;
+	stats->total_us += latency_us;
+	stats->last_us = latency_us;
+
+	if (latency_us > stats->max_us) {
+		stats->max_us = latency_us;
+	}
+
+	stats->count++;
+
+	/* the end of the pipeline publishes the breakdown */
+	if (stage == LATENCY_STAGE_OUTPUT) {
+		latency_last_sample = sample_timestamp;
+
+		if (now - latency_last_publish >= LATENCY_PUBLISH_INTERVAL_US) {
+			latency_last_publish = now;
+			latency_publish(now);
+		}
+	}
+}
+
+uint32_t
+latency_percentile(enum latency_stage stage, float percentile)
+{
+	if (stage >= LATENCY_STAGE_COUNT) {
+		return 0;
+	}
+
+	const struct latency_stats *stats = &latency_stages[stage];
+	uint32_t total = 0;
+
+	for (unsigned b = 0; b < LATENCY_BUCKETS; b++) {
+		total += stats->buckets[b];
+	}
+
+	if (total == 0) {
+		return 0;
+	}
+
+	uint32_t rank = (uint32_t)(total * percentile / 100.0f);
+	uint32_t sum = 0;
+
+	for (unsigned b = 0; b < LATENCY_BUCKETS - 1; b++) {
+		sum += stats->buckets[b];
+
+		if (sum > rank) {
+			return latency_bucket_limit(b);
+		}
+	}
+
+	/* the last bucket is open, the maximum is the best bound */
+	return stats->max_us;
+}
+
+void
+latency_print(bool verbose)
+{
+	printf("%-11s %8s %9s %8s %8s %8s\n", "stage", "count", "mean us", "p50 us", "p99 us", "max us");
+
+	for (unsigned s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		const struct latency_stats *stats = &latency_stages[s];
+
+		printf("%-11s %8u %9.1f %8u %8u %8u\n", latency_names[s], (unsigned)stats->count,
+		       (stats->count > 0) ? (double)stats->total_us / stats->count : 0.0,
+		       (unsigned)latency_percentile(s, 50.0f), (unsigned)latency_percentile(s, 99.0f),
+		       (unsigned)stats->max_us);
+	}
+
+	/* the stages are cumulative, show what each one adds */
+	printf("\nper stage (mean us):");
+
+	double previous = 0.0;
+
+	for (unsigned s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		const struct latency_stats *stats = &latency_stages[s];
+		double mean = (stats->count > 0) ? (double)stats->total_us / stats->count : previous;
+		printf(" %s +%.1f", latency_names[s], mean - previous);
+		previous = mean;
+	}
+
+	printf("\n");
+
+	if (!verbose) {
+		return;
+	}
+
+	for (unsigned s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		const struct latency_stats *stats = &latency_stages[s];
+
+		if (stats->count == 0) {
+			continue;
+		}
+
+		printf("\n%s:\n", latency_names[s]);
+
+		for (unsigned b = 0; b < LATENCY_BUCKETS; b++) {
+			if (b < LATENCY_BUCKETS - 1) {
+				printf("  < %6u us: %u\n", (unsigned)latency_bucket_limit(b), (unsigned)stats->buckets[b]);
+
+			} else {
+				printf(" >= %6u us: %u\n", (unsigned)latency_bucket_limit(b - 1), (unsigned)stats->buckets[b]);
+			}
+		}
+	}
+}
+
+void
+latency_reset(void)
+{
+	memset(latency_stages, 0, sizeof(latency_stages));
+}
@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file latency.h
+ *
+ * Latency of the control pipeline stages.
+ *
+ * Every stage records the time since the IMU sample its output is based on,
+ * the sample timestamp is carried through the uORB messages from the driver
+ * to the actuator outputs. Each stage keeps a log scale histogram, the
+ * output stage publishes the breakdown as control_latency once per second.
+ */
+
+#ifndef _SYSTEMLIB_LATENCY_H
+#define _SYSTEMLIB_LATENCY_H value
+
+#include <stdint.h>
+#include <px4_defines.h>
+
+/**
+ * Stages of the control pipeline, same order as in control_latency.
+ */
+enum latency_stage {
+	LATENCY_STAGE_DRIVER = 0,	/**< driver publication of the sample */
+	LATENCY_STAGE_SENSORS,		/**< sensor_combined publication */
+	LATENCY_STAGE_ESTIMATOR,	/**< control_state publication */
+	LATENCY_STAGE_CONTROLLER,	/**< actuator_controls_0 publication */
+	LATENCY_STAGE_OUTPUT,		/**< actuator output written */
+	LATENCY_STAGE_COUNT
+};
+
+/** histogram bucket 0 holds latencies below this, every further bucket doubles */
+#define LATENCY_BUCKET_MIN_US	64
+#define LATENCY_BUCKETS		12
+
+__BEGIN_DECLS
+
+/**
+ * Record the latency of a stage.
+ *
+ * Each stage is recorded by one thread at a time.
+ *
+ * @param stage			The pipeline stage.
+ * @param sample_timestamp	Timestamp of the IMU sample the output of the stage is based on,
+ *				ignored if zero.
+ */
+__EXPORT extern void		latency_record(enum latency_stage stage, uint64_t sample_timestamp);
+
+/**
+ * Get the upper bound of the histogram bucket holding a percentile of a stage.
+ *
+ * @param stage			The pipeline stage.
+ * @param percentile		Percentile, 0..100.
+ * @return			The latency in us, 0 if the stage has no samples.
+ */
+__EXPORT extern uint32_t	latency_percentile(enum latency_stage stage, float percentile);
+
+/**
+ * Print the latency of all stages and the histograms.
+ *
+ * @param verbose		Also print the histogram buckets.
+ */
+__EXPORT extern void		latency_print(bool verbose);
+
+/**
+ * Reset the statistics of all stages.
+ */
+__EXPORT extern void		latency_reset(void);
+
+/**
+ * Name of a stage.
+ */
+__EXPORT extern const char	*latency_stage_name(enum latency_stage stage);
+
+__END_DECLS
+
+#endif
@@ -111,6 +111,9 @@ uint8_t  *param_changed_storage = 0;
 int size_param_changed_storage_bytes = 0;
 const int bits_per_allocation_unit  = (sizeof(*param_changed_storage) * 8);
 
+/** change count of each parameter, bumped whenever its value changes */
+static uint16_t *param_generations = NULL;
+
 
 static unsigned
 get_param_info_count(void)
@@ -128,6 +131,14 @@ get_param_info_count(void)
 		}
 	}
 
+	if (!param_generations) {
+		param_generations = calloc(param_info_count, sizeof(*param_generations));
+
+		if (param_generations == NULL) {
+			return 0;
+		}
+	}
+
 	return param_info_count;
 }
 
@@ -498,6 +509,40 @@ param_get(param_t param, void *val)
 	return result;
 }
 
+uint32_t
+param_get_generation(param_t param)
+{
+	if (!handle_in_range(param)) {
+		return 0;
+	}
+
+	/* offset by one so that a generation of 0 never matches */
+	return (uint32_t)param_generations[param] + 1;
+}
+
+int
+param_get_if_changed(param_t param, void *val, uint32_t *generation)
+{
+	if (!handle_in_range(param) || val == NULL || generation == NULL) {
+		return -1;
+	}
+
+	/* the generation is a single word, compare it before taking the lock */
+	if (param_get_generation(param) == *generation) {
+		return 0;
+	}
+
+	param_lock();
+
+	const void *v = param_get_value_ptr(param);
+	memcpy(val, v, param_size(param));
+	*generation = param_get_generation(param);
+
+	param_unlock();
+
+	return 1;
+}
+
 static int
 param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_changes, bool is_saved)
 {
@@ -517,6 +562,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 
 	if (handle_in_range(param)) {
 
+		/* setting the same value again does not start a new generation */
+		const void *current = param_get_value_ptr(param);
+		bool value_changed = (current == NULL || memcmp(current, val, param_size(param)) != 0);
+
 		struct param_wbuf_s *s = param_find_changed(param);
 
 		if (s == NULL) {
@@ -567,6 +616,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 		s->unsaved = !mark_saved;
 		params_changed = true;
 		result = 0;
+
+		if (value_changed) {
+			param_generations[param]++;
+		}
 	}
 
 out:
@@ -641,6 +694,8 @@ param_reset(param_t param)
 
 		/* if we found one, erase it */
 		if (s != NULL) {
+			param_generations[param]++;
+
 			int pos = utarray_eltidx(param_values, s);
 			utarray_erase(param_values, pos, 1);
 		}
@@ -663,6 +718,13 @@ param_reset_all(void)
 	param_lock();
 
 	if (param_values != NULL) {
+		struct param_wbuf_s *s = NULL;
+
+		/* every parameter that had a value of its own is back to its default */
+		while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
+			param_generations[s->param]++;
+		}
+
 		utarray_free(param_values);
 	}
 
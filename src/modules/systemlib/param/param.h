@@ -206,6 +206,28 @@ __EXPORT size_t		param_size(param_t param);
  */
 __EXPORT int		param_get(param_t param, void *val);
 
+/**
+ * Obtain the generation of a parameter's value.
+ *
+ * The generation changes whenever the value of the parameter changes, setting
+ * the same value again leaves it unchanged. It is never zero for a valid parameter.
+ *
+ * @param param		A handle returned by param_find or passed by param_foreach.
+ * @return		The current generation, or zero if the parameter does not exist.
+ */
+__EXPORT uint32_t	param_get_generation(param_t param);
+
+/**
+ * Copy the value of a parameter if it changed since it was last read.
+ *
+ * @param param		A handle returned by param_find or passed by param_foreach.
+ * @param val		Where to return the value, assumed to point to suitable storage for the parameter type.
+ * @param generation	The generation of the value held by the caller, updated when the value is copied.
+ *			Initialize to zero to always copy on the first call.
+ * @return		1 if the value was copied, 0 if it did not change, -1 if the parameter does not exist.
+ */
+__EXPORT int		param_get_if_changed(param_t param, void *val, uint32_t *generation);
+
 /**
  * Set the value of a parameter.
  *
@@ -45,6 +45,20 @@
 #include <math.h>
 #include "perf_counter.h"
 
+#if defined(CONFIG_ARCH_BOARD_PX4IO_V1) || defined(CONFIG_ARCH_BOARD_PX4IO_V2)
+/* the IO firmware builds the counters alone and has no room for the trace */
+#define trace_active false
+#define trace_event(...)
+#else
+#include "trace_buffer.h"
+#endif
+
+#ifdef __PX4_NUTTX
+#include <nuttx/arch.h>
+#else
+#include <pthread.h>
+#endif
+
 #ifdef __PX4_QURT
 #define dprintf(...)
 #define ddeclare(...)
@@ -59,6 +73,10 @@ struct perf_ctr_header {
 	sq_entry_t		link;	/**< list linkage */
 	enum perf_counter_type	type;	/**< counter type */
 	const char		*name;	/**< counter name */
+	struct perf_ctr_header	*hash_next;	/**< next counter in the same name hash bucket */
+#ifndef __PX4_NUTTX
+	pthread_mutex_t		lock;	/**< serializes the updates from several threads */
+#endif
 };
 
 /**
@@ -99,14 +117,102 @@ struct perf_ctr_interval {
 	float			M2;
 };
 
+/**
+ * PC_HISTOGRAM counter, a PC_ELAPSED counter with a log scale histogram.
+ */
+struct perf_ctr_histogram {
+	struct perf_ctr_elapsed	elapsed;
+	uint32_t		buckets[PERF_HISTOGRAM_BUCKETS];
+};
+
 /**
  * List of all known counters.
  */
 static sq_queue_t	perf_counters;
 
+/**
+ * Counters by name hash, for perf_alloc_once and perf_find.
+ */
+#define PERF_HASH_BUCKETS	32
+static struct perf_ctr_header *perf_hash[PERF_HASH_BUCKETS];
 
-perf_counter_t
-perf_alloc(enum perf_counter_type type, const char *name)
+/*
+ * Updates of a counter are a few instructions. On NuttX they run with the
+ * interrupts disabled, which also covers the counters used in interrupt
+ * handlers, the POSIX builds lock the counter.
+ */
+#ifdef __PX4_NUTTX
+#define PERF_LOCK(handle)	irqstate_t perf_irq_state = irqsave()
+#define PERF_UNLOCK(handle)	irqrestore(perf_irq_state)
+#define PERF_LIST_LOCK()	irqstate_t perf_list_state = irqsave()
+#define PERF_LIST_UNLOCK()	irqrestore(perf_list_state)
+#else
+static pthread_mutex_t perf_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define PERF_LOCK(handle)	pthread_mutex_lock(&(handle)->lock)
+#define PERF_UNLOCK(handle)	pthread_mutex_unlock(&(handle)->lock)
+#define PERF_LIST_LOCK()	pthread_mutex_lock(&perf_list_mutex)
+#define PERF_LIST_UNLOCK()	pthread_mutex_unlock(&perf_list_mutex)
+#endif
+
+static unsigned
+perf_hash_name(const char *name)
+{
+	unsigned hash = 5381;
+
+	while (*name != '\0') {
+		hash = hash * 33 + (unsigned char)*name++;
+	}
+
+	return hash % PERF_HASH_BUCKETS;
+}
+
+/* requires the list lock */
+static perf_counter_t
+perf_lookup(const char *name)
+{
+	perf_counter_t handle = perf_hash[perf_hash_name(name)];
+
+	while (handle != NULL && strcmp(handle->name, name) != 0) {
+		handle = handle->hash_next;
+	}
+
+	return handle;
+}
+
+/**
+ * Histogram bucket of a duration: exact below 4us, then 4 buckets per
+ * doubling, the last bucket holds everything above.
+ */
+static unsigned
+perf_histogram_bucket(uint64_t elapsed)
+{
+	if (elapsed < 4) {
+		return (unsigned)elapsed;
+	}
+
+	unsigned msb = 63 - __builtin_clzll(elapsed);
+	unsigned bucket = (msb - 1) * 4 + ((elapsed >> (msb - 2)) & 3);
+
+	return (bucket < PERF_HISTOGRAM_BUCKETS) ? bucket : PERF_HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * Upper bound (exclusive) of a histogram bucket in us.
+ */
+static uint64_t
+perf_histogram_limit(unsigned bucket)
+{
+	if (bucket < 4) {
+		return bucket + 1;
+	}
+
+	unsigned msb = bucket / 4 + 1;
+	return (uint64_t)(5 + bucket % 4) << (msb - 2);
+}
+
+/* allocation is not allowed with the interrupts disabled, so this runs without the list lock */
+static perf_counter_t
+perf_new(enum perf_counter_type type, const char *name)
 {
 	perf_counter_t ctr = NULL;
 
@@ -124,6 +230,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 
 		break;
 
+	case PC_HISTOGRAM:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_histogram), 1);
+		break;
+
 	default:
 		break;
 	}
@@ -131,7 +241,43 @@ perf_alloc(enum perf_counter_type type, const char *name)
 	if (ctr != NULL) {
 		ctr->type = type;
 		ctr->name = name;
-		sq_addfirst(&ctr->link, &perf_counters);
+#ifndef __PX4_NUTTX
+		pthread_mutex_init(&ctr->lock, NULL);
+#endif
+	}
+
+	return ctr;
+}
+
+static void
+perf_delete(perf_counter_t handle)
+{
+#ifndef __PX4_NUTTX
+	pthread_mutex_destroy(&handle->lock);
+#endif
+	free(handle);
+}
+
+/* requires the list lock */
+static void
+perf_insert(perf_counter_t ctr)
+{
+	sq_addfirst(&ctr->link, &perf_counters);
+
+	unsigned hash = perf_hash_name(ctr->name);
+	ctr->hash_next = perf_hash[hash];
+	perf_hash[hash] = ctr;
+}
+
+perf_counter_t
+perf_alloc(enum perf_counter_type type, const char *name)
+{
+	perf_counter_t ctr = perf_new(type, name);
+
+	if (ctr != NULL) {
+		PERF_LIST_LOCK();
+		perf_insert(ctr);
+		PERF_LIST_UNLOCK();
 	}
 
 	return ctr;
@@ -140,25 +286,48 @@ perf_alloc(enum perf_counter_type type, const char *name)
 perf_counter_t
 perf_alloc_once(enum perf_counter_type type, const char *name)
 {
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_find(name);
 
-	while (handle != NULL) {
-		if (!strcmp(handle->name, name)) {
-			if (type == handle->type) {
-				/* they are the same counter */
-				return handle;
-
-			} else {
-				/* same name but different type, assuming this is an error and not intended */
-				return NULL;
-			}
+	if (handle == NULL) {
+		/* no existing counter of that name was found */
+		perf_counter_t ctr = perf_new(type, name);
+
+		if (ctr == NULL) {
+			return NULL;
 		}
 
-		handle = (perf_counter_t)sq_next(&handle->link);
+		/* another thread may have added one while allocating */
+		PERF_LIST_LOCK();
+		handle = perf_lookup(name);
+
+		if (handle == NULL) {
+			perf_insert(ctr);
+			handle = ctr;
+		}
+
+		PERF_LIST_UNLOCK();
+
+		if (handle != ctr) {
+			perf_delete(ctr);
+		}
+	}
+
+	if (handle->type != type) {
+		/* same name but different type, assuming this is an error and not intended */
+		handle = NULL;
 	}
 
-	/* if the execution reaches here, no existing counter of that name was found */
-	return perf_alloc(type, name);
+	return handle;
+}
+
+perf_counter_t
+perf_find(const char *name)
+{
+	PERF_LIST_LOCK();
+	perf_counter_t handle = perf_lookup(name);
+	PERF_LIST_UNLOCK();
+
+	return handle;
 }
 
 void
@@ -168,8 +337,23 @@ perf_free(perf_counter_t handle)
 		return;
 	}
 
+	PERF_LIST_LOCK();
+
 	sq_rem(&handle->link, &perf_counters);
-	free(handle);
+
+	struct perf_ctr_header **prev = &perf_hash[perf_hash_name(handle->name)];
+
+	while (*prev != NULL && *prev != handle) {
+		prev = &(*prev)->hash_next;
+	}
+
+	if (*prev != NULL) {
+		*prev = handle->hash_next;
+	}
+
+	PERF_LIST_UNLOCK();
+
+	perf_delete(handle);
 }
 
 void
@@ -179,15 +363,24 @@ perf_count(perf_counter_t handle)
 		return;
 	}
 
+	if (trace_active) {
+		trace_event(TRACE_INSTANT, handle->name, 0);
+	}
+
 	switch (handle->type) {
-	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count++;
-		break;
+	case PC_COUNT: {
+			PERF_LOCK(handle);
+			((struct perf_ctr_count *)handle)->event_count++;
+			PERF_UNLOCK(handle);
+			break;
+		}
 
 	case PC_INTERVAL: {
 			struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 			hrt_abstime now = hrt_absolute_time();
 
+			PERF_LOCK(handle);
+
 			switch (pci->event_count) {
 			case 0:
 				pci->time_first = now;
@@ -223,6 +416,8 @@ perf_count(perf_counter_t handle)
 
 			pci->time_last = now;
 			pci->event_count++;
+
+			PERF_UNLOCK(handle);
 			break;
 		}
 
@@ -240,6 +435,11 @@ perf_begin(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_ELAPSED:
+	case PC_HISTOGRAM:
+		if (trace_active) {
+			trace_event(TRACE_BEGIN, handle->name, 0);
+		}
+
 		((struct perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
 		break;
 
@@ -248,6 +448,42 @@ perf_begin(perf_counter_t handle)
 	}
 }
 
+/**
+ * Add a measurement to a PC_ELAPSED or PC_HISTOGRAM counter, requires the counter lock.
+ */
+static void
+perf_add_elapsed(perf_counter_t handle, int64_t elapsed)
+{
+	struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+
+	if (elapsed < 0) {
+		pce->event_overruns++;
+		return;
+	}
+
+	pce->event_count++;
+	pce->time_total += elapsed;
+
+	if ((pce->time_least > (uint64_t)elapsed) || (pce->time_least == 0)) {
+		pce->time_least = elapsed;
+	}
+
+	if (pce->time_most < (uint64_t)elapsed) {
+		pce->time_most = elapsed;
+	}
+
+	// maintain mean and variance of the elapsed time in seconds
+	// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
+	float dt = elapsed / 1e6f;
+	float delta_intvl = dt - pce->mean;
+	pce->mean += delta_intvl / pce->event_count;
+	pce->M2 += delta_intvl * (dt - pce->mean);
+
+	if (handle->type == PC_HISTOGRAM) {
+		((struct perf_ctr_histogram *)handle)->buckets[perf_histogram_bucket(elapsed)]++;
+	}
+}
+
 void
 perf_end(perf_counter_t handle)
 {
@@ -256,35 +492,22 @@ perf_end(perf_counter_t handle)
 	}
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 
 			if (pce->time_start != 0) {
 				int64_t elapsed = hrt_absolute_time() - pce->time_start;
 
-				if (elapsed < 0) {
-					pce->event_overruns++;
-
-				} else {
-
-					pce->event_count++;
-					pce->time_total += elapsed;
-
-					if ((pce->time_least > (uint64_t)elapsed) || (pce->time_least == 0)) {
-						pce->time_least = elapsed;
-					}
+				if (trace_active) {
+					trace_event(TRACE_END, handle->name, 0);
+				}
 
-					if (pce->time_most < (uint64_t)elapsed) {
-						pce->time_most = elapsed;
-					}
-
-					// maintain mean and variance of the elapsed time in seconds
-					// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
-					float dt = elapsed / 1e6f;
-					float delta_intvl = dt - pce->mean;
-					pce->mean += delta_intvl / pce->event_count;
-					pce->M2 += delta_intvl * (dt - pce->mean);
+				PERF_LOCK(handle);
+				perf_add_elapsed(handle, elapsed);
+				PERF_UNLOCK(handle);
 
+				if (elapsed >= 0) {
 					pce->time_start = 0;
 				}
 			}
@@ -305,37 +528,18 @@ perf_set(perf_counter_t handle, int64_t elapsed)
 		return;
 	}
 
-	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-
-			if (elapsed < 0) {
-				pce->event_overruns++;
-
-			} else {
-
-				pce->event_count++;
-				pce->time_total += elapsed;
-
-				if ((pce->time_least > (uint64_t)elapsed) || (pce->time_least == 0)) {
-					pce->time_least = elapsed;
-				}
-
-				if (pce->time_most < (uint64_t)elapsed) {
-					pce->time_most = elapsed;
-				}
-
-				// maintain mean and variance of the elapsed time in seconds
-				// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
-				float dt = elapsed / 1e6f;
-				float delta_intvl = dt - pce->mean;
-				pce->mean += delta_intvl / pce->event_count;
-				pce->M2 += delta_intvl * (dt - pce->mean);
+	if (trace_active) {
+		trace_event(TRACE_COUNTER, handle->name, elapsed);
+	}
 
-				pce->time_start = 0;
-			}
+	switch (handle->type) {
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
+			PERF_LOCK(handle);
+			perf_add_elapsed(handle, elapsed);
+			PERF_UNLOCK(handle);
+			break;
 		}
-		break;
 
 	default:
 		break;
@@ -350,9 +554,15 @@ perf_cancel(perf_counter_t handle)
 	}
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 
+			/* close the duration in the trace, it is only dropped from the statistics */
+			if (trace_active && pce->time_start != 0) {
+				trace_event(TRACE_END, handle->name, 0);
+			}
+
 			pce->time_start = 0;
 		}
 		break;
@@ -371,11 +581,17 @@ perf_reset(perf_counter_t handle)
 		return;
 	}
 
+	PERF_LOCK(handle);
+
 	switch (handle->type) {
 	case PC_COUNT:
 		((struct perf_ctr_count *)handle)->event_count = 0;
 		break;
 
+	case PC_HISTOGRAM:
+		memset(((struct perf_ctr_histogram *)handle)->buckets, 0, sizeof(((struct perf_ctr_histogram *)handle)->buckets));
+
+	/* FALLTHROUGH */
 	case PC_ELAPSED: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 			pce->event_count = 0;
@@ -397,6 +613,128 @@ perf_reset(perf_counter_t handle)
 			break;
 		}
 	}
+
+	PERF_UNLOCK(handle);
+}
+
+/* requires the counter lock */
+static uint64_t
+perf_histogram_percentile(const struct perf_ctr_histogram *pch, float percentile)
+{
+	uint64_t count = 0;
+
+	for (unsigned b = 0; b < PERF_HISTOGRAM_BUCKETS; b++) {
+		count += pch->buckets[b];
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	/* the rank of the sample at the percentile, counted from 1 */
+	uint64_t rank = (uint64_t)ceilf(count * percentile / 100.0f);
+	uint64_t sum = 0;
+
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	for (unsigned b = 0; b < PERF_HISTOGRAM_BUCKETS - 1; b++) {
+		sum += pch->buckets[b];
+
+		if (sum >= rank) {
+			uint64_t limit = perf_histogram_limit(b) - 1;
+
+			/* the bucket bound can't be above the largest sample */
+			return (limit < pch->elapsed.time_most) ? limit : pch->elapsed.time_most;
+		}
+	}
+
+	/* the last bucket is open */
+	return pch->elapsed.time_most;
+}
+
+uint64_t
+perf_percentile(perf_counter_t handle, float percentile)
+{
+	if (handle == NULL || handle->type != PC_HISTOGRAM) {
+		return 0;
+	}
+
+	PERF_LOCK(handle);
+	uint64_t value = perf_histogram_percentile((const struct perf_ctr_histogram *)handle, percentile);
+	PERF_UNLOCK(handle);
+
+	return value;
+}
+
+int
+perf_get_stats(perf_counter_t handle, struct perf_counter_stats *stats)
+{
+	if (handle == NULL) {
+		return -1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	stats->name = handle->name;
+	stats->type = handle->type;
+
+	PERF_LOCK(handle);
+
+	switch (handle->type) {
+	case PC_COUNT:
+		stats->event_count = ((struct perf_ctr_count *)handle)->event_count;
+		break;
+
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
+			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+			stats->event_count = pce->event_count;
+			stats->event_overruns = pce->event_overruns;
+			stats->time_total = pce->time_total;
+			stats->time_least = pce->time_least;
+			stats->time_most = pce->time_most;
+			stats->mean = 1e6f * pce->mean;
+			stats->rms = (pce->event_count > 1) ? 1e6f * sqrtf(pce->M2 / (pce->event_count - 1)) : 0.0f;
+
+			if (handle->type == PC_HISTOGRAM) {
+				const struct perf_ctr_histogram *pch = (const struct perf_ctr_histogram *)handle;
+				stats->p50 = perf_histogram_percentile(pch, 50.0f);
+				stats->p99 = perf_histogram_percentile(pch, 99.0f);
+				stats->p999 = perf_histogram_percentile(pch, 99.9f);
+			}
+
+			break;
+		}
+
+	case PC_INTERVAL: {
+			struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+			stats->event_count = pci->event_count;
+			stats->time_total = pci->time_last - pci->time_first;
+			stats->time_least = pci->time_least;
+			stats->time_most = pci->time_most;
+			stats->mean = 1e6f * pci->mean;
+			stats->rms = (pci->event_count > 1) ? 1e6f * sqrtf(pci->M2 / (pci->event_count - 1)) : 0.0f;
+			break;
+		}
+
+	default:
+		break;
+	}
+
+	PERF_UNLOCK(handle);
+	return 0;
+}
+
+int
+perf_get_stats_by_name(const char *name, struct perf_counter_stats *stats)
+{
+	/* the list lock keeps the counter from being freed meanwhile */
+	PERF_LIST_LOCK();
+	int ret = perf_get_stats(perf_lookup(name), stats);
+	PERF_LIST_UNLOCK();
+
+	return ret;
 }
 
 void
@@ -448,6 +786,23 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 			break;
 		}
 
+	case PC_HISTOGRAM: {
+			ddeclare(struct perf_counter_stats stats;)
+			ddeclare(perf_get_stats(handle, &stats);)
+
+			dprintf(fd, "%s: %llu events, %llu overruns, %lluus avg, min %lluus p50 %lluus p99 %lluus p99.9 %lluus max %lluus\n",
+				handle->name,
+				(unsigned long long)stats.event_count,
+				(unsigned long long)stats.event_overruns,
+				stats.event_count == 0 ? 0 : (unsigned long long)stats.time_total / stats.event_count,
+				(unsigned long long)stats.time_least,
+				(unsigned long long)stats.p50,
+				(unsigned long long)stats.p99,
+				(unsigned long long)stats.p999,
+				(unsigned long long)stats.time_most);
+			break;
+		}
+
 	default:
 		break;
 	}
@@ -464,7 +819,8 @@ perf_event_count(perf_counter_t handle)
 	case PC_COUNT:
 		return ((struct perf_ctr_count *)handle)->event_count;
 
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 			return pce->event_count;
 		}
@@ -492,6 +848,48 @@ perf_print_all(int fd)
 	}
 }
 
+void
+perf_print_all_json(int fd)
+{
+	ddeclare(static const char *const type_names[] = { "count", "elapsed", "interval", "histogram" };)
+	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	ddeclare(bool first = true;)
+
+	dprintf(fd, "[");
+
+	while (handle != NULL) {
+		ddeclare(struct perf_counter_stats stats;)
+		ddeclare(perf_get_stats(handle, &stats);)
+
+		dprintf(fd, "%s\n{\"name\":\"%s\",\"type\":\"%s\",\"events\":%llu", first ? "" : ",",
+			handle->name, type_names[handle->type], (unsigned long long)stats.event_count);
+
+		if (handle->type != PC_COUNT) {
+			dprintf(fd, ",\"overruns\":%llu,\"total_us\":%llu,\"min_us\":%llu,\"max_us\":%llu,"
+				"\"mean_us\":%.3f,\"rms_us\":%.3f",
+				(unsigned long long)stats.event_overruns,
+				(unsigned long long)stats.time_total,
+				(unsigned long long)stats.time_least,
+				(unsigned long long)stats.time_most,
+				(double)stats.mean,
+				(double)stats.rms);
+		}
+
+		if (handle->type == PC_HISTOGRAM) {
+			dprintf(fd, ",\"p50_us\":%llu,\"p99_us\":%llu,\"p999_us\":%llu",
+				(unsigned long long)stats.p50,
+				(unsigned long long)stats.p99,
+				(unsigned long long)stats.p999);
+		}
+
+		dprintf(fd, "}");
+		ddeclare(first = false;)
+		handle = (perf_counter_t)sq_next(&handle->link);
+	}
+
+	dprintf(fd, "\n]\n");
+}
+
 extern const uint16_t latency_bucket_count;
 extern uint32_t latency_counters[];
 extern const uint16_t latency_buckets[];
@@ -48,12 +48,38 @@
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
 	PC_ELAPSED,		/**< measure the time elapsed performing an event */
-	PC_INTERVAL		/**< measure the interval between instances of an event */
+	PC_INTERVAL,		/**< measure the interval between instances of an event */
+	PC_HISTOGRAM		/**< PC_ELAPSED with a histogram of the durations, for percentiles */
 };
 
+/**
+ * Number of PC_HISTOGRAM buckets. The buckets are 1us wide below 4us,
+ * then 4 buckets per doubling of the duration, the last one holds everything
+ * above about 115ms.
+ */
+#define PERF_HISTOGRAM_BUCKETS	64
+
 struct perf_ctr_header;
 typedef struct perf_ctr_header	*perf_counter_t;
 
+/**
+ * Snapshot of a counter, see perf_get_stats.
+ */
+struct perf_counter_stats {
+	const char		*name;
+	enum perf_counter_type	type;
+	uint64_t		event_count;
+	uint64_t		event_overruns;
+	uint64_t		time_total;	/**< us, time between the first and last event for PC_INTERVAL */
+	uint64_t		time_least;	/**< us */
+	uint64_t		time_most;	/**< us */
+	float			mean;		/**< us */
+	float			rms;		/**< us */
+	uint64_t		p50;		/**< us, PC_HISTOGRAM only */
+	uint64_t		p99;		/**< us, PC_HISTOGRAM only */
+	uint64_t		p999;		/**< us, PC_HISTOGRAM only */
+};
+
 __BEGIN_DECLS
 
 /**
@@ -76,6 +102,14 @@ __EXPORT extern perf_counter_t	perf_alloc(enum perf_counter_type type, const cha
  */
 __EXPORT extern perf_counter_t	perf_alloc_once(enum perf_counter_type type, const char *name);
 
+/**
+ * Find an existing counter by name.
+ *
+ * @param name			The counter name.
+ * @return			Handle for the counter, or NULL if there is none.
+ */
+__EXPORT extern perf_counter_t	perf_find(const char *name);
+
 /**
  * Free a counter.
  *
@@ -143,6 +177,37 @@ __EXPORT extern void		perf_cancel(perf_counter_t handle);
  */
 __EXPORT extern void		perf_reset(perf_counter_t handle);
 
+/**
+ * Take a consistent snapshot of a counter.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param stats			Filled with the counter values.
+ * @return			0 on success, -1 if the handle is NULL.
+ */
+__EXPORT extern int		perf_get_stats(perf_counter_t handle, struct perf_counter_stats *stats);
+
+/**
+ * Take a consistent snapshot of a counter by name, safe against a
+ * concurrent perf_free of the counter.
+ *
+ * @param name			Name of the counter.
+ * @param stats			Filled with the counter values, the name is the one of the counter.
+ * @return			0 on success, -1 if there is no such counter.
+ */
+__EXPORT extern int		perf_get_stats_by_name(const char *name, struct perf_counter_stats *stats);
+
+/**
+ * Percentile of the durations of a PC_HISTOGRAM counter.
+ *
+ * The result is the upper bound of the histogram bucket holding the
+ * percentile, at most the largest duration seen.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param percentile		Percentile in percent, e.g. 99.9.
+ * @return			Duration in us, 0 for empty or other counters.
+ */
+__EXPORT extern uint64_t	perf_percentile(perf_counter_t handle, float percentile);
+
 /**
  * Print one performance counter to stdout
  *
@@ -165,6 +230,27 @@ __EXPORT extern void		perf_print_counter_fd(int fd, perf_counter_t handle);
  */
 __EXPORT extern void		perf_print_all(int fd);
 
+/**
+ * Print all of the performance counters as a JSON array.
+ *
+ * @param fd			File descriptor to print to - e.g. 0 for stdout
+ */
+__EXPORT extern void		perf_print_all_json(int fd);
+
+/**
+ * Publish a counter on the perf_stats topic once per second.
+ *
+ * @param name			Name of an existing counter.
+ * @return			0 on success, -1 if there is no such counter
+ *				or too many counters are published.
+ */
+__EXPORT extern int		perf_publish_add(const char *name);
+
+/**
+ * Stop publishing all counters.
+ */
+__EXPORT extern void		perf_publish_stop(void);
+
 /**
  * Print hrt latency counters.
  *
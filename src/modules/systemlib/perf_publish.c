@@ -0,0 +1,148 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file perf_publish.c
+ *
+ * Periodic uORB publication of selected performance counters.
+ */
+
+#include <px4_workqueue.h>
+#include <stdbool.h>
+#include <string.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/perf_stats.h>
+#include "perf_counter.h"
+
+#define PERF_PUBLISH_MAX		8
+#define PERF_PUBLISH_INTERVAL_US	1000000
+
+/* counters are looked up by name every cycle, they may be freed while published */
+struct perf_publication {
+	char		name[PERF_STATS_NAME_LEN];
+	orb_advert_t	pub;
+	int		instance;
+};
+
+static struct perf_publication perf_publications[PERF_PUBLISH_MAX];
+static unsigned perf_publication_count;
+static struct work_s perf_publish_work;
+static volatile bool perf_publish_running;
+
+static void
+perf_publish_cycle(void *arg)
+{
+	if (!perf_publish_running) {
+		return;
+	}
+
+	struct perf_stats_s report;
+	struct perf_counter_stats stats;
+
+	for (unsigned i = 0; i < perf_publication_count; i++) {
+		struct perf_publication *publication = &perf_publications[i];
+
+		if (perf_get_stats_by_name(publication->name, &stats) != 0) {
+			continue;
+		}
+
+		memset(&report, 0, sizeof(report));
+		report.timestamp = hrt_absolute_time();
+		strncpy(report.name, publication->name, sizeof(report.name) - 1);
+		report.type = stats.type;
+		report.event_count = stats.event_count;
+		report.overruns = stats.event_overruns;
+		report.total_us = stats.time_total;
+		report.min_us = stats.time_least;
+		report.max_us = stats.time_most;
+		report.mean_us = stats.mean;
+		report.rms_us = stats.rms;
+		report.p50_us = stats.p50;
+		report.p99_us = stats.p99;
+		report.p999_us = stats.p999;
+
+		if (publication->pub != NULL) {
+			orb_publish(ORB_ID(perf_stats), publication->pub, &report);
+
+		} else {
+			publication->pub = orb_advertise_multi(ORB_ID(perf_stats), &report, &publication->instance, ORB_PRIO_DEFAULT);
+		}
+	}
+
+	work_queue(LPWORK, &perf_publish_work, perf_publish_cycle, NULL, USEC2TICK(PERF_PUBLISH_INTERVAL_US));
+}
+
+int
+perf_publish_add(const char *name)
+{
+	if (perf_find(name) == NULL) {
+		return -1;
+	}
+
+	for (unsigned i = 0; i < perf_publication_count; i++) {
+		if (strncmp(perf_publications[i].name, name, sizeof(perf_publications[i].name) - 1) == 0) {
+			return 0;
+		}
+	}
+
+	if (perf_publication_count >= PERF_PUBLISH_MAX) {
+		return -1;
+	}
+
+	/* the count is only raised once the entry is complete, the cycle may be running */
+	strncpy(perf_publications[perf_publication_count].name, name, sizeof(perf_publications[0].name) - 1);
+	perf_publication_count++;
+
+	if (!perf_publish_running) {
+		perf_publish_running = true;
+		work_queue(LPWORK, &perf_publish_work, perf_publish_cycle, NULL, 0);
+	}
+
+	return 0;
+}
+
+void
+perf_publish_stop(void)
+{
+	if (!perf_publish_running) {
+		return;
+	}
+
+	perf_publish_running = false;
+	work_cancel(LPWORK, &perf_publish_work);
+
+	/* the slots keep their advertised topic instance for the next publications */
+	perf_publication_count = 0;
+}
@@ -0,0 +1,162 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file pipeline.c
+ *
+ * Synchronous control pipeline.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <systemlib/param/param.h>
+#include "perf_counter.h"
+#include "pipeline.h"
+
+struct pipeline_entry {
+	const char		*name;
+	pipeline_callback_t	callback;
+	void			*arg;
+};
+
+static struct pipeline_entry pipeline_stages[PIPELINE_STAGE_COUNT];
+
+/* held while the stages run, so a stage can't go away in the middle of a cycle */
+static pthread_mutex_t pipeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* -1 until SYS_PIPELINE is read */
+static int pipeline_mode = -1;
+
+static perf_counter_t pipeline_perf;
+
+static const char *const pipeline_names[PIPELINE_STAGE_COUNT] = {
+	"estimator",
+	"controller",
+	"output"
+};
+
+bool
+pipeline_enabled(void)
+{
+	if (pipeline_mode < 0) {
+		int32_t mode = 0;
+		param_get(param_find("SYS_PIPELINE"), &mode);
+		pipeline_mode = (mode != 0) ? 1 : 0;
+	}
+
+	return pipeline_mode > 0;
+}
+
+int
+pipeline_register(enum pipeline_stage stage, const char *name, pipeline_callback_t callback, void *arg)
+{
+	if (stage >= PIPELINE_STAGE_COUNT || !pipeline_enabled()) {
+		return -1;
+	}
+
+	int ret = -1;
+
+	pthread_mutex_lock(&pipeline_mutex);
+
+	if (pipeline_perf == NULL) {
+		pipeline_perf = perf_alloc(PC_HISTOGRAM, "pipeline cycle");
+	}
+
+	if (pipeline_stages[stage].callback == NULL) {
+		pipeline_stages[stage].name = name;
+		pipeline_stages[stage].arg = arg;
+		pipeline_stages[stage].callback = callback;
+		ret = 0;
+	}
+
+	pthread_mutex_unlock(&pipeline_mutex);
+
+	return ret;
+}
+
+void
+pipeline_unregister(enum pipeline_stage stage)
+{
+	if (stage >= PIPELINE_STAGE_COUNT) {
+		return;
+	}
+
+	pthread_mutex_lock(&pipeline_mutex);
+	pipeline_stages[stage].callback = NULL;
+	pipeline_stages[stage].arg = NULL;
+	pipeline_stages[stage].name = NULL;
+	pthread_mutex_unlock(&pipeline_mutex);
+}
+
+void
+pipeline_run(void)
+{
+	if (pipeline_mode <= 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&pipeline_mutex);
+	perf_begin(pipeline_perf);
+
+	for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+		if (pipeline_stages[s].callback != NULL) {
+			pipeline_stages[s].callback(pipeline_stages[s].arg);
+		}
+	}
+
+	perf_end(pipeline_perf);
+	pthread_mutex_unlock(&pipeline_mutex);
+}
+
+void
+pipeline_print(void)
+{
+	if (!pipeline_enabled()) {
+		printf("pipeline: disabled\n");
+		return;
+	}
+
+	printf("pipeline:\n");
+
+	pthread_mutex_lock(&pipeline_mutex);
+
+	for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+		printf("  %-10s %s\n", pipeline_names[s],
+		       (pipeline_stages[s].callback != NULL) ? pipeline_stages[s].name : "(own task)");
+	}
+
+	pthread_mutex_unlock(&pipeline_mutex);
+
+	perf_print_counter(pipeline_perf);
+}
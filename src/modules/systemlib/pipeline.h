@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file pipeline.h
+ *
+ * Synchronous control pipeline.
+ *
+ * With SYS_PIPELINE set the estimator, controller and output stages don't
+ * wait for their input topic in their own task, they register a callback
+ * instead. The sensors task runs the callbacks back to back after every
+ * sensor_combined publication, triggered by the gyro sample. The stages
+ * still publish their topics for everyone else.
+ *
+ * The callbacks run in the context of the sensors task: subscriptions must
+ * be created from the callback (file descriptors belong to the task on
+ * NuttX) and the callbacks must not block.
+ */
+
+#ifndef _SYSTEMLIB_PIPELINE_H
+#define _SYSTEMLIB_PIPELINE_H value
+
+#include <stdbool.h>
+#include <px4_defines.h>
+
+/**
+ * Stages run by the pipeline, in order.
+ */
+enum pipeline_stage {
+	PIPELINE_STAGE_ESTIMATOR = 0,	/**< publishes control_state */
+	PIPELINE_STAGE_CONTROLLER,	/**< publishes actuator_controls */
+	PIPELINE_STAGE_OUTPUT,		/**< mixes and writes the outputs */
+	PIPELINE_STAGE_COUNT
+};
+
+/** additional stack of the sensors task for the stages */
+#define PIPELINE_STACK_SIZE	3000
+
+typedef void (*pipeline_callback_t)(void *arg);
+
+__BEGIN_DECLS
+
+/**
+ * Check if the pipeline mode is enabled.
+ *
+ * SYS_PIPELINE is read once, changes take effect after a reboot.
+ */
+__EXPORT extern bool		pipeline_enabled(void);
+
+/**
+ * Register the callback of a stage.
+ *
+ * @param stage			The pipeline stage.
+ * @param name			Name of the module, for the status.
+ * @param callback		Called once per sensor_combined publication.
+ * @param arg			Passed to the callback.
+ * @return			0 on success, -1 if the stage is taken or the pipeline is disabled.
+ */
+__EXPORT extern int		pipeline_register(enum pipeline_stage stage, const char *name,
+		pipeline_callback_t callback, void *arg);
+
+/**
+ * Remove the callback of a stage.
+ *
+ * Waits for a running pipeline cycle, the callback isn't called after this returns.
+ *
+ * @param stage			The pipeline stage.
+ */
+__EXPORT extern void		pipeline_unregister(enum pipeline_stage stage);
+
+/**
+ * Run all registered stages, called by the sensors task.
+ */
+__EXPORT extern void		pipeline_run(void);
+
+/**
+ * Print the registered stages.
+ */
+__EXPORT extern void		pipeline_print(void);
+
+__END_DECLS
+
+#endif
@@ -41,10 +41,19 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <systemlib/cpuload.h>
 #include <systemlib/printload.h>
 #include <drivers/drv_hrt.h>
+#include <uORB/topics/task_load.h>
+
+#ifdef __PX4_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 
 extern struct system_load_s system_load;
 
@@ -66,9 +75,290 @@ void init_print_load_s(uint64_t t, struct print_load_s *s)
 	}
 
 	s->interval_time_ms_inv = 0.f;
+
+	memset(s->threads, 0, sizeof(s->threads));
+	s->sample_count = 0;
 }
 
-void print_load(uint64_t t, int fd, struct print_load_s *print_state)
+#ifdef __PX4_LINUX
+
+/**
+ * Current statistics of a thread, as read from /proc.
+ */
+struct thread_sample_s {
+	char name[TASK_LOAD_NAME_LEN];
+	uint64_t cpu_time_ns;
+	uint64_t wait_time_ns;
+	uint64_t time_slices;
+	uint64_t voluntary_switches;
+	uint64_t involuntary_switches;
+	int priority;
+};
+
+static int read_proc_file(int tid, const char *file, char *buf, size_t len)
+{
+	char path[48];
+	snprintf(path, sizeof(path), "/proc/self/task/%d/%s", tid, file);
+
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	ssize_t n = read(fd, buf, len - 1);
+	close(fd);
+
+	if (n < 0) {
+		return -1;
+	}
+
+	buf[n] = '\0';
+	return n;
+}
+
+static uint64_t status_value(const char *status, const char *key)
+{
+	const char *line = strstr(status, key);
+	return (line != NULL) ? strtoull(line + strlen(key), NULL, 10) : 0;
+}
+
+static int read_thread(int tid, struct thread_sample_s *sample)
+{
+	char buf[2048];
+
+	memset(sample, 0, sizeof(*sample));
+
+	/* the PX4 tasks name their threads */
+	if (read_proc_file(tid, "comm", buf, sizeof(buf)) <= 0) {
+		return -1;
+	}
+
+	buf[strcspn(buf, "\n")] = '\0';
+	strncpy(sample->name, buf, sizeof(sample->name) - 1);
+
+	/* CPU time and run queue wait in ns, needs schedstats or sched info in the kernel */
+	unsigned long long cpu_ns, wait_ns, slices;
+
+	if (read_proc_file(tid, "schedstat", buf, sizeof(buf)) > 0 &&
+	    sscanf(buf, "%llu %llu %llu", &cpu_ns, &wait_ns, &slices) == 3) {
+		sample->cpu_time_ns = cpu_ns;
+		sample->wait_time_ns = wait_ns;
+		sample->time_slices = slices;
+
+	} else if (read_proc_file(tid, "stat", buf, sizeof(buf)) > 0) {
+		/* only the tick resolution user and system time, the name may contain spaces */
+		const char *fields = strrchr(buf, ')');
+		unsigned long utime, stime;
+
+		if (fields == NULL || sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+					     &utime, &stime) != 2) {
+			return -1;
+		}
+
+		sample->cpu_time_ns = (uint64_t)(utime + stime) * 1000000000ULL / sysconf(_SC_CLK_TCK);
+	}
+
+	if (read_proc_file(tid, "status", buf, sizeof(buf)) > 0) {
+		/* the newline keeps the voluntary count from matching the nonvoluntary one */
+		sample->voluntary_switches = status_value(buf, "\nvoluntary_ctxt_switches:");
+		sample->involuntary_switches = status_value(buf, "\nnonvoluntary_ctxt_switches:");
+	}
+
+	struct sched_param param;
+
+	if (sched_getparam(tid, &param) == 0) {
+		sample->priority = param.sched_priority;
+	}
+
+	return 0;
+}
+
+/**
+ * State of a thread at the last sample, a free or stale slot for a new one.
+ */
+static struct print_load_thread_s *thread_state(struct print_load_s *print_state, int tid, bool *is_new)
+{
+	struct print_load_thread_s *free_slot = NULL;
+
+	for (int i = 0; i < PRINT_LOAD_THREADS_MAX; i++) {
+		struct print_load_thread_s *thread = &print_state->threads[i];
+
+		if (thread->tid == tid && thread->tid != 0) {
+			*is_new = false;
+			return thread;
+		}
+
+		/* slots of threads not seen in the last sample are free */
+		if (free_slot == NULL && (thread->tid == 0 || thread->seen + 1 < print_state->sample_count)) {
+			free_slot = thread;
+		}
+	}
+
+	*is_new = true;
+	return free_slot;
+}
+
+/**
+ * Insert a thread into the report, which is sorted by load.
+ */
+static void report_insert(struct task_load_s *report, int tid, const struct thread_sample_s *sample, float load,
+			  uint32_t voluntary, uint32_t involuntary, float latency_us)
 {
+	unsigned pos = report->task_count;
+
+	while (pos > 0 && report->cpu_load[pos - 1] < load) {
+		pos--;
+	}
+
+	if (pos >= TASK_LOAD_MAX) {
+		return;
+	}
+
+	unsigned move = ((report->task_count < TASK_LOAD_MAX) ? report->task_count : TASK_LOAD_MAX - 1) - pos;
+
+	memmove(&report->names[(pos + 1) * TASK_LOAD_NAME_LEN], &report->names[pos * TASK_LOAD_NAME_LEN],
+		move * TASK_LOAD_NAME_LEN);
+	memmove(&report->tid[pos + 1], &report->tid[pos], move * sizeof(report->tid[0]));
+	memmove(&report->cpu_load[pos + 1], &report->cpu_load[pos], move * sizeof(report->cpu_load[0]));
+	memmove(&report->cpu_time_ms[pos + 1], &report->cpu_time_ms[pos], move * sizeof(report->cpu_time_ms[0]));
+	memmove(&report->voluntary_switches[pos + 1], &report->voluntary_switches[pos],
+		move * sizeof(report->voluntary_switches[0]));
+	memmove(&report->involuntary_switches[pos + 1], &report->involuntary_switches[pos],
+		move * sizeof(report->involuntary_switches[0]));
+	memmove(&report->sched_latency_us[pos + 1], &report->sched_latency_us[pos],
+		move * sizeof(report->sched_latency_us[0]));
+	memmove(&report->priority[pos + 1], &report->priority[pos], move * sizeof(report->priority[0]));
+
+	memcpy(&report->names[pos * TASK_LOAD_NAME_LEN], sample->name, TASK_LOAD_NAME_LEN);
+	report->tid[pos] = tid;
+	report->cpu_load[pos] = load;
+	report->cpu_time_ms[pos] = (uint32_t)(sample->cpu_time_ns / 1000000);
+	report->voluntary_switches[pos] = voluntary;
+	report->involuntary_switches[pos] = involuntary;
+	report->sched_latency_us[pos] = latency_us;
+	report->priority[pos] = (int16_t)sample->priority;
+
+	if (report->task_count < TASK_LOAD_MAX) {
+		report->task_count++;
+	}
 }
 
+int print_load_sample(uint64_t t, struct print_load_s *print_state, struct task_load_s *report)
+{
+	DIR *dir = opendir("/proc/self/task");
+
+	if (dir == NULL) {
+		return -1;
+	}
+
+	memset(report, 0, sizeof(*report));
+
+	print_state->new_time = t;
+	print_state->sample_count++;
+
+	uint64_t interval_us = print_state->new_time - print_state->interval_start_time;
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != NULL) {
+		int tid = atoi(entry->d_name);
+		struct thread_sample_s sample;
+
+		if (tid <= 0 || read_thread(tid, &sample) != 0) {
+			continue;
+		}
+
+		report->task_total++;
+
+		bool is_new;
+		struct print_load_thread_s *thread = thread_state(print_state, tid, &is_new);
+		float load = 0.0f;
+		uint32_t voluntary = 0;
+		uint32_t involuntary = 0;
+		float latency_us = 0.0f;
+
+		if (thread != NULL && !is_new && interval_us > 0) {
+			load = (float)(sample.cpu_time_ns - thread->cpu_time_ns) / 1000.0f / interval_us;
+			voluntary = (uint32_t)(sample.voluntary_switches - thread->voluntary_switches);
+			involuntary = (uint32_t)(sample.involuntary_switches - thread->involuntary_switches);
+
+			if (sample.time_slices > thread->time_slices) {
+				latency_us = (float)(sample.wait_time_ns - thread->wait_time_ns) / 1000.0f /
+					     (sample.time_slices - thread->time_slices);
+			}
+		}
+
+		if (thread != NULL) {
+			thread->tid = tid;
+			thread->seen = print_state->sample_count;
+			thread->cpu_time_ns = sample.cpu_time_ns;
+			thread->wait_time_ns = sample.wait_time_ns;
+			thread->time_slices = sample.time_slices;
+			thread->voluntary_switches = sample.voluntary_switches;
+			thread->involuntary_switches = sample.involuntary_switches;
+		}
+
+		report->load += load;
+		report_insert(report, tid, &sample, load, voluntary, involuntary, latency_us);
+	}
+
+	closedir(dir);
+
+	report->timestamp = t;
+	report->interval_us = (uint32_t)interval_us;
+	report->cpu_count = (uint16_t)sysconf(_SC_NPROCESSORS_ONLN);
+
+	print_state->interval_start_time = print_state->new_time;
+	return 0;
+}
+
+#else
+
+int print_load_sample(uint64_t t, struct print_load_s *print_state, struct task_load_s *report)
+{
+	return -1;
+}
+
+#endif /* __PX4_LINUX */
+
+void print_load(uint64_t t, int fd, struct print_load_s *print_state)
+{
+	const char *clear_line = "";
+
+	/* print system information */
+	if (fd == 1) {
+		dprintf(fd, "\033[H"); /* move cursor home and clear screen */
+		clear_line = CL;
+	}
+
+	struct task_load_s *report = (struct task_load_s *)malloc(sizeof(struct task_load_s));
+
+	if (report == NULL || print_load_sample(t, print_state, report) != 0) {
+		dprintf(fd, "%sno thread statistics on this OS\n", clear_line);
+		free(report);
+		return;
+	}
+
+	dprintf(fd, "%sThreads: %d total, %d shown\n", clear_line, report->task_total, report->task_count);
+	dprintf(fd, "%sCPU usage: %.2f%% of %d cores\n", clear_line,
+		(double)(report->load * 100.f) / (report->cpu_count > 0 ? report->cpu_count : 1), report->cpu_count);
+	dprintf(fd, "%sUptime: %.3fs\n%s\n", clear_line, (double)t / 1000000.0, clear_line);
+
+	/* header for thread list, switches per interval */
+	dprintf(fd, "%s%6s %-*s %8s %7s %6s %6s %8s %4s\n", clear_line, "TID", TASK_LOAD_NAME_LEN, "COMMAND",
+		"CPU(ms)", "CPU(%)", "VCSW", "ICSW", "WAIT(us)", "PRIO");
+
+	for (int i = 0; i < report->task_count; i++) {
+		dprintf(fd, "%s%6d %-*.*s %8u %7.3f %6u %6u %8.1f %4d\n", clear_line,
+			(int)report->tid[i],
+			TASK_LOAD_NAME_LEN, TASK_LOAD_NAME_LEN, &report->names[i * TASK_LOAD_NAME_LEN],
+			(unsigned)report->cpu_time_ms[i],
+			(double)(report->cpu_load[i] * 100.f),
+			(unsigned)report->voluntary_switches[i],
+			(unsigned)report->involuntary_switches[i],
+			(double)report->sched_latency_us[i],
+			(int)report->priority[i]);
+	}
+
+	free(report);
+}
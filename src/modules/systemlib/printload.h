@@ -50,6 +50,24 @@ __BEGIN_DECLS
 #define CONFIG_MAX_TASKS 64
 #endif
 
+#ifndef __PX4_NUTTX
+#define PRINT_LOAD_THREADS_MAX 64
+
+/**
+ * Statistics of a thread at the last sample, the POSIX builds sample the
+ * threads of the process from the OS.
+ */
+struct print_load_thread_s {
+	int tid;
+	uint32_t seen;				///< sample count when the thread was last seen
+	uint64_t cpu_time_ns;
+	uint64_t wait_time_ns;			///< time spent waiting on a run queue
+	uint64_t time_slices;
+	uint64_t voluntary_switches;
+	uint64_t involuntary_switches;
+};
+#endif
+
 struct print_load_s {
 	uint64_t total_user_time;
 
@@ -61,10 +79,31 @@ struct print_load_s {
 	uint64_t last_times[CONFIG_MAX_TASKS];
 	float curr_loads[CONFIG_MAX_TASKS];
 	float interval_time_ms_inv;
+#ifndef __PX4_NUTTX
+	struct print_load_thread_s threads[PRINT_LOAD_THREADS_MAX];
+	uint32_t sample_count;
+#endif
 };
 
 __EXPORT void init_print_load_s(uint64_t t, struct print_load_s *s);
 
 __EXPORT void print_load(uint64_t t, int fd, struct print_load_s *print_state);
 
+#ifndef __PX4_NUTTX
+struct task_load_s;
+
+/**
+ * Sample the CPU usage of the threads of the process.
+ *
+ * The loads and switch counts of the report refer to the interval since
+ * the previous sample, threads seen for the first time report zero.
+ *
+ * @param t		The current time.
+ * @param print_state	Sampling state, initialized with init_print_load_s.
+ * @param report	Filled with the busiest threads.
+ * @return		0 on success, -1 if the OS provides no thread statistics.
+ */
+__EXPORT int print_load_sample(uint64_t t, struct print_load_s *print_state, struct task_load_s *report);
+#endif
+
 __END_DECLS
@@ -115,3 +115,18 @@ PARAM_DEFINE_INT32(SYS_COMPANION, 157600);
  * @group System
  */
 PARAM_DEFINE_INT32(SYS_PARAM_VER, 1);
+
+/**
+ * Synchronous control pipeline
+ *
+ * Run the attitude estimator, the attitude controller and the output mixer
+ * in the sensors task right after every gyro sample instead of in their own
+ * tasks. This removes the task switches between the stages from the control
+ * latency. The stages still publish their topics.
+ *
+ * @min 0
+ * @max 1
+ * @reboot_required true
+ * @group System
+ */
+PARAM_DEFINE_INT32(SYS_PIPELINE, 0);
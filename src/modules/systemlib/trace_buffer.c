@@ -0,0 +1,324 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file trace_buffer.c
+ *
+ * Execution trace of the perf counters.
+ */
+
+#if defined(__PX4_LINUX) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE	/* pthread_getname_np */
+#endif
+
+#include <px4_config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <drivers/drv_hrt.h>
+#include "trace_buffer.h"
+
+#ifdef __PX4_NUTTX
+#include <nuttx/arch.h>
+#include <systemlib/err.h>
+#endif
+
+#define TRACE_NAME_LEN	24
+
+struct trace_record {
+	uint64_t		timestamp;
+	const char		*name;
+	int32_t			value;
+	uint8_t			type;
+};
+
+/**
+ * Ring of one thread, only written by the owner.
+ */
+struct trace_thread {
+	volatile uintptr_t	owner;		/**< id of the thread, 0 if the slot is free */
+	volatile uint32_t	head;		/**< number of events written since the start */
+	struct trace_record	*records;
+	char			name[TRACE_NAME_LEN];
+};
+
+volatile bool trace_active = false;
+
+static struct trace_thread trace_threads[TRACE_THREADS_MAX];
+static unsigned trace_dropped_threads;
+static hrt_abstime trace_start_time;
+
+static uintptr_t
+trace_thread_id(void)
+{
+#ifdef __PX4_NUTTX
+	return (uintptr_t)getpid();
+#else
+	return (uintptr_t)pthread_self();
+#endif
+}
+
+static void
+trace_thread_name(char *name)
+{
+#if defined(__PX4_NUTTX)
+	strncpy(name, getprogname(), TRACE_NAME_LEN - 1);
+#elif defined(__PX4_LINUX) || defined(__PX4_DARWIN)
+
+	/* the PX4 tasks name their threads */
+	if (pthread_getname_np(pthread_self(), name, TRACE_NAME_LEN) != 0 || name[0] == '\0') {
+		snprintf(name, TRACE_NAME_LEN, "thread %lx", (unsigned long)pthread_self());
+	}
+
+#else
+	snprintf(name, TRACE_NAME_LEN, "thread %lx", (unsigned long)trace_thread_id());
+#endif
+	name[TRACE_NAME_LEN - 1] = '\0';
+}
+
+/**
+ * Find the ring of the calling thread, claim a free one on the first event.
+ *
+ * The rings are allocated by trace_start, this never allocates.
+ */
+static struct trace_thread *
+trace_self(void)
+{
+	uintptr_t id = trace_thread_id();
+	unsigned i;
+
+	/* the slots are claimed in order, the first free one ends the search */
+	for (i = 0; i < TRACE_THREADS_MAX; i++) {
+		uintptr_t owner = trace_threads[i].owner;
+
+		if (owner == id) {
+			return &trace_threads[i];
+		}
+
+		if (owner == 0) {
+			break;
+		}
+	}
+
+	for (; i < TRACE_THREADS_MAX; i++) {
+		struct trace_thread *thread = &trace_threads[i];
+
+		/* a slot without a ring is never claimed, its thread is not traced */
+		if (thread->records == NULL) {
+			break;
+		}
+
+		if (thread->owner == 0 && __sync_bool_compare_and_swap(&thread->owner, 0, id)) {
+			thread->head = 0;
+			trace_thread_name(thread->name);
+			return thread;
+		}
+	}
+
+	trace_dropped_threads++;
+	return NULL;
+}
+
+void
+trace_event(enum trace_event_type type, const char *name, int64_t value)
+{
+	if (!trace_active) {
+		return;
+	}
+
+#ifdef __PX4_NUTTX
+
+	/* an interrupt would write into the ring of the thread it interrupted */
+	if (up_interrupt_context()) {
+		return;
+	}
+
+#endif
+
+	struct trace_thread *thread = trace_self();
+
+	if (thread == NULL || thread->records == NULL) {
+		return;
+	}
+
+	uint32_t head = thread->head;
+	struct trace_record *record = &thread->records[head & (TRACE_RING_EVENTS - 1)];
+
+	record->timestamp = hrt_absolute_time();
+	record->name = name;
+	record->value = (value > INT32_MAX) ? INT32_MAX : (int32_t)value;
+	record->type = (uint8_t)type;
+
+	/* publish the record before the reader can see the new head */
+	__sync_synchronize();
+	thread->head = head + 1;
+}
+
+int
+trace_start(void)
+{
+	trace_active = false;
+
+	/* allocate all rings up front, recording an event must not allocate */
+	for (unsigned i = 0; i < TRACE_THREADS_MAX; i++) {
+		if (trace_threads[i].records == NULL) {
+			trace_threads[i].records = (struct trace_record *)malloc(TRACE_RING_EVENTS * sizeof(struct trace_record));
+
+			if (trace_threads[i].records == NULL) {
+				return -1;
+			}
+		}
+	}
+
+	/* threads claim their slot again, the rings are reused */
+	for (unsigned i = 0; i < TRACE_THREADS_MAX; i++) {
+		trace_threads[i].owner = 0;
+		trace_threads[i].head = 0;
+	}
+
+	trace_dropped_threads = 0;
+	trace_start_time = hrt_absolute_time();
+
+	__sync_synchronize();
+	trace_active = true;
+	return 0;
+}
+
+void
+trace_stop(void)
+{
+	trace_active = false;
+}
+
+static void
+trace_write_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', f);
+		}
+
+		fputc(*s, f);
+	}
+
+	fputc('"', f);
+}
+
+int
+trace_dump(const char *path)
+{
+	static const char phases[] = { 'B', 'E', 'i', 'C' };
+
+	trace_stop();
+
+	if (path == NULL) {
+		path = TRACE_DEFAULT_PATH;
+	}
+
+	FILE *f = fopen(path, "w");
+
+	if (f == NULL) {
+		return -1;
+	}
+
+	int count = 0;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (unsigned i = 0; i < TRACE_THREADS_MAX; i++) {
+		const struct trace_thread *thread = &trace_threads[i];
+
+		if (thread->owner == 0 || thread->records == NULL) {
+			continue;
+		}
+
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			(count > 0) ? ",\n" : "", i + 1);
+		trace_write_string(f, thread->name);
+		fprintf(f, "}}");
+		count++;
+
+		/* the ring keeps the newest events */
+		uint32_t head = thread->head;
+		uint32_t first = (head > TRACE_RING_EVENTS) ? head - TRACE_RING_EVENTS : 0;
+
+		for (uint32_t n = first; n < head; n++) {
+			const struct trace_record *record = &thread->records[n & (TRACE_RING_EVENTS - 1)];
+
+			fprintf(f, ",\n{\"name\":");
+			trace_write_string(f, record->name);
+			fprintf(f, ",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u", phases[record->type & 3],
+				(unsigned long long)record->timestamp, i + 1);
+
+			if (record->type == TRACE_INSTANT) {
+				fprintf(f, ",\"s\":\"t\"");
+
+			} else if (record->type == TRACE_COUNTER) {
+				fprintf(f, ",\"args\":{\"value\":%d}", (int)record->value);
+			}
+
+			fprintf(f, "}");
+			count++;
+		}
+	}
+
+	fprintf(f, "\n]}\n");
+
+	int ret = (ferror(f) != 0) ? -1 : count;
+	fclose(f);
+	return ret;
+}
+
+void
+trace_print_status(void)
+{
+	printf("trace %s, %u ms since start, %u threads not traced\n", trace_active ? "active" : "stopped",
+	       (unsigned)(hrt_elapsed_time(&trace_start_time) / 1000), trace_dropped_threads);
+
+	for (unsigned i = 0; i < TRACE_THREADS_MAX; i++) {
+		const struct trace_thread *thread = &trace_threads[i];
+
+		if (thread->owner == 0) {
+			continue;
+		}
+
+		uint32_t head = thread->head;
+		printf("%3u %-24s %8u events, %5u kept\n", i + 1, thread->name, (unsigned)head,
+		       (unsigned)((head > TRACE_RING_EVENTS) ? TRACE_RING_EVENTS : head));
+	}
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file trace_buffer.h
+ *
+ * Execution trace of the perf counters.
+ *
+ * While tracing is active, perf_begin, perf_end, perf_count and perf_set
+ * record an event with the counter name into a ring of the calling thread.
+ * Every thread writes only into its own ring, so recording takes no lock.
+ * The rings keep the most recent events and can be written out in the
+ * Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+ */
+
+#ifndef _SYSTEMLIB_TRACE_BUFFER_H
+#define _SYSTEMLIB_TRACE_BUFFER_H value
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <px4_defines.h>
+
+/**
+ * Event types, match the phases of the Chrome trace format.
+ */
+enum trace_event_type {
+	TRACE_BEGIN = 0,	/**< start of a duration, perf_begin */
+	TRACE_END,		/**< end of a duration, perf_end and perf_cancel */
+	TRACE_INSTANT,		/**< single event, perf_count */
+	TRACE_COUNTER		/**< value, perf_set */
+};
+
+#ifdef __PX4_NUTTX
+#define TRACE_THREADS_MAX	16
+#define TRACE_RING_EVENTS	128	/**< per thread, power of two */
+#else
+#define TRACE_THREADS_MAX	64
+#define TRACE_RING_EVENTS	8192	/**< per thread, power of two */
+#endif
+
+/** default output of trace_dump, next to the flight logs */
+#define TRACE_DEFAULT_PATH	PX4_ROOTFSDIR "/fs/microsd/log/trace.json"
+
+__BEGIN_DECLS
+
+/**
+ * True while events are recorded, checked by the perf counters before
+ * calling trace_event.
+ */
+__EXPORT extern volatile bool	trace_active;
+
+/**
+ * Clear the rings and start recording.
+ *
+ * The rings of all TRACE_THREADS_MAX threads are allocated on the first start,
+ * so recording an event never allocates.
+ *
+ * @return			0 on success, -1 if the rings could not be allocated.
+ */
+__EXPORT extern int		trace_start(void);
+
+/**
+ * Stop recording, the rings keep their events until the next start.
+ */
+__EXPORT extern void		trace_stop(void);
+
+/**
+ * Record an event in the ring of the calling thread.
+ *
+ * Threads beyond TRACE_THREADS_MAX are not traced.
+ *
+ * @param type			The event type.
+ * @param name			Name of the event, must stay valid until the trace is written.
+ * @param value			Value of a TRACE_COUNTER event, ignored otherwise.
+ */
+__EXPORT extern void		trace_event(enum trace_event_type type, const char *name, int64_t value);
+
+/**
+ * Write the recorded events as Chrome trace JSON, stops recording.
+ *
+ * @param path			Output file, TRACE_DEFAULT_PATH if NULL.
+ * @return			Number of events written, -1 if the file could not be written.
+ */
+__EXPORT extern int		trace_dump(const char *path);
+
+/**
+ * Print the traced threads and their event counts.
+ */
+__EXPORT extern void		trace_print_status(void);
+
+__END_DECLS
+
+#endif
@@ -56,6 +56,48 @@ struct orb_metadata {
 
 typedef const struct orb_metadata *orb_id_t;
 
+/**
+ * Type of a topic field, as described by struct orb_field.
+ */
+enum orb_field_type {
+	ORB_FIELD_INT8 = 0,
+	ORB_FIELD_INT16,
+	ORB_FIELD_INT32,
+	ORB_FIELD_INT64,
+	ORB_FIELD_UINT8,
+	ORB_FIELD_UINT16,
+	ORB_FIELD_UINT32,
+	ORB_FIELD_UINT64,
+	ORB_FIELD_FLOAT,
+	ORB_FIELD_DOUBLE,
+	ORB_FIELD_BOOL,
+	ORB_FIELD_CHAR,
+	ORB_FIELD_STRUCT		/**< embedded message, described by nested */
+};
+
+struct orb_fields;
+
+/**
+ * Field descriptor, generated for every field of a topic.
+ */
+struct orb_field {
+	const char *name;
+	uint16_t offset;		/**< in the topic struct */
+	uint16_t array_length;		/**< 1 for scalar fields */
+	uint8_t type;			/**< enum orb_field_type */
+	const struct orb_fields *(*nested)(void);	/**< embedded message descriptors, NULL otherwise */
+};
+
+/**
+ * Descriptors of all fields of a topic, in declaration order.
+ */
+struct orb_fields {
+	const char *name;		/**< topic name */
+	uint16_t size;			/**< of the topic struct */
+	uint16_t count;
+	const struct orb_field *fields;
+};
+
 /**
  * Maximum number of multi topic instances
  */
@@ -385,8 +427,43 @@ extern int	orb_priority(int handle, int32_t *priority) __EXPORT;
  */
 extern int	orb_set_interval(int handle, unsigned interval) __EXPORT;
 
+/**
+ * Size of one element of a field type.
+ *
+ * @param type		The enum orb_field_type of the field.
+ * @return		The size in bytes, 0 for ORB_FIELD_STRUCT.
+ */
+extern size_t orb_field_type_size(uint8_t type) __EXPORT;
+
+/**
+ * Print a message into a buffer, one "name: value" line per field.
+ *
+ * Arrays and embedded messages are printed element by element, char
+ * arrays as string. The output is truncated to fit the buffer.
+ *
+ * @param buf		The buffer, always null terminated.
+ * @param size		Size of buf.
+ * @param fields	The descriptors of the topic, e.g. orb_topic_traits<T>::fields().
+ * @param data		The message.
+ * @return		The number of characters written, without the terminating null.
+ */
+extern int	orb_print_message(char *buf, size_t size, const struct orb_fields *fields, const void *data) __EXPORT;
+
 __END_DECLS
 
+#if defined(__cplusplus)
+/**
+ * Compile time properties of a topic, specialized by every generated topic header:
+ *
+ * name(), size(), field_count() and metadata() are constexpr, fields() returns
+ * the field descriptors. Modules which do not call fields() pay nothing for them.
+ *
+ * @param T		The structure the topic provides, e.g. sensor_combined_s.
+ */
+template<typename T>
+struct orb_topic_traits;
+#endif
+
 /* Diverse uORB header defines */ //XXX: move to better location
 #define ORB_ID_VEHICLE_ATTITUDE_CONTROLS    ORB_ID(actuator_controls_0)
 typedef uint8_t arming_state_t;
@@ -64,7 +64,8 @@ public:
 	 * 	This represents the uORB message name; This message name should be
 	 * 	globally unique.
 	 * @param msgRate
-	 * 	The max rate at which the subscriber can accept the messages.
+	 * 	The max rate at which the subscriber can accept the messages,
+	 * 	0 if it wants every update. Sent again when the rate changes.
 	 * @return
 	 * 	0 = success; This means the messages is successfully sent to the receiver
 	 * 		Note: This does not mean that the receiver as received it.
@@ -117,6 +118,36 @@ public:
 
 	virtual int16_t send_message(const char *messageName, int32_t length, uint8_t *data) = 0;
 
+	/**
+	 * @brief Sends several data messages in one transfer.
+	 *
+	 * Channels that can move a batch cheaper than single messages override
+	 * this, by default the messages are sent one by one.
+	 * @param count
+	 * 	Number of messages.
+	 * @param messageNames
+	 * 	The uORB message name of each message.
+	 * @param lengths
+	 * 	The length of each data buffer.
+	 * @param data
+	 * 	The data of each message.
+	 * @return
+	 * 	The number of messages sent; the messages following the first
+	 * 	failure are not sent.
+	 */
+
+	virtual int32_t send_messages(int32_t count, const char *const messageNames[], const int32_t lengths[],
+				      uint8_t *const data[])
+	{
+		int32_t sent = 0;
+
+		while (sent < count && send_message(messageNames[sent], lengths[sent], data[sent]) == 0) {
+			sent++;
+		}
+
+		return sent;
+	}
+
 };
 
 /**
@@ -133,7 +164,8 @@ public:
 	 * 	This represents the uORB message Name; This message Name should be
 	 * 	globally unique.
 	 * @param msgRate
-	 * 	The max rate at which the subscriber can accept the messages.
+	 * 	The max rate at which the subscriber can accept the messages,
+	 * 	0 if it wants every update.
 	 * @return
 	 *  0 = success; This means the messages is successfully handled in the
 	 *  	handler.
@@ -69,7 +69,18 @@ uORB::DeviceNode::DeviceNode(const struct orb_metadata *meta, const char *name,
 	_publisher(0),
 	_priority(priority),
 	_published(false),
-	_subscriber_count(0)
+	_subscriber_count(0),
+	_unlimited_subscribers(0),
+	_subscribers(nullptr),
+	_subscriber_rate(0),
+	_requested_remote_rate(-1),
+	_remote_subscribed(false),
+	_remote_interval(0),
+	_remote_last_sent(0),
+	_remote_pending(false),
+	_remote_buffer(nullptr),
+	_remote_forwarded(0),
+	_remote_dropped(0)
 {
 	// enable debug() calls
 	//_debug_enabled = true;
@@ -81,6 +92,11 @@ uORB::DeviceNode::~DeviceNode()
 		delete[] _data;
 	}
 
+	uORB::Manager::get_instance()->set_remote_rate_limited(this, false);
+
+	if (_remote_buffer != nullptr) {
+		delete[] _remote_buffer;
+	}
 }
 
 int
@@ -144,6 +160,12 @@ uORB::DeviceNode::open(device::file_t *filp)
 		if (ret != PX4_OK) {
 			warnx("ERROR: VDev::open failed\n");
 			delete sd;
+
+		} else {
+			lock();
+			sd->next = _subscribers;
+			_subscribers = sd;
+			unlock();
 		}
 
 		//warnx("uORB::DeviceNode::Open: fd = %d flags = %d, priv = %p cdev = %p\n", filp->fd, filp->flags, filp->priv, filp->cdev);
@@ -167,6 +189,24 @@ uORB::DeviceNode::close(device::file_t *filp)
 
 		if (sd != nullptr) {
 			hrt_cancel(&sd->update_call);
+
+			if (sd->update_interval == 0) {
+				_unlimited_subscribers--;
+			}
+
+			lock();
+
+			for (SubscriberData **link = &_subscribers; *link != nullptr; link = &(*link)->next) {
+				if (*link == sd) {
+					*link = sd->next;
+					break;
+				}
+			}
+
+			/* the closed subscriber may have been the fastest one */
+			update_subscriber_rate();
+			unlock();
+
 			remove_internal_subscriber();
 			delete sd;
 			sd = nullptr;
@@ -286,8 +326,22 @@ uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 		return PX4_OK;
 
 	case ORBIOCSETINTERVAL:
+		if (sd->update_interval == 0 && arg != 0) {
+			_unlimited_subscribers--;
+
+		} else if (sd->update_interval != 0 && arg == 0) {
+			_unlimited_subscribers++;
+		}
+
 		sd->update_interval = arg;
 		sd->last_update = hrt_absolute_time();
+
+		/* a subscriber may also slow down, so the rate is taken from all of them again */
+		lock();
+		update_subscriber_rate();
+		unlock();
+
+		update_remote_rate();
 		return PX4_OK;
 
 	case ORBIOCGADVERTISER:
@@ -341,11 +395,25 @@ uORB::DeviceNode::publish(const orb_metadata *meta, orb_advert_t handle, const v
 	 */
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
-	if (ch != nullptr) {
-		if (ch->send_message(meta->o_name, meta->o_size, (uint8_t *)data) != 0) {
-			warnx("[uORB::DeviceNode::publish(%d)]: Error Sending [%s] topic data over comm_channel",
-			      __LINE__, meta->o_name);
-			return ERROR;
+	if (ch != nullptr && devnode->_remote_subscribed) {
+		if (devnode->_remote_interval == 0) {
+			if (ch->send_message(meta->o_name, meta->o_size, (uint8_t *)data) != 0) {
+				devnode->_remote_dropped++;
+				warnx("[uORB::DeviceNode::publish(%d)]: Error Sending [%s] topic data over comm_channel",
+				      __LINE__, meta->o_name);
+				return ERROR;
+			}
+
+			devnode->_remote_forwarded++;
+
+		} else {
+			/* rate limited: the latest data goes out with the next due batch of the
+			 * manager, an update that is replaced before that is never sent */
+			if (devnode->_remote_pending) {
+				devnode->_remote_dropped++;
+			}
+
+			devnode->_remote_pending = true;
 		}
 	}
 
@@ -471,10 +539,15 @@ uORB::DeviceNode::update_deferred_trampoline(void *arg)
 void uORB::DeviceNode::add_internal_subscriber()
 {
 	_subscriber_count++;
+
+	/* a new subscriber gets every update until it sets an interval */
+	_unlimited_subscribers++;
+
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (ch != nullptr && _subscriber_count > 0) {
-		ch->add_subscription(_meta->o_name, 1);
+		_requested_remote_rate = local_subscriber_rate();
+		ch->add_subscription(_meta->o_name, _requested_remote_rate);
 	}
 }
 
@@ -483,10 +556,51 @@ void uORB::DeviceNode::add_internal_subscriber()
 void uORB::DeviceNode::remove_internal_subscriber()
 {
 	_subscriber_count--;
+
+	if (_subscriber_count == 0) {
+		_unlimited_subscribers = 0;
+		_subscriber_rate = 0;
+	}
+
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (ch != nullptr && _subscriber_count == 0) {
 		ch->remove_subscription(_meta->o_name);
+		_requested_remote_rate = -1;
+
+	} else {
+		update_remote_rate();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void uORB::DeviceNode::update_subscriber_rate()
+{
+	int32_t rate = 0;
+
+	for (SubscriberData *sd = _subscribers; sd != nullptr; sd = sd->next) {
+		if (sd->update_interval != 0) {
+			int32_t sd_rate = (1000000 + sd->update_interval - 1) / sd->update_interval;
+
+			if (sd_rate > rate) {
+				rate = sd_rate;
+			}
+		}
+	}
+
+	_subscriber_rate = rate;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void uORB::DeviceNode::update_remote_rate()
+{
+	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
+
+	if (ch != nullptr && _subscriber_count > 0 && local_subscriber_rate() != _requested_remote_rate) {
+		_requested_remote_rate = local_subscriber_rate();
+		ch->add_subscription(_meta->o_name, _requested_remote_rate);
 	}
 }
 
@@ -502,13 +616,31 @@ bool uORB::DeviceNode::is_published()
 //-----------------------------------------------------------------------------
 int16_t uORB::DeviceNode::process_add_subscription(int32_t rateInHz)
 {
+	_remote_interval = (rateInHz > 0) ? 1000000 / rateInHz : 0;
+
+	if (_remote_interval > 0 && _remote_buffer == nullptr) {
+		_remote_buffer = new uint8_t[_meta->o_size];
+
+		if (_remote_buffer == nullptr) {
+			/* can't batch, forward every publish instead */
+			_remote_interval = 0;
+		}
+	}
+
+	_remote_subscribed = true;
+	uORB::Manager::get_instance()->set_remote_rate_limited(this, _remote_interval > 0);
+
 	// if there is already data in the node, send this out to
 	// the remote entity.
 	// send the data to the remote entity.
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (_data != nullptr && ch != nullptr) { // _data will not be null if there is a publisher.
-		ch->send_message(_meta->o_name, _meta->o_size, _data);
+		if (ch->send_message(_meta->o_name, _meta->o_size, _data) == 0) {
+			_remote_forwarded++;
+			_remote_last_sent = hrt_absolute_time();
+			_remote_pending = false;
+		}
 	}
 
 	return 0;
@@ -518,9 +650,43 @@ int16_t uORB::DeviceNode::process_add_subscription(int32_t rateInHz)
 //-----------------------------------------------------------------------------
 int16_t uORB::DeviceNode::process_remove_subscription()
 {
+	_remote_subscribed = false;
+	_remote_pending = false;
+	uORB::Manager::get_instance()->set_remote_rate_limited(this, false);
 	return 0;
 }
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+uint8_t *uORB::DeviceNode::take_remote_update(hrt_abstime now)
+{
+	if (!_remote_pending || _remote_buffer == nullptr || now < _remote_last_sent + _remote_interval) {
+		return nullptr;
+	}
+
+	/* take a consistent copy, the publisher may be writing */
+	lock();
+	memcpy(_remote_buffer, _data, _meta->o_size);
+	_remote_pending = false;
+	unlock();
+
+	_remote_last_sent = now;
+	return _remote_buffer;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void uORB::DeviceNode::print_remote_status()
+{
+	if (_requested_remote_rate < 0 && !_remote_subscribed && _remote_forwarded == 0 && _remote_dropped == 0) {
+		return;
+	}
+
+	PX4_INFO("%s: requested %d Hz, remote %s interval %u us, forwarded %u, dropped %u", get_devname(),
+		 (int)_requested_remote_rate, _remote_subscribed ? "subscribed," : "not subscribed,",
+		 (unsigned)_remote_interval, (unsigned)_remote_forwarded, (unsigned)_remote_dropped);
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 int16_t uORB::DeviceNode::process_received_message(int32_t length, uint8_t *data)
@@ -660,6 +826,12 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 				} else {
 					// add to the node map;.
 					_node_map[std::string(nodepath)] = node;
+
+					// the remote may have subscribed before the topic existed here,
+					// the rate it asked for is not kept, forward every update
+					if (uORB::Manager::get_instance()->is_remote_subscriber_present(meta->o_name)) {
+						node->process_add_subscription(0);
+					}
 				}
 
 
@@ -683,6 +855,13 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 	}
 }
 
+void uORB::DeviceMaster::print_remote_status()
+{
+	for (auto it = _node_map.begin(); it != _node_map.end(); ++it) {
+		it->second->print_remote_status();
+	}
+}
+
 uORB::DeviceNode *uORB::DeviceMaster::GetDeviceNode(const char *nodepath)
 {
 	uORB::DeviceNode *rc = nullptr;
@@ -96,6 +96,28 @@ public:
 	 */
 	void remove_internal_subscriber();
 
+	/**
+	 * Take the update for the remote if one is pending and the interval
+	 * requested by the remote has elapsed.
+	 * @param now
+	 *   Current time.
+	 * @return
+	 *   Copy of the latest data to send, nullptr if nothing is due.
+	 */
+	uint8_t *take_remote_update(hrt_abstime now);
+
+	/**
+	 * Count an update taken with take_remote_update() as sent or dropped.
+	 */
+	void remote_update_done(bool sent) { sent ? _remote_forwarded++ : _remote_dropped++; }
+
+	/**
+	 * Print the remote forwarding counters, if the topic ever had a remote subscriber.
+	 */
+	void print_remote_status();
+
+	const struct orb_metadata *get_meta() const { return _meta; }
+
 	/**
 	 * Return true if this topic has been published.
 	 *
@@ -116,6 +138,7 @@ private:
 		void    *poll_priv; /**< saved copy of fds->f_priv while poll is active */
 		bool    update_reported; /**< true if we have reported the update via poll/check */
 		int   priority; /**< priority of publisher */
+		SubscriberData *next; /**< next subscriber of the node */
 	};
 
 	const struct orb_metadata *_meta; /**< object metadata information */
@@ -129,6 +152,33 @@ private:
 	SubscriberData    *filp_to_sd(device::file_t *filp);
 
 	int32_t _subscriber_count;
+	int32_t _unlimited_subscribers; /**< local subscribers without an update interval */
+	SubscriberData *_subscribers; /**< list of the local subscribers, protected by the node lock */
+	int32_t _subscriber_rate; /**< highest rate of the local rate-limited subscribers [Hz] */
+	int32_t _requested_remote_rate; /**< rate last requested from the remote, -1 if none */
+
+	bool _remote_subscribed; /**< the remote has a subscriber for this topic */
+	hrt_abstime _remote_interval; /**< minimum interval between updates sent to the remote, 0 = every publish */
+	hrt_abstime _remote_last_sent; /**< time the last rate-limited update was taken for the remote */
+	volatile bool _remote_pending; /**< published since the last rate-limited update was taken */
+	uint8_t *_remote_buffer; /**< copy of the data being sent to the remote */
+	uint32_t _remote_forwarded; /**< updates sent to the remote */
+	uint32_t _remote_dropped; /**< updates not sent, coalesced by the rate limit or failed */
+
+	/**
+	 * Rate to ask from the remote for the current local subscribers.
+	 */
+	int32_t local_subscriber_rate() const { return (_unlimited_subscribers > 0) ? 0 : _subscriber_rate; }
+
+	/**
+	 * Recompute the highest rate of the local rate-limited subscribers, call with the node locked.
+	 */
+	void update_subscriber_rate();
+
+	/**
+	 * Ask the remote for the current local subscriber rate if it changed.
+	 */
+	void update_remote_rate();
 
 	/**
 	 * Perform a deferred update for a rate-limited subscriber.
@@ -170,6 +220,11 @@ public:
 
 	static uORB::DeviceNode *GetDeviceNode(const char *node_name);
 
+	/**
+	 * Print the remote forwarding counters of all topics.
+	 */
+	static void print_remote_status();
+
 	virtual int   ioctl(device::file_t *filp, int cmd, unsigned long arg);
 private:
 	Flavor      _flavor;
@@ -0,0 +1,229 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file uORBFields.cpp
+ * Generic message printing based on the generated field descriptors.
+ */
+
+#include "uORB.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+size_t orb_field_type_size(uint8_t type)
+{
+	switch (type) {
+	case ORB_FIELD_INT8:
+	case ORB_FIELD_UINT8:
+	case ORB_FIELD_BOOL:
+	case ORB_FIELD_CHAR:
+		return 1;
+
+	case ORB_FIELD_INT16:
+	case ORB_FIELD_UINT16:
+		return 2;
+
+	case ORB_FIELD_INT32:
+	case ORB_FIELD_UINT32:
+	case ORB_FIELD_FLOAT:
+		return 4;
+
+	case ORB_FIELD_INT64:
+	case ORB_FIELD_UINT64:
+	case ORB_FIELD_DOUBLE:
+		return 8;
+
+	default:
+		return 0;
+	}
+}
+
+namespace
+{
+
+/**
+ * Output buffer, keeps count of what would have been written.
+ */
+struct print_buffer {
+	char *buf;
+	size_t size;
+	size_t len;
+
+	void append(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+void print_buffer::append(const char *fmt, ...)
+{
+	size_t pos = (len < size) ? len : size;
+
+	va_list args;
+	va_start(args, fmt);
+	int ret = vsnprintf(buf + pos, size - pos, fmt, args);
+	va_end(args);
+
+	if (ret > 0) {
+		len += ret;
+	}
+}
+
+/* the fields may not be aligned in a packed message, so copy them out */
+template<typename T>
+T read_field(const uint8_t *data)
+{
+	T value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+void print_value(print_buffer &out, uint8_t type, const uint8_t *data)
+{
+	switch (type) {
+	case ORB_FIELD_INT8:
+		out.append("%d", (int)read_field<int8_t>(data));
+		break;
+
+	case ORB_FIELD_INT16:
+		out.append("%d", (int)read_field<int16_t>(data));
+		break;
+
+	case ORB_FIELD_INT32:
+		out.append("%ld", (long)read_field<int32_t>(data));
+		break;
+
+	case ORB_FIELD_INT64:
+		out.append("%lld", (long long)read_field<int64_t>(data));
+		break;
+
+	case ORB_FIELD_UINT8:
+		out.append("%u", (unsigned)read_field<uint8_t>(data));
+		break;
+
+	case ORB_FIELD_UINT16:
+		out.append("%u", (unsigned)read_field<uint16_t>(data));
+		break;
+
+	case ORB_FIELD_UINT32:
+		out.append("%lu", (unsigned long)read_field<uint32_t>(data));
+		break;
+
+	case ORB_FIELD_UINT64:
+		out.append("%llu", (unsigned long long)read_field<uint64_t>(data));
+		break;
+
+	case ORB_FIELD_FLOAT:
+		out.append("%.4f", (double)read_field<float>(data));
+		break;
+
+	case ORB_FIELD_DOUBLE:
+		out.append("%.8f", read_field<double>(data));
+		break;
+
+	case ORB_FIELD_BOOL:
+		out.append("%s", read_field<bool>(data) ? "true" : "false");
+		break;
+
+	case ORB_FIELD_CHAR:
+		out.append("%d", (int)read_field<char>(data));
+		break;
+
+	default:
+		out.append("?");
+		break;
+	}
+}
+
+void print_fields(print_buffer &out, const char *prefix, const struct orb_fields *fields, const uint8_t *data)
+{
+	for (unsigned i = 0; i < fields->count; i++) {
+		const struct orb_field &field = fields->fields[i];
+		const uint8_t *value = data + field.offset;
+
+		if (field.type == ORB_FIELD_CHAR && field.array_length > 1) {
+			/* not necessarily null terminated */
+			out.append("%s%s: \"%.*s\"\n", prefix, field.name, (int)strnlen((const char *)value, field.array_length),
+				   (const char *)value);
+			continue;
+		}
+
+		if (field.type == ORB_FIELD_STRUCT) {
+			const struct orb_fields *nested = field.nested();
+
+			for (unsigned j = 0; j < field.array_length; j++) {
+				char nested_prefix[64];
+
+				if (field.array_length > 1) {
+					snprintf(nested_prefix, sizeof(nested_prefix), "%s%s[%u].", prefix, field.name, j);
+
+				} else {
+					snprintf(nested_prefix, sizeof(nested_prefix), "%s%s.", prefix, field.name);
+				}
+
+				print_fields(out, nested_prefix, nested, value + j * nested->size);
+			}
+
+			continue;
+		}
+
+		size_t element_size = orb_field_type_size(field.type);
+
+		for (unsigned j = 0; j < field.array_length; j++) {
+			if (field.array_length > 1) {
+				out.append("%s%s[%u]: ", prefix, field.name, j);
+
+			} else {
+				out.append("%s%s: ", prefix, field.name);
+			}
+
+			print_value(out, field.type, value + j * element_size);
+			out.append("\n");
+		}
+	}
+}
+
+}
+
+int orb_print_message(char *buf, size_t size, const struct orb_fields *fields, const void *data)
+{
+	if (buf == nullptr || size == 0) {
+		return 0;
+	}
+
+	buf[0] = '\0';
+	print_buffer out = { buf, size, 0 };
+	print_fields(out, "", fields, (const uint8_t *)data);
+
+	return (out.len < size) ? out.len : size - 1;
+}
@@ -32,6 +32,8 @@
  ****************************************************************************/
 
 #include <string.h>
+#include <stdlib.h>
+#include <px4_tasks.h>
 #include "uORBDevices.hpp"
 #include "uORB.h"
 #include "uORBCommon.hpp"
@@ -45,7 +47,7 @@ extern "C" { __EXPORT int uorb_main(int argc, char *argv[]); }
 static uORB::DeviceMaster *g_dev = nullptr;
 static void usage()
 {
-	PX4_INFO("Usage: uorb 'start', 'test', 'latency_test' or 'status'");
+	PX4_INFO("Usage: uorb 'start', 'test', 'latency_test', 'namespace <n>' or 'status'");
 }
 
 
@@ -116,6 +118,27 @@ uorb_main(int argc, char *argv[])
 		}
 	}
 
+#endif
+
+#ifdef __PX4_POSIX
+
+	/*
+	 * Select the topic namespace for the tasks started from this shell.
+	 */
+	if (!strcmp(argv[1], "namespace")) {
+		if (argc > 2) {
+			int ret = px4_task_set_namespace(strtol(argv[2], nullptr, 0));
+
+			if (ret != OK) {
+				PX4_ERR("namespace must be between 0 and %d", PX4_MAX_TASK_NAMESPACES - 1);
+				return ret;
+			}
+		}
+
+		PX4_INFO("namespace %d", px4_task_get_namespace());
+		return OK;
+	}
+
 #endif
 
 	/*
@@ -129,6 +152,12 @@ uorb_main(int argc, char *argv[])
 			PX4_INFO("uorb is not running");
 		}
 
+#ifdef __PX4_POSIX
+		PX4_INFO("namespace %d", px4_task_get_namespace());
+
+		/* forwarding of the topics shared with a remote processor or process */
+		uORB::DeviceMaster::print_remote_status();
+#endif
 		return OK;
 	}
 
@@ -42,6 +42,9 @@
 #else
 #include <string>
 #include <set>
+#include <vector>
+#include <pthread.h>
+#include <px4_workqueue.h>
 #define ORBSet std::set<std::string>
 #endif
 
@@ -312,6 +315,19 @@ public:
 	 */
 	bool is_remote_subscriber_present(const char *messageName);
 
+#ifndef __PX4_NUTTX
+	/**
+	 * Add or remove a node from the topics forwarded to the remote at a
+	 * limited rate. The due updates of these topics are collected every
+	 * tick and sent in a single transfer.
+	 * @param node
+	 *  The node the remote subscribed to.
+	 * @param limited
+	 *  true if the remote asked for a limited rate.
+	 */
+	void set_remote_rate_limited(uORB::DeviceNode *node, bool limited);
+#endif
+
 private: // class methods
 	/**
 	 * Advertise a node; don't consider it an error if the node has
@@ -351,9 +367,30 @@ private: // data members
 	uORBCommunicator::IChannel *_comm_channel;
 	ORBSet _remote_subscriber_topics;
 
+#ifndef __PX4_NUTTX
+	static const unsigned REMOTE_TICK_US = 5000; ///< interval of the batched transfers to the remote
+
+	pthread_mutex_t _remote_mutex; ///< protects the rate-limited list and the batch
+	std::vector<uORB::DeviceNode *> _remote_rate_limited;
+	std::vector<uORB::DeviceNode *> _remote_batch_nodes;
+	std::vector<const char *> _remote_batch_names;
+	std::vector<int32_t> _remote_batch_lengths;
+	std::vector<uint8_t *> _remote_batch_data;
+	struct work_s _remote_work;
+	bool _remote_work_scheduled;
+#endif
+
 private: //class methods
 	Manager();
 
+#ifndef __PX4_NUTTX
+	/**
+	 * Send the due updates of the rate-limited topics in one transfer.
+	 */
+	void remote_flush();
+	static void remote_flush_trampoline(void *arg);
+#endif
+
 	/**
 	   * Interface to process a received AddSubscription from remote.
 	   * @param messageName
@@ -41,6 +41,8 @@
 #include "uORBManager.hpp"
 #include "px4_config.h"
 #include "uORBDevices.hpp"
+#include <algorithm>
+#include <drivers/drv_hrt.h>
 
 
 //=========================  Static initializations =================
@@ -60,8 +62,11 @@ uORB::Manager *uORB::Manager::get_instance()
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 uORB::Manager::Manager()
-	: _comm_channel(nullptr)
+	: _comm_channel(nullptr),
+	  _remote_work{},
+	  _remote_work_scheduled(false)
 {
+	pthread_mutex_init(&_remote_mutex, nullptr);
 }
 
 int uORB::Manager::orb_exists(const struct orb_metadata *meta, int instance)
@@ -415,6 +420,78 @@ int16_t uORB::Manager::process_received_message(const char *messageName,
 	return rc;
 }
 
+void uORB::Manager::set_remote_rate_limited(uORB::DeviceNode *node, bool limited)
+{
+	pthread_mutex_lock(&_remote_mutex);
+
+	auto it = std::find(_remote_rate_limited.begin(), _remote_rate_limited.end(), node);
+
+	if (limited && it == _remote_rate_limited.end()) {
+		_remote_rate_limited.push_back(node);
+
+		if (!_remote_work_scheduled) {
+			_remote_work_scheduled = true;
+			work_queue(LPWORK, &_remote_work, (worker_t)&uORB::Manager::remote_flush_trampoline, this,
+				   USEC2TICK(REMOTE_TICK_US));
+		}
+
+	} else if (!limited && it != _remote_rate_limited.end()) {
+		_remote_rate_limited.erase(it);
+	}
+
+	pthread_mutex_unlock(&_remote_mutex);
+}
+
+void uORB::Manager::remote_flush_trampoline(void *arg)
+{
+	((uORB::Manager *)arg)->remote_flush();
+}
+
+void uORB::Manager::remote_flush()
+{
+	pthread_mutex_lock(&_remote_mutex);
+
+	_remote_batch_nodes.clear();
+	_remote_batch_names.clear();
+	_remote_batch_lengths.clear();
+	_remote_batch_data.clear();
+
+	hrt_abstime now = hrt_absolute_time();
+
+	for (auto node : _remote_rate_limited) {
+		uint8_t *data = node->take_remote_update(now);
+
+		if (data != nullptr) {
+			_remote_batch_nodes.push_back(node);
+			_remote_batch_names.push_back(node->get_meta()->o_name);
+			_remote_batch_lengths.push_back(node->get_meta()->o_size);
+			_remote_batch_data.push_back(data);
+		}
+	}
+
+	int32_t count = _remote_batch_nodes.size();
+
+	if (count > 0) {
+		int32_t sent = (_comm_channel != nullptr) ?
+			       _comm_channel->send_messages(count, _remote_batch_names.data(), _remote_batch_lengths.data(),
+					       _remote_batch_data.data()) : 0;
+
+		for (int32_t i = 0; i < count; i++) {
+			_remote_batch_nodes[i]->remote_update_done(i < sent);
+		}
+	}
+
+	/* keep ticking while there are rate-limited topics */
+	_remote_work_scheduled = !_remote_rate_limited.empty();
+
+	if (_remote_work_scheduled) {
+		work_queue(LPWORK, &_remote_work, (worker_t)&uORB::Manager::remote_flush_trampoline, this,
+			   USEC2TICK(REMOTE_TICK_US));
+	}
+
+	pthread_mutex_unlock(&_remote_mutex);
+}
+
 bool uORB::Manager::is_remote_subscriber_present(const char *messageName)
 {
 	return (_remote_subscriber_topics.find(messageName) != _remote_subscriber_topics.end());
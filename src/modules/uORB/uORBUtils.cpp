@@ -34,6 +34,32 @@
 #include "uORBUtils.hpp"
 #include <stdio.h>
 #include <errno.h>
+#include <px4_tasks.h>
+
+int uORB::Utils::node_mkroot(char *buf, unsigned buflen, Flavor f)
+{
+	const char *root = (f == PUBSUB) ? "obj" : "param";
+	unsigned len;
+
+#ifdef __PX4_POSIX
+	/* tasks of additional vehicles hosted in the same process get their own topic tree */
+	int ns = px4_task_get_namespace();
+
+	if (ns > 0) {
+		len = snprintf(buf, buflen, "/%s/v%d/", root, ns);
+
+	} else
+#endif
+	{
+		len = snprintf(buf, buflen, "/%s/", root);
+	}
+
+	if (len >= buflen) {
+		return -ENAMETOOLONG;
+	}
+
+	return len;
+}
 
 int uORB::Utils::node_mkpath
 (
@@ -51,9 +77,13 @@ int uORB::Utils::node_mkpath
 		index = *instance;
 	}
 
-	len = snprintf(buf, orb_maxpath, "/%s/%s%d",
-		       (f == PUBSUB) ? "obj" : "param",
-		       meta->o_name, index);
+	int root_len = node_mkroot(buf, orb_maxpath, f);
+
+	if (root_len < 0) {
+		return root_len;
+	}
+
+	len = root_len + snprintf(buf + root_len, orb_maxpath - root_len, "%s%d", meta->o_name, index);
 
 	if (len >= orb_maxpath) {
 		return -ENAMETOOLONG;
@@ -71,8 +101,13 @@ int uORB::Utils::node_mkpath(char *buf, Flavor f,
 
 	unsigned index = 0;
 
-	len = snprintf(buf, orb_maxpath, "/%s/%s%d", (f == PUBSUB) ? "obj" : "param",
-		       orbMsgName, index);
+	int root_len = node_mkroot(buf, orb_maxpath, f);
+
+	if (root_len < 0) {
+		return root_len;
+	}
+
+	len = root_len + snprintf(buf + root_len, orb_maxpath - root_len, "%s%d", orbMsgName, index);
 
 	if (len >= orb_maxpath) {
 		return -ENAMETOOLONG;
@@ -57,6 +57,16 @@ public:
 	 */
 	static int node_mkpath(char *buf, Flavor f, const char *orbMsgName);
 
+	/**
+	 * Generate the root directory of the topic tree for the calling task.
+	 *
+	 * On POSIX this depends on the namespace of the calling task (see
+	 * px4_task_set_namespace()), so that several vehicles can be hosted
+	 * in one process with isolated topics.
+	 * @return the length of the root path on success, negative errno otherwise.
+	 */
+	static int node_mkroot(char *buf, unsigned buflen, Flavor f);
+
 };
 
 #endif // _uORBUtils_hpp_
@@ -63,6 +63,7 @@
 #include <simulator/simulator.h>
 
 #include <systemlib/perf_counter.h>
+#include <systemlib/latency.h>
 #include <systemlib/err.h>
 #include <systemlib/conversions.h>
 
@@ -172,7 +173,6 @@ private:
 	perf_counter_t		_sample_perf;
 	perf_counter_t		_good_transfers;
 	perf_counter_t		_reset_retries;
-	perf_counter_t		_controller_latency_perf;
 
 	Integrator _accel_int;
 	Integrator _gyro_int;
@@ -330,7 +330,6 @@ GYROSIM::GYROSIM(const char *path_accel, const char *path_gyro, enum Rotation ro
 	_sample_perf(perf_alloc(PC_ELAPSED, "gyrosim_read")),
 	_good_transfers(perf_alloc(PC_COUNT, "gyrosim_good_transfers")),
 	_reset_retries(perf_alloc(PC_COUNT, "gyrosim_reset_retries")),
-	_controller_latency_perf(perf_alloc_once(PC_ELAPSED, "ctrl_latency")),
 	_accel_int(1000000 / GYROSIM_ACCEL_DEFAULT_RATE, true),
 	_gyro_int(1000000 / GYROSIM_GYRO_DEFAULT_RATE, true),
 	_rotation(rotation),
@@ -1040,6 +1039,9 @@ GYROSIM::_measure()
 	/* start measuring */
 	perf_begin(_sample_perf);
 
+	/* the timer callout is the time the sample is taken, the bus transfer adds to the driver latency */
+	const hrt_abstime timestamp_sample = hrt_absolute_time();
+
 	/*
 	 * Fetch the full set of measurements from the GYROSIM in one pass.
 	 */
@@ -1058,7 +1060,7 @@ GYROSIM::_measure()
 	gyro_report	grb = {};
 
 	// for now use local time but this should be the timestamp of the simulator
-	grb.timestamp = hrt_absolute_time();
+	grb.timestamp = timestamp_sample;
 	arb.timestamp = grb.timestamp;
 	// report the error count as the sum of the number of bad
 	// transfers and bad register reads. This allows the higher
@@ -1140,8 +1142,6 @@ GYROSIM::_measure()
 		_gyro->parent_poll_notify();
 
 		if (!(_pub_blocked)) {
-			/* log the time of this report */
-			perf_begin(_controller_latency_perf);
 			/* publish it */
 			orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
 		}
@@ -1154,6 +1154,7 @@ GYROSIM::_measure()
 		if (!(_pub_blocked)) {
 			/* publish it */
 			orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+			latency_record(LATENCY_STAGE_DRIVER, grb.timestamp);
 		}
 	}
 
@@ -41,6 +41,7 @@
 #include <px4_posix.h>
 #include <px4_defines.h>
 #include <px4_workqueue.h>
+#include <px4_tasks.h>
 #include <drivers/drv_hrt.h>
 #include <semaphore.h>
 #include <time.h>
@@ -437,6 +438,7 @@ hrt_call_internal(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime inte
 	entry->period = interval;
 	entry->callout = callout;
 	entry->arg = arg;
+	entry->ns = px4_task_get_namespace();
 
 	hrt_call_enter(entry);
 	hrt_unlock();
@@ -525,7 +527,11 @@ hrt_call_invoke(void)
 			hrt_unlock();
 
 			//PX4_INFO("call %p: %p(%p)", call, call->callout, call->arg);
+			/* run the callout in the namespace of the task that scheduled it */
+			int prev_ns = px4_task_get_namespace();
+			px4_task_set_namespace(call->ns);
 			call->callout(call->arg);
+			px4_task_set_namespace(prev_ns);
 
 			hrt_lock();
 		}
@@ -71,14 +71,19 @@ struct task_entry {
 	pthread_t pid;
 	std::string name;
 	bool isused;
-	task_entry() : isused(false) {}
+	int ns;
+	task_entry() : isused(false), ns(0) {}
 };
 
 static task_entry taskmap[PX4_MAX_TASKS] = {};
 
+/* namespace of the calling thread, inherited by the tasks it spawns */
+static __thread int _task_namespace = 0;
+
 typedef struct {
 	px4_main_t entry;
 	const char *name;
+	int ns;
 	int argc;
 	char *argv[];
 	// strings are allocated after the
@@ -100,6 +105,8 @@ static void *entry_adapter(void *ptr)
 		PX4_ERR("px4_task_spawn_cmd: failed to set name of thread %d %d\n", rv, errno);
 	}
 
+	_task_namespace = data->ns;
+
 	data->entry(data->argc, data->argv);
 	free(ptr);
 	PX4_DEBUG("Before px4_task_exit");
@@ -152,6 +159,7 @@ px4_task_t px4_task_spawn_cmd(const char *name, int scheduler, int priority, int
 
 	taskdata->name = name;
 	taskdata->entry = entry;
+	taskdata->ns = _task_namespace;
 	taskdata->argc = argc;
 
 	for (i = 0; i < argc; i++) {
@@ -219,6 +227,7 @@ px4_task_t px4_task_spawn_cmd(const char *name, int scheduler, int priority, int
 		if (taskmap[i].isused == false) {
 			taskmap[i].name = name;
 			taskmap[i].isused = true;
+			taskmap[i].ns = _task_namespace;
 			taskid = i;
 			break;
 		}
@@ -339,7 +348,7 @@ void px4_show_tasks()
 
 	for (idx = 0; idx < PX4_MAX_TASKS; idx++) {
 		if (taskmap[idx].isused) {
-			PX4_INFO("   %-10s %lu", taskmap[idx].name.c_str(), (unsigned long)taskmap[idx].pid);
+			PX4_INFO("   %-10s %lu ns:%d", taskmap[idx].name.c_str(), (unsigned long)taskmap[idx].pid, taskmap[idx].ns);
 			count++;
 		}
 	}
@@ -362,6 +371,21 @@ bool px4_task_is_running(const char *taskname)
 
 	return false;
 }
+int px4_task_set_namespace(int ns)
+{
+	if (ns < 0 || ns >= PX4_MAX_TASK_NAMESPACES) {
+		return -EINVAL;
+	}
+
+	_task_namespace = ns;
+	return 0;
+}
+
+int px4_task_get_namespace(void)
+{
+	return _task_namespace;
+}
+
 __BEGIN_DECLS
 
 unsigned long px4_getpid()
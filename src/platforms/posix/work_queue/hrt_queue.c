@@ -47,6 +47,7 @@
 #include <semaphore.h>
 #include <drivers/drv_hrt.h>
 #include <px4_workqueue.h>
+#include <px4_tasks.h>
 #include "hrt_work.h"
 
 /****************************************************************************
@@ -110,6 +111,7 @@ int hrt_work_queue(struct work_s *work, worker_t worker, void *arg, uint32_t del
 	work->worker = worker;           /* Work callback */
 	work->arg    = arg;              /* Callback argument */
 	work->delay  = delay;            /* Delay until work performed */
+	work->ns     = px4_task_get_namespace(); /* Namespace the worker runs in */
 
 	/* Now, time-tag that entry and put it in the work queue.  This must be
 	 * done with interrupts disabled.  This permits this function to be called
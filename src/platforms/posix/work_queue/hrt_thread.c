@@ -47,6 +47,7 @@
 #include <unistd.h>
 #include <queue.h>
 #include <px4_workqueue.h>
+#include <px4_tasks.h>
 #include <drivers/drv_hrt.h>
 #include "hrt_work.h"
 
@@ -115,6 +116,7 @@ static void hrt_work_process()
 	volatile struct work_s *work;
 	worker_t  worker;
 	void *arg;
+	int ns;
 	uint64_t elapsed;
 	uint32_t remaining;
 	uint32_t next;
@@ -160,6 +162,7 @@ static void hrt_work_process()
 
 			worker = work->worker;
 			arg    = work->arg;
+			ns     = work->ns;
 
 			/* Mark the work as no longer being queued */
 
@@ -176,7 +179,11 @@ static void hrt_work_process()
 				PX4_BACKTRACE();
 
 			} else {
+				/* run the worker in the namespace of the task that queued it */
+				int prev_ns = px4_task_get_namespace();
+				px4_task_set_namespace(ns);
 				worker(arg);
+				px4_task_set_namespace(prev_ns);
 			}
 
 			/* Now, unfortunately, since we re-enabled interrupts we don't
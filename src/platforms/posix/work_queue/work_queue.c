@@ -46,6 +46,7 @@
 #include <stdio.h>
 #include <semaphore.h>
 #include <px4_workqueue.h>
+#include <px4_tasks.h>
 #include "work_lock.h"
 
 #ifdef CONFIG_SCHED_WORKQUEUE
@@ -114,6 +115,7 @@ int work_queue(int qid, struct work_s *work, worker_t worker, void *arg, uint32_
 	work->worker = worker;           /* Work callback */
 	work->arg    = arg;              /* Callback argument */
 	work->delay  = delay;            /* Delay until work performed */
+	work->ns     = px4_task_get_namespace(); /* Namespace the worker runs in */
 
 	/* Now, time-tag that entry and put it in the work queue.  This must be
 	 * done with interrupts disabled.  This permits this function to be called
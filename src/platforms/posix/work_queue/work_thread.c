@@ -47,6 +47,7 @@
 #include <queue.h>
 #include <pthread.h>
 #include <px4_workqueue.h>
+#include <px4_tasks.h>
 #include <drivers/drv_hrt.h>
 #include "work_lock.h"
 
@@ -95,6 +96,7 @@ static void work_process(struct wqueue_s *wqueue, int lock_id)
 	volatile struct work_s *work;
 	worker_t  worker;
 	void *arg;
+	int ns;
 	uint64_t elapsed;
 	uint32_t remaining;
 	uint32_t next;
@@ -130,6 +132,7 @@ static void work_process(struct wqueue_s *wqueue, int lock_id)
 
 			worker = work->worker;
 			arg    = work->arg;
+			ns     = work->ns;
 
 			/* Mark the work as no longer being queued */
 
@@ -145,7 +148,11 @@ static void work_process(struct wqueue_s *wqueue, int lock_id)
 				PX4_WARN("MESSED UP: worker = 0\n");
 
 			} else {
+				/* run the worker in the namespace of the task that queued it */
+				int prev_ns = px4_task_get_namespace();
+				px4_task_set_namespace(ns);
 				worker(arg);
+				px4_task_set_namespace(prev_ns);
 			}
 
 			/* Now, unfortunately, since we re-enabled interrupts we don't
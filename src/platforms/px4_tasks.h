@@ -132,6 +132,21 @@ __EXPORT bool px4_task_is_running(const char *taskname);
 #ifdef __PX4_POSIX
 /** set process (and thread) options */
 __EXPORT int px4_prctl(int option, const char *arg2, unsigned pid);
+
+/** Maximum number of task namespaces (vehicle instances) hosted by one process */
+#define PX4_MAX_TASK_NAMESPACES 16
+
+/**
+ * Set the namespace of the calling task.
+ *
+ * Tasks spawned afterwards by the calling task inherit its namespace. The namespace
+ * selects an isolated set of uORB topics, so several vehicles can share one process.
+ * Namespace 0 is the default and maps to the regular topic paths.
+ */
+__EXPORT int px4_task_set_namespace(int ns);
+
+/** Get the namespace of the calling task */
+__EXPORT int px4_task_get_namespace(void);
 #endif
 
 __END_DECLS
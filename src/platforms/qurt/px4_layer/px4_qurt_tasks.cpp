@@ -385,6 +385,17 @@ int px4_sem_timedwait(px4_sem_t *sem, const struct timespec *ts)
 	return 0;
 }
 
+int px4_task_set_namespace(int ns)
+{
+	/* a single vehicle per DSP image, only the default namespace is supported */
+	return (ns == 0) ? 0 : -ENOTSUP;
+}
+
+int px4_task_get_namespace(void)
+{
+	return 0;
+}
+
 int px4_prctl(int option, const char *arg2, unsigned pid)
 {
 	int rv;
@@ -1,19 +0,0 @@
-/*
- * eigen_math.h
- *
- *  Created on: Aug 25, 2014
- *      Author: roman
- */
-
-#ifndef EIGEN_MATH_H_
-#define EIGEN_MATH_H_
-
-
-struct eigen_matrix_instance {
-	int numRows;
-	int numCols;
-	float *pData;
-};
-
-
-#endif /* EIGEN_MATH_H_ */
@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file latency.c
+ * Show the latency of the control pipeline stages
+ */
+
+#include <px4_config.h>
+#include <px4_log.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <systemlib/latency.h>
+#include <systemlib/pipeline.h>
+
+__EXPORT int latency_main(int argc, char *argv[]);
+
+static void
+usage(void)
+{
+	PX4_INFO("usage: latency [status [-v] | reset]\n"
+		 "   -v   also print the histograms");
+}
+
+int
+latency_main(int argc, char *argv[])
+{
+	if (argc < 2 || strcmp(argv[1], "status") == 0) {
+		bool verbose = (argc > 2 && strcmp(argv[2], "-v") == 0);
+		latency_print(verbose);
+		pipeline_print();
+		fflush(stdout);
+		return 0;
+	}
+
+	if (strcmp(argv[1], "reset") == 0) {
+		latency_reset();
+		return 0;
+	}
+
+	usage();
+	return 1;
+}
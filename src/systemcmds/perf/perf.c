@@ -73,9 +73,29 @@ int perf_main(int argc, char *argv[])
 			perf_print_latency(0 /* stdout */);
 			fflush(stdout);
 			return 0;
+
+		} else if (strcmp(argv[1], "--json") == 0) {
+			perf_print_all_json(0 /* stdout */);
+			fflush(stdout);
+			return 0;
+
+		} else if (strcmp(argv[1], "publish") == 0 && argc > 2) {
+			if (strcmp(argv[2], "stop") == 0) {
+				perf_publish_stop();
+				return 0;
+			}
+
+			for (int i = 2; i < argc; i++) {
+				if (perf_publish_add(argv[i]) != 0) {
+					printf("perf: can't publish %s\n", argv[i]);
+					return -1;
+				}
+			}
+
+			return 0;
 		}
 
-		printf("Usage: perf [reset | latency]\n");
+		printf("Usage: perf [reset | latency | --json | publish <name>... | publish stop]\n");
 		return -1;
 	}
 
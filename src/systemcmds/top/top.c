@@ -40,6 +40,8 @@
  */
 
 #include <px4_config.h>
+#include <px4_defines.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdbool.h>
@@ -89,7 +91,11 @@ top_main(int argc, char *argv[])
 
 			if (ret > 0) {
 
-				read(0, &c, 1);
+				/* without a terminal, e.g. in daemon mode, stdin ends and top runs until stopped */
+				if (read(0, &c, 1) != 1) {
+					usleep(200000);
+					continue;
+				}
 
 				switch (c) {
 				case 0x03: // ctrl-c
@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file trace.c
+ * Record the perf counter events of all threads and write them as a Chrome trace
+ */
+
+#include <px4_config.h>
+#include <px4_log.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <systemlib/trace_buffer.h>
+
+__EXPORT int trace_main(int argc, char *argv[]);
+
+static void
+usage(void)
+{
+	PX4_INFO("usage: trace {start|stop|status|dump [file]}\n"
+		 "   dump stops the trace and writes it to %s by default,\n"
+		 "   open it in chrome://tracing or ui.perfetto.dev", TRACE_DEFAULT_PATH);
+}
+
+int
+trace_main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+
+	if (strcmp(argv[1], "start") == 0) {
+		if (trace_start() != 0) {
+			PX4_ERR("no memory for the trace");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (strcmp(argv[1], "stop") == 0) {
+		trace_stop();
+		return 0;
+	}
+
+	if (strcmp(argv[1], "status") == 0) {
+		trace_print_status();
+		fflush(stdout);
+		return 0;
+	}
+
+	if (strcmp(argv[1], "dump") == 0) {
+		const char *path = (argc > 2) ? argv[2] : TRACE_DEFAULT_PATH;
+		int count = trace_dump(path);
+
+		if (count < 0) {
+			PX4_ERR("writing %s failed", path);
+			return 1;
+		}
+
+		PX4_INFO("%d events written to %s", count, path);
+		return 0;
+	}
+
+	usage();
+	return 1;
+}
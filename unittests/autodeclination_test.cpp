@@ -7,6 +7,7 @@
 #include <drivers/drv_hrt.h>
 #include <geo/geo.h>
 #include <px4iofirmware/px4io.h>
+#include <px4_log.h>
 #include <systemlib/err.h>
 #include <systemlib/mixer/mixer.h>
 
@@ -16,3 +17,142 @@ TEST(AutoDeclinationTest, AutoDeclination)
 {
 	ASSERT_NEAR(get_mag_declination(47.0, 8.0), 0.6, 0.5) << "declination differs more than 1 degree";
 }
+
+/* approximate field in 2015 */
+TEST(AutoDeclinationTest, Field)
+{
+	static const struct {
+		float lat;
+		float lon;
+		float declination;
+		float inclination;
+		float strength;
+	} references[] = {
+		{ 47.4f, 8.5f, 1.8f, 63.6f, 0.477f },		// Zurich
+		{ 40.0f, -105.3f, 8.6f, 67.0f, 0.527f },	// Boulder
+		{ -33.9f, 151.2f, 12.7f, -64.6f, 0.573f },	// Sydney
+		{ 0.0f, 0.0f, -5.6f, -30.0f, 0.320f },
+	};
+
+	for (unsigned i = 0; i < sizeof(references) / sizeof(references[0]); i++) {
+		struct geo_mag_field_s field;
+		ASSERT_EQ(0, get_mag_field(nullptr, references[i].lat, references[i].lon, &field));
+
+		EXPECT_NEAR(field.declination, references[i].declination, 2.0f) << i;
+		EXPECT_NEAR(field.inclination, references[i].inclination, 2.0f) << i;
+		EXPECT_NEAR(field.strength, references[i].strength, 0.02f) << i;
+
+		EXPECT_FLOAT_EQ(get_mag_declination(references[i].lat, references[i].lon), field.declination);
+		EXPECT_FLOAT_EQ(get_mag_inclination(references[i].lat, references[i].lon), field.inclination);
+		EXPECT_FLOAT_EQ(get_mag_strength(references[i].lat, references[i].lon), field.strength);
+	}
+}
+
+TEST(AutoDeclinationTest, Continuity)
+{
+	/* no jumps at the cell borders, also on the negative side */
+	for (float lat = -55.0f; lat <= 55.0f; lat += 10.0f) {
+		for (float lon = -175.0f; lon <= 165.0f; lon += 10.0f) {
+			const float border_lat = lat + 5.0f;
+			const float border_lon = lon + 5.0f;
+			struct geo_mag_field_s below, above;
+
+			get_mag_field(nullptr, border_lat - 1e-3f, lon, &below);
+			get_mag_field(nullptr, border_lat + 1e-3f, lon, &above);
+			ASSERT_NEAR(below.declination, above.declination, 0.05f) << border_lat << " " << lon;
+			ASSERT_NEAR(below.inclination, above.inclination, 0.05f) << border_lat << " " << lon;
+
+			get_mag_field(nullptr, lat, border_lon - 1e-3f, &below);
+			get_mag_field(nullptr, lat, border_lon + 1e-3f, &above);
+			ASSERT_NEAR(below.declination, above.declination, 0.05f) << lat << " " << border_lon;
+			ASSERT_NEAR(below.strength, above.strength, 0.001f) << lat << " " << border_lon;
+		}
+	}
+}
+
+TEST(AutoDeclinationTest, Bounds)
+{
+	struct geo_mag_field_s field;
+
+	ASSERT_EQ(-1, get_mag_field(nullptr, 91.0f, 0.0f, &field));
+	ASSERT_EQ(0.0f, field.declination);
+	ASSERT_EQ(0.0f, field.strength);
+	ASSERT_EQ(-1, get_mag_field(nullptr, 0.0f, -181.0f, &field));
+	ASSERT_EQ(-1, get_mag_field(nullptr, NAN, 0.0f, &field));
+	ASSERT_EQ(0.0f, get_mag_declination(0.0f, 200.0f));
+
+	/* the table ends at +-60 degrees, beyond it the last row holds */
+	struct geo_mag_field_s edge;
+	ASSERT_EQ(0, get_mag_field(nullptr, 60.0f, 25.0f, &edge));
+	ASSERT_EQ(0, get_mag_field(nullptr, 85.0f, 25.0f, &field));
+	ASSERT_FLOAT_EQ(field.declination, edge.declination);
+	ASSERT_FLOAT_EQ(field.strength, edge.strength);
+
+	ASSERT_EQ(0, get_mag_field(nullptr, -60.0f, -25.0f, &edge));
+	ASSERT_EQ(0, get_mag_field(nullptr, -90.0f, -25.0f, &field));
+	ASSERT_FLOAT_EQ(field.inclination, edge.inclination);
+
+	ASSERT_EQ(0, get_mag_field(nullptr, 90.0f, 180.0f, &field));
+	ASSERT_EQ(0, get_mag_field(nullptr, -90.0f, -180.0f, &field));
+}
+
+TEST(AutoDeclinationTest, Cache)
+{
+	struct geo_mag_cache_s cache;
+	geo_mag_cache_init(&cache);
+
+	/* a flight across several cells gives the same results with and without the cache */
+	for (unsigned i = 0; i < 10000; i++) {
+		float lat = -70.0f + i * 0.014f;
+		float lon = 170.0f - i * 0.035f;
+		struct geo_mag_field_s cached, direct;
+
+		ASSERT_EQ(0, get_mag_field(&cache, lat, lon, &cached));
+		ASSERT_EQ(0, get_mag_field(nullptr, lat, lon, &direct));
+		ASSERT_EQ(0, memcmp(&cached, &direct, sizeof(cached))) << lat << " " << lon;
+	}
+
+	/* out of range positions leave the cache alone */
+	struct geo_mag_cache_s before = cache;
+	struct geo_mag_field_s field;
+	ASSERT_EQ(-1, get_mag_field(&cache, 100.0f, 0.0f, &field));
+	ASSERT_EQ(0, memcmp(&before, &cache, sizeof(cache)));
+}
+
+TEST(AutoDeclinationTest, Benchmark)
+{
+	const unsigned count = 1000000;
+	double sum_single = 0.0;
+	double sum_cache = 0.0;
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < count; i++) {
+		/* a vehicle crossing a few cells */
+		float lat = 47.0f + (i % 1000) * 0.01f;
+		float lon = 8.0f + (i % 1000) * 0.02f;
+		sum_single += get_mag_declination(lat, lon) + get_mag_inclination(lat, lon) + get_mag_strength(lat, lon);
+	}
+
+	hrt_abstime single_time = hrt_absolute_time() - start;
+
+	struct geo_mag_cache_s cache;
+	geo_mag_cache_init(&cache);
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < count; i++) {
+		float lat = 47.0f + (i % 1000) * 0.01f;
+		float lon = 8.0f + (i % 1000) * 0.02f;
+		struct geo_mag_field_s field;
+		get_mag_field(&cache, lat, lon, &field);
+		sum_cache += field.declination + field.inclination + field.strength;
+	}
+
+	hrt_abstime cache_time = hrt_absolute_time() - start;
+
+	PX4_INFO("%u lookups of all three values: %.0f lookups/s single calls, %.0f lookups/s with cache",
+		 count, count * 1e6 / single_time, count * 1e6 / cache_time);
+
+	/* both paths compute the same values */
+	ASSERT_DOUBLE_EQ(sum_single, sum_cache);
+}
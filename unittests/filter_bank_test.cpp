@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <drivers/drv_hrt.h>
+#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/BiquadFilterBank.hpp>
+#include <systemlib/err.h>
+
+#include "gtest/gtest.h"
+
+/* three IMUs with accel and gyro each */
+static const unsigned bench_channels = 18;
+
+static float random_sample()
+{
+	return (float)rand() / (float)RAND_MAX * 20.0f - 10.0f;
+}
+
+TEST(FilterBankTest, MatchesLowPassFilter2p)
+{
+	const float sample_freq = 1000.0f;
+	const float cutoff_freq = 30.0f;
+
+	math::LowPassFilter2p lpf[3] = {
+		math::LowPassFilter2p(sample_freq, cutoff_freq),
+		math::LowPassFilter2p(sample_freq, cutoff_freq),
+		math::LowPassFilter2p(sample_freq, cutoff_freq)
+	};
+	math::BiquadFilterBank<3> bank(sample_freq, cutoff_freq);
+
+	ASSERT_EQ(bank.get_num_sections(), 1u);
+	ASSERT_FLOAT_EQ(bank.get_cutoff_freq(), cutoff_freq);
+
+	for (unsigned k = 0; k < 5000; k++) {
+		float data[3];
+
+		for (unsigned i = 0; i < 3; i++) {
+			data[i] = random_sample();
+		}
+
+		float expected[3];
+
+		for (unsigned i = 0; i < 3; i++) {
+			expected[i] = lpf[i].apply(data[i]);
+		}
+
+		bank.apply(data);
+
+		for (unsigned i = 0; i < 3; i++) {
+			ASSERT_NEAR(data[i], expected[i], 1e-4f);
+		}
+	}
+}
+
+TEST(FilterBankTest, Disabled)
+{
+	math::BiquadFilterBank<3> bank(1000.0f, 0.0f);
+	float data[3] = { 1.0f, -2.0f, 3.0f };
+
+	bank.apply(data);
+
+	ASSERT_EQ(bank.get_num_sections(), 0u);
+	ASSERT_FLOAT_EQ(data[0], 1.0f);
+	ASSERT_FLOAT_EQ(data[1], -2.0f);
+	ASSERT_FLOAT_EQ(data[2], 3.0f);
+}
+
+TEST(FilterBankTest, Reset)
+{
+	math::BiquadFilterBank<2> bank(1000.0f, 30.0f);
+	bank.set_notch_frequency(1000.0f, 80.0f, 20.0f);
+
+	float data[2] = { 9.81f, -1.0f };
+	bank.reset(data);
+
+	ASSERT_NEAR(data[0], 9.81f, 1e-4f);
+	ASSERT_NEAR(data[1], -1.0f, 1e-4f);
+
+	/* a constant input must stay constant after a reset */
+	for (unsigned k = 0; k < 100; k++) {
+		data[0] = 9.81f;
+		data[1] = -1.0f;
+		bank.apply(data);
+		ASSERT_NEAR(data[0], 9.81f, 1e-3f);
+		ASSERT_NEAR(data[1], -1.0f, 1e-3f);
+	}
+}
+
+TEST(FilterBankTest, Notch)
+{
+	const float sample_freq = 4000.0f;
+	const float notch_freq = 200.0f;
+
+	math::BiquadFilterBank<1> bank;
+	bank.set_notch_frequency(sample_freq, notch_freq, 20.0f);
+	ASSERT_EQ(bank.get_num_sections(), 1u);
+
+	float peak = 0.0f;
+
+	for (unsigned k = 0; k < 8000; k++) {
+		float data[1] = { sinf(2.0f * M_PI_F * notch_freq * k / sample_freq) };
+		bank.apply(data);
+
+		/* skip the transient */
+		if (k > 4000) {
+			peak = fmaxf(peak, fabsf(data[0]));
+		}
+	}
+
+	ASSERT_LT(peak, 0.05f);
+
+	/* frequencies far away from the notch pass unattenuated */
+	bank.set_notch_frequency(sample_freq, notch_freq, 20.0f);
+	peak = 0.0f;
+
+	for (unsigned k = 0; k < 8000; k++) {
+		float data[1] = { sinf(2.0f * M_PI_F * 20.0f * k / sample_freq) };
+		bank.apply(data);
+
+		if (k > 4000) {
+			peak = fmaxf(peak, fabsf(data[0]));
+		}
+	}
+
+	ASSERT_GT(peak, 0.95f);
+}
+
+TEST(FilterBankTest, Retune)
+{
+	const float sample_freq = 1000.0f;
+
+	math::BiquadCoefficients extra;
+	ASSERT_TRUE(math::BiquadCoefficients::lowpass(extra, sample_freq, 100.0f));
+
+	/* the added section is kept, whatever happens to the configured ones */
+	math::BiquadFilterBank<2, 3> bank(sample_freq, 30.0f);
+	ASSERT_TRUE(bank.add_section(extra));
+	ASSERT_TRUE(bank.set_notch_frequency(sample_freq, 80.0f, 20.0f));
+	ASSERT_EQ(bank.get_num_sections(), 3u);
+	ASSERT_FALSE(bank.add_section(extra));
+
+	ASSERT_TRUE(bank.set_cutoff_frequency(sample_freq, 0.0f));
+	ASSERT_TRUE(bank.set_notch_frequency(sample_freq, 0.0f, 20.0f));
+	ASSERT_EQ(bank.get_num_sections(), 1u);
+
+	/* only the added section is left */
+	math::BiquadFilterBank<2, 3> reference;
+	reference.add_section(extra);
+
+	for (unsigned k = 0; k < 100; k++) {
+		float data[2] = { random_sample(), random_sample() };
+		float expected[2] = { data[0], data[1] };
+		reference.apply(expected);
+		bank.apply(data);
+		ASSERT_FLOAT_EQ(data[0], expected[0]);
+		ASSERT_FLOAT_EQ(data[1], expected[1]);
+	}
+
+	ASSERT_TRUE(bank.set_cutoff_frequency(sample_freq, 30.0f));
+	ASSERT_TRUE(bank.set_notch_frequency(sample_freq, 80.0f, 20.0f));
+	ASSERT_EQ(bank.get_num_sections(), 3u);
+
+	/* a full bank can't enable another section */
+	math::BiquadFilterBank<2, 2> full(sample_freq, 30.0f);
+	ASSERT_TRUE(full.add_section(extra));
+	ASSERT_FALSE(full.set_notch_frequency(sample_freq, 80.0f, 20.0f));
+	ASSERT_EQ(full.get_num_sections(), 2u);
+}
+
+TEST(FilterBankTest, RetuneKeepsState)
+{
+	const float sample_freq = 1000.0f;
+
+	math::BiquadFilterBank<1> bank(sample_freq, 30.0f);
+	bank.set_notch_frequency(sample_freq, 80.0f, 20.0f);
+
+	/* settle on a constant input */
+	for (unsigned k = 0; k < 1000; k++) {
+		float data[1] = { 5.0f };
+		bank.apply(data);
+	}
+
+	/* retuning causes no step */
+	bank.set_cutoff_frequency(sample_freq, 50.0f);
+	bank.set_notch_frequency(sample_freq, 120.0f, 30.0f);
+
+	for (unsigned k = 0; k < 100; k++) {
+		float data[1] = { 5.0f };
+		bank.apply(data);
+		ASSERT_NEAR(data[0], 5.0f, 1e-3f);
+	}
+
+	bank.set_cutoff_frequency(2.0f * sample_freq, 20.0f);
+
+	for (unsigned k = 0; k < 100; k++) {
+		float data[1] = { 5.0f };
+		bank.apply(data);
+		ASSERT_NEAR(data[0], 5.0f, 1e-3f);
+	}
+}
+
+static void benchmark(float sample_freq)
+{
+	const unsigned samples = (unsigned)sample_freq * 10;
+	const float cutoff_freq = 30.0f;
+
+	float *input = new float[samples * bench_channels];
+
+	for (unsigned k = 0; k < samples * bench_channels; k++) {
+		input[k] = random_sample();
+	}
+
+	math::LowPassFilter2p *lpf[bench_channels];
+
+	for (unsigned i = 0; i < bench_channels; i++) {
+		lpf[i] = new math::LowPassFilter2p(sample_freq, cutoff_freq);
+	}
+
+	math::BiquadFilterBank<bench_channels> bank(sample_freq, cutoff_freq);
+
+	float sum_lpf = 0.0f;
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < samples; k++) {
+		for (unsigned i = 0; i < bench_channels; i++) {
+			sum_lpf += lpf[i]->apply(input[k * bench_channels + i]);
+		}
+	}
+
+	hrt_abstime lpf_time = hrt_absolute_time() - start;
+
+	float sum_bank = 0.0f;
+	start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < samples; k++) {
+		float data[bench_channels];
+
+		for (unsigned i = 0; i < bench_channels; i++) {
+			data[i] = input[k * bench_channels + i];
+		}
+
+		bank.apply(data);
+
+		for (unsigned i = 0; i < bench_channels; i++) {
+			sum_bank += data[i];
+		}
+	}
+
+	hrt_abstime bank_time = hrt_absolute_time() - start;
+
+	PX4_INFO("%5.0f Hz, %u channels, 10 s of data: LowPassFilter2p %llu us, BiquadFilterBank %llu us",
+	         (double)sample_freq, bench_channels, (unsigned long long)lpf_time, (unsigned long long)bank_time);
+
+	/* both paths must compute the same result */
+	ASSERT_NEAR(sum_lpf, sum_bank, fabsf(sum_lpf) * 1e-3f + 1e-1f);
+
+	for (unsigned i = 0; i < bench_channels; i++) {
+		delete lpf[i];
+	}
+
+	delete[] input;
+}
+
+TEST(FilterBankTest, Benchmark)
+{
+	benchmark(1000.0f);
+	benchmark(4000.0f);
+	benchmark(8000.0f);
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <drivers/drv_hrt.h>
+#include <geo/geo.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+#define TEST_HOME_LAT		47.397742
+#define TEST_HOME_LON		8.545594
+
+static const unsigned point_count = 1000;
+static const unsigned bench_rounds = 200;
+
+/* points spread uniformly up to range meters around the reference, longitudes wrapped at the date line */
+static void make_points(double lat_0, double lon_0, float range, double *lat, double *lon)
+{
+	for (unsigned i = 0; i < point_count; i++) {
+		double r = range * sqrt((double)rand() / RAND_MAX);
+		double angle = 2.0 * M_PI * rand() / RAND_MAX;
+		double d_lat = r * cos(angle) / CONSTANTS_RADIUS_OF_EARTH;
+		double d_lon = r * sin(angle) / (CONSTANTS_RADIUS_OF_EARTH * cos(lat_0 * M_DEG_TO_RAD));
+		lat[i] = lat_0 + d_lat * M_RAD_TO_DEG;
+		lon[i] = lon_0 + d_lon * M_RAD_TO_DEG;
+
+		if (lon[i] > 180.0) {
+			lon[i] -= 360.0;
+
+		} else if (lon[i] < -180.0) {
+			lon[i] += 360.0;
+		}
+	}
+}
+
+static float max_error(const float *a, const float *b, unsigned count)
+{
+	float error = 0.0f;
+
+	for (unsigned i = 0; i < count; i++) {
+		error = fmaxf(error, fabsf(a[i] - b[i]));
+	}
+
+	return error;
+}
+
+/* bearings close to +-pi may come out on the other side */
+static float max_angle_error(const float *a, const float *b, unsigned count)
+{
+	float error = 0.0f;
+
+	for (unsigned i = 0; i < count; i++) {
+		error = fmaxf(error, fabsf(_wrap_pi(a[i] - b[i])));
+	}
+
+	return error;
+}
+
+class GeoBatchTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		srand(1);
+	}
+
+	/* the batch functions against the single point ones for all points within range */
+	void check(double lat_0, double lon_0, float range, float max_fast_error)
+	{
+		make_points(lat_0, lon_0, range, lat, lon);
+
+		struct map_projection_reference_s ref;
+		ASSERT_EQ(0, map_projection_init(&ref, lat_0, lon_0));
+
+		for (unsigned i = 0; i < point_count; i++) {
+			ASSERT_EQ(0, map_projection_project(&ref, lat[i], lon[i], &x_ref[i], &y_ref[i]));
+			dist_ref[i] = get_distance_to_next_waypoint(lat_0, lon_0, lat[i], lon[i]);
+			bearing_ref[i] = get_bearing_to_next_waypoint(lat_0, lon_0, lat[i], lon[i]);
+		}
+
+		ASSERT_EQ(0, map_projection_project_batch(&ref, lat, lon, x, y, point_count));
+		ASSERT_EQ(0.0f, max_error(x, x_ref, point_count));
+		ASSERT_EQ(0.0f, max_error(y, y_ref, point_count));
+
+		ASSERT_EQ(0, map_projection_project_batch_fast(&ref, lat, lon, x, y, point_count));
+		float x_error = max_error(x, x_ref, point_count);
+		float y_error = max_error(y, y_ref, point_count);
+
+		get_distance_to_waypoints(lat_0, lon_0, lat, lon, dist, bearing, point_count);
+		ASSERT_LT(max_error(dist, dist_ref, point_count), 1e-3f);
+		ASSERT_LT(max_angle_error(bearing, bearing_ref, point_count), 1e-6f);
+
+		get_distance_to_waypoints_fast(lat_0, lon_0, lat, lon, dist, bearing, point_count);
+		float dist_error = max_error(dist, dist_ref, point_count);
+		float bearing_error = max_angle_error(bearing, bearing_ref, point_count);
+
+		PX4_INFO("lat %5.1f, %6.0f m: fast projection error x %.4f m y %.4f m, distance %.4f m, bearing %.2e rad",
+			 lat_0, (double)range, (double)x_error, (double)y_error, (double)dist_error, (double)bearing_error);
+
+		ASSERT_LT(x_error, max_fast_error);
+		ASSERT_LT(y_error, max_fast_error);
+		ASSERT_LT(dist_error, max_fast_error);
+
+		/* the bearing error corresponds to the position error at the range */
+		ASSERT_LT(bearing_error, fmaxf(max_fast_error / range * 10.0f, 1e-5f));
+	}
+
+	double lat[point_count];
+	double lon[point_count];
+	float x[point_count];
+	float y[point_count];
+	float x_ref[point_count];
+	float y_ref[point_count];
+	float dist[point_count];
+	float dist_ref[point_count];
+	float bearing[point_count];
+	float bearing_ref[point_count];
+};
+
+TEST_F(GeoBatchTest, Accuracy)
+{
+	check(TEST_HOME_LAT, TEST_HOME_LON, 100.0f, 0.01f);
+	check(TEST_HOME_LAT, TEST_HOME_LON, 10000.0f, 0.01f);
+	check(TEST_HOME_LAT, TEST_HOME_LON, 100000.0f, 0.1f);
+
+	/* close to the pole and across the date line */
+	check(-78.5, 179.99, 10000.0f, 0.01f);
+	check(0.0, -180.0, 10000.0f, 0.01f);
+}
+
+TEST_F(GeoBatchTest, NotInitialized)
+{
+	struct map_projection_reference_s ref = {};
+
+	ASSERT_EQ(-1, map_projection_project_batch(&ref, lat, lon, x, y, point_count));
+	ASSERT_EQ(-1, map_projection_project_batch_fast(&ref, lat, lon, x, y, point_count));
+
+	/* an empty batch does nothing */
+	get_distance_to_waypoints(TEST_HOME_LAT, TEST_HOME_LON, lat, lon, NULL, NULL, 0);
+	get_distance_to_waypoints_fast(TEST_HOME_LAT, TEST_HOME_LON, lat, lon, NULL, NULL, 0);
+}
+
+TEST_F(GeoBatchTest, Benchmark)
+{
+	make_points(TEST_HOME_LAT, TEST_HOME_LON, 5000.0f, lat, lon);
+
+	struct map_projection_reference_s ref;
+	map_projection_init(&ref, TEST_HOME_LAT, TEST_HOME_LON);
+
+	const double points = (double)point_count * bench_rounds;
+	float sum = 0.0f;
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		for (unsigned i = 0; i < point_count; i++) {
+			map_projection_project(&ref, lat[i], lon[i], &x[i], &y[i]);
+		}
+
+		sum += x[r];
+	}
+
+	hrt_abstime project_time = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		map_projection_project_batch(&ref, lat, lon, x, y, point_count);
+		sum += x[r];
+	}
+
+	hrt_abstime batch_time = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		map_projection_project_batch_fast(&ref, lat, lon, x, y, point_count);
+		sum += x[r];
+	}
+
+	hrt_abstime fast_time = hrt_absolute_time() - start;
+
+	PX4_INFO("projection: single %.0f points/s, batch %.0f points/s, fast %.0f points/s",
+		 points * 1e6 / project_time, points * 1e6 / batch_time, points * 1e6 / fast_time);
+
+	start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		for (unsigned i = 0; i < point_count; i++) {
+			dist[i] = get_distance_to_next_waypoint(TEST_HOME_LAT, TEST_HOME_LON, lat[i], lon[i]);
+			bearing[i] = get_bearing_to_next_waypoint(TEST_HOME_LAT, TEST_HOME_LON, lat[i], lon[i]);
+		}
+
+		sum += dist[r] + bearing[r];
+	}
+
+	project_time = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		get_distance_to_waypoints(TEST_HOME_LAT, TEST_HOME_LON, lat, lon, dist, bearing, point_count);
+		sum += dist[r] + bearing[r];
+	}
+
+	batch_time = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned r = 0; r < bench_rounds; r++) {
+		get_distance_to_waypoints_fast(TEST_HOME_LAT, TEST_HOME_LON, lat, lon, dist, bearing, point_count);
+		sum += dist[r] + bearing[r];
+	}
+
+	fast_time = hrt_absolute_time() - start;
+
+	PX4_INFO("distance and bearing: single %.0f points/s, batch %.0f points/s, fast %.0f points/s",
+		 points * 1e6 / project_time, points * 1e6 / batch_time, points * 1e6 / fast_time);
+
+	/* keeps the compiler from dropping the loops */
+	ASSERT_TRUE(isfinite(sum));
+}
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include <drivers/drv_hrt.h>
+#include <drivers/gps/ubx.h>
+#include <drivers/gps/mtk.h>
+#include <drivers/gps/ashtech.h>
+#include <uORB/topics/vehicle_gps_position.h>
+#include <uORB/topics/satellite_info.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+/* optional recorded receiver output, replayed by the benchmarks if present */
+#define UBX_RECORDING_PATH	"data/gps_ubx.bin"
+
+typedef std::vector<uint8_t> stream_t;
+
+static void ubx_append_frame(stream_t &stream, uint16_t msg, const void *payload, uint16_t length)
+{
+	const uint8_t header[] = {UBX_SYNC1, UBX_SYNC2, (uint8_t)(msg & 0xff), (uint8_t)(msg >> 8),
+				  (uint8_t)(length & 0xff), (uint8_t)(length >> 8)
+				 };
+	stream.insert(stream.end(), header, header + sizeof(header));
+	stream.insert(stream.end(), (const uint8_t *)payload, (const uint8_t *)payload + length);
+
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+
+	for (unsigned i = 2; i < sizeof(header) + length; i++) {
+		ck_a += stream[stream.size() - sizeof(header) - length + i];
+		ck_b += ck_a;
+	}
+
+	stream.push_back(ck_a);
+	stream.push_back(ck_b);
+}
+
+static void ubx_append_pvt(stream_t &stream, int32_t lat, int32_t lon, int32_t alt)
+{
+	ubx_payload_rx_nav_pvt_t pvt = {};
+	pvt.fixType = 3;
+	pvt.flags = UBX_RX_NAV_PVT_FLAGS_GNSSFIXOK;
+	pvt.numSV = 12;
+	pvt.lat = lat;
+	pvt.lon = lon;
+	pvt.hMSL = alt;
+	pvt.hAcc = 1500;
+	pvt.vAcc = 2500;
+	pvt.velN = 1000;
+	ubx_append_frame(stream, UBX_MSG_NAV_PVT, &pvt, UBX_PAYLOAD_RX_NAV_PVT_SIZE_UBX8);
+}
+
+static void ubx_append_nav_epoch(stream_t &stream, int32_t lat, unsigned num_sats)
+{
+	ubx_append_pvt(stream, lat, 85000000, 488000);
+
+	ubx_payload_rx_nav_dop_t dop = {};
+	dop.hDOP = 90;
+	dop.vDOP = 140;
+	ubx_append_frame(stream, UBX_MSG_NAV_DOP, &dop, sizeof(dop));
+
+	uint8_t svinfo[sizeof(ubx_payload_rx_nav_svinfo_part1_t) + 32 * sizeof(ubx_payload_rx_nav_svinfo_part2_t)] = {};
+	ubx_payload_rx_nav_svinfo_part1_t *part1 = (ubx_payload_rx_nav_svinfo_part1_t *)svinfo;
+	part1->numCh = num_sats;
+
+	for (unsigned i = 0; i < num_sats; i++) {
+		ubx_payload_rx_nav_svinfo_part2_t *part2 = (ubx_payload_rx_nav_svinfo_part2_t *)
+				&svinfo[sizeof(*part1) + i * sizeof(ubx_payload_rx_nav_svinfo_part2_t)];
+		part2->svid = i + 1;
+		part2->flags = 1;
+		part2->cno = 30 + i;
+		part2->elev = 45;
+		part2->azim = 180;
+	}
+
+	ubx_append_frame(stream, UBX_MSG_NAV_SVINFO, svinfo,
+			 sizeof(*part1) + num_sats * sizeof(ubx_payload_rx_nav_svinfo_part2_t));
+
+	ubx_payload_rx_mon_hw_ubx7_t hw = {};
+	hw.noisePerMS = 87;
+	hw.jamInd = 3;
+	ubx_append_frame(stream, UBX_MSG_MON_HW, &hw, sizeof(hw));
+}
+
+static int feed(int (*parse)(void *, const uint8_t *, unsigned), void *parser, const stream_t &stream, unsigned chunk)
+{
+	int handled = 0;
+
+	for (unsigned i = 0; i < stream.size(); i += chunk) {
+		unsigned n = (stream.size() - i < chunk) ? stream.size() - i : chunk;
+		handled |= parse(parser, &stream[i], n);
+	}
+
+	return handled;
+}
+
+static int ubx_parse(void *parser, const uint8_t *buf, unsigned len) { return ((UBX *)parser)->parse(buf, len); }
+static int mtk_parse(void *parser, const uint8_t *buf, unsigned len) { return ((MTK *)parser)->parse(buf, len); }
+static int ashtech_parse(void *parser, const uint8_t *buf, unsigned len) { return ((ASHTECH *)parser)->parse(buf, len); }
+
+static bool load_recording(const char *path, stream_t &stream)
+{
+	FILE *f = fopen(path, "rb");
+
+	if (f == nullptr) {
+		return false;
+	}
+
+	uint8_t buf[1024];
+	size_t n;
+
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		stream.insert(stream.end(), buf, buf + n);
+	}
+
+	fclose(f);
+	return !stream.empty();
+}
+
+/**
+ * Receiver simulation that acknowledges every CFG message, so that
+ * UBX::configure() completes over a socket pair.
+ */
+class UBXReceiverSim
+{
+public:
+	UBXReceiverSim() : _run(true)
+	{
+		socketpair(AF_UNIX, SOCK_STREAM, 0, _fds);
+		pthread_create(&_thread, nullptr, &UBXReceiverSim::run_trampoline, this);
+	}
+
+	~UBXReceiverSim()
+	{
+		_run = false;
+		pthread_join(_thread, nullptr);
+		close(_fds[0]);
+		close(_fds[1]);
+	}
+
+	int fd() { return _fds[0]; }
+
+private:
+	static void *run_trampoline(void *arg)
+	{
+		((UBXReceiverSim *)arg)->run();
+		return nullptr;
+	}
+
+	void run()
+	{
+		uint8_t buf[512];
+		unsigned len = 0;
+
+		while (_run) {
+			pollfd fds = {_fds[1], POLLIN, 0};
+
+			if (poll(&fds, 1, 10) <= 0) {
+				continue;
+			}
+
+			int ret = read(_fds[1], &buf[len], sizeof(buf) - len);
+
+			if (ret <= 0) {
+				continue;
+			}
+
+			len += ret;
+
+			while (len >= 8) {
+				if (buf[0] != UBX_SYNC1 || buf[1] != UBX_SYNC2) {
+					memmove(buf, buf + 1, --len);
+					continue;
+				}
+
+				unsigned frame_len = 8 + (buf[4] | (buf[5] << 8));
+
+				if (frame_len > sizeof(buf)) {
+					len = 0;
+					break;
+				}
+
+				if (len < frame_len) {
+					break;
+				}
+
+				if (buf[2] == UBX_CLASS_CFG) {
+					stream_t ack;
+					ubx_payload_rx_ack_ack_t payload;
+					payload.clsID = buf[2];
+					payload.msgID = buf[3];
+					ubx_append_frame(ack, UBX_MSG_ACK_ACK, &payload, sizeof(payload));
+					write(_fds[1], &ack[0], ack.size());
+				}
+
+				len -= frame_len;
+				memmove(buf, buf + frame_len, len);
+			}
+		}
+	}
+
+	int _fds[2];
+	volatile bool _run;
+	pthread_t _thread;
+};
+
+class GPSParserTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		memset(&_gps, 0, sizeof(_gps));
+		memset(&_sat, 0, sizeof(_sat));
+	}
+
+	vehicle_gps_position_s _gps;
+	satellite_info_s _sat;
+};
+
+TEST_F(GPSParserTest, UBXSplitStream)
+{
+	UBXReceiverSim sim;
+	UBX ubx(sim.fd(), &_gps, &_sat);
+	unsigned baudrate;
+	ASSERT_EQ(0, ubx.configure(baudrate));
+
+	stream_t stream;
+	const uint8_t garbage[] = {0x00, UBX_SYNC1, 0x13, UBX_SYNC1, UBX_SYNC1, 0xff, 0x24};
+	stream.insert(stream.end(), garbage, garbage + sizeof(garbage));
+	ubx_append_nav_epoch(stream, 473977418, 8);
+
+	const unsigned chunks[] = {1, 2, 3, 7, 13, 64, 128, (unsigned)stream.size()};
+
+	for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		memset(&_gps, 0, sizeof(_gps));
+		memset(&_sat, 0, sizeof(_sat));
+
+		// NAV-PVT, NAV-DOP and MON-HW return 1, NAV-SVINFO returns 2
+		EXPECT_EQ(3, feed(ubx_parse, &ubx, stream, chunks[c])) << "chunk " << chunks[c];
+		EXPECT_EQ(473977418, _gps.lat);
+		EXPECT_EQ(85000000, _gps.lon);
+		EXPECT_EQ(488000, _gps.alt);
+		EXPECT_EQ(3, _gps.fix_type);
+		EXPECT_FLOAT_EQ(1.5f, _gps.eph);
+		EXPECT_FLOAT_EQ(0.9f, _gps.hdop);
+		EXPECT_EQ(87, _gps.noise_per_ms);
+		EXPECT_EQ(8, _sat.count);
+		EXPECT_EQ(8, _sat.svid[7]);
+		EXPECT_EQ(37, _sat.snr[7]);
+	}
+}
+
+TEST_F(GPSParserTest, UBXCorruptFrame)
+{
+	UBXReceiverSim sim;
+	UBX ubx(sim.fd(), &_gps, &_sat);
+	unsigned baudrate;
+	ASSERT_EQ(0, ubx.configure(baudrate));
+
+	stream_t stream;
+	ubx_append_pvt(stream, 100, 200, 300);
+	stream[20] ^= 0x40;	// payload bit flip
+	ubx_append_pvt(stream, 400, 500, 600);
+
+	EXPECT_EQ(1, feed(ubx_parse, &ubx, stream, stream.size()));
+	EXPECT_EQ(400, _gps.lat);
+
+	memset(&_gps, 0, sizeof(_gps));
+	EXPECT_EQ(1, feed(ubx_parse, &ubx, stream, 5));
+	EXPECT_EQ(400, _gps.lat);
+}
+
+TEST_F(GPSParserTest, UBXFuzz)
+{
+	UBXReceiverSim sim;
+	UBX ubx(sim.fd(), &_gps, &_sat);
+	unsigned baudrate;
+	ASSERT_EQ(0, ubx.configure(baudrate));
+
+	srand(1234);
+
+	for (unsigned iteration = 0; iteration < 20; iteration++) {
+		stream_t stream;
+
+		for (unsigned k = 0; k < 10; k++) {
+			// random bytes, with plenty of sync bytes
+			unsigned n = rand() % 64;
+
+			for (unsigned i = 0; i < n; i++) {
+				stream.push_back((rand() % 4 == 0) ? UBX_SYNC1 : rand() & 0xff);
+			}
+
+			// valid frames, some of them truncated or mutated
+			stream_t frames;
+			ubx_append_nav_epoch(frames, rand(), rand() % 33);
+
+			if (rand() % 2) {
+				frames[rand() % frames.size()] = rand() & 0xff;
+			}
+
+			if (rand() % 4 == 0) {
+				frames.resize(rand() % frames.size());
+			}
+
+			stream.insert(stream.end(), frames.begin(), frames.end());
+		}
+
+		for (unsigned i = 0; i < stream.size();) {
+			unsigned n = 1 + rand() % 200;
+
+			if (n > stream.size() - i) {
+				n = stream.size() - i;
+			}
+
+			ubx.parse(&stream[i], n);
+			i += n;
+		}
+
+		// terminate whatever frame the garbage started (max payload length), then check we still decode
+		stream_t flush(8 + 0xffff, 0);
+		ubx.parse(&flush[0], flush.size());
+
+		stream_t pvt;
+		ubx_append_pvt(pvt, 42, 43, 44);
+		EXPECT_EQ(1, ubx.parse(&pvt[0], pvt.size()));
+		EXPECT_EQ(42, _gps.lat);
+		EXPECT_LE(_sat.count, satellite_info_s::SAT_INFO_MAX_SATELLITES);
+	}
+}
+
+TEST_F(GPSParserTest, UBXThroughput)
+{
+	UBXReceiverSim sim;
+	UBX ubx(sim.fd(), &_gps, &_sat);
+	unsigned baudrate;
+	ASSERT_EQ(0, ubx.configure(baudrate));
+
+	stream_t stream;
+
+	if (load_recording(UBX_RECORDING_PATH, stream)) {
+		PX4_INFO("replaying %s (%u bytes)", UBX_RECORDING_PATH, (unsigned)stream.size());
+
+	} else {
+		// 20 Hz navigation epochs, about 1 MB
+		while (stream.size() < 1000000) {
+			ubx_append_nav_epoch(stream, 473977418, 20);
+		}
+	}
+
+	const unsigned chunks[] = {1, 32, 128, 1024};
+
+	for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		hrt_abstime start = hrt_absolute_time();
+		int handled = feed(ubx_parse, &ubx, stream, chunks[c]);
+		hrt_abstime elapsed = hrt_absolute_time() - start;
+
+		EXPECT_NE(0, handled);
+		PX4_INFO("ubx: %u bytes in %4u byte chunks: %8llu us (%.1f MB/s)", (unsigned)stream.size(), chunks[c],
+			 (unsigned long long)elapsed, (double)stream.size() / (elapsed > 0 ? elapsed : 1));
+	}
+}
+
+static void mtk_append_packet(stream_t &stream, int32_t lat, int32_t lon)
+{
+	gps_mtk_packet_t packet = {};
+	packet.payload = sizeof(packet) - 3;
+	packet.latitude = lat;
+	packet.longitude = lon;
+	packet.msl_altitude = 48800;
+	packet.satellites = 9;
+	packet.fix_type = 3;
+	packet.hdop = 120;
+
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+
+	for (unsigned i = 0; i < sizeof(packet) - 2; i++) {
+		ck_a += ((uint8_t *)&packet)[i];
+		ck_b += ck_a;
+	}
+
+	packet.ck_a = ck_a;
+	packet.ck_b = ck_b;
+
+	stream.push_back(MTK_SYNC1_V19);
+	stream.push_back(MTK_SYNC2);
+	stream.insert(stream.end(), (uint8_t *)&packet, (uint8_t *)&packet + sizeof(packet));
+}
+
+TEST_F(GPSParserTest, MTKSplitStream)
+{
+	MTK mtk(-1, &_gps);
+
+	stream_t stream;
+	const uint8_t garbage[] = {MTK_SYNC1_V16, 0x00, MTK_SYNC1_V19, MTK_SYNC1_V19};
+	stream.insert(stream.end(), garbage, garbage + sizeof(garbage));
+	mtk_append_packet(stream, 11, 12);
+	stream.push_back(MTK_SYNC2);
+	mtk_append_packet(stream, 473977418, 85000000);
+
+	const unsigned chunks[] = {1, 2, 5, 32, (unsigned)stream.size()};
+
+	for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		memset(&_gps, 0, sizeof(_gps));
+		EXPECT_EQ(1, feed(mtk_parse, &mtk, stream, chunks[c])) << "chunk " << chunks[c];
+		EXPECT_EQ(473977418, _gps.lat);
+		EXPECT_EQ(85000000, _gps.lon);
+		EXPECT_EQ(488000, _gps.alt);
+		EXPECT_EQ(9, _gps.satellites_used);
+	}
+
+	// corrupt the last packet
+	stream[stream.size() - 10] ^= 0x01;
+	memset(&_gps, 0, sizeof(_gps));
+	feed(mtk_parse, &mtk, stream, 7);
+	EXPECT_EQ(11, _gps.lat);
+}
+
+static void nmea_append_sentence(stream_t &stream, const char *body)
+{
+	uint8_t checksum = 0;
+
+	for (const char *c = body; *c != '\0'; c++) {
+		checksum ^= *c;
+	}
+
+	char sentence[128];
+	int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+	stream.insert(stream.end(), sentence, sentence + len);
+}
+
+TEST_F(GPSParserTest, AshtechSplitStream)
+{
+	ASHTECH ashtech(-1, &_gps, &_sat);
+
+	stream_t stream;
+	const char garbage[] = "GGA,$,**\r\n$GPGGA,1,2";
+	stream.insert(stream.end(), garbage, garbage + sizeof(garbage) - 1);
+	nmea_append_sentence(stream, "GPGGA,172814.0,3723.46587704,N,12202.26957864,W,2,6,1.2,18.893,M,-25.669,M,2.0,0031");
+
+	const unsigned chunks[] = {1, 3, 16, 32, (unsigned)stream.size()};
+
+	for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		memset(&_gps, 0, sizeof(_gps));
+		EXPECT_EQ(1, feed(ashtech_parse, &ashtech, stream, chunks[c])) << "chunk " << chunks[c];
+		EXPECT_NEAR(373910979, _gps.lat, 2);
+		EXPECT_NEAR(-1220378263, _gps.lon, 2);
+		EXPECT_EQ(18893, _gps.alt);
+		EXPECT_EQ(4, _gps.fix_type);
+	}
+
+	// bad checksum
+	stream[stream.size() - 10] ^= 0x01;
+	memset(&_gps, 0, sizeof(_gps));
+	EXPECT_EQ(0, feed(ashtech_parse, &ashtech, stream, 16));
+	EXPECT_EQ(0, _gps.lat);
+}
+
+TEST_F(GPSParserTest, NMEAThroughput)
+{
+	ASHTECH ashtech(-1, &_gps, &_sat);
+
+	stream_t stream;
+
+	while (stream.size() < 1000000) {
+		nmea_append_sentence(stream, "GPGGA,172814.0,3723.46587704,N,12202.26957864,W,2,6,1.2,18.893,M,-25.669,M,2.0,0031");
+	}
+
+	const unsigned chunks[] = {1, 32, 128, 1024};
+
+	for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		hrt_abstime start = hrt_absolute_time();
+		int handled = feed(ashtech_parse, &ashtech, stream, chunks[c]);
+		hrt_abstime elapsed = hrt_absolute_time() - start;
+
+		EXPECT_EQ(1, handled);
+		PX4_INFO("nmea: %u bytes in %4u byte chunks: %8llu us (%.1f MB/s)", (unsigned)stream.size(), chunks[c],
+			 (unsigned long long)elapsed, (double)stream.size() / (elapsed > 0 ? elapsed : 1));
+	}
+}
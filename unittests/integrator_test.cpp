@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <math.h>
+
+#include <drivers/device/integrator.h>
+
+#include "gtest/gtest.h"
+
+static const uint64_t sample_interval = 1000;
+
+/* a constant rate integrates to rate * elapsed time */
+static void check_integral(Integrator &integrator, const math::Vector<3> &rate, uint64_t elapsed)
+{
+	math::Vector<3> integral = integrator.read(false);
+
+	for (unsigned i = 0; i < 3; i++) {
+		ASSERT_TRUE(isfinite(integral(i)));
+		ASSERT_NEAR(integral(i), rate(i) * elapsed * 1e-6f, 1e-5f) << i;
+	}
+}
+
+TEST(IntegratorTest, Batch)
+{
+	Integrator integrator(4000, false);
+	math::Vector<3> rate(0.1f, -0.2f, 0.3f);
+	math::Vector<3> vals[8];
+
+	for (unsigned k = 0; k < 8; k++) {
+		vals[k] = rate;
+	}
+
+	math::Vector<3> integral;
+	uint64_t integral_dt = 0;
+
+	/* the first item only sets the start */
+	ASSERT_FALSE(integrator.put_batch(100000, vals, 4, sample_interval, integral, integral_dt));
+	check_integral(integrator, rate, 3 * sample_interval);
+
+	ASSERT_TRUE(integrator.put_batch(104000, vals, 4, sample_interval, integral, integral_dt));
+	ASSERT_EQ(7 * sample_interval, integral_dt);
+	check_integral(integrator, rate, 7 * sample_interval);
+}
+
+TEST(IntegratorTest, OverlappingBatches)
+{
+	Integrator integrator(3000, false);
+	math::Vector<3> rate(0.1f, -0.2f, 0.3f);
+	math::Vector<3> vals[8];
+
+	for (unsigned k = 0; k < 8; k++) {
+		vals[k] = rate;
+	}
+
+	math::Vector<3> integral;
+	uint64_t integral_dt = 0;
+
+	/* 0.1 ms after the previous batch, 8 items back-dated reach 6.9 ms into it */
+	integrator.put_batch(100000, vals, 4, sample_interval, integral, integral_dt);
+	ASSERT_TRUE(integrator.put_batch(100100, vals, 8, sample_interval, integral, integral_dt));
+
+	/* the overlap is squeezed in, the integral covers the elapsed time only */
+	ASSERT_EQ(3 * sample_interval + 100, integral_dt);
+	check_integral(integrator, rate, 3 * sample_interval + 100);
+
+	/* the next regular batch continues from there */
+	integrator.put_batch(104100, vals, 4, sample_interval, integral, integral_dt);
+	check_integral(integrator, rate, 7 * sample_interval + 100);
+
+	/* a timestamp before the last integration must not wrap around */
+	integrator.put_batch(103000, vals, 4, sample_interval, integral, integral_dt);
+	check_integral(integrator, rate, 7 * sample_interval + 100);
+}
@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <drivers/drv_hrt.h>
+#include <local_position_estimator/lpe_kalman.hpp>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+using namespace matrix;
+
+/* state layout of BlockLocalPositionEstimator */
+enum {X_x = 0, X_y, X_z, X_vx, X_vy, X_vz, X_bx, X_by, X_bz, X_tz, n_x};
+
+/* rate of the sensor_combined driven prediction */
+#define LPE_TEST_DT		0.004f
+
+/* deterministic pseudo random noise, uniform in [-1, 1] */
+static float noise()
+{
+	static uint32_t seed = 12345;
+	seed = seed * 1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+static Matrix<float, 3, 3> rotation(float roll, float pitch, float yaw)
+{
+	float cp = cosf(pitch), sp = sinf(pitch);
+	float cr = cosf(roll), sr = sinf(roll);
+	float cy = cosf(yaw), sy = sinf(yaw);
+	float d[3][3] = {
+		{cp * cy, -cr * sy + sr * sp * cy, sr * sy + cr * sp * cy},
+		{cp * sy, cr * cy + sr * sp * sy, -sr * cy + cr * sp * sy},
+		{-sp, sr * cp, cr * cp}
+	};
+	return Matrix<float, 3, 3>(&d[0][0]);
+}
+
+/**
+ * Sensor samples along a synthetic flight, in the form the estimator
+ * receives them from the attitude estimator and sensors app.
+ */
+struct flight_sample {
+	Matrix<float, 3, 3> R_att;
+	Vector<float, 3> u;		/**< acceleration NED incl. gravity compensation */
+	Vector<float, n_x> truth;
+};
+
+static flight_sample fly(unsigned step)
+{
+	flight_sample s;
+	float t = step * LPE_TEST_DT;
+	float w = 0.5f;
+
+	/* 10 m circle at 0.5 rad/s with a slow altitude oscillation */
+	s.truth.setZero();
+	s.truth(X_x) = 10.0f * cosf(w * t);
+	s.truth(X_y) = 10.0f * sinf(w * t);
+	s.truth(X_z) = -5.0f - sinf(0.2f * t);
+	s.truth(X_vx) = -10.0f * w * sinf(w * t);
+	s.truth(X_vy) = 10.0f * w * cosf(w * t);
+	s.truth(X_vz) = -0.2f * cosf(0.2f * t);
+	s.truth(X_bx) = 0.05f;
+	s.truth(X_by) = -0.03f;
+	s.truth(X_bz) = 0.1f;
+	s.truth(X_tz) = -0.5f * sinf(0.05f * t);
+
+	s.R_att = rotation(0.1f * sinf(w * t), 0.1f * cosf(w * t), w * t);
+
+	/* input is R_att * (a + bias) in the estimator, bias is estimated back out */
+	Vector<float, 3> a;
+	a(0) = -10.0f * w * w * cosf(w * t);
+	a(1) = -10.0f * w * w * sinf(w * t);
+	a(2) = 0.04f * sinf(0.2f * t);
+	Vector<float, 3> b;
+	b(0) = s.truth(X_bx);
+	b(1) = s.truth(X_by);
+	b(2) = s.truth(X_bz);
+	s.u = a + s.R_att * b;
+
+	for (unsigned i = 0; i < 3; i++) {
+		s.u(i) += 0.05f * noise();
+	}
+
+	return s;
+}
+
+/**
+ * The estimator math as it was before using the model structure: dense
+ * A, B and C, full products and the generic inverse.
+ */
+class DenseFilter
+{
+public:
+	void predict(const flight_sample &s, const Vector<float, 3> &var_u, const Vector<float, n_x> &q, float dt)
+	{
+		Matrix<float, n_x, n_x> A;
+		A.setZero();
+		A(X_x, X_vx) = 1;
+		A(X_y, X_vy) = 1;
+		A(X_z, X_vz) = 1;
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned j = 0; j < 3; j++) {
+				A(X_vx + i, X_bx + j) = -s.R_att(i, j);
+			}
+		}
+
+		Matrix<float, n_x, 3> B;
+		B.setZero();
+		B(X_vx, 0) = 1;
+		B(X_vy, 1) = 1;
+		B(X_vz, 2) = 1;
+
+		Matrix<float, 3, 3> R;
+		R.setZero();
+
+		for (unsigned i = 0; i < 3; i++) {
+			R(i, i) = var_u(i);
+		}
+
+		Matrix<float, n_x, n_x> Q;
+		Q.setZero();
+
+		for (unsigned i = 0; i < n_x; i++) {
+			Q(i, i) = q(i);
+		}
+
+		x += (A * x + B * s.u) * dt;
+		P += (A * P + P * A.transpose() + B * R * B.transpose() + Q) * dt;
+	}
+
+	template<size_t N_Y>
+	void correct(const Matrix<float, N_Y, n_x> &C, const Vector<float, N_Y> &y, const Matrix<float, N_Y, N_Y> &R)
+	{
+		Matrix<float, N_Y, N_Y> S_I = inv<float, N_Y>(C * P * C.transpose() + R);
+		Vector<float, N_Y> r = y - C * x;
+		Matrix<float, n_x, N_Y> K = P * C.transpose() * S_I;
+		x += K * r;
+		P -= K * C * P;
+	}
+
+	Vector<float, n_x> x;
+	Matrix<float, n_x, n_x> P;
+};
+
+/**
+ * The same filter using the structure exploiting kernels of the estimator.
+ */
+class StructuredFilter
+{
+public:
+	void predict(const flight_sample &s, const Vector<float, 3> &var_u, const Vector<float, n_x> &q, float dt)
+	{
+		Vector<float, n_x> dx;
+		lpe::predict<n_x, X_x, X_vx, X_bx>(x, P, s.R_att, s.u, var_u, q, dt, dx);
+		x += dx;
+	}
+
+	template<size_t N_Y>
+	void correct(lpe::Measurement<n_x, N_Y> &C, const Vector<float, N_Y> &y, const Matrix<float, N_Y, N_Y> &R)
+	{
+		C.project(P);
+		Matrix<float, N_Y, N_Y> S_I = C.S_I(R);
+		Vector<float, N_Y> r = y - C * x;
+		Matrix<float, n_x, N_Y> K = C.gain(S_I);
+		x += K * r;
+		C.update(P, K);
+	}
+
+	Vector<float, n_x> x;
+	Matrix<float, n_x, n_x> P;
+};
+
+enum {
+	LPE_TEST_PREDICT = 0,
+	LPE_TEST_BARO,
+	LPE_TEST_LIDAR,
+	LPE_TEST_FLOW,
+	LPE_TEST_GPS,
+	LPE_TEST_VISION,
+	LPE_TEST_NUM
+};
+
+static const char *const lpe_test_names[LPE_TEST_NUM] = {"predict", "baro", "lidar", "flow", "gps", "vision"};
+
+class LPEKalmanTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		var_u(0) = 0.012f * 0.012f;
+		var_u(1) = 0.012f * 0.012f;
+		var_u(2) = 0.02f * 0.02f;
+
+		for (unsigned i = 0; i < n_x; i++) {
+			q(i) = (i < X_bx) ? 0.1f : (i < X_tz) ? 1e-8f : 1e-3f;
+		}
+
+		/* same initial covariance as BlockLocalPositionEstimator::initP */
+		Matrix<float, n_x, n_x> P0;
+		P0.setZero();
+
+		for (unsigned i = 0; i < n_x; i++) {
+			P0(i, i) = (i >= X_bx && i <= X_bz) ? 1e-6f : 1.0f;
+		}
+
+		dense.x.setZero();
+		dense.P = P0;
+		structured.x.setZero();
+		structured.P = P0;
+		memset(dense_time, 0, sizeof(dense_time));
+		memset(structured_time, 0, sizeof(structured_time));
+		memset(count, 0, sizeof(count));
+	}
+
+	/* one measurement of selected states, applied to both filters */
+	template<size_t N_Y>
+	void correct(unsigned type, const size_t idx[N_Y], const float coef[N_Y], const float var[N_Y],
+		     const Vector<float, n_x> &truth)
+	{
+		Matrix<float, N_Y, n_x> C;
+		C.setZero();
+		lpe::Measurement<n_x, N_Y> C_s;
+		Matrix<float, N_Y, N_Y> R;
+		R.setZero();
+		Vector<float, N_Y> y;
+
+		for (size_t r = 0; r < N_Y; r++) {
+			C(r, idx[r]) = coef[r];
+			C_s.set(r, idx[r], coef[r]);
+			R(r, r) = var[r];
+			y(r) = coef[r] * truth(idx[r]) + sqrtf(var[r]) * noise();
+		}
+
+		/* rangefinders measure the distance to the terrain */
+		if (type == LPE_TEST_LIDAR) {
+			C(0, X_tz) = 1;
+			C_s.set(0, X_tz, 1);
+			y(0) += truth(X_tz);
+		}
+
+		hrt_abstime start = hrt_absolute_time();
+		dense.correct<N_Y>(C, y, R);
+		hrt_abstime mid = hrt_absolute_time();
+		structured.correct<N_Y>(C_s, y, R);
+		dense_time[type] += mid - start;
+		structured_time[type] += hrt_absolute_time() - mid;
+		count[type]++;
+	}
+
+	/* replay a flight with the sensor rates of a typical multicopter setup */
+	void replay(unsigned steps)
+	{
+		for (unsigned step = 0; step < steps; step++) {
+			flight_sample s = fly(step);
+
+			hrt_abstime start = hrt_absolute_time();
+			dense.predict(s, var_u, q, LPE_TEST_DT);
+			hrt_abstime mid = hrt_absolute_time();
+			structured.predict(s, var_u, q, LPE_TEST_DT);
+			dense_time[LPE_TEST_PREDICT] += mid - start;
+			structured_time[LPE_TEST_PREDICT] += hrt_absolute_time() - mid;
+			count[LPE_TEST_PREDICT]++;
+
+			/* baro at 50 Hz */
+			if (step % 5 == 0) {
+				const size_t idx[1] = {X_z};
+				const float coef[1] = {-1};
+				const float var[1] = {0.5f * 0.5f};
+				correct<1>(LPE_TEST_BARO, idx, coef, var, s.truth);
+			}
+
+			/* lidar and flow at 20 Hz */
+			if (step % 12 == 0) {
+				const size_t idx[1] = {X_z};
+				const float coef[1] = {-1};
+				const float var[1] = {0.03f * 0.03f};
+				correct<1>(LPE_TEST_LIDAR, idx, coef, var, s.truth);
+			}
+
+			if (step % 12 == 6) {
+				const size_t idx[2] = {X_x, X_y};
+				const float coef[2] = {1, 1};
+				const float var[2] = {0.05f * 0.05f, 0.05f * 0.05f};
+				correct<2>(LPE_TEST_FLOW, idx, coef, var, s.truth);
+			}
+
+			/* gps at 5 Hz */
+			if (step % 50 == 0) {
+				const size_t idx[6] = {X_x, X_y, X_z, X_vx, X_vy, X_vz};
+				const float coef[6] = {1, 1, 1, 1, 1, 1};
+				const float var[6] = {1, 1, 9, 0.0625f, 0.0625f, 0.0625f};
+				correct<6>(LPE_TEST_GPS, idx, coef, var, s.truth);
+			}
+
+			/* vision at 30 Hz */
+			if (step % 8 == 0) {
+				const size_t idx[3] = {X_x, X_y, X_z};
+				const float coef[3] = {1, 1, 1};
+				const float var[3] = {0.01f, 0.01f, 0.01f};
+				correct<3>(LPE_TEST_VISION, idx, coef, var, s.truth);
+			}
+		}
+	}
+
+	void expect_equal(float tol)
+	{
+		for (unsigned i = 0; i < n_x; i++) {
+			EXPECT_NEAR(dense.x(i), structured.x(i), tol) << "x(" << i << ")";
+
+			for (unsigned j = 0; j < n_x; j++) {
+				EXPECT_NEAR(dense.P(i, j), structured.P(i, j), tol) << "P(" << i << ", " << j << ")";
+			}
+		}
+	}
+
+	DenseFilter dense;
+	StructuredFilter structured;
+	Vector<float, 3> var_u;
+	Vector<float, n_x> q;
+	hrt_abstime dense_time[LPE_TEST_NUM];
+	hrt_abstime structured_time[LPE_TEST_NUM];
+	unsigned count[LPE_TEST_NUM];
+};
+
+TEST_F(LPEKalmanTest, Predict)
+{
+	/* start from a fully populated covariance */
+	replay(500);
+	dense.P = (dense.P + dense.P.transpose()) * 0.5f;
+	structured.x = dense.x;
+	structured.P = dense.P;
+
+	flight_sample s = fly(500);
+	dense.predict(s, var_u, q, LPE_TEST_DT);
+	structured.predict(s, var_u, q, LPE_TEST_DT);
+	expect_equal(1e-6f);
+
+	for (unsigned i = 0; i < n_x; i++) {
+		for (unsigned j = 0; j < n_x; j++) {
+			EXPECT_EQ(structured.P(i, j), structured.P(j, i));
+		}
+	}
+}
+
+TEST_F(LPEKalmanTest, Inverse)
+{
+	Matrix<float, 6, 6> S;
+
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = 0; j < 6; j++) {
+			S(i, j) = 1.0f / (1 + i + j) + ((i == j) ? 1.0f : 0.0f);
+		}
+	}
+
+	Matrix<float, 6, 6> I = S * lpe::inv_spd<6>(S);
+
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = 0; j < 6; j++) {
+			EXPECT_NEAR((i == j) ? 1.0f : 0.0f, I(i, j), 1e-5f);
+		}
+	}
+
+	Matrix<float, 1, 1> s;
+	s(0, 0) = 4.0f;
+	EXPECT_FLOAT_EQ(0.25f, lpe::inv_spd<1>(s)(0, 0));
+}
+
+TEST_F(LPEKalmanTest, Replay)
+{
+	/* one minute of flight */
+	replay(15000);
+	expect_equal(1e-3f);
+
+	/* both track the flight */
+	flight_sample s = fly(15000);
+
+	for (unsigned i = X_x; i <= X_z; i++) {
+		EXPECT_NEAR(s.truth(i), structured.x(i), 0.5f);
+	}
+
+	for (unsigned i = 0; i < LPE_TEST_NUM; i++) {
+		PX4_INFO("%-8s %6u steps, dense %8.3f us/step, structured %8.3f us/step", lpe_test_names[i], count[i],
+			 (double)dense_time[i] / count[i], (double)structured_time[i] / count[i]);
+	}
+}
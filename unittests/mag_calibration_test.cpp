@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include <drivers/drv_hrt.h>
+#include <commander/mag_calibration_fit.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+/* same limits as mag_calibration.cpp */
+#define MAG_TEST_POINTS_PERBIN	3
+#define MAG_TEST_FIT_INTERVAL	8
+
+struct mag_sample {
+	float x;
+	float y;
+	float z;
+};
+
+typedef std::vector<mag_sample> recording_t;
+
+/* deterministic pseudo random noise, uniform in [-1, 1] */
+static float noise()
+{
+	static uint32_t seed = 4321;
+	seed = seed * 1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+/* rotate v about axis (0: x, 1: y, 2: z) by angle */
+static mag_sample rotate(const mag_sample &v, unsigned axis, float angle)
+{
+	float c = cosf(angle);
+	float s = sinf(angle);
+	mag_sample r = v;
+
+	switch (axis) {
+	case 0:
+		r.y = c * v.y - s * v.z;
+		r.z = s * v.y + c * v.z;
+		break;
+
+	case 1:
+		r.x = c * v.x + s * v.z;
+		r.z = -s * v.x + c * v.z;
+		break;
+
+	default:
+		r.x = c * v.x - s * v.y;
+		r.y = s * v.x + c * v.y;
+		break;
+	}
+
+	return r;
+}
+
+/**
+ * Mag readings of a calibration: each of the six sides is held down while
+ * the vehicle is turned around the vertical axis, with some wobble.
+ * The sensor has an offset and a scale error per axis.
+ */
+static void generate(recording_t &recording, const float offset[3], const float scale[3], unsigned rate)
+{
+	/* earth field, 0.5 Ga at 60 deg inclination */
+	mag_sample earth = {0.25f, 0.0f, 0.433f};
+
+	/* rotations that bring each side down */
+	const unsigned side_axis[6] = {1, 1, 0, 0, 0, 0};
+	const float side_angle[6] = {M_PI_2, -M_PI_2, M_PI_2, -M_PI_2, M_PI, 0.0f};
+
+	for (unsigned side = 0; side < 6; side++) {
+		/* 7 seconds per side */
+		for (unsigned i = 0; i < 7 * rate; i++) {
+			float t = (float)i / rate;
+			mag_sample b = rotate(earth, 2, -0.9f * t);
+			b = rotate(b, 0, 0.15f * sinf(3.0f * t));
+			b = rotate(b, side_axis[side], side_angle[side]);
+
+			mag_sample m = {
+				offset[0] + scale[0] * b.x + 0.003f * noise(),
+				offset[1] + scale[1] * b.y + 0.003f * noise(),
+				offset[2] + scale[2] * b.z + 0.003f * noise()
+			};
+			recording.push_back(m);
+		}
+	}
+}
+
+/* load the raw samples printed by previous versions of the calibration, one "x, y, z" per line */
+static bool load_recording(const char *filepath, recording_t &recording)
+{
+	FILE *fp = fopen(filepath, "rt");
+
+	if (fp == nullptr) {
+		return false;
+	}
+
+	char line[200];
+
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		mag_sample m;
+
+		if (sscanf(line, "%f, %f, %f", &m.x, &m.y, &m.z) == 3) {
+			recording.push_back(m);
+		}
+	}
+
+	fclose(fp);
+	return !recording.empty();
+}
+
+class MagCalibrationTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		mag_sample_bins_reset(&bins);
+		ellipsoid_fit_reset(&fit);
+		memset(center, 0, sizeof(center));
+	}
+
+	/* feed samples the way the calibration worker does */
+	unsigned replay(const recording_t &recording)
+	{
+		unsigned accepted = 0;
+
+		for (size_t i = 0; i < recording.size(); i++) {
+			const mag_sample &m = recording[i];
+			int bin = mag_sample_bins_index(m.x, m.y, m.z, center);
+
+			if (bin < 0 || mag_sample_bins_full(&bins, bin, MAG_TEST_POINTS_PERBIN)) {
+				continue;
+			}
+
+			mag_sample_bins_add(&bins, bin);
+			ellipsoid_fit_add(&fit, m.x, m.y, m.z);
+			accepted++;
+
+			if (fit.n % MAG_TEST_FIT_INTERVAL == 0) {
+				struct ellipsoid_fit_result_s result;
+
+				if (ellipsoid_fit_solve(&fit, &result) == 0 || ellipsoid_fit_solve_sphere(&fit, &result) == 0) {
+					memcpy(center, result.center, sizeof(center));
+				}
+			}
+		}
+
+		return accepted;
+	}
+
+	struct mag_sample_bins_s bins;
+	struct ellipsoid_fit_s fit;
+	float center[3];
+};
+
+TEST_F(MagCalibrationTest, Bins)
+{
+	const float zero[3] = {0.0f, 0.0f, 0.0f};
+
+	/* opposite directions land in different bins, the magnitude does not matter */
+	int up = mag_sample_bins_index(0.0f, 0.0f, -0.5f, zero);
+	int down = mag_sample_bins_index(0.0f, 0.0f, 0.5f, zero);
+	EXPECT_NE(up, down);
+	EXPECT_EQ(up, mag_sample_bins_index(0.0f, 0.0f, -0.2f, zero));
+	EXPECT_EQ(-1, mag_sample_bins_index(0.0f, 0.0f, 0.0f, zero));
+
+	for (unsigned i = 0; i < MAG_TEST_POINTS_PERBIN; i++) {
+		EXPECT_FALSE(mag_sample_bins_full(&bins, up, MAG_TEST_POINTS_PERBIN));
+		mag_sample_bins_add(&bins, up);
+	}
+
+	EXPECT_TRUE(mag_sample_bins_full(&bins, up, MAG_TEST_POINTS_PERBIN));
+	EXPECT_EQ(1u, bins.occupied);
+
+	/* every direction maps to a valid bin, all bins are reachable */
+	for (unsigned i = 0; i < 20000; i++) {
+		int bin = mag_sample_bins_index(noise(), noise(), noise(), zero);
+		ASSERT_GE(bin, 0);
+		ASSERT_LT(bin, (int)mag_bins_count);
+
+		if (bins.count[bin] == 0) {
+			mag_sample_bins_add(&bins, bin);
+		}
+	}
+
+	EXPECT_EQ(100u, mag_sample_bins_coverage(&bins));
+}
+
+TEST_F(MagCalibrationTest, Fit)
+{
+	const float offset[3] = {0.1f, -0.2f, 0.05f};
+	const float radii[3] = {0.5f, 0.45f, 0.55f};
+
+	/* exact samples on the ellipsoid */
+	for (unsigned i = 0; i < 200; i++) {
+		float el = acosf(noise());
+		float az = M_PI * noise();
+		ellipsoid_fit_add(&fit, offset[0] + radii[0] * sinf(el) * cosf(az),
+				  offset[1] + radii[1] * sinf(el) * sinf(az),
+				  offset[2] + radii[2] * cosf(el));
+	}
+
+	struct ellipsoid_fit_result_s result;
+	ASSERT_EQ(0, ellipsoid_fit_solve(&fit, &result));
+
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_NEAR(offset[i], result.center[i], 1e-4f);
+		EXPECT_NEAR(radii[i], result.radii[i], 1e-4f);
+	}
+
+	EXPECT_LT(result.residual, 1e-4f);
+
+	/* a sphere does not fit as well */
+	ASSERT_EQ(0, ellipsoid_fit_solve_sphere(&fit, &result));
+	EXPECT_GT(result.residual, 0.01f);
+
+	/* too few samples */
+	ellipsoid_fit_reset(&fit);
+	ellipsoid_fit_add(&fit, 0.5f, 0.0f, 0.0f);
+	EXPECT_EQ(-1, ellipsoid_fit_solve(&fit, &result));
+	EXPECT_EQ(-1, ellipsoid_fit_solve_sphere(&fit, &result));
+}
+
+TEST_F(MagCalibrationTest, Replay)
+{
+	const float offset[3] = {0.15f, -0.08f, 0.25f};
+	const float scale[3] = {1.05f, 0.95f, 1.0f};
+
+	recording_t recording;
+	generate(recording, offset, scale, 100);
+
+	hrt_abstime start = hrt_absolute_time();
+	unsigned accepted = replay(recording);
+	struct ellipsoid_fit_result_s result;
+	ASSERT_EQ(0, ellipsoid_fit_solve(&fit, &result));
+	hrt_abstime elapsed = hrt_absolute_time() - start;
+
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_NEAR(offset[i], result.center[i], 0.005f);
+	}
+
+	EXPECT_GT(mag_sample_bins_coverage(&bins), 50u);
+	EXPECT_LT(result.residual, 0.02f);
+
+	PX4_INFO("%u of %u samples accepted, coverage %u%%, fit error %.2f%%, %llu us",
+		 accepted, (unsigned)recording.size(), mag_sample_bins_coverage(&bins),
+		 (double)(100.0f * result.residual), (unsigned long long)elapsed);
+	PX4_INFO("center %8.4f %8.4f %8.4f, radii %8.4f %8.4f %8.4f",
+		 (double)result.center[0], (double)result.center[1], (double)result.center[2],
+		 (double)result.radii[0], (double)result.radii[1], (double)result.radii[2]);
+
+	ASSERT_EQ(0, ellipsoid_fit_solve_sphere(&fit, &result));
+	PX4_INFO("sphere center %8.4f %8.4f %8.4f, fit error %.2f%%",
+		 (double)result.center[0], (double)result.center[1], (double)result.center[2],
+		 (double)(100.0f * result.residual));
+}
+
+TEST_F(MagCalibrationTest, Benchmark)
+{
+	const float offset[3] = {0.15f, -0.08f, 0.25f};
+	const float scale[3] = {1.05f, 0.95f, 1.0f};
+
+	recording_t recording;
+	generate(recording, offset, scale, 100);
+
+	/* duplicate rejection against all previous samples, as done before binning */
+	const unsigned max_count = 240;
+	const float min_sample_dist = fabsf(5.4f * 0.2f / sqrtf(max_count)) / 3.0f;
+	std::vector<mag_sample> kept;
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (size_t i = 0; i < recording.size() && kept.size() < max_count; i++) {
+		bool rejected = false;
+
+		for (size_t j = 0; j < kept.size() && !rejected; j++) {
+			float dx = recording[i].x - kept[j].x;
+			float dy = recording[i].y - kept[j].y;
+			float dz = recording[i].z - kept[j].z;
+			rejected = sqrtf(dx * dx + dy * dy + dz * dz) < min_sample_dist;
+		}
+
+		if (!rejected) {
+			kept.push_back(recording[i]);
+		}
+	}
+
+	hrt_abstime pairwise = hrt_absolute_time() - start;
+
+	start = hrt_absolute_time();
+	unsigned accepted = replay(recording);
+	hrt_abstime binned = hrt_absolute_time() - start;
+
+	PX4_INFO("pairwise rejection: %u samples kept in %llu us", (unsigned)kept.size(), (unsigned long long)pairwise);
+	PX4_INFO("binned rejection and incremental fit: %u samples kept in %llu us", accepted,
+		 (unsigned long long)binned);
+}
+
+/* replay a recording given in MAG_CAL_RECORDING, e.g. the raw samples of a field calibration */
+TEST_F(MagCalibrationTest, Recording)
+{
+	const char *filepath = getenv("MAG_CAL_RECORDING");
+
+	if (filepath == nullptr) {
+		PX4_INFO("set MAG_CAL_RECORDING to replay recorded mag data");
+		return;
+	}
+
+	recording_t recording;
+	ASSERT_TRUE(load_recording(filepath, recording)) << filepath;
+
+	unsigned accepted = replay(recording);
+	struct ellipsoid_fit_result_s result;
+	bool ellipsoid = (ellipsoid_fit_solve(&fit, &result) == 0);
+	ASSERT_TRUE(ellipsoid || ellipsoid_fit_solve_sphere(&fit, &result) == 0);
+
+	PX4_INFO("%s: %u of %u samples accepted, coverage %u%%, %s fit error %.2f%%", filepath, accepted,
+		 (unsigned)recording.size(), mag_sample_bins_coverage(&bins), ellipsoid ? "ellipsoid" : "sphere",
+		 (double)(100.0f * result.residual));
+	PX4_INFO("center %8.4f %8.4f %8.4f, radii %8.4f %8.4f %8.4f",
+		 (double)result.center[0], (double)result.center[1], (double)result.center[2],
+		 (double)result.radii[0], (double)result.radii[1], (double)result.radii[2]);
+}
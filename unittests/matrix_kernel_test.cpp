@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <drivers/drv_hrt.h>
+#include <mathlib/mathlib.h>
+#include <matrix/math.hpp>
+#include <systemlib/err.h>
+
+#include "gtest/gtest.h"
+
+static const unsigned bench_iterations = 200000;
+
+static float random_element()
+{
+	return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+template <unsigned M, unsigned N>
+static math::Matrix<M, N> random_matrix()
+{
+	math::Matrix<M, N> m;
+
+	for (unsigned i = 0; i < M; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			m.data[i][j] = random_element();
+		}
+	}
+
+	return m;
+}
+
+/* diagonally dominant, so it is well conditioned */
+template <unsigned N>
+static math::Matrix<N, N> random_invertible()
+{
+	math::Matrix<N, N> m = random_matrix<N, N>();
+
+	for (unsigned i = 0; i < N; i++) {
+		m.data[i][i] += (float)N;
+	}
+
+	return m;
+}
+
+/* the product in double, as reference */
+template <unsigned M, unsigned N, unsigned P>
+static void reference_mult(const math::Matrix<M, N> &a, const math::Matrix<N, P> &b, double res[M][P])
+{
+	for (unsigned i = 0; i < M; i++) {
+		for (unsigned j = 0; j < P; j++) {
+			res[i][j] = 0.0;
+
+			for (unsigned k = 0; k < N; k++) {
+				res[i][j] += (double)a.data[i][k] * (double)b.data[k][j];
+			}
+		}
+	}
+}
+
+/* the product as computed on POSIX before the kernels */
+template <unsigned M, unsigned N, unsigned P>
+static math::Matrix<M, P> copy_mult(const math::Matrix<M, N> &a, const math::Matrix<N, P> &b)
+{
+	matrix::Matrix<float, M, N> Me(&a.data[0][0]);
+	matrix::Matrix<float, N, P> Him(&b.data[0][0]);
+	matrix::Matrix<float, M, P> Product = Me * Him;
+	math::Matrix<M, P> res(Product.data());
+	return res;
+}
+
+/* plain triple loop */
+template <unsigned M, unsigned N, unsigned P>
+static math::Matrix<M, P> naive_mult(const math::Matrix<M, N> &a, const math::Matrix<N, P> &b)
+{
+	math::Matrix<M, P> res;
+
+	for (unsigned i = 0; i < M; i++) {
+		for (unsigned j = 0; j < P; j++) {
+			for (unsigned k = 0; k < N; k++) {
+				res.data[i][j] += a.data[i][k] * b.data[k][j];
+			}
+		}
+	}
+
+	return res;
+}
+
+template <unsigned N>
+static void check_square()
+{
+	math::Matrix<N, N> a = random_matrix<N, N>();
+	math::Matrix<N, N> b = random_matrix<N, N>();
+	math::Vector<N> v;
+
+	for (unsigned i = 0; i < N; i++) {
+		v.data[i] = random_element();
+	}
+
+	/* product */
+	double expected[N][N];
+	reference_mult<N, N, N>(a, b, expected);
+	math::Matrix<N, N> ab = a * b;
+
+	for (unsigned i = 0; i < N; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			ASSERT_NEAR(ab.data[i][j], expected[i][j], 1e-5) << N << "x" << N << " (" << i << ", " << j << ")";
+		}
+	}
+
+	/* product with a vector */
+	math::Vector<N> av = a * v;
+
+	for (unsigned i = 0; i < N; i++) {
+		double sum = 0.0;
+
+		for (unsigned k = 0; k < N; k++) {
+			sum += (double)a.data[i][k] * (double)v.data[k];
+		}
+
+		ASSERT_NEAR(av.data[i], sum, 1e-5) << N << "x" << N << " row " << i;
+	}
+
+	/* transpose */
+	math::Matrix<N, N> at = a.transposed();
+
+	for (unsigned i = 0; i < N; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			ASSERT_EQ(at.data[j][i], a.data[i][j]);
+		}
+	}
+
+	/* inverse */
+	math::Matrix<N, N> c = random_invertible<N>();
+	math::Matrix<N, N> ci = c * c.inversed();
+
+	for (unsigned i = 0; i < N; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			ASSERT_NEAR(ci.data[i][j], i == j ? 1.0f : 0.0f, 1e-5f) << N << "x" << N << " (" << i << ", " << j << ")";
+		}
+	}
+
+	/* a zero pivot needs the row exchange */
+	math::Matrix<N, N> p;
+
+	for (unsigned i = 0; i < N; i++) {
+		p.data[i][(i + 1) % N] = 2.0f;
+	}
+
+	math::Matrix<N, N> pi = p * p.inversed();
+
+	for (unsigned i = 0; i < N; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			ASSERT_NEAR(pi.data[i][j], i == j ? 1.0f : 0.0f, 1e-6f);
+		}
+	}
+
+	/* singular matrices give the zero matrix */
+	math::Matrix<N, N> s = random_matrix<N, N>();
+
+	for (unsigned i = 0; i < N; i++) {
+		s.data[i][N - 1] = 0.0f;
+	}
+
+	math::Matrix<N, N> zero;
+	ASSERT_TRUE(s.inversed() == zero);
+	ASSERT_TRUE(zero.inversed() == zero);
+}
+
+TEST(MatrixKernelTest, Square)
+{
+	check_square<3>();
+	check_square<4>();
+	check_square<6>();
+	check_square<10>();
+}
+
+TEST(MatrixKernelTest, NonSquare)
+{
+	math::Matrix<3, 4> a = random_matrix<3, 4>();
+	math::Matrix<4, 6> b = random_matrix<4, 6>();
+
+	double expected[3][6];
+	reference_mult<3, 4, 6>(a, b, expected);
+	math::Matrix<3, 6> ab = a * b;
+
+	for (unsigned i = 0; i < 3; i++) {
+		for (unsigned j = 0; j < 6; j++) {
+			ASSERT_NEAR(ab.data[i][j], expected[i][j], 1e-5);
+		}
+	}
+
+	math::Matrix<4, 3> at = a.transposed();
+
+	for (unsigned i = 0; i < 3; i++) {
+		for (unsigned j = 0; j < 4; j++) {
+			ASSERT_EQ(at.data[j][i], a.data[i][j]);
+		}
+	}
+}
+
+/* all three paths must compute the same product, the sum keeps the compiler from dropping the loops */
+template <unsigned N>
+static void benchmark()
+{
+	math::Matrix<N, N> a = random_matrix<N, N>();
+	math::Matrix<N, N> b = random_matrix<N, N>();
+	math::Matrix<N, N> res;
+
+	float sum_kernel = 0.0f;
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < bench_iterations; k++) {
+		a.data[0][0] = (float)(k & 0xff) * 1e-3f;
+		res = a * b;
+		sum_kernel += res.data[N - 1][N - 1];
+	}
+
+	hrt_abstime kernel_time = hrt_absolute_time() - start;
+
+	float sum_copy = 0.0f;
+	start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < bench_iterations; k++) {
+		a.data[0][0] = (float)(k & 0xff) * 1e-3f;
+		res = copy_mult<N, N, N>(a, b);
+		sum_copy += res.data[N - 1][N - 1];
+	}
+
+	hrt_abstime copy_time = hrt_absolute_time() - start;
+
+	float sum_naive = 0.0f;
+	start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < bench_iterations; k++) {
+		a.data[0][0] = (float)(k & 0xff) * 1e-3f;
+		res = naive_mult<N, N, N>(a, b);
+		sum_naive += res.data[N - 1][N - 1];
+	}
+
+	hrt_abstime naive_time = hrt_absolute_time() - start;
+
+	math::Vector<N> v;
+	math::Vector<N> av;
+	float sum_vec = 0.0f;
+	start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < bench_iterations; k++) {
+		v.data[0] = (float)(k & 0xff) * 1e-3f;
+		av = a * v;
+		sum_vec += av.data[N - 1];
+	}
+
+	hrt_abstime vec_time = hrt_absolute_time() - start;
+
+	math::Matrix<N, N> c = random_invertible<N>();
+	float sum_inv = 0.0f;
+	start = hrt_absolute_time();
+
+	for (unsigned k = 0; k < bench_iterations; k++) {
+		c.data[0][0] = (float)N + (float)(k & 0xff) * 1e-3f;
+		res = c.inversed();
+		sum_inv += res.data[0][0];
+	}
+
+	hrt_abstime inv_time = hrt_absolute_time() - start;
+
+	PX4_INFO("%2ux%-2u %u iterations: mult %llu us (matrix copies %llu us, naive %llu us), mult vector %llu us, inverse %llu us",
+		 N, N, bench_iterations, (unsigned long long)kernel_time, (unsigned long long)copy_time,
+		 (unsigned long long)naive_time, (unsigned long long)vec_time, (unsigned long long)inv_time);
+
+	ASSERT_NEAR(sum_kernel, sum_copy, fabsf(sum_copy) * 1e-4f + 1e-2f);
+	ASSERT_NEAR(sum_kernel, sum_naive, fabsf(sum_naive) * 1e-4f + 1e-2f);
+	ASSERT_TRUE(isfinite(sum_vec));
+	ASSERT_TRUE(isfinite(sum_inv));
+}
+
+TEST(MatrixKernelTest, Benchmark)
+{
+	benchmark<3>();
+	benchmark<4>();
+	benchmark<6>();
+	benchmark<10>();
+}
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <dataman/dataman.h>
+#include <navigator/navigation.h>
+#include <navigator/geofence.h>
+#include <navigator/mission_feasibility_checker.h>
+#include <systemlib/param/param.h>
+#include <uORB/topics/fence.h>
+#include <uORB/topics/navigation_capabilities.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+#define TEST_FENCE_PATH		"mission_feasibility_test_fence.txt"
+#define TEST_HOME_LAT		47.397742
+#define TEST_HOME_LON		8.545594
+#define TEST_HOME_ALT		488.0f
+
+ORB_DEFINE(fence, struct fence_s);
+ORB_DEFINE(navigation_capabilities, struct navigation_capabilities_s);
+
+/******************************************
+ * dataman stubs, the mission is generated from the item index
+ ******************************************/
+
+static unsigned g_dm_reads = 0;
+static unsigned g_fence_vertices = 0;
+
+/* waypoints on a circle with a radius of 200 m around home */
+static void make_mission_item(unsigned index, struct mission_item_s *item)
+{
+	memset(item, 0, sizeof(*item));
+
+	double angle = 2.0 * M_PI * (index % 64) / 64.0;
+	item->lat = TEST_HOME_LAT + 0.0018 * cos(angle);
+	item->lon = TEST_HOME_LON + 0.0027 * sin(angle);
+	item->altitude = 50.0f;
+	item->altitude_is_relative = true;
+	item->nav_cmd = (index == 0) ? NAV_CMD_TAKEOFF : NAV_CMD_WAYPOINT;
+	item->autocontinue = true;
+}
+
+/* the fence polygon is a regular polygon with a radius of 500 m around home */
+static void make_fence_vertex(unsigned index, struct fence_vertex_s *vertex)
+{
+	double angle = 2.0 * M_PI * index / g_fence_vertices;
+	vertex->lat = (float)(TEST_HOME_LAT + 0.0045 * cos(angle));
+	vertex->lon = (float)(TEST_HOME_LON + 0.0067 * sin(angle));
+}
+
+ssize_t dm_read(dm_item_t item, unsigned char index, void *buffer, size_t buflen)
+{
+	g_dm_reads++;
+
+	if (item == DM_KEY_FENCE_POINTS && buflen == sizeof(struct fence_vertex_s)) {
+		make_fence_vertex(index, (struct fence_vertex_s *)buffer);
+		return buflen;
+	}
+
+	if (item == DM_KEY_WAYPOINTS_OFFBOARD_0 && buflen == sizeof(struct mission_item_s)) {
+		make_mission_item(index, (struct mission_item_s *)buffer);
+		return buflen;
+	}
+
+	return -1;
+}
+
+ssize_t dm_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buffer, size_t buflen)
+{
+	return buflen;
+}
+
+int dm_clear(dm_item_t item)
+{
+	return 0;
+}
+
+/******************************************
+ * param stubs, all parameters keep their default value
+ ******************************************/
+
+param_t param_find(const char *name)
+{
+	return PARAM_INVALID;
+}
+
+int param_get(param_t param, void *val)
+{
+	return -1;
+}
+
+int param_set(param_t param, const void *val)
+{
+	return -1;
+}
+
+class MissionFeasibilityTest : public ::testing::Test
+{
+protected:
+	/* load a fence with the given number of vertices through the fence file */
+	void load_fence(unsigned vertices)
+	{
+		g_fence_vertices = vertices;
+
+		FILE *fp = fopen(TEST_FENCE_PATH, "w");
+		ASSERT_TRUE(fp != nullptr);
+		fprintf(fp, "# test fence\n0 1000\n");
+
+		for (unsigned i = 0; i < vertices; i++) {
+			struct fence_vertex_s vertex;
+			make_fence_vertex(i, &vertex);
+			fprintf(fp, "%.7f %.7f\n", (double)vertex.lat, (double)vertex.lon);
+		}
+
+		fclose(fp);
+
+		ASSERT_EQ(OK, _geofence.loadFromFile(TEST_FENCE_PATH));
+		ASSERT_TRUE(_geofence.valid());
+		unlink(TEST_FENCE_PATH);
+	}
+
+	bool check(size_t items)
+	{
+		bool warning = false;
+		return _checker.checkMissionFeasible(-1, true, DM_KEY_WAYPOINTS_OFFBOARD_0, items, _geofence,
+						     TEST_HOME_ALT, true, TEST_HOME_LAT, TEST_HOME_LON, 900.0f, warning, 2.0f, true);
+	}
+
+	Geofence _geofence;
+	MissionFeasibilityChecker _checker;
+};
+
+TEST_F(MissionFeasibilityTest, FenceContainment)
+{
+	load_fence(12);
+
+	EXPECT_TRUE(_geofence.inside_polygon(TEST_HOME_LAT, TEST_HOME_LON, 100.0f));
+	EXPECT_FALSE(_geofence.inside_polygon(TEST_HOME_LAT + 0.01, TEST_HOME_LON, 100.0f));
+	EXPECT_FALSE(_geofence.inside_polygon(TEST_HOME_LAT, TEST_HOME_LON - 0.01, 100.0f));
+	EXPECT_FALSE(_geofence.inside_polygon(TEST_HOME_LAT, TEST_HOME_LON, 2000.0f));
+}
+
+TEST_F(MissionFeasibilityTest, SinglePass)
+{
+	load_fence(15);
+
+	/* the mission and the fence are read from the dataman once */
+	g_dm_reads = 0;
+	EXPECT_TRUE(check(200));
+	EXPECT_EQ(200u + 15u, g_dm_reads);
+
+	/* checking the same mission again does not touch the dataman */
+	g_dm_reads = 0;
+	EXPECT_TRUE(check(200));
+	EXPECT_EQ(0u, g_dm_reads);
+
+	_checker.invalidateMission();
+	g_dm_reads = 0;
+	EXPECT_TRUE(check(200));
+	EXPECT_EQ(200u, g_dm_reads);
+}
+
+TEST_F(MissionFeasibilityTest, Benchmark)
+{
+	load_fence(15);
+
+	/* dataman indices are 8 bit, the stub generates any number of items */
+	const size_t items = 1000;
+
+	_checker.invalidateMission();
+	g_dm_reads = 0;
+	EXPECT_TRUE(check(items));
+	PX4_INFO("%u items, %u vertex fence: %llu us, %u dataman reads", (unsigned)items, g_fence_vertices,
+		 (unsigned long long)_checker.getValidationTime(), g_dm_reads);
+
+	EXPECT_TRUE(check(items));
+	PX4_INFO("%u items, cached: %llu us", (unsigned)items, (unsigned long long)_checker.getValidationTime());
+}
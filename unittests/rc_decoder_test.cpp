@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include <drivers/drv_hrt.h>
+#include <rc/rc_decoder.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+/* polling interval of the RC input in the fmu driver */
+#define RC_DECODER_TEST_TICK	2000
+
+struct rc_sample {
+	uint64_t	time;	/**< receive time [us] */
+	uint8_t		value;
+};
+
+typedef std::vector<rc_sample> recording_t;
+
+/* load one of the logic analyzer captures also used by the per-protocol tests */
+static bool load_recording(const char *filepath, recording_t &recording)
+{
+	FILE *fp = fopen(filepath, "rt");
+
+	if (fp == nullptr) {
+		return false;
+	}
+
+	// Trash the first 20 lines
+	for (unsigned i = 0; i < 20; i++) {
+		char buf[200];
+		(void)fgets(buf, sizeof(buf), fp);
+	}
+
+	float f;
+	unsigned x;
+
+	while (fscanf(fp, "%f,%x,,", &f, &x) == 2) {
+		rc_sample sample = {(uint64_t)(f * 1e6f), (uint8_t)x};
+		recording.push_back(sample);
+	}
+
+	fclose(fp);
+	return !recording.empty();
+}
+
+/**
+ * Replay a recording the way the fmu driver reads it: every tick all bytes
+ * received since the previous tick are handed to the decoder in one span.
+ *
+ * @return number of frames reported to the caller
+ */
+static unsigned replay(struct rc_decoder *dec, const recording_t &recording, unsigned tick)
+{
+	std::vector<uint8_t> buf;
+	unsigned frames = 0;
+	size_t next = 0;
+
+	for (uint64_t now = recording.front().time + tick; next < recording.size(); now += tick) {
+		buf.clear();
+
+		while (next < recording.size() && recording[next].time <= now) {
+			buf.push_back(recording[next++].value);
+		}
+
+		if (!buf.empty() && rc_decoder_parse(dec, now, &buf[0], buf.size())) {
+			frames++;
+		}
+	}
+
+	return frames;
+}
+
+class RCDecoderTest : public ::testing::Test
+{
+protected:
+	void check_lock(const char *filepath, unsigned protocols, enum RC_DECODER_PROTOCOL expected)
+	{
+		recording_t recording;
+		ASSERT_TRUE(load_recording(filepath, recording)) << filepath;
+
+		struct rc_decoder dec;
+		rc_decoder_init(&dec, protocols);
+
+		unsigned frames = replay(&dec, recording, RC_DECODER_TEST_TICK);
+
+		EXPECT_EQ(expected, dec.locked) << filepath << ": locked " << rc_decoder_protocol_name(dec.locked);
+		EXPECT_GT(frames, 0u);
+		EXPECT_GT(dec.num_values, 0u);
+
+		rc_decoder_print_status(&dec);
+	}
+
+	void check_provisional(const char *filepath, unsigned protocols, enum RC_DECODER_PROTOCOL expected)
+	{
+		recording_t recording;
+		ASSERT_TRUE(load_recording(filepath, recording)) << filepath;
+
+		struct rc_decoder dec;
+		rc_decoder_init(&dec, protocols);
+
+		std::vector<uint8_t> buf;
+		unsigned provisional = 0;
+		size_t next = 0;
+
+		/* replay until the protocol locks, the frames before have to be reported provisionally */
+		for (uint64_t now = recording.front().time + RC_DECODER_TEST_TICK;
+		     next < recording.size() && dec.locked == RC_DECODER_PROTO_NONE; now += RC_DECODER_TEST_TICK) {
+			buf.clear();
+
+			while (next < recording.size() && recording[next].time <= now) {
+				buf.push_back(recording[next++].value);
+			}
+
+			if (!buf.empty() && rc_decoder_parse(&dec, now, &buf[0], buf.size())) {
+				EXPECT_EQ(expected, dec.source) << filepath;
+				EXPECT_GT(dec.num_values, 0u);
+
+				if (dec.provisional) {
+					EXPECT_EQ(RC_DECODER_PROTO_NONE, dec.locked);
+					provisional++;
+				}
+			}
+		}
+
+		EXPECT_EQ(expected, dec.locked) << filepath;
+		EXPECT_FALSE(dec.provisional);
+		EXPECT_GT(provisional, 0u) << filepath;
+	}
+
+	void benchmark(const char *filepath, unsigned protocols)
+	{
+		recording_t recording;
+		ASSERT_TRUE(load_recording(filepath, recording)) << filepath;
+
+		std::vector<uint8_t> stream;
+
+		for (size_t i = 0; i < recording.size(); i++) {
+			stream.push_back(recording[i].value);
+		}
+
+		const unsigned chunks[] = {1, 16, 64};
+		const unsigned repeat = 20;
+
+		for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+			struct rc_decoder dec;
+			rc_decoder_init(&dec, protocols);
+
+			/* time stamps only advance per chunk, spaced to keep the gap based framers in sync */
+			uint64_t now = 1;
+			hrt_abstime start = hrt_absolute_time();
+
+			for (unsigned r = 0; r < repeat; r++) {
+				for (size_t i = 0; i < stream.size(); i += chunks[c]) {
+					unsigned len = (stream.size() - i < chunks[c]) ? stream.size() - i : chunks[c];
+					rc_decoder_parse(&dec, now, &stream[i], len);
+					now += recording[i + len - 1].time - recording[i].time + 100;
+				}
+			}
+
+			hrt_abstime elapsed = hrt_absolute_time() - start;
+			unsigned bytes = stream.size() * repeat;
+
+			PX4_INFO("%s: %u bytes in %2u byte chunks: %6llu us (%.2f MB/s)", filepath, bytes, chunks[c],
+				 (unsigned long long)elapsed, (elapsed > 0) ? (double)bytes / elapsed : 0.0);
+		}
+	}
+};
+
+TEST_F(RCDecoderTest, SBUSLock)
+{
+	check_lock("testdata/sbus2_r7008SB.txt", RC_DECODER_MASK_SBUS, RC_DECODER_PROTO_SBUS);
+}
+
+TEST_F(RCDecoderTest, DSMLock)
+{
+	check_lock("testdata/dsm_x_data.txt", RC_DECODER_MASK_115200, RC_DECODER_PROTO_DSM);
+}
+
+TEST_F(RCDecoderTest, ST24Lock)
+{
+	check_lock("testdata/st24_data.txt", RC_DECODER_MASK_115200, RC_DECODER_PROTO_ST24);
+}
+
+TEST_F(RCDecoderTest, SUMDLock)
+{
+	check_lock("testdata/sumd_data.txt", RC_DECODER_MASK_115200, RC_DECODER_PROTO_SUMD);
+}
+
+TEST_F(RCDecoderTest, Provisional)
+{
+	check_provisional("testdata/sbus2_r7008SB.txt", RC_DECODER_MASK_SBUS, RC_DECODER_PROTO_SBUS);
+	check_provisional("testdata/st24_data.txt", RC_DECODER_MASK_115200, RC_DECODER_PROTO_ST24);
+	check_provisional("testdata/sumd_data.txt", RC_DECODER_MASK_115200, RC_DECODER_PROTO_SUMD);
+}
+
+TEST_F(RCDecoderTest, Throughput)
+{
+	benchmark("testdata/sbus2_r7008SB.txt", RC_DECODER_MASK_SBUS);
+	benchmark("testdata/dsm_x_data.txt", RC_DECODER_MASK_115200);
+	benchmark("testdata/st24_data.txt", RC_DECODER_MASK_115200);
+	benchmark("testdata/sumd_data.txt", RC_DECODER_MASK_115200);
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <drivers/drv_hrt.h>
+#include <sensors/sensor_voter.h>
+
+#include "gtest/gtest.h"
+
+/* same limits as the gyro voter in sensors.cpp */
+static const hrt_abstime TIMEOUT = 20 * 1000;
+static const float INCONSISTENCY_LIMIT = 0.1f;
+static const hrt_abstime SWITCH_DELAY = 500 * 1000;
+static const hrt_abstime DT = 4000;
+
+class SensorVoterTest : public ::testing::Test
+{
+protected:
+	SensorVoterTest() : voter("gyro", TIMEOUT, INCONSISTENCY_LIMIT, SWITCH_DELAY), now(1000000)
+	{
+		memset(errors, 0, sizeof(errors));
+		memset(offset, 0, sizeof(offset));
+	}
+
+	/* one sensors loop with a sample of every instance in the mask */
+	bool step(unsigned mask, const uint32_t priority[3])
+	{
+		now += DT;
+
+		for (unsigned i = 0; i < 3; i++) {
+			if (mask & (1 << i)) {
+				float value[3] = { 0.01f + offset[i], -0.02f, 0.03f };
+				voter.put(i, now, value, errors[i], priority[i]);
+			}
+		}
+
+		return voter.update(now);
+	}
+
+	unsigned run_steps(unsigned steps, unsigned mask, const uint32_t priority[3])
+	{
+		unsigned switches = 0;
+
+		for (unsigned s = 0; s < steps; s++) {
+			switches += step(mask, priority) ? 1 : 0;
+		}
+
+		return switches;
+	}
+
+	SensorVoter voter;
+	hrt_abstime now;
+	uint64_t errors[3];
+	float offset[3];
+};
+
+static const uint32_t equal_priority[3] = { 75, 75, 75 };
+
+TEST_F(SensorVoterTest, FirstSelection)
+{
+	EXPECT_EQ(-1, voter.selected());
+	EXPECT_TRUE(step(0x7, equal_priority));
+	EXPECT_EQ(0, voter.selected());
+	EXPECT_EQ(0u, voter.switch_count());
+
+	/* equal instances never replace each other */
+	EXPECT_EQ(0u, run_steps(1000, 0x7, equal_priority));
+
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_EQ(SensorVoter::HEALTH_OK, voter.health(i));
+	}
+}
+
+TEST_F(SensorVoterTest, TimeoutFailover)
+{
+	run_steps(10, 0x7, equal_priority);
+	ASSERT_EQ(0, voter.selected());
+
+	/* instance 0 stops, the switch happens as soon as it times out */
+	unsigned steps = 0;
+
+	while (voter.selected() == 0 && steps < 100) {
+		step(0x6, equal_priority);
+		steps++;
+	}
+
+	EXPECT_EQ(SensorVoter::HEALTH_TIMEOUT, voter.health(0));
+	EXPECT_NE(0, voter.selected());
+	EXPECT_LE(steps * DT, TIMEOUT + 2 * DT);
+	EXPECT_EQ(1u, voter.switch_count());
+
+	/* coming back with the same priority doesn't take the selection back */
+	EXPECT_EQ(0u, run_steps(1000, 0x7, equal_priority));
+	EXPECT_EQ(SensorVoter::HEALTH_OK, voter.health(0));
+}
+
+TEST_F(SensorVoterTest, PriorityHysteresis)
+{
+	const uint32_t priority[3] = { 50, 100, 75 };
+
+	/* only instance 0 at first, it is selected */
+	run_steps(10, 0x1, priority);
+	ASSERT_EQ(0, voter.selected());
+
+	/* the better instance takes over only after the switch delay */
+	unsigned steps = 0;
+
+	while (voter.selected() == 0 && steps < 1000) {
+		step(0x7, priority);
+		steps++;
+	}
+
+	EXPECT_EQ(1, voter.selected());
+	EXPECT_GE(steps * DT, SWITCH_DELAY);
+	EXPECT_LE(steps * DT, SWITCH_DELAY + 2 * DT);
+	EXPECT_EQ(1u, voter.switch_count());
+}
+
+TEST_F(SensorVoterTest, Inconsistent)
+{
+	run_steps(10, 0x7, equal_priority);
+	ASSERT_EQ(0, voter.selected());
+
+	/* instance 0 drifts away from the other two */
+	offset[0] = 0.5f;
+	run_steps(200, 0x7, equal_priority);
+
+	EXPECT_EQ(SensorVoter::HEALTH_INCONSISTENT, voter.health(0));
+	EXPECT_GT(voter.inconsistency(0), INCONSISTENCY_LIMIT);
+	EXPECT_EQ(SensorVoter::HEALTH_OK, voter.health(1));
+	EXPECT_EQ(SensorVoter::HEALTH_OK, voter.health(2));
+	EXPECT_NE(0, voter.selected());
+	EXPECT_EQ(1u, voter.switch_count());
+
+	/* an instance alone is not compared */
+	run_steps(200, 0x2, equal_priority);
+	EXPECT_EQ(0.0f, voter.inconsistency(1));
+}
+
+TEST_F(SensorVoterTest, Errors)
+{
+	run_steps(10, 0x3, equal_priority);
+	ASSERT_EQ(0, voter.selected());
+
+	/* every sample of instance 0 counts an error */
+	for (unsigned s = 0; s < 200; s++) {
+		errors[0]++;
+		step(0x3, equal_priority);
+	}
+
+	EXPECT_EQ(SensorVoter::HEALTH_ERRORS, voter.health(0));
+	EXPECT_EQ(1, voter.selected());
+
+	voter.print_status();
+}
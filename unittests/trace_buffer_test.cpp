@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+#include <systemlib/trace_buffer.h>
+
+#include "gtest/gtest.h"
+
+static std::string read_file(const char *path)
+{
+	std::ifstream f(path);
+	std::stringstream s;
+	s << f.rdbuf();
+	return s.str();
+}
+
+static unsigned occurrences(const std::string &s, const std::string &what)
+{
+	unsigned n = 0;
+
+	for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1)) {
+		n++;
+	}
+
+	return n;
+}
+
+static void *loop(void *arg)
+{
+	pthread_setname_np(pthread_self(), "test_worker");
+
+	for (unsigned i = 0; i < 100; i++) {
+		trace_event(TRACE_BEGIN, "test_loop", 0);
+		trace_event(TRACE_END, "test_loop", 0);
+	}
+
+	return nullptr;
+}
+
+class TraceBufferTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		snprintf(path, sizeof(path), "/tmp/trace_buffer_test_%d.json", (int)getpid());
+	}
+
+	virtual void TearDown()
+	{
+		unlink(path);
+	}
+
+	char path[64];
+};
+
+TEST_F(TraceBufferTest, Threads)
+{
+	/* nothing is recorded before the start */
+	trace_event(TRACE_INSTANT, "test_count", 0);
+
+	ASSERT_EQ(0, trace_start());
+
+	pthread_t threads[2];
+
+	for (unsigned i = 0; i < 2; i++) {
+		ASSERT_EQ(0, pthread_create(&threads[i], nullptr, loop, nullptr));
+	}
+
+	trace_event(TRACE_INSTANT, "test_count", 0);
+	trace_event(TRACE_COUNTER, "test_elapsed", 1234);
+	trace_event(TRACE_BEGIN, "test_elapsed", 0);
+	trace_event(TRACE_END, "test_elapsed", 0);
+
+	for (unsigned i = 0; i < 2; i++) {
+		pthread_join(threads[i], nullptr);
+	}
+
+	/* 2 x 100 durations and the main thread events, with a name for each of the 3 threads */
+	EXPECT_EQ(2 * 200 + 4 + 3, trace_dump(path));
+
+	std::string json = read_file(path);
+	EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+	EXPECT_EQ(2u, occurrences(json, "\"name\":\"test_worker\""));
+	EXPECT_EQ(201u, occurrences(json, "\"ph\":\"B\""));
+	EXPECT_EQ(201u, occurrences(json, "\"ph\":\"E\""));
+	EXPECT_EQ(1u, occurrences(json, "\"name\":\"test_count\",\"ph\":\"i\""));
+	EXPECT_EQ(1u, occurrences(json, "\"args\":{\"value\":1234}"));
+
+	/* the dump stops the trace */
+	trace_event(TRACE_INSTANT, "test_count", 0);
+	EXPECT_EQ(2 * 200 + 4 + 3, trace_dump(path));
+}
+
+TEST_F(TraceBufferTest, Wrap)
+{
+	ASSERT_EQ(0, trace_start());
+
+	for (unsigned i = 0; i < TRACE_RING_EVENTS + 10; i++) {
+		trace_event(TRACE_COUNTER, "test_wrap", i);
+	}
+
+	/* the ring keeps the newest events of the thread and its name */
+	EXPECT_EQ(TRACE_RING_EVENTS + 1, trace_dump(path));
+
+	std::string json = read_file(path);
+	EXPECT_EQ(0u, occurrences(json, "\"args\":{\"value\":9}"));
+	EXPECT_EQ(1u, occurrences(json, "\"args\":{\"value\":10}"));
+}
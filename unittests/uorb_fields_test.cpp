@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <uORB/uORB.h>
+#include <uORB/topics/esc_status.h>
+#include <uORB/topics/perf_stats.h>
+
+#include "gtest/gtest.h"
+
+ORB_DEFINE(esc_report, struct esc_report_s);
+ORB_DEFINE(esc_status, struct esc_status_s);
+ORB_DEFINE(perf_stats, struct perf_stats_s);
+
+/* the traits are usable at compile time */
+static_assert(orb_topic_traits<esc_status_s>::size() == sizeof(esc_status_s), "size");
+static_assert(orb_topic_traits<esc_status_s>::field_count() == 5, "field count");
+static_assert(orb_topic_traits<perf_stats_s>::name()[0] == 'p', "name");
+
+template<typename T>
+static void check_layout()
+{
+	typedef orb_topic_traits<T> traits;
+	const struct orb_fields *fields = traits::fields();
+
+	ASSERT_STREQ(traits::name(), fields->name);
+	ASSERT_STREQ(traits::name(), traits::metadata()->o_name);
+	ASSERT_EQ(traits::size(), traits::metadata()->o_size);
+	ASSERT_EQ(traits::size(), fields->size);
+	ASSERT_EQ(traits::field_count(), fields->count);
+
+	/* in declaration order, without overlaps and within the struct */
+	size_t end = 0;
+
+	for (unsigned i = 0; i < fields->count; i++) {
+		const struct orb_field &field = fields->fields[i];
+		size_t element_size = (field.type == ORB_FIELD_STRUCT) ? field.nested()->size : orb_field_type_size(field.type);
+
+		ASSERT_GT(element_size, 0u) << field.name;
+		ASSERT_GE(field.offset, end) << field.name;
+		end = field.offset + element_size * field.array_length;
+		ASSERT_LE(end, fields->size) << field.name;
+	}
+}
+
+TEST(uORBFieldsTest, Layout)
+{
+	check_layout<esc_report_s>();
+	check_layout<esc_status_s>();
+	check_layout<perf_stats_s>();
+
+	const struct orb_fields *fields = orb_topic_traits<esc_status_s>::fields();
+	const struct orb_field &esc = fields->fields[4];
+	ASSERT_STREQ("esc", esc.name);
+	ASSERT_EQ(offsetof(esc_status_s, esc), esc.offset);
+	ASSERT_EQ(8, esc.array_length);
+	ASSERT_EQ(ORB_FIELD_STRUCT, esc.type);
+	ASSERT_EQ(orb_topic_traits<esc_report_s>::fields(), esc.nested());
+
+	const struct orb_field &name = orb_topic_traits<perf_stats_s>::fields()->fields[1];
+	ASSERT_STREQ("name", name.name);
+	ASSERT_EQ(ORB_FIELD_CHAR, name.type);
+	ASSERT_EQ(sizeof(perf_stats_s::name), name.array_length);
+}
+
+TEST(uORBFieldsTest, Print)
+{
+	struct esc_status_s status = {};
+	status.timestamp = 1234567890123ull;
+	status.esc_count = 2;
+	status.esc[1].esc_rpm = -1500;
+	status.esc[1].esc_voltage = 11.5f;
+
+	char buf[4096];
+	int len = orb_print_message(buf, sizeof(buf), orb_topic_traits<esc_status_s>::fields(), &status);
+	ASSERT_EQ(strlen(buf), (size_t)len);
+
+	ASSERT_TRUE(strstr(buf, "timestamp: 1234567890123\n") != nullptr) << buf;
+	ASSERT_TRUE(strstr(buf, "esc_count: 2\n") != nullptr);
+	ASSERT_TRUE(strstr(buf, "esc[1].esc_rpm: -1500\n") != nullptr);
+	ASSERT_TRUE(strstr(buf, "esc[1].esc_voltage: 11.5000\n") != nullptr);
+	ASSERT_TRUE(strstr(buf, "esc[7].esc_state: 0\n") != nullptr);
+
+	/* char arrays as string, also without termination */
+	struct perf_stats_s perf = {};
+	memset(perf.name, 'a', sizeof(perf.name));
+	perf.mean_us = 2.25f;
+
+	orb_print_message(buf, sizeof(buf), orb_topic_traits<perf_stats_s>::fields(), &perf);
+	char expected[64];
+	snprintf(expected, sizeof(expected), "name: \"%.*s\"\n", (int)sizeof(perf.name), perf.name);
+	ASSERT_TRUE(strstr(buf, expected) != nullptr) << buf;
+	ASSERT_TRUE(strstr(buf, "mean_us: 2.2500\n") != nullptr);
+}
+
+TEST(uORBFieldsTest, Truncate)
+{
+	struct esc_status_s status = {};
+	char full[4096];
+	int len = orb_print_message(full, sizeof(full), orb_topic_traits<esc_status_s>::fields(), &status);
+
+	char buf[100];
+	memset(buf, 'x', sizeof(buf));
+	ASSERT_EQ((int)sizeof(buf) - 1, orb_print_message(buf, sizeof(buf), orb_topic_traits<esc_status_s>::fields(), &status));
+	ASSERT_EQ(0, strncmp(buf, full, sizeof(buf) - 1));
+	ASSERT_EQ('\0', buf[sizeof(buf) - 1]);
+	ASSERT_GT(len, (int)sizeof(buf));
+
+	ASSERT_EQ(0, orb_print_message(buf, 0, orb_topic_traits<esc_status_s>::fields(), &status));
+}
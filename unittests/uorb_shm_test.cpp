@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include <drivers/drv_hrt.h>
+#include <muorb/shm/uORBShmChannel.hpp>
+#include <uORB/topics/sensor_combined.h>
+#include <px4_log.h>
+
+#include "gtest/gtest.h"
+
+/* sends every message and subscription it receives back to the other process */
+class EchoHandler : public uORBCommunicator::IChannelRxHandler
+{
+public:
+	EchoHandler(uORB::ShmChannel *channel) : _channel(channel) {}
+
+	virtual int16_t process_add_subscription(const char *messageName, int32_t msgRateInHz)
+	{
+		return _channel->add_subscription(messageName, msgRateInHz);
+	}
+
+	virtual int16_t process_remove_subscription(const char *messageName)
+	{
+		return _channel->remove_subscription(messageName);
+	}
+
+	virtual int16_t process_received_message(const char *messageName, int32_t length, uint8_t *data)
+	{
+		/* don't drop in the echo, the test counts every message */
+		while (_channel->send_message(messageName, length, data) != 0) {
+			sched_yield();
+		}
+
+		return 0;
+	}
+
+private:
+	uORB::ShmChannel *_channel;
+};
+
+/* records what comes back */
+class CountingHandler : public uORBCommunicator::IChannelRxHandler
+{
+public:
+	CountingHandler() : subscriptions(0), messages(0), last_timestamp(0), errors(0)
+	{
+		pthread_mutex_init(&_mutex, nullptr);
+		pthread_cond_init(&_cond, nullptr);
+	}
+
+	virtual int16_t process_add_subscription(const char *messageName, int32_t msgRateInHz)
+	{
+		pthread_mutex_lock(&_mutex);
+
+		if (strcmp(messageName, "sensor_combined") == 0 && msgRateInHz == 250) {
+			subscriptions++;
+
+		} else {
+			errors++;
+		}
+
+		pthread_cond_broadcast(&_cond);
+		pthread_mutex_unlock(&_mutex);
+		return 0;
+	}
+
+	virtual int16_t process_remove_subscription(const char *messageName)
+	{
+		pthread_mutex_lock(&_mutex);
+		subscriptions--;
+		pthread_cond_broadcast(&_cond);
+		pthread_mutex_unlock(&_mutex);
+		return 0;
+	}
+
+	virtual int16_t process_received_message(const char *messageName, int32_t length, uint8_t *data)
+	{
+		pthread_mutex_lock(&_mutex);
+
+		if (length == sizeof(sensor_combined_s) && strcmp(messageName, "sensor_combined") == 0) {
+			const sensor_combined_s *report = (const sensor_combined_s *)data;
+
+			/* the payload pattern depends on the timestamp */
+			if (report->gyro_rad_s[0] != (float)(report->timestamp % 1000)) {
+				errors++;
+			}
+
+			last_timestamp = report->timestamp;
+			messages++;
+
+		} else {
+			errors++;
+		}
+
+		pthread_cond_broadcast(&_cond);
+		pthread_mutex_unlock(&_mutex);
+		return 0;
+	}
+
+	/* wait until the counters satisfy the condition, false on timeout */
+	template<class Condition>
+	bool wait(Condition condition, unsigned timeout_ms)
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += timeout_ms / 1000;
+		ts.tv_nsec += (timeout_ms % 1000) * 1000000;
+
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		pthread_mutex_lock(&_mutex);
+		int ret = 0;
+
+		while (!condition(this) && ret == 0) {
+			ret = pthread_cond_timedwait(&_cond, &_mutex, &ts);
+		}
+
+		bool ok = condition(this);
+		pthread_mutex_unlock(&_mutex);
+		return ok;
+	}
+
+	int subscriptions;
+	unsigned messages;
+	uint64_t last_timestamp;
+	unsigned errors;
+
+private:
+	pthread_mutex_t _mutex;
+	pthread_cond_t _cond;
+};
+
+static void fill(sensor_combined_s &report, uint64_t timestamp)
+{
+	report.timestamp = timestamp;
+	report.gyro_rad_s[0] = (float)(timestamp % 1000);
+}
+
+class ShmChannelTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		snprintf(name, sizeof(name), "/px4_shm_test_%d", (int)getpid());
+		ASSERT_EQ(0, channel.open(name, true));
+
+		/* the second process of the loopback, attaches and echoes */
+		child = fork();
+
+		if (child == 0) {
+			uORB::ShmChannel remote;
+
+			if (remote.open(name, false) != 0) {
+				_exit(1);
+			}
+
+			EchoHandler echo(&remote);
+			remote.register_handler(&echo);
+			remote.Start();
+
+			for (;;) {
+				pause();
+			}
+		}
+
+		ASSERT_GT(child, 0);
+		channel.register_handler(&handler);
+		ASSERT_EQ(0, channel.Start());
+		memset(&report, 0, sizeof(report));
+
+		/* one round trip, so the measurements don't include the start of the other process */
+		ASSERT_EQ(0, channel.add_subscription("sensor_combined", 250));
+		ASSERT_TRUE(handler.wait([](CountingHandler * h) { return h->subscriptions == 1; }, 2000));
+	}
+
+	virtual void TearDown()
+	{
+		if (child > 0) {
+			kill(child, SIGTERM);
+			waitpid(child, nullptr, 0);
+		}
+
+		channel.close();
+	}
+
+	char name[64];
+	pid_t child;
+	uORB::ShmChannel channel;
+	CountingHandler handler;
+	sensor_combined_s report;
+};
+
+TEST_F(ShmChannelTest, Subscriptions)
+{
+	ASSERT_EQ(0, channel.remove_subscription("sensor_combined"));
+	EXPECT_TRUE(handler.wait([](CountingHandler * h) { return h->subscriptions == 0; }, 2000));
+
+	/* names longer than the table entries are rejected */
+	char name[100];
+	memset(name, 'x', sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	EXPECT_NE(0, channel.send_message(name, sizeof(report), (uint8_t *)&report));
+
+	EXPECT_EQ(0u, handler.errors);
+}
+
+TEST_F(ShmChannelTest, Batch)
+{
+	const int32_t count = 16;
+	sensor_combined_s reports[count];
+	const char *names[count];
+	int32_t lengths[count];
+	uint8_t *data[count];
+
+	for (int32_t i = 0; i < count; i++) {
+		memset(&reports[i], 0, sizeof(reports[i]));
+		fill(reports[i], 1000 + i);
+		names[i] = "sensor_combined";
+		lengths[i] = sizeof(reports[i]);
+		data[i] = (uint8_t *)&reports[i];
+	}
+
+	ASSERT_EQ(count, channel.send_messages(count, names, lengths, data));
+	EXPECT_TRUE(handler.wait([](CountingHandler * h) { return h->messages == count; }, 2000));
+	EXPECT_EQ(1000u + count - 1, handler.last_timestamp);
+
+	/* a batch larger than the ring is cut at the first message that does not fit */
+	const int32_t large = 2 * uORB::ShmChannel::RING_SIZE / sizeof(sensor_combined_s);
+	std::vector<const char *> large_names(large, "sensor_combined");
+	std::vector<int32_t> large_lengths(large, sizeof(report));
+	std::vector<uint8_t *> large_data(large, (uint8_t *)&report);
+
+	int32_t sent = channel.send_messages(large, large_names.data(), large_lengths.data(), large_data.data());
+	EXPECT_GT(sent, 0);
+	EXPECT_LT(sent, large);
+
+	EXPECT_EQ(0u, handler.errors);
+}
+
+TEST_F(ShmChannelTest, Latency)
+{
+	const unsigned count = 5000;
+	hrt_abstime rtt_sum = 0;
+	hrt_abstime rtt_max = 0;
+
+	for (unsigned i = 0; i < count; i++) {
+		hrt_abstime sent = hrt_absolute_time();
+		fill(report, sent);
+		ASSERT_EQ(0, channel.send_message("sensor_combined", sizeof(report), (uint8_t *)&report));
+		ASSERT_TRUE(handler.wait([sent](CountingHandler * h) { return h->last_timestamp == sent; }, 2000)) << i;
+
+		hrt_abstime rtt = hrt_absolute_time() - sent;
+		rtt_sum += rtt;
+
+		if (rtt > rtt_max) {
+			rtt_max = rtt;
+		}
+	}
+
+	EXPECT_EQ(count, handler.messages);
+	EXPECT_EQ(0u, handler.errors);
+
+	PX4_INFO("%u round trips of %u bytes: mean %.1f us, max %llu us", count, (unsigned)sizeof(report),
+		 (double)rtt_sum / count, (unsigned long long)rtt_max);
+}
+
+TEST_F(ShmChannelTest, Throughput)
+{
+	const unsigned count = 100000;
+	unsigned retries = 0;
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < count; i++) {
+		fill(report, start + i);
+
+		/* a full ring drops the message, retry to push everything through */
+		while (channel.send_message("sensor_combined", sizeof(report), (uint8_t *)&report) != 0) {
+			retries++;
+			sched_yield();
+		}
+	}
+
+	ASSERT_TRUE(handler.wait([count](CountingHandler * h) { return h->messages == count; }, 10000))
+			<< handler.messages;
+
+	hrt_abstime elapsed = hrt_absolute_time() - start;
+	EXPECT_EQ(0u, handler.errors);
+
+	PX4_INFO("%u messages of %u bytes echoed in %llu us: %.0f msg/s, %.1f MB/s each way, %u retries on full ring",
+		 count, (unsigned)sizeof(report), (unsigned long long)elapsed, count * 1e6 / elapsed,
+		 (double)count * sizeof(report) / elapsed, retries);
+	channel.print_status();
+}
@@ -21,3 +21,24 @@ int	orb_publish(const struct orb_metadata *meta, orb_advert_t handle, const void
 }
 
 
+
+int	orb_subscribe(const struct orb_metadata *meta)
+{
+	return -1;
+}
+
+int	orb_unsubscribe(int handle)
+{
+	return 0;
+}
+
+int	orb_copy(const struct orb_metadata *meta, int handle, void *buffer)
+{
+	return -1;
+}
+
+int	orb_check(int handle, bool *updated)
+{
+	*updated = false;
+	return 0;
+}